@@ -102,7 +102,17 @@ class Message:
     """
     Constructor
     """
-    def __init__(self, service, mbimex_service, mbimex_version, dictionary):
+    def __init__(self, service, mbimex_service, mbimex_version, dictionary, tables = False):
+        # Whether field tables run by the generic codec should be used when possible
+        self.tables = tables
+
+        # Names of the structs whose arrays can be visited element by element;
+        # updated after having created the object.
+        self.viewable_structs = []
+        # Names of the structs with a fixed size, whose arrays can be read in
+        # place through overlays; updated after having created the object.
+        self.overlay_structs = []
+
         # The message service, e.g. "Basic Connect"
         self.service = service
         self.mbimex_service = mbimex_service
@@ -160,6 +170,16 @@ class Message:
             self.has_notification = False
             self.notification = []
 
+        # Message types allowed by the protocol for this command, but without
+        # any message definition in the library; they are only used to report
+        # the command capabilities
+        self.not_implemented = dictionary['not-implemented'] if 'not-implemented' in dictionary else []
+        for message_type in self.not_implemented:
+            if message_type not in ['query', 'set', 'notification']:
+                raise ValueError('Message ' + self.name + ' cannot flag \'' + message_type + '\' as not implemented')
+            if message_type in dictionary:
+                raise ValueError('Message ' + self.name + ' (' + message_type + ') is implemented')
+
         # Build Fullname
         if self.service == 'Basic Connect':
             self.fullname = 'MBIM Message ' + self.name
@@ -192,26 +212,146 @@ class Message:
         if self.has_query:
             utils.add_separator(hfile, 'Message (Query)', self.fullname);
             utils.add_separator(cfile, 'Message (Query)', self.fullname);
+            self._emit_message_codec(cfile, 'query', self.query)
             self._emit_message_creator(hfile, cfile, 'query', self.query, self.query_since)
+            self._emit_message_patchable_offsets(hfile, 'query', self.query)
             self._emit_message_printable(cfile, 'query', self.query)
+            self._emit_message_json(cfile, 'query', self.query)
 
         if self.has_set:
             utils.add_separator(hfile, 'Message (Set)', self.fullname);
             utils.add_separator(cfile, 'Message (Set)', self.fullname);
+            self._emit_message_codec(cfile, 'set', self.set)
             self._emit_message_creator(hfile, cfile, 'set', self.set, self.set_since)
+            self._emit_message_patchable_offsets(hfile, 'set', self.set)
             self._emit_message_printable(cfile, 'set', self.set)
+            self._emit_message_json(cfile, 'set', self.set)
 
         if self.has_response:
             utils.add_separator(hfile, 'Message (Response)', self.fullname);
             utils.add_separator(cfile, 'Message (Response)', self.fullname);
+            self._emit_message_codec(cfile, 'response', self.response)
             self._emit_message_parser(hfile, cfile, 'response', self.response, self.response_since)
+            self._emit_message_visitors(hfile, cfile, 'response', self.response)
+            self._emit_message_peekers(hfile, cfile, 'response', self.response)
+            self._emit_message_tlv_iterators(hfile, cfile, 'response', self.response)
+            self._emit_message_accessors(hfile, cfile, 'response', self.response)
             self._emit_message_printable(cfile, 'response', self.response)
+            self._emit_message_json(cfile, 'response', self.response)
 
         if self.has_notification:
             utils.add_separator(hfile, 'Message (Notification)', self.fullname);
             utils.add_separator(cfile, 'Message (Notification)', self.fullname);
+            self._emit_message_codec(cfile, 'notification', self.notification)
             self._emit_message_parser(hfile, cfile, 'notification', self.notification, self.notification_since)
+            self._emit_message_visitors(hfile, cfile, 'notification', self.notification)
+            self._emit_message_peekers(hfile, cfile, 'notification', self.notification)
+            self._emit_message_tlv_iterators(hfile, cfile, 'notification', self.notification)
+            self._emit_message_accessors(hfile, cfile, 'notification', self.notification)
             self._emit_message_printable(cfile, 'notification', self.notification)
+            self._emit_message_json(cfile, 'notification', self.notification)
+
+
+    """
+    Whether the fields can be handled by the generic table-driven codec; only
+    messages with fields at fixed offsets and without dependencies between
+    them are supported, all others get their own generated code
+    """
+    def _codec_supported(self, fields):
+        if not self.tables or fields == []:
+            return False
+        for field in fields:
+            if 'available-if' in field or 'always-read' in field or 'array-size-field' in field:
+                return False
+            if field['format'] not in ['guint16', 'guint32', 'guint64', 'uuid', 'byte-array', 'unsized-byte-array', 'ref-byte-array', 'string']:
+                return False
+            # The parsed value is written with the size of the public type
+            if 'public-format' in field and field['format'] != 'guint32':
+                return False
+            # A field after a variable-size one would not be at a fixed offset
+            if field['format'] == 'unsized-byte-array' and field is not fields[-1]:
+                return False
+        return True
+
+
+    """
+    Emit the field table used by the generic codec
+    """
+    def _emit_message_codec(self, cfile, message_type, fields, hfile = None):
+        if not self._codec_supported(fields):
+            return
+
+        # Tables are only exported when emitted on their own (--codec-tables)
+        translations = { 'underscore'   : utils.build_underscore_name (self.fullname),
+                         'message_type' : message_type,
+                         'storage'      : 'static ' if hfile is None else '' }
+
+        if hfile is not None:
+            template = (
+                '\n'
+                'G_GNUC_INTERNAL\n'
+                'extern const MbimMessageCodecMessage ${underscore}_${message_type}_codec;\n')
+            hfile.write(string.Template(template).substitute(translations))
+
+        template = (
+            '\n'
+            'static const MbimMessageCodecField ${underscore}_${message_type}_codec_fields[] = {\n')
+
+        for field in fields:
+            translations['name'] = field['name']
+            translations['format_enum'] = 'MBIM_MESSAGE_CODEC_FORMAT_' + utils.build_underscore_uppercase_name(field['format'])
+            translations['array_size'] = field['array-size'] if 'array-size' in field else '0'
+
+            flags = []
+            if 'personal-info' in field:
+                flags.append('MBIM_MESSAGE_CODEC_FLAG_PERSONAL_INFO')
+            if 'encoding' in field and field['encoding'] == 'utf-8':
+                flags.append('MBIM_MESSAGE_CODEC_FLAG_UTF8')
+            if 'pad-array' in field and field['pad-array'] == 'FALSE':
+                flags.append('MBIM_MESSAGE_CODEC_FLAG_NO_PAD')
+            if 'public-format' in field and field['public-format'] == 'gboolean':
+                flags.append('MBIM_MESSAGE_CODEC_FLAG_BOOLEAN')
+
+            if 'public-format' in field and field['public-format'] != 'gboolean':
+                translations['public_underscore'] = utils.build_underscore_name_from_camelcase(field['public-format'])
+                translations['public_underscore_upper'] = translations['public_underscore'].upper()
+                translations['enum_flags'] = ' | '.join(flags + ['MBIM_MESSAGE_CODEC_FLAG_ENUM'])
+                translations['flags_flags'] = ' | '.join(flags + ['MBIM_MESSAGE_CODEC_FLAG_FLAGS'])
+                inner_template = (
+                    '#if defined __${public_underscore_upper}_IS_ENUM__\n'
+                    '    { "${name}", ${format_enum}, ${enum_flags}, ${array_size}, G_CALLBACK (${public_underscore}_get_string) },\n'
+                    '#elif defined __${public_underscore_upper}_IS_FLAGS__\n'
+                    '    { "${name}", ${format_enum}, ${flags_flags}, ${array_size}, G_CALLBACK (${public_underscore}_build_string_from_mask) },\n'
+                    '#else\n'
+                    '# error neither enum nor flags\n'
+                    '#endif\n')
+            else:
+                translations['flags'] = ' | '.join(flags) if flags else 'MBIM_MESSAGE_CODEC_FLAG_NONE'
+                inner_template = (
+                    '    { "${name}", ${format_enum}, ${flags}, ${array_size}, NULL },\n')
+            template += (string.Template(inner_template).substitute(translations))
+
+        translations['fixed_size'] = utils.fixed_size_prefix(fields)[0]
+        template += (
+            '};\n'
+            '\n'
+            '${storage}const MbimMessageCodecMessage ${underscore}_${message_type}_codec = {\n'
+            '    ${fixed_size},\n'
+            '    G_N_ELEMENTS (${underscore}_${message_type}_codec_fields),\n'
+            '    ${underscore}_${message_type}_codec_fields\n'
+            '};\n')
+        cfile.write(string.Template(template).substitute(translations))
+
+
+    """
+    Emit only the field tables of the message, exported in the given header
+    """
+    def emit_codec_tables(self, hfile, cfile):
+        for (message_type, fields) in [ ('query',        self.query),
+                                        ('set',          self.set),
+                                        ('response',     self.response),
+                                        ('notification', self.notification) ]:
+            self._emit_message_codec(cfile, message_type, fields, hfile)
 
 
     """
@@ -421,7 +561,34 @@ class Message:
             template += (string.Template(inner_template).substitute(translations))
 
         template += (
-            '    GError **error)\n'
+            '    GError **error)\n')
+
+        if self._codec_supported(fields):
+            template += (
+                '{\n'
+                '    const MbimMessageCodecValue values[] = {\n')
+            for field in fields:
+                translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
+                if field['format'] in ['unsized-byte-array', 'ref-byte-array']:
+                    inner_template = ('        { .size = ${field}_size, .pointer = ${field} },\n')
+                elif field['format'] in ['byte-array', 'uuid', 'string']:
+                    inner_template = ('        { .pointer = ${field} },\n')
+                else:
+                    inner_template = ('        { .integer = ${field} },\n')
+                template += (string.Template(inner_template).substitute(translations))
+            template += (
+                '    };\n'
+                '\n'
+                '    return _mbim_message_codec_build (${service_enum_name},\n'
+                '                                      ${cid_enum_name},\n'
+                '                                      MBIM_MESSAGE_COMMAND_TYPE_${message_type_upper},\n'
+                '                                      &${underscore}_${message_type}_codec,\n'
+                '                                      values);\n'
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
+            return
+
+        template += (
             '{\n'
             '    MbimMessageCommandBuilder *builder;\n'
             '\n'
@@ -512,6 +679,57 @@ class Message:
         cfile.write(string.Template(template).substitute(translations))
 
 
+    """
+    Fields of a query or set message that can be patched in place in an
+    already built message: 32-bit integers at a fixed offset, which no other
+    field depends on. Returns the field indices and their offsets in the
+    information buffer.
+    """
+    def patchable_fields(self, fields):
+        dependencies = []
+        for field in fields:
+            if 'array-size-field' in field:
+                dependencies.append(field['array-size-field'])
+            if 'available-if' in field:
+                dependencies.append(field['available-if']['field'])
+
+        patchable = []
+        offset = 0
+        for field_index in range(utils.fixed_size_prefix(fields)[1]):
+            field = fields[field_index]
+            if field['format'] == 'guint32' and field['name'] not in dependencies:
+                patchable.append((field_index, offset))
+            offset += utils.fixed_field_size(field)
+        return patchable
+
+
+    """
+    Emit the offsets of the fields that can be patched in built messages
+    """
+    def _emit_message_patchable_offsets(self, hfile, message_type, fields):
+        translations = { 'message'      : self.name,
+                         'service'      : self.service,
+                         'underscore'   : utils.build_underscore_name (self.fullname),
+                         'message_type' : message_type }
+
+        for (field_index, offset) in self.patchable_fields(fields):
+            translations['name'] = fields[field_index]['name']
+            translations['offset'] = offset
+            translations['define'] = (translations['underscore'] + '_' + message_type + '_' +
+                                      utils.build_underscore_name_from_camelcase(fields[field_index]['name']) + '_offset').upper()
+            template = (
+                '\n'
+                '/**\n'
+                ' * ${define}:\n'
+                ' *\n'
+                ' * Offset of the \'${name}\' field in the information buffer of the \'${message}\' ${message_type} command in the \'${service}\' service, to be used with mbim_message_command_patch_guint32().\n'
+                ' *\n'
+                ' * Since: 1.36\n'
+                ' */\n'
+                '#define ${define} ${offset}\n')
+            hfile.write(string.Template(template).substitute(translations))
+
+
     """
     Emit message parser
     """
@@ -722,11 +940,39 @@ class Message:
             '    GError **error)\n'
             '{\n')
 
+        if self._codec_supported(fields):
+            translations['message_type_enum'] = 'MBIM_MESSAGE_TYPE_COMMAND_DONE' if message_type == 'response' else 'MBIM_MESSAGE_TYPE_INDICATE_STATUS'
+            template += (
+                '    gpointer out[] = {\n')
+            for field in fields:
+                translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
+                if field['format'] in ['unsized-byte-array', 'ref-byte-array']:
+                    inner_template = ('        out_${field}_size,\n'
+                                      '        out_${field},\n')
+                else:
+                    inner_template = ('        out_${field},\n')
+                template += (string.Template(inner_template).substitute(translations))
+            template += (
+                '    };\n'
+                '\n'
+                '    return _mbim_message_codec_parse (message, ${message_type_enum}, &${underscore}_${message_type}_codec, out, error);\n'
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
+            return
+
         if fields != []:
             template += (
                 '    gboolean success = FALSE;\n'
                 '    guint32 offset = 0;\n')
 
+        # The leading fixed-size fields are validated at once, and then read
+        # through the cursor without any further check
+        (fixed_size, fixed_count) = utils.fixed_size_prefix(fields)
+        translations['fixed_size'] = fixed_size
+        if fixed_count > 0:
+            template += (
+                '    MbimMessageCursor cursor;\n')
+
         count_allocated_variables = 0
         for field in fields:
             translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
@@ -822,7 +1068,14 @@ class Message:
         else:
             raise ValueError('Unexpected message type \'%s\'' % message_type)
 
-        for field in fields:
+        if fixed_count > 0:
+            template += (
+                '\n'
+                '    _mbim_message_cursor_init (&cursor, message);\n'
+                '    if (!_mbim_message_cursor_check (&cursor, 0, ${fixed_size}, error))\n'
+                '        return FALSE;\n')
+
+        for field_index, field in enumerate(fields):
             translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
             translations['field_format_underscore'] = utils.build_underscore_name_from_camelcase(field['format'])
             translations['field_name'] = field['name']
@@ -881,7 +1134,10 @@ class Message:
                 inner_template += (
                     '    {\n')
 
-            if 'always-read' in field:
+            fixed_template = self._emit_message_parser_fixed_field(field, translations) if field_index < fixed_count else ''
+            if fixed_template:
+                inner_template += fixed_template
+            elif 'always-read' in field:
                 inner_template += (
                     '        if (!_mbim_message_read_guint32 (message, offset, &_${field}, error))\n'
                     '            goto out;\n'
@@ -1190,111 +1446,819 @@ class Message:
 
 
     """
-    Emit message printable
+    Whether the offset of the given field can be computed without parsing the
+    whole message, i.e. if it is not optional, and is not after optional
+    fields or fields with a variable size in the fixed buffer
     """
-    def _emit_message_printable(self, cfile, message_type, fields):
-        translations = { 'message'            : self.name,
-                         'underscore'         : utils.build_underscore_name(self.name),
-                         'service'            : self.service,
-                         'underscore'         : utils.build_underscore_name (self.fullname),
-                         'message_type'       : message_type,
-                         'message_type_upper' : message_type.upper() }
+    def _field_offset_computable(self, fields, field_index, conditional = False):
+        if 'available-if' in fields[field_index]:
+            if not conditional or not self._condition_readable(fields, fields[field_index]):
+                return False
+        for previous in fields[:field_index]:
+            if 'available-if' in previous:
+                if not conditional or not self._condition_readable(fields, previous):
+                    return False
+                if previous['format'] != 'ref-struct-array' and utils.fixed_field_size(previous) is None:
+                    return False
+                continue
+            if previous['format'] in ['ref-struct-array', 'string-array', 'ref-byte-array']:
+                continue
+            if utils.fixed_field_size(previous) is None:
+                return False
+        return True
+
+    """
+    Whether the 'available-if' condition of the given field depends only on an
+    integer field that is always available and that is found before it
+    """
+    def _condition_readable(self, fields, field):
+        for previous in fields[:fields.index(field)]:
+            if previous['name'] == field['available-if']['field']:
+                return previous['format'] == 'guint32' and 'available-if' not in previous
+        return False
+
+    """
+    Counter fields that must be read in order to compute the offset of the
+    given field and, for arrays, its number of elements
+    """
+    def _field_offset_counters(self, fields, field_index):
+        counters = []
+        for field in fields[:field_index + 1]:
+            if 'available-if' in field and field['available-if']['field'] not in counters:
+                counters.append(field['available-if']['field'])
+        for previous in fields[:field_index]:
+            if previous['format'] in ['ref-struct-array', 'string-array']:
+                counters.append(previous['array-size-field'])
+        if 'array-size-field' in fields[field_index]:
+            counters.append(fields[field_index]['array-size-field'])
+        # Arrays may share the same counter
+        return list(dict.fromkeys(counters))
+
+    """
+    Emit the checks of the message type done before reading any field
+    """
+    def _emit_message_type_checks(self, message_type):
+        if message_type == 'response':
+            translations = { 'message_type'           : message_type,
+                             'expected_type'          : 'MBIM_MESSAGE_TYPE_COMMAND_DONE',
+                             'get_information_buffer' : 'mbim_message_command_done_get_raw_information_buffer' }
+        else:
+            translations = { 'message_type'           : message_type,
+                             'expected_type'          : 'MBIM_MESSAGE_TYPE_INDICATE_STATUS',
+                             'get_information_buffer' : 'mbim_message_indicate_status_get_raw_information_buffer' }
         template = (
+            '    if (mbim_message_get_message_type (message) != ${expected_type}) {\n'
+            '        g_set_error (error,\n'
+            '                     MBIM_CORE_ERROR,\n'
+            '                     MBIM_CORE_ERROR_INVALID_MESSAGE,\n'
+            '                     \"Message is not a ${message_type}\");\n'
+            '        return FALSE;\n'
+            '    }\n'
             '\n'
-            'static gchar *\n'
-            '${underscore}_${message_type}_get_printable (\n'
-            '    const MbimMessage *message,\n'
-            '    const gchar *line_prefix,\n'
-            '    GError **error)\n'
-            '{\n'
-            '    GString *str;\n')
+            '    if (!${get_information_buffer} (message, NULL)) {\n'
+            '        g_set_error (error,\n'
+            '                     MBIM_CORE_ERROR,\n'
+            '                     MBIM_CORE_ERROR_INVALID_MESSAGE,\n'
+            '                     \"Message does not have information buffer\");\n'
+            '        return FALSE;\n'
+            '    }\n')
+        return string.Template(template).substitute(translations)
 
-        if fields != []:
+    """
+    Emit the computation of the offset of the given field, reading only the
+    counters needed to skip the previous fields
+    """
+    def _emit_field_offset(self, fields, field_index, counters):
+        template = ''
+        pending = 0
+        for previous in fields[:field_index]:
+            translations = { 'previous'            : utils.build_underscore_name_from_camelcase(previous['name']),
+                             'previous_size_field' : utils.build_underscore_name_from_camelcase(previous['array-size-field']) if 'array-size-field' in previous else '' }
+            if previous['name'] in counters:
+                if pending:
+                    template += ('    offset += %d;\n' % pending)
+                    pending = 0
+                template += string.Template(
+                    '    if (!_mbim_message_read_guint32 (message, offset, &_${previous}, error))\n'
+                    '        return FALSE;\n').substitute(translations)
+                pending = 4
+            elif 'available-if' in previous:
+                # Fields not available take no space at all
+                if pending:
+                    template += ('    offset += %d;\n' % pending)
+                    pending = 0
+                condition = previous['available-if']
+                translations['condition_field'] = utils.build_underscore_name_from_camelcase(condition['field'])
+                translations['condition_operation'] = condition['operation']
+                translations['condition_value'] = condition['value']
+                if previous['format'] == 'ref-struct-array':
+                    # The skip is bounded by the message, so it never wraps around
+                    template += string.Template(
+                        '    if ((_${condition_field} ${condition_operation} ${condition_value}) &&\n'
+                        '        !_mbim_message_skip_array (message, &offset, _${previous_size_field}, 8, error))\n'
+                        '        return FALSE;\n').substitute(translations)
+                else:
+                    translations['size'] = str(utils.fixed_field_size(previous))
+                    template += string.Template(
+                        '    if (_${condition_field} ${condition_operation} ${condition_value})\n'
+                        '        offset += ${size};\n').substitute(translations)
+            elif previous['format'] in ['ref-struct-array', 'string-array']:
+                if pending:
+                    template += ('    offset += %d;\n' % pending)
+                    pending = 0
+                template += string.Template(
+                    '    if (!_mbim_message_skip_array (message, &offset, _${previous_size_field}, 8, error))\n'
+                    '        return FALSE;\n').substitute(translations)
+            elif previous['format'] == 'ref-byte-array':
+                pending += 8
+            else:
+                pending += utils.fixed_field_size(previous)
+        if pending:
+            template += ('    offset += %d;\n' % pending)
+        if field_index > 0:
+            template += '\n'
+        return template
+
+    """
+    Indices of the struct array fields that can be visited element by element
+    """
+    def visitable_fields(self, fields):
+        visitable = []
+        for field_index, field in enumerate(fields):
+            if field['format'] not in ['struct-array', 'ref-struct-array', 'ms-struct-array']:
+                continue
+            if field['struct-type'] not in self.viewable_structs:
+                continue
+            if self._field_offset_computable(fields, field_index, True):
+                visitable.append(field_index)
+        return visitable
+
+    """
+    Emit the methods to visit the struct arrays of a response or notification
+    """
+    def _emit_message_visitors(self, hfile, cfile, message_type, fields):
+        translations = { 'underscore'   : utils.build_underscore_name (self.fullname),
+                         'message_type' : message_type }
+
+        for field_index in self.visitable_fields(fields):
+            field = fields[field_index]
+            translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
+            translations['name'] = field['name']
+            translations['struct'] = field['struct-type']
+            translations['struct_underscore'] = utils.build_underscore_name_from_camelcase(field['struct-type'])
+            translations['array_size_field'] = utils.build_underscore_name_from_camelcase(field['array-size-field']) if 'array-size-field' in field else ''
+            if 'available-if' in field:
+                translations['condition_name'] = field['available-if']['field']
+                translations['condition_field'] = utils.build_underscore_name_from_camelcase(field['available-if']['field'])
+                translations['condition_operation'] = field['available-if']['operation']
+                translations['condition_value'] = field['available-if']['value']
+
+            template = (
+                '\n'
+                '/**\n'
+                ' * ${underscore}_${message_type}_visit_${field}:\n'
+                ' * @message: the #MbimMessage.\n'
+                ' * @callback: (scope call): function to run for each #${struct} element.\n'
+                ' * @user_data: data to pass to @callback.\n'
+                ' * @error: return location for error or %NULL.\n'
+                ' *\n'
+                ' * Visits the \'${name}\' elements of the ${message_type} one by one, in\n'
+                ' * the same order as ${underscore}_${message_type}_parse() would\n'
+                ' * return them, but without copying them. The visit stops as soon as\n'
+                ' * @callback returns %FALSE.\n'
+                ' *\n'
+                ' * Each element is validated when reached, so @callback may have been\n'
+                ' * run for the previous elements when an error is returned.\n')
+            if 'available-if' in field:
+                template += (
+                    ' *\n'
+                    ' * The elements are only available when \'${condition_name}\' is\n'
+                    ' * %${condition_value}; otherwise @callback is never run.\n')
             template += (
-                '    GError *inner_error = NULL;\n'
+                ' *\n'
+                ' * Returns: %TRUE if the visit finished or was stopped by @callback,\n'
+                ' * %FALSE if @error is set.\n'
+                ' *\n'
+                ' * Since: 1.36\n'
+                ' */\n'
+                'gboolean ${underscore}_${message_type}_visit_${field} (\n'
+                '    const MbimMessage *message,\n'
+                '    ${struct}VisitFunc callback,\n'
+                '    gpointer user_data,\n'
+                '    GError **error);\n')
+            hfile.write(string.Template(template).substitute(translations))
+
+            counters = self._field_offset_counters(fields, field_index)
+
+            template = (
+                '\n'
+                'gboolean\n'
+                '${underscore}_${message_type}_visit_${field} (\n'
+                '    const MbimMessage *message,\n'
+                '    ${struct}VisitFunc callback,\n'
+                '    gpointer user_data,\n'
+                '    GError **error)\n'
+                '{\n'
                 '    guint32 offset = 0;\n')
+            for counter in counters:
+                template += ('    guint32 _' + utils.build_underscore_name_from_camelcase(counter) + ';\n')
+            template += (
+                '\n'
+                '    g_return_val_if_fail (callback != NULL, FALSE);\n'
+                '\n')
+            template += self._emit_message_type_checks(message_type).replace('$', '$$')
+            template += '\n'
+            template += self._emit_field_offset(fields, field_index, counters).replace('$', '$$')
 
-        for field in fields:
-            if 'always-read' in field:
-                translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
-                inner_template = ('    guint32 _${field};\n')
-                template += (string.Template(inner_template).substitute(translations))
+            if 'available-if' in field:
+                template += (
+                    '    if (!(_${condition_field} ${condition_operation} ${condition_value}))\n'
+                    '        return TRUE;\n'
+                    '\n')
 
-        for field in fields:
-            if 'personal-info' in field:
+            if field['format'] == 'struct-array':
                 template += (
-                    '    gboolean show_field;\n'
-                    '\n'
-                    '    show_field = mbim_utils_get_show_personal_info ();\n')
-                break
+                    '    return _mbim_message_visit_${struct_underscore}_struct_array (message, _${array_size_field}, offset, callback, user_data, error);\n')
+            elif field['format'] == 'ref-struct-array':
+                template += (
+                    '    return _mbim_message_visit_${struct_underscore}_ref_struct_array (message, _${array_size_field}, offset, callback, user_data, error);\n')
+            else:
+                template += (
+                    '    return _mbim_message_visit_${struct_underscore}_ms_struct_array (message, offset, callback, user_data, error);\n')
+            template += (
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
 
-        if fields != []:
-            if message_type == 'set' or message_type == 'query':
+    """
+    Indices of the struct array fields that can be read in place, i.e. arrays
+    of contiguous fixed-size structs
+    """
+    def peekable_fields(self, fields):
+        peekable = []
+        for field_index, field in enumerate(fields):
+            if field['format'] not in ['struct-array', 'ms-struct-array']:
+                continue
+            if field['struct-type'] not in self.overlay_structs:
+                continue
+            if self._field_offset_computable(fields, field_index):
+                peekable.append(field_index)
+        return peekable
+
+    """
+    Emit the methods to read the struct arrays of a response or notification
+    in place, as arrays of overlays pointing to the contents of the message
+    """
+    def _emit_message_peekers(self, hfile, cfile, message_type, fields):
+        translations = { 'underscore'   : utils.build_underscore_name (self.fullname),
+                         'message_type' : message_type }
+
+        for field_index in self.peekable_fields(fields):
+            field = fields[field_index]
+            translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
+            translations['name'] = field['name']
+            translations['struct'] = field['struct-type']
+            translations['array_size_field'] = utils.build_underscore_name_from_camelcase(field['array-size-field']) if 'array-size-field' in field else ''
+
+            template = (
+                '\n'
+                '/**\n'
+                ' * ${underscore}_${message_type}_peek_${field}:\n'
+                ' * @message: the #MbimMessage.\n'
+                ' * @out_count: (out): return location for the number of elements.\n'
+                ' * @out_array: (out) (transfer none) (array length=out_count): return location\n'
+                ' *  for the #${struct}Overlay elements, or %NULL if there are none.\n'
+                ' * @error: return location for error or %NULL.\n'
+                ' *\n'
+                ' * Reads the \'${name}\' elements of the ${message_type} in place. The\n'
+                ' * whole array is validated at once and nothing is copied or allocated;\n'
+                ' * @out_array points to the contents of @message and is only valid\n'
+                ' * while @message is alive.\n'
+                ' *\n'
+                ' * Returns: %TRUE if the array was read, %FALSE if @error is set.\n'
+                ' *\n'
+                ' * Since: 1.36\n'
+                ' */\n'
+                'gboolean ${underscore}_${message_type}_peek_${field} (\n'
+                '    const MbimMessage *message,\n'
+                '    guint32 *out_count,\n'
+                '    const ${struct}Overlay **out_array,\n'
+                '    GError **error);\n')
+            hfile.write(string.Template(template).substitute(translations))
+
+            counters = self._field_offset_counters(fields, field_index)
+
+            template = (
+                '\n'
+                'gboolean\n'
+                '${underscore}_${message_type}_peek_${field} (\n'
+                '    const MbimMessage *message,\n'
+                '    guint32 *out_count,\n'
+                '    const ${struct}Overlay **out_array,\n'
+                '    GError **error)\n'
+                '{\n'
+                '    guint32 offset = 0;\n'
+                '    guint32 array_offset;\n')
+            if field['format'] == 'ms-struct-array':
                 template += (
-                    '\n'
-                    '    if (!mbim_message_command_get_raw_information_buffer (message, NULL))\n'
-                    '        return NULL;\n')
-            elif message_type == 'response':
+                    '    guint32 array_size;\n')
+            for counter in counters:
+                template += ('    guint32 _' + utils.build_underscore_name_from_camelcase(counter) + ';\n')
+            template += (
+                '    MbimMessageCursor cursor;\n'
+                '\n'
+                '    g_return_val_if_fail (out_count != NULL, FALSE);\n'
+                '    g_return_val_if_fail (out_array != NULL, FALSE);\n'
+                '\n')
+            template += self._emit_message_type_checks(message_type).replace('$', '$$')
+            template += '\n'
+            template += self._emit_field_offset(fields, field_index, counters).replace('$', '$$')
+
+            if field['format'] == 'struct-array':
+                translations['count'] = '_' + translations['array_size_field']
                 template += (
+                    '    if (!_${array_size_field}) {\n'
+                    '        *out_count = 0;\n'
+                    '        *out_array = NULL;\n'
+                    '        return TRUE;\n'
+                    '    }\n'
                     '\n'
-                    '    if (!mbim_message_command_done_get_raw_information_buffer (message, NULL))\n'
-                    '        return NULL;\n')
-            elif message_type == 'notification':
+                    '    if (!_mbim_message_read_guint32 (message, offset, &array_offset, error))\n'
+                    '        return FALSE;\n')
+            else:
+                translations['count'] = 'array_size'
                 template += (
+                    '    if (!_mbim_message_read_guint32 (message, offset, &array_offset, error))\n'
+                    '        return FALSE;\n'
                     '\n'
-                    '    if (!mbim_message_indicate_status_get_raw_information_buffer (message, NULL))\n'
-                    '        return NULL;\n')
+                    '    if (!array_offset) {\n'
+                    '        *out_count = 0;\n'
+                    '        *out_array = NULL;\n'
+                    '        return TRUE;\n'
+                    '    }\n'
+                    '\n'
+                    '    if (!_mbim_message_read_guint32 (message, array_offset, &array_size, error))\n'
+                    '        return FALSE;\n'
+                    '    array_offset += 4;\n')
+            template += (
+                '\n'
+                '    _mbim_message_cursor_init (&cursor, message);\n'
+                '    if (!_mbim_message_cursor_check_array (&cursor, array_offset, ${count}, sizeof (${struct}Overlay), error))\n'
+                '        return FALSE;\n'
+                '\n'
+                '    *out_count = ${count};\n'
+                '    *out_array = ${count} ? (const ${struct}Overlay *) _mbim_message_cursor_peek (&cursor, array_offset) : NULL;\n'
+                '    return TRUE;\n'
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
 
-        template += (
-            '\n'
-            '    str = g_string_new ("");\n')
+    """
+    Indices of the TLV list fields that can be iterated in place, i.e. those
+    only preceded by fixed-size fields and TLVs
+    """
+    def tlv_iterable_fields(self, fields):
+        iterable = []
+        for field_index, field in enumerate(fields):
+            if field['format'] != 'tlv-list' or 'available-if' in field:
+                continue
+            for previous in fields[:field_index]:
+                if 'available-if' in previous:
+                    break
+                if previous['format'] in ['tlv', 'tlv-string', 'tlv-guint16-array']:
+                    continue
+                if utils.fixed_field_size(previous) is None:
+                    break
+            else:
+                iterable.append(field_index)
+        return iterable
 
-        for field in fields:
-            translations['field']                   = utils.build_underscore_name_from_camelcase(field['name'])
-            translations['field_format']            = field['format']
-            translations['field_format_underscore'] = utils.build_underscore_name_from_camelcase(field['format'])
-            translations['public']                  = field['public-format'] if 'public-format' in field else field['format']
-            translations['field_name']              = field['name']
-            translations['array_size_field']        = utils.build_underscore_name_from_camelcase(field['array-size-field']) if 'array-size-field' in field else ''
-            translations['struct_name']             = utils.build_underscore_name_from_camelcase(field['struct-type']) if 'struct-type' in field else ''
-            translations['struct_type']             = field['struct-type'] if 'struct-type' in field else ''
-            translations['array_size']              = field['array-size'] if 'array-size' in field else ''
+    """
+    Emit the methods to iterate the TLV lists of a response or notification
+    without copying the TLVs
+    """
+    def _emit_message_tlv_iterators(self, hfile, cfile, message_type, fields):
+        translations = { 'underscore'   : utils.build_underscore_name (self.fullname),
+                         'message_type' : message_type }
 
-            if 'personal-info' in field:
-                translations['if_show_field'] = 'if (show_field) '
-            else:
-                translations['if_show_field'] = ''
+        for field_index in self.tlv_iterable_fields(fields):
+            field = fields[field_index]
+            translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
+            translations['name'] = field['name']
 
-            inner_template = (
+            template = (
                 '\n'
-                '    g_string_append_printf (str, "%s  ${field_name} = ", line_prefix);\n')
+                '/**\n'
+                ' * ${underscore}_${message_type}_iter_init_${field}:\n'
+                ' * @message: the #MbimMessage.\n'
+                ' * @iter: (out caller-allocates): a #MbimTlvIter to initialize.\n'
+                ' * @error: return location for error or %NULL.\n'
+                ' *\n'
+                ' * Initializes @iter to go through the \'${name}\' TLVs of the\n'
+                ' * ${message_type} with mbim_tlv_iter_next(), in the same order as\n'
+                ' * ${underscore}_${message_type}_parse() would return them, but\n'
+                ' * without copying them.\n'
+                ' *\n'
+                ' * Returns: %TRUE if @iter was initialized, %FALSE if @error is set.\n'
+                ' *\n'
+                ' * Since: 1.36\n'
+                ' */\n'
+                'gboolean ${underscore}_${message_type}_iter_init_${field} (\n'
+                '    const MbimMessage *message,\n'
+                '    MbimTlvIter *iter,\n'
+                '    GError **error);\n')
+            hfile.write(string.Template(template).substitute(translations))
 
-            if 'available-if' in field:
-                condition = field['available-if']
-                translations['condition_field'] = utils.build_underscore_name_from_camelcase(condition['field'])
-                translations['condition_operation'] = condition['operation']
-                translations['condition_value'] = condition['value']
-                inner_template += (
-                    '    if (_${condition_field} ${condition_operation} ${condition_value}) {\n')
-            else:
-                inner_template += (
-                    '    {\n')
+            template = (
+                '\n'
+                'gboolean\n'
+                '${underscore}_${message_type}_iter_init_${field} (\n'
+                '    const MbimMessage *message,\n'
+                '    MbimTlvIter *iter,\n'
+                '    GError **error)\n'
+                '{\n'
+                '    guint32 offset = 0;\n')
+            previous_tlvs = [previous for previous in fields[:field_index] if previous['format'] in ['tlv', 'tlv-string', 'tlv-guint16-array']]
+            if previous_tlvs:
+                template += (
+                    '    guint32 bytes_read;\n')
+            template += (
+                '\n'
+                '    g_return_val_if_fail (iter != NULL, FALSE);\n'
+                '\n')
+            template += self._emit_message_type_checks(message_type).replace('$', '$$')
+            template += '\n'
+
+            pending = 0
+            for previous in fields[:field_index]:
+                if previous['format'] in ['tlv', 'tlv-string', 'tlv-guint16-array']:
+                    if pending:
+                        template += ('    offset += %d;\n' % pending)
+                        pending = 0
+                    template += (
+                        '    if (!_mbim_message_skip_tlv (message, offset, &bytes_read, error))\n'
+                        '        return FALSE;\n'
+                        '    offset += bytes_read;\n')
+                else:
+                    pending += utils.fixed_field_size(previous)
+            if pending:
+                template += ('    offset += %d;\n' % pending)
+            if field_index > 0:
+                template += '\n'
 
-            if 'always-read' in field:
-                inner_template += (
-                    '        if (!_mbim_message_read_guint32 (message, offset, &_${field}, &inner_error))\n'
-                    '            goto out;\n'
-                    '        offset += 4;\n'
-                    '        ${if_show_field}{\n'
-                    '            g_string_append_printf (str, "\'%" G_GUINT32_FORMAT "\'", _${field});\n'
-                    '        }\n')
+            template += (
+                '    return _mbim_message_tlv_iter_init (message, offset, iter, error);\n'
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
 
-            elif field['format'] == 'byte-array' or \
-                 field['format'] == 'unsized-byte-array' or \
-                 field['format'] == 'ref-byte-array' or \
-                 field['format'] == 'uicc-ref-byte-array' or \
-                 field['format'] == 'ref-byte-array-no-offset':
-                inner_template += (
+    """
+    Indices of the fields that can be read on their own with a lazy accessor
+    """
+    def accessor_fields(self, fields):
+        accessors = []
+        for field_index, field in enumerate(fields):
+            if field['format'] in ['tlv', 'tlv-string', 'tlv-guint16-array', 'tlv-list']:
+                continue
+            if self._field_offset_computable(fields, field_index):
+                accessors.append(field_index)
+        return accessors
+
+    """
+    Emit the lazy accessors of the fields of a response or notification,
+    which read a single field without parsing the previous ones
+    """
+    def _emit_message_accessors(self, hfile, cfile, message_type, fields):
+        translations = { 'message'      : self.name,
+                         'service'      : self.service,
+                         'underscore'   : utils.build_underscore_name (self.fullname),
+                         'message_type' : message_type }
+
+        for field_index in self.accessor_fields(fields):
+            field = fields[field_index]
+            translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
+            translations['name'] = field['name']
+            translations['format'] = field['format']
+            translations['public'] = field['public-format'] if 'public-format' in field else field['format']
+            translations['struct'] = field['struct-type'] if 'struct-type' in field else ''
+            translations['struct_underscore'] = utils.build_underscore_name_from_camelcase(translations['struct'])
+            translations['array_size'] = field['array-size'] if 'array-size' in field else ''
+            translations['array_size_field'] = utils.build_underscore_name_from_camelcase(field['array-size-field']) if 'array-size-field' in field else ''
+            translations['encoding'] = 'MBIM_STRING_ENCODING_UTF8' if 'encoding' in field and field['encoding'] == 'utf-8' else 'MBIM_STRING_ENCODING_UTF16'
+
+            # Output arguments, and their documentation
+            if field['format'] == 'byte-array':
+                doc = (' * @out_${field}: (out)(transfer none)(element-type guint8)(array fixed-size=${array_size}): return location for an array of ${array_size} #guint8 values. Do not free the returned value, it is owned by @message.\n')
+                args = ('    const guint8 **out_${field},\n')
+            elif field['format'] in ['unsized-byte-array', 'ref-byte-array', 'uicc-ref-byte-array']:
+                doc = (' * @out_${field}_size: (out): return location for the size of the ${field} array.\n'
+                       ' * @out_${field}: (out)(transfer none)(element-type guint8)(array length=out_${field}_size): return location for an array of #guint8 values. Do not free the returned value, it is owned by @message.\n')
+                args = ('    guint32 *out_${field}_size,\n'
+                        '    const guint8 **out_${field},\n')
+            elif field['format'] == 'uuid':
+                doc = (' * @out_${field}: (out)(transfer none): return location for a #MbimUuid. Do not free the returned value, it is owned by @message.\n')
+                args = ('    const MbimUuid **out_${field},\n')
+            elif field['format'] in ['guint16', 'guint32', 'guint64']:
+                doc = (' * @out_${field}: (out): return location for a #${public}.\n')
+                args = ('    ${public} *out_${field},\n')
+            elif field['format'] == 'string':
+                doc = (' * @out_${field}: (out)(transfer full): return location for a newly allocated string. Free the returned value with g_free().\n')
+                args = ('    gchar **out_${field},\n')
+            elif field['format'] == 'string-array':
+                doc = (' * @out_${field}: (out)(transfer full)(type GStrv): return location for a newly allocated array of strings. Free the returned value with g_strfreev().\n')
+                args = ('    gchar ***out_${field},\n')
+            elif field['format'] in ['struct', 'ms-struct']:
+                doc = (' * @out_${field}: (out)(nullable)(transfer full): return location for a newly allocated #${struct}. Free the returned value with ${struct_underscore}_free().\n')
+                args = ('    ${struct} **out_${field},\n')
+            elif field['format'] in ['struct-array', 'ref-struct-array']:
+                doc = (' * @out_${field}: (out)(nullable)(transfer full)(array zero-terminated=1)(element-type ${struct}): return location for a newly allocated array of #${struct} items. Free the returned value with ${struct_underscore}_array_free().\n')
+                args = ('    ${struct}Array **out_${field},\n')
+            elif field['format'] == 'ms-struct-array':
+                doc = (' * @out_${field}_count: (out): return location for a #guint32.\n'
+                       ' * @out_${field}: (out)(nullable)(transfer full)(array zero-terminated=1)(element-type ${struct}): return location for a newly allocated array of #${struct} items. Free the returned value with ${struct_underscore}_array_free().\n')
+                args = ('    guint32 *out_${field}_count,\n'
+                        '    ${struct}Array **out_${field},\n')
+            elif field['format'] in ['ref-ipv4', 'ref-ipv6']:
+                translations['ip'] = 'MbimIPv4' if field['format'] == 'ref-ipv4' else 'MbimIPv6'
+                doc = (' * @out_${field}: (out)(transfer none): return location for a #${ip}. Do not free the returned value, it is owned by @message.\n')
+                args = ('    const ${ip} **out_${field},\n')
+            elif field['format'] in ['ipv4-array', 'ipv6-array']:
+                translations['ip'] = 'MbimIPv4' if field['format'] == 'ipv4-array' else 'MbimIPv6'
+                doc = (' * @out_${field}: (out)(nullable)(transfer full)(array zero-terminated=1)(element-type ${ip}): return location for a newly allocated array of #${ip} items. Free the returned value with g_free().\n')
+                args = ('    ${ip} **out_${field},\n')
+            else:
+                raise ValueError('Cannot handle field type \'%s\' in accessor' % field['format'])
+
+            template = (
+                '\n'
+                '/**\n'
+                ' * ${underscore}_${message_type}_get_${field}:\n'
+                ' * @message: the #MbimMessage.\n' +
+                doc +
+                ' * @error: return location for error or %NULL.\n'
+                ' *\n'
+                ' * Gets the \'${name}\' field of the \'${message}\' ${message_type} command in the \'${service}\' service.\n'
+                ' *\n'
+                ' * Only the contents of the message needed to locate and read this field are\n'
+                ' * parsed, so this is cheaper than ${underscore}_${message_type}_parse() when\n'
+                ' * just one or two fields are required.\n'
+                ' *\n'
+                ' * Returns: %TRUE if the field was correctly read, %FALSE if @error is set.\n'
+                ' *\n'
+                ' * Since: 1.36\n'
+                ' */\n'
+                'gboolean ${underscore}_${message_type}_get_${field} (\n'
+                '    const MbimMessage *message,\n' +
+                args +
+                '    GError **error);\n')
+            hfile.write(string.Template(template).substitute(translations))
+
+            counters = self._field_offset_counters(fields, field_index)
+
+            template = (
+                '\n'
+                'gboolean\n'
+                '${underscore}_${message_type}_get_${field} (\n'
+                '    const MbimMessage *message,\n' +
+                args +
+                '    GError **error)\n'
+                '{\n'
+                '    guint32 offset = 0;\n')
+            for counter in counters:
+                template += ('    guint32 _' + utils.build_underscore_name_from_camelcase(counter) + ';\n')
+            if field['format'] in ['guint16', 'guint32', 'guint64'] and 'public-format' in field:
+                template += ('    ${format} aux;\n')
+            template += '\n'
+
+            if field['format'] in ['unsized-byte-array', 'ref-byte-array', 'uicc-ref-byte-array']:
+                template += ('    g_return_val_if_fail (out_${field}_size != NULL, FALSE);\n')
+            elif field['format'] == 'ms-struct-array':
+                template += ('    g_return_val_if_fail (out_${field}_count != NULL, FALSE);\n')
+            template += (
+                '    g_return_val_if_fail (out_${field} != NULL, FALSE);\n'
+                '\n')
+            template += self._emit_message_type_checks(message_type).replace('$', '$$')
+            template += '\n'
+            template += self._emit_field_offset(fields, field_index, counters).replace('$', '$$')
+
+            if field['format'] in ['guint16', 'guint32', 'guint64']:
+                if 'public-format' in field:
+                    template += (
+                        '    if (!_mbim_message_read_${format} (message, offset, &aux, error))\n'
+                        '        return FALSE;\n'
+                        '    *out_${field} = (${public})aux;\n'
+                        '    return TRUE;\n')
+                else:
+                    template += (
+                        '    return _mbim_message_read_${format} (message, offset, out_${field}, error);\n')
+            elif field['format'] == 'byte-array':
+                template += (
+                    '    return _mbim_message_read_byte_array (message, 0, offset, FALSE, FALSE, ${array_size}, out_${field}, NULL, error, FALSE);\n')
+            elif field['format'] == 'unsized-byte-array':
+                template += (
+                    '    return _mbim_message_read_byte_array (message, 0, offset, FALSE, FALSE, 0, out_${field}, out_${field}_size, error, FALSE);\n')
+            elif field['format'] == 'ref-byte-array':
+                template += (
+                    '    return _mbim_message_read_byte_array (message, 0, offset, TRUE, TRUE, 0, out_${field}, out_${field}_size, error, FALSE);\n')
+            elif field['format'] == 'uicc-ref-byte-array':
+                template += (
+                    '    return _mbim_message_read_byte_array (message, 0, offset, TRUE, TRUE, 0, out_${field}, out_${field}_size, error, TRUE);\n')
+            elif field['format'] == 'uuid':
+                template += (
+                    '    return _mbim_message_read_uuid (message, offset, out_${field}, NULL, error);\n')
+            elif field['format'] == 'string':
+                template += (
+                    '    return _mbim_message_read_string (message, 0, offset, ${encoding}, out_${field}, NULL, error);\n')
+            elif field['format'] == 'string-array':
+                template += (
+                    '    return _mbim_message_read_string_array (message, _${array_size_field}, 0, offset, ${encoding}, out_${field}, error);\n')
+            elif field['format'] == 'struct':
+                template += (
+                    '    *out_${field} = _mbim_message_read_${struct_underscore}_struct (message, offset, 0, NULL, error);\n'
+                    '    return (*out_${field} != NULL);\n')
+            elif field['format'] == 'ms-struct':
+                template += (
+                    '    return _mbim_message_read_${struct_underscore}_ms_struct (message, offset, out_${field}, error);\n')
+            elif field['format'] == 'struct-array':
+                template += (
+                    '    return _mbim_message_read_${struct_underscore}_struct_array (message, _${array_size_field}, offset, out_${field}, error);\n')
+            elif field['format'] == 'ref-struct-array':
+                template += (
+                    '    return _mbim_message_read_${struct_underscore}_ref_struct_array (message, _${array_size_field}, offset, out_${field}, error);\n')
+            elif field['format'] == 'ms-struct-array':
+                template += (
+                    '    return _mbim_message_read_${struct_underscore}_ms_struct_array (message, offset, out_${field}_count, out_${field}, error);\n')
+            elif field['format'] == 'ref-ipv4':
+                template += (
+                    '    return _mbim_message_read_ipv4 (message, offset, TRUE, out_${field}, NULL, error);\n')
+            elif field['format'] == 'ref-ipv6':
+                template += (
+                    '    return _mbim_message_read_ipv6 (message, offset, TRUE, out_${field}, NULL, error);\n')
+            elif field['format'] == 'ipv4-array':
+                template += (
+                    '    return _mbim_message_read_ipv4_array (message, _${array_size_field}, offset, out_${field}, error);\n')
+            elif field['format'] == 'ipv6-array':
+                template += (
+                    '    return _mbim_message_read_ipv6_array (message, _${array_size_field}, offset, out_${field}, error);\n')
+            template += (
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
+
+    """
+    Emit the reading of a field already validated through the cursor; returns
+    an empty template if the field is not read through the cursor
+    """
+    def _emit_message_parser_fixed_field(self, field, translations):
+        translations['cast'] = '(' + field['public-format'] + ') ' if 'public-format' in field else ''
+        if 'always-read' in field:
+            template = (
+                '        _${field} = _mbim_message_cursor_get_guint32 (&cursor, offset);\n'
+                '        if (out_${field} != NULL)\n'
+                '            *out_${field} = _${field};\n'
+                '        offset += 4;\n')
+        elif field['format'] == 'byte-array':
+            template = (
+                '        if (out_${field} != NULL)\n'
+                '            *out_${field} = _mbim_message_cursor_peek (&cursor, offset);\n'
+                '        offset += ${array_size};\n')
+        elif field['format'] == 'uuid':
+            # NOTE: The output MbimUuid address would be broken if the contents of the message are misaligned.
+            template = (
+                '        if (out_${field} != NULL)\n'
+                '            *out_${field} = (const MbimUuid *) _mbim_message_cursor_peek (&cursor, offset);\n'
+                '        offset += 16;\n')
+        elif field['format'] == 'guint16':
+            template = (
+                '        if (out_${field} != NULL)\n'
+                '            *out_${field} = ${cast}_mbim_message_cursor_get_guint16 (&cursor, offset);\n'
+                '        offset += 2;\n')
+        elif field['format'] == 'guint32':
+            template = (
+                '        if (out_${field} != NULL)\n'
+                '            *out_${field} = ${cast}_mbim_message_cursor_get_guint32 (&cursor, offset);\n'
+                '        offset += 4;\n')
+        elif field['format'] == 'guint64':
+            template = (
+                '        if (out_${field} != NULL)\n'
+                '            *out_${field} = ${cast}_mbim_message_cursor_get_guint64 (&cursor, offset);\n'
+                '        offset += 8;\n')
+        else:
+            template = ''
+        return template
+
+
+    """
+    Emit message printable
+    """
+    def _emit_message_printable(self, cfile, message_type, fields):
+        translations = { 'message'            : self.name,
+                         'underscore'         : utils.build_underscore_name(self.name),
+                         'service'            : self.service,
+                         'underscore'         : utils.build_underscore_name (self.fullname),
+                         'message_type'       : message_type,
+                         'message_type_upper' : message_type.upper() }
+        template = (
+            '\n'
+            'static gchar *\n'
+            '${underscore}_${message_type}_get_printable (\n'
+            '    const MbimMessage *message,\n'
+            '    const gchar *line_prefix,\n'
+            '    GError **error)\n'
+            '{\n')
+
+        if self._codec_supported(fields):
+            template += (
+                '    return _mbim_message_codec_print (message, &${underscore}_${message_type}_codec, line_prefix);\n'
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
+            return
+
+        template += (
+            '    GString *str;\n')
+
+        if fields != []:
+            template += (
+                '    GError *inner_error = NULL;\n'
+                '    guint32 offset = 0;\n')
+
+        for field in fields:
+            if 'always-read' in field:
+                translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
+                inner_template = ('    guint32 _${field};\n')
+                template += (string.Template(inner_template).substitute(translations))
+
+        for field in fields:
+            if 'personal-info' in field:
+                template += (
+                    '    gboolean show_field;\n'
+                    '\n'
+                    '    show_field = mbim_utils_get_show_personal_info ();\n')
+                break
+
+        if fields != []:
+            if message_type == 'set' or message_type == 'query':
+                template += (
+                    '\n'
+                    '    if (!mbim_message_command_get_raw_information_buffer (message, NULL))\n'
+                    '        return NULL;\n')
+            elif message_type == 'response':
+                template += (
+                    '\n'
+                    '    if (!mbim_message_command_done_get_raw_information_buffer (message, NULL))\n'
+                    '        return NULL;\n')
+            elif message_type == 'notification':
+                template += (
+                    '\n'
+                    '    if (!mbim_message_indicate_status_get_raw_information_buffer (message, NULL))\n'
+                    '        return NULL;\n')
+
+        template += (
+            '\n'
+            '    str = g_string_new ("");\n')
+
+        for field in fields:
+            translations['field']                   = utils.build_underscore_name_from_camelcase(field['name'])
+            translations['field_format']            = field['format']
+            translations['field_format_underscore'] = utils.build_underscore_name_from_camelcase(field['format'])
+            translations['public']                  = field['public-format'] if 'public-format' in field else field['format']
+            translations['field_name']              = field['name']
+            translations['array_size_field']        = utils.build_underscore_name_from_camelcase(field['array-size-field']) if 'array-size-field' in field else ''
+            translations['struct_name']             = utils.build_underscore_name_from_camelcase(field['struct-type']) if 'struct-type' in field else ''
+            translations['struct_type']             = field['struct-type'] if 'struct-type' in field else ''
+            translations['array_size']              = field['array-size'] if 'array-size' in field else ''
+
+            if 'personal-info' in field:
+                translations['if_show_field'] = 'if (show_field) '
+            else:
+                translations['if_show_field'] = ''
+
+            inner_template = (
+                '\n'
+                '    g_string_append_printf (str, "%s  ${field_name} = ", line_prefix);\n')
+
+            if 'available-if' in field:
+                condition = field['available-if']
+                translations['condition_field'] = utils.build_underscore_name_from_camelcase(condition['field'])
+                translations['condition_operation'] = condition['operation']
+                translations['condition_value'] = condition['value']
+                inner_template += (
+                    '    if (_${condition_field} ${condition_operation} ${condition_value}) {\n')
+            else:
+                inner_template += (
+                    '    {\n')
+
+            if 'always-read' in field:
+                inner_template += (
+                    '        if (!_mbim_message_read_guint32 (message, offset, &_${field}, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += 4;\n'
+                    '        ${if_show_field}{\n'
+                    '            g_string_append_printf (str, "\'%" G_GUINT32_FORMAT "\'", _${field});\n'
+                    '        }\n')
+
+            elif field['format'] == 'byte-array' or \
+                 field['format'] == 'unsized-byte-array' or \
+                 field['format'] == 'ref-byte-array' or \
+                 field['format'] == 'uicc-ref-byte-array' or \
+                 field['format'] == 'ref-byte-array-no-offset':
+                inner_template += (
                     '        guint i;\n'
                     '        const guint8 *tmp;\n'
                     '        guint32 tmpsize;\n'
@@ -1686,6 +2650,413 @@ class Message:
         cfile.write(string.Template(template).substitute(translations))
 
 
+    """
+    Emit the message JSON serializer
+    """
+    def _emit_message_json(self, cfile, message_type, fields):
+        translations = { 'underscore'         : utils.build_underscore_name (self.fullname),
+                         'message_type'       : message_type }
+        template = (
+            '\n'
+            'static gboolean\n'
+            '${underscore}_${message_type}_get_json (\n'
+            '    const MbimMessage *message,\n'
+            '    GString *output,\n'
+            '    GError **error)\n'
+            '{\n')
+
+        if fields == []:
+            template += (
+                '    g_string_append (output, "{}");\n'
+                '    return TRUE;\n'
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
+            return
+
+        template += (
+            '    GError *inner_error = NULL;\n'
+            '    guint32 offset = 0;\n')
+
+        for field in fields:
+            if 'always-read' in field:
+                translations['field'] = utils.build_underscore_name_from_camelcase(field['name'])
+                inner_template = ('    guint32 _${field};\n')
+                template += (string.Template(inner_template).substitute(translations))
+
+        for field in fields:
+            if 'personal-info' in field:
+                template += (
+                    '    gboolean show_field;\n'
+                    '\n'
+                    '    show_field = mbim_utils_get_show_personal_info ();\n')
+                break
+
+        if message_type == 'set' or message_type == 'query':
+            template += (
+                '\n'
+                '    if (!mbim_message_command_get_raw_information_buffer (message, NULL)) {\n')
+        elif message_type == 'response':
+            template += (
+                '\n'
+                '    if (!mbim_message_command_done_get_raw_information_buffer (message, NULL)) {\n')
+        elif message_type == 'notification':
+            template += (
+                '\n'
+                '    if (!mbim_message_indicate_status_get_raw_information_buffer (message, NULL)) {\n')
+        template += (
+            '        g_string_append (output, "null");\n'
+            '        return TRUE;\n'
+            '    }\n'
+            '\n'
+            '    g_string_append_c (output, \'{\');\n')
+
+        for field in fields:
+            translations['field']            = utils.build_underscore_name_from_camelcase(field['name'])
+            translations['field_format']     = field['format']
+            translations['public']           = field['public-format'] if 'public-format' in field else field['format']
+            translations['field_name']       = field['name']
+            translations['array_size_field'] = utils.build_underscore_name_from_camelcase(field['array-size-field']) if 'array-size-field' in field else ''
+            translations['struct_name']      = utils.build_underscore_name_from_camelcase(field['struct-type']) if 'struct-type' in field else ''
+            translations['struct_type']      = field['struct-type'] if 'struct-type' in field else ''
+            translations['array_size']       = field['array-size'] if 'array-size' in field else ''
+
+            if 'available-if' in field:
+                condition = field['available-if']
+                translations['condition_field'] = utils.build_underscore_name_from_camelcase(condition['field'])
+                translations['condition_operation'] = condition['operation']
+                translations['condition_value'] = condition['value']
+                inner_template = (
+                    '\n'
+                    '    if (_${condition_field} ${condition_operation} ${condition_value}) {\n')
+            else:
+                inner_template = (
+                    '\n'
+                    '    {\n')
+
+            # Read the field
+            if 'always-read' in field:
+                inner_template += (
+                    '        if (!_mbim_message_read_guint32 (message, offset, &_${field}, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += 4;\n')
+                value_template = (
+                    'g_string_append_printf (output, "%" G_GUINT32_FORMAT, _${field});\n')
+
+            elif field['format'] == 'byte-array' or \
+                 field['format'] == 'unsized-byte-array' or \
+                 field['format'] == 'ref-byte-array' or \
+                 field['format'] == 'uicc-ref-byte-array' or \
+                 field['format'] == 'ref-byte-array-no-offset':
+                inner_template += (
+                    '        const guint8 *tmp;\n'
+                    '        guint32 tmpsize;\n'
+                    '\n')
+                if field['format'] == 'byte-array':
+                    inner_template += (
+                        '        if (!_mbim_message_read_byte_array (message, 0, offset, FALSE, FALSE, ${array_size}, &tmp, NULL, &inner_error, FALSE))\n'
+                        '            goto out;\n'
+                        '        tmpsize = ${array_size};\n'
+                        '        offset += ${array_size};\n')
+                elif field['format'] == 'unsized-byte-array':
+                    inner_template += (
+                        '        if (!_mbim_message_read_byte_array (message, 0, offset, FALSE, FALSE, 0, &tmp, &tmpsize, &inner_error, FALSE))\n'
+                        '            goto out;\n'
+                        '        offset += tmpsize;\n')
+                elif field['format'] == 'ref-byte-array':
+                    inner_template += (
+                        '        if (!_mbim_message_read_byte_array (message, 0, offset, TRUE, TRUE, 0, &tmp, &tmpsize, &inner_error, FALSE))\n'
+                        '            goto out;\n'
+                        '        offset += 8;\n')
+                elif field['format'] == 'uicc-ref-byte-array':
+                    inner_template += (
+                        '        if (!_mbim_message_read_byte_array (message, 0, offset, TRUE, TRUE, 0, &tmp, &tmpsize, &inner_error, TRUE))\n'
+                        '            goto out;\n'
+                        '        offset += 8;\n')
+                elif field['format'] == 'ref-byte-array-no-offset':
+                    inner_template += (
+                        '        if (!_mbim_message_read_byte_array (message, 0, offset, FALSE, TRUE, 0, &tmp, &tmpsize, &inner_error, FALSE))\n'
+                        '            goto out;\n'
+                        '        offset += 4;\n')
+                value_template = (
+                    '_mbim_json_append_hex (output, tmp, tmpsize);\n')
+
+            elif field['format'] == 'uuid':
+                inner_template += (
+                    '        MbimUuid tmp;\n'
+                    '\n'
+                    '        if (!_mbim_message_read_uuid (message, offset, NULL, &tmp, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += 16;\n')
+                value_template = (
+                    '_mbim_json_append_uuid (output, &tmp);\n')
+
+            elif field['format'] == 'guint16' or \
+                 field['format'] == 'guint32' or \
+                 field['format'] == 'guint64':
+                translations['field_size'] = { 'guint16' : 2, 'guint32' : 4, 'guint64' : 8 }[field['format']]
+                inner_template += (
+                    '        ${field_format} tmp;\n'
+                    '\n'
+                    '        if (!_mbim_message_read_${field_format} (message, offset, &tmp, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += ${field_size};\n')
+
+                if 'public-format' in field:
+                    if field['public-format'] == 'gboolean':
+                        value_template = (
+                            '_mbim_json_append_boolean (output, !!tmp);\n')
+                    else:
+                        translations['public_underscore']       = utils.build_underscore_name_from_camelcase(field['public-format'])
+                        translations['public_underscore_upper'] = utils.build_underscore_name_from_camelcase(field['public-format']).upper()
+                        value_template = (
+                            '#if defined __${public_underscore_upper}_IS_ENUM__\n'
+                            '_mbim_json_append_enum (output, ${public_underscore}_get_string ((${public})tmp), tmp);\n'
+                            '#elif defined __${public_underscore_upper}_IS_FLAGS__\n'
+                            '_mbim_json_append_flags (output, ${public_underscore}_get_type (), tmp);\n'
+                            '#else\n'
+                            '# error neither enum nor flags\n'
+                            '#endif\n')
+                elif field['format'] == 'guint16':
+                    value_template = (
+                        'g_string_append_printf (output, "%" G_GUINT16_FORMAT, tmp);\n')
+                elif field['format'] == 'guint32':
+                    value_template = (
+                        'g_string_append_printf (output, "%" G_GUINT32_FORMAT, tmp);\n')
+                else:
+                    value_template = (
+                        'g_string_append_printf (output, "%" G_GUINT64_FORMAT, tmp);\n')
+
+            elif field['format'] == 'string':
+                inner_template += (
+                    '        MbimStringView tmp;\n'
+                    '\n'
+                    '        if (!_mbim_message_read_string_view (message, 0, offset, &tmp, NULL, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += 8;\n')
+                if 'encoding' in field and field['encoding'] == 'utf-8':
+                    value_template = (
+                        '_mbim_json_append_utf8 (output, tmp.data, tmp.size);\n')
+                else:
+                    value_template = (
+                        '_mbim_json_append_utf16 (output, &tmp);\n')
+
+            elif field['format'] == 'string-array':
+                if 'encoding' in field and field['encoding'] == 'utf-8':
+                    translations['append_string'] = '_mbim_json_append_utf8 (output, tmp.data, tmp.size)'
+                else:
+                    translations['append_string'] = '_mbim_json_append_utf16 (output, &tmp)'
+                # Strings are read one by one while serializing them
+                inner_template += (
+                    '        guint32 array_offset;\n'
+                    '\n'
+                    '        array_offset = offset;\n'
+                    '        offset += (8 * _${array_size_field});\n')
+                value_template = (
+                    'guint i;\n'
+                    '\n'
+                    'g_string_append_c (output, \'[\');\n'
+                    'for (i = 0; i < _${array_size_field}; i++) {\n'
+                    '    MbimStringView tmp;\n'
+                    '\n'
+                    '    if (!_mbim_message_read_string_view (message, 0, array_offset + (8 * i), &tmp, NULL, &inner_error))\n'
+                    '        goto out;\n'
+                    '    _mbim_json_append_separator (output);\n'
+                    '    ${append_string};\n'
+                    '}\n'
+                    'g_string_append_c (output, \']\');\n')
+
+            elif field['format'] == 'struct':
+                inner_template += (
+                    '        g_autoptr(${struct_type}) tmp = NULL;\n'
+                    '        guint32 bytes_read = 0;\n'
+                    '\n'
+                    '        tmp = _mbim_message_read_${struct_name}_struct (message, offset, 0, &bytes_read, &inner_error);\n'
+                    '        if (!tmp)\n'
+                    '            goto out;\n'
+                    '        offset += bytes_read;\n')
+                value_template = (
+                    '_mbim_message_json_${struct_name}_struct (tmp, output);\n')
+
+            elif field['format'] == 'ms-struct':
+                inner_template += (
+                    '        g_autoptr(${struct_type}) tmp = NULL;\n'
+                    '\n'
+                    '        if (!_mbim_message_read_${struct_name}_ms_struct (message, offset, &tmp, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += 8;\n')
+                value_template = (
+                    'if (tmp)\n'
+                    '    _mbim_message_json_${struct_name}_struct (tmp, output);\n'
+                    'else\n'
+                    '    g_string_append (output, "null");\n')
+
+            elif field['format'] == 'struct-array' or field['format'] == 'ref-struct-array' or field['format'] == 'ms-struct-array':
+                inner_template += (
+                    '        g_autoptr(${struct_type}Array) tmp = NULL;\n')
+                if field['format'] == 'ms-struct-array':
+                    inner_template += (
+                        '        guint32 tmp_count = 0;\n'
+                        '\n'
+                        '        if (!_mbim_message_read_${struct_name}_ms_struct_array (message, offset, &tmp_count, &tmp, &inner_error))\n'
+                        '            goto out;\n'
+                        '        offset += 8;\n')
+                    translations['struct_array_size'] = 'tmp_count'
+                elif field['format'] == 'struct-array':
+                    inner_template += (
+                        '\n'
+                        '        if (!_mbim_message_read_${struct_name}_struct_array (message, _${array_size_field}, offset, &tmp, &inner_error))\n'
+                        '            goto out;\n'
+                        '        offset += 4;\n')
+                    translations['struct_array_size'] = '_' + translations['array_size_field']
+                else:
+                    inner_template += (
+                        '\n'
+                        '        if (!_mbim_message_read_${struct_name}_ref_struct_array (message, _${array_size_field}, offset, &tmp, &inner_error))\n'
+                        '            goto out;\n'
+                        '        offset += (8 * _${array_size_field});\n')
+                    translations['struct_array_size'] = '_' + translations['array_size_field']
+                value_template = (
+                    'guint i;\n'
+                    '\n'
+                    'g_string_append_c (output, \'[\');\n'
+                    'for (i = 0; i < ${struct_array_size}; i++) {\n'
+                    '    _mbim_json_append_separator (output);\n'
+                    '    _mbim_message_json_${struct_name}_struct (tmp[i], output);\n'
+                    '}\n'
+                    'g_string_append_c (output, \']\');\n')
+
+            elif field['format'] == 'ref-ipv4' or \
+                 field['format'] == 'ref-ipv6':
+                translations['ip'] = 'ipv4' if field['format'] == 'ref-ipv4' else 'ipv6'
+                translations['ip_type'] = 'MbimIPv4' if field['format'] == 'ref-ipv4' else 'MbimIPv6'
+                inner_template += (
+                    '        const ${ip_type} *tmp;\n'
+                    '\n'
+                    '        if (!_mbim_message_read_${ip} (message, offset, TRUE, &tmp, NULL, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += 4;\n')
+                value_template = (
+                    'if (tmp)\n'
+                    '    _mbim_json_append_${ip} (output, tmp);\n'
+                    'else\n'
+                    '    g_string_append (output, "null");\n')
+
+            elif field['format'] == 'ipv4-array' or \
+                 field['format'] == 'ipv6-array':
+                translations['ip'] = 'ipv4' if field['format'] == 'ipv4-array' else 'ipv6'
+                translations['ip_type'] = 'MbimIPv4' if field['format'] == 'ipv4-array' else 'MbimIPv6'
+                inner_template += (
+                    '        g_autofree ${ip_type} *tmp = NULL;\n'
+                    '\n'
+                    '        if (!_mbim_message_read_${ip}_array (message, _${array_size_field}, offset, &tmp, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += 4;\n')
+                value_template = (
+                    'guint i;\n'
+                    '\n'
+                    'g_string_append_c (output, \'[\');\n'
+                    'for (i = 0; tmp && i < _${array_size_field}; i++) {\n'
+                    '    _mbim_json_append_separator (output);\n'
+                    '    _mbim_json_append_${ip} (output, &tmp[i]);\n'
+                    '}\n'
+                    'g_string_append_c (output, \']\');\n')
+
+            elif field['format'] == 'tlv' or \
+                 field['format'] == 'tlv-string' or \
+                 field['format'] == 'tlv-guint16-array':
+                inner_template += (
+                    '        g_autoptr(MbimTlv) tmp = NULL;\n'
+                    '        guint32 bytes_read = 0;\n'
+                    '\n'
+                    '        if (!_mbim_message_read_tlv (message, offset, &tmp, &bytes_read, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += bytes_read;\n')
+                value_template = (
+                    '_mbim_json_append_tlv (output, tmp);\n')
+
+            elif field['format'] == 'tlv-list':
+                inner_template += (
+                    '        g_autolist(MbimTlv) tmp = NULL;\n'
+                    '        guint32 bytes_read = 0;\n'
+                    '\n'
+                    '        if (!_mbim_message_read_tlv_list (message, offset, &tmp, &bytes_read, &inner_error))\n'
+                    '            goto out;\n'
+                    '        offset += bytes_read;\n')
+                value_template = (
+                    'GList *walker;\n'
+                    '\n'
+                    'g_string_append_c (output, \'[\');\n'
+                    'for (walker = tmp; walker; walker = g_list_next (walker)) {\n'
+                    '    _mbim_json_append_separator (output);\n'
+                    '    _mbim_json_append_tlv (output, (MbimTlv *)walker->data);\n'
+                    '}\n'
+                    'g_string_append_c (output, \']\');\n')
+
+            else:
+                raise ValueError('Field format \'%s\' not serializable' % field['format'])
+
+            # Write the field; values with their own variables get their own block
+            inner_template += (
+                '\n'
+                '        _mbim_json_append_key (output, "${field_name}");\n')
+            value_block = ('\n\n' in value_template)
+            if 'personal-info' in field:
+                inner_template += (
+                    '        if (!show_field)\n'
+                    '            g_string_append (output, "\\"###\\"");\n'
+                    '        else {\n')
+                value_block = True
+            elif value_block:
+                inner_template += (
+                    '        {\n')
+            indent = '            ' if value_block else '        '
+            for line in value_template.split('\n')[:-1]:
+                if line == '' or line.startswith('#'):
+                    inner_template += line + '\n'
+                else:
+                    inner_template += indent + line + '\n'
+            if value_block:
+                inner_template += (
+                    '        }\n')
+
+            inner_template += (
+                '    }\n')
+
+            template += (string.Template(inner_template).substitute(translations))
+
+        template += (
+            '\n'
+            '    g_string_append_c (output, \'}\');\n'
+            '\n'
+            ' out:\n'
+            '    if (inner_error) {\n'
+            '        g_propagate_error (error, inner_error);\n'
+            '        return FALSE;\n'
+            '    }\n'
+            '    return TRUE;\n'
+            '}\n')
+        cfile.write(string.Template(template).substitute(translations))
+
+
+    """
+    Build the section entries of the methods reading single fields of a
+    response or notification, one per line and per field
+    """
+    def _section_field_methods(self, message_type, fields):
+        translations = { 'underscore'   : utils.build_underscore_name(self.fullname),
+                         'message_type' : message_type }
+        entries = ''
+        for (method, field_indices) in [ ('visit',     self.visitable_fields(fields)),
+                                         ('peek',      self.peekable_fields(fields)),
+                                         ('iter_init', self.tlv_iterable_fields(fields)),
+                                         ('get',       self.accessor_fields(fields)) ]:
+            translations['method'] = method
+            for field_index in field_indices:
+                translations['field'] = utils.build_underscore_name_from_camelcase(fields[field_index]['name'])
+                entries += string.Template('${underscore}_${message_type}_${method}_${field}\n').substitute(translations)
+        return entries
+
+
     """
     Emit the section content
     """
@@ -1701,19 +3072,29 @@ class Message:
         if self.has_query:
             template = (
                 '${underscore}_query_new\n')
+            for (field_index, offset) in self.patchable_fields(self.query):
+                translations['field'] = utils.build_underscore_name_from_camelcase(self.query[field_index]['name'])
+                template += string.Template(
+                    '${underscore}_query_${field}_offset\n').substitute(translations).upper()
             sfile.write(string.Template(template).substitute(translations))
 
         if self.has_set:
             template = (
                 '${underscore}_set_new\n')
+            for (field_index, offset) in self.patchable_fields(self.set):
+                translations['field'] = utils.build_underscore_name_from_camelcase(self.set[field_index]['name'])
+                template += string.Template(
+                    '${underscore}_set_${field}_offset\n').substitute(translations).upper()
             sfile.write(string.Template(template).substitute(translations))
 
         if self.has_response:
             template = (
                 '${underscore}_response_parse\n')
             sfile.write(string.Template(template).substitute(translations))
+            sfile.write(self._section_field_methods('response', self.response))
 
         if self.has_notification:
             template = (
                 '${underscore}_notification_parse\n')
             sfile.write(string.Template(template).substitute(translations))
+            sfile.write(self._section_field_methods('notification', self.notification))
@@ -43,10 +43,13 @@ class ObjectList:
     """
     Constructor
     """
-    def __init__(self, objects_dictionary):
+    def __init__(self, objects_dictionary, tables = False):
         self.command_list = []
         self.struct_list = []
         self.service_list = []
+        # All commands, including the ones without any message implemented,
+        # which are only used to report the command capabilities
+        self.cid_list = []
 
         # Loop items in the list, creating Message objects for the messages
         service_iter = ''
@@ -57,7 +60,10 @@ class ObjectList:
             if object_dictionary['type'] == 'Command':
                 if service_iter == '':
                     raise ValueError('Service name not specified before the first command')
-                self.command_list.append(Message(service_iter, mbimex_service_iter, mbimex_version_iter, object_dictionary))
+                command = Message(service_iter, mbimex_service_iter, mbimex_version_iter, object_dictionary, tables)
+                self.cid_list.append(command)
+                if command.has_query or command.has_set or command.has_response or command.has_notification:
+                    self.command_list.append(command)
             elif object_dictionary['type'] == 'Struct':
                 self.struct_list.append(Struct(service_iter, mbimex_service_iter, mbimex_version_iter, object_dictionary))
             elif object_dictionary['type'] == 'Service':
@@ -83,6 +89,23 @@ class ObjectList:
                 set_struct_usage(struct, command.response)
                 set_struct_usage(struct, command.notification)
 
+        # Populate the struct arrays visited element by element
+        viewable_structs = [struct.name for struct in self.struct_list if struct.viewable()]
+        overlay_structs = [struct.name for struct in self.struct_list if struct.size > 0]
+        for command in self.command_list:
+            command.viewable_structs = viewable_structs
+            command.overlay_structs = overlay_structs
+            for fields in [command.response, command.notification]:
+                for field_index in command.visitable_fields(fields):
+                    field = fields[field_index]
+                    for struct in self.struct_list:
+                        if struct.name == field['struct-type'] and field['format'] not in struct.visit_formats:
+                            struct.visit_formats.append(field['format'])
+                for field_index in command.peekable_fields(fields):
+                    for struct in self.struct_list:
+                        if struct.name == fields[field_index]['struct-type']:
+                            struct.overlay = True
+
     """
     Emit the structs and commands handling implementation
     """
@@ -95,6 +118,15 @@ class ObjectList:
             item.emit(hfile, cfile)
 
 
+    """
+    Emit only the field tables of the messages supported by the generic codec,
+    exported so that they can be used directly (e.g. in tests)
+    """
+    def emit_codec_tables(self, hfile, cfile):
+        for item in self.command_list:
+            item.emit_codec_tables(hfile, cfile)
+
+
     """
     Emit support for printing messages in a single service
     """
@@ -243,6 +275,154 @@ class ObjectList:
         hfile.write(template)
 
 
+    """
+    Emit support for serializing messages in a single service
+    """
+    def emit_json_service(self, hfile, cfile, service):
+        translations = { 'service_underscore' : utils.build_underscore_name(service),
+                         'service'            : service }
+
+        template = (
+            '\n'
+            'G_GNUC_INTERNAL\n'
+            'gboolean\n'
+            '__mbim_message_${service_underscore}_get_json_fields (\n'
+            '    const MbimMessage *message,\n'
+            '    GString *output,\n'
+            '    GError **error);\n')
+        hfile.write(string.Template(template).substitute(translations))
+
+        template = (
+            '\n'
+            'static const GetJsonCallbacks ${service_underscore}_get_json_callbacks[] = {\n')
+
+        for item in self.command_list:
+            if item.service == service:
+                translations['message'] = utils.build_underscore_name (item.fullname)
+                translations['cid']     = item.cid_enum_name
+                inner_template = (
+                    '    [${cid}] = {\n')
+                if item.has_query:
+                    inner_template += (
+                        '        .query_cb = ${message}_query_get_json,\n')
+                if item.has_set:
+                    inner_template += (
+                        '        .set_cb = ${message}_set_get_json,\n')
+                if item.has_response:
+                    inner_template += (
+                        '        .response_cb = ${message}_response_get_json,\n')
+                if item.has_notification:
+                    inner_template += (
+                        '        .notification_cb = ${message}_notification_get_json,\n')
+                inner_template += (
+                    '    },\n')
+                template += (string.Template(inner_template).substitute(translations))
+
+        template += (
+            '};\n'
+            '\n'
+            'gboolean\n'
+            '__mbim_message_${service_underscore}_get_json_fields (\n'
+            '    const MbimMessage *message,\n'
+            '    GString *output,\n'
+            '    GError **error)\n'
+            '{\n'
+            '    guint32 cid;\n'
+            '\n'
+            '    switch (mbim_message_get_message_type (message)) {\n'
+            '        case MBIM_MESSAGE_TYPE_COMMAND: {\n'
+            '            cid = mbim_message_command_get_cid (message);\n'
+            '            if (cid < G_N_ELEMENTS (${service_underscore}_get_json_callbacks)) {\n'
+            '                switch (mbim_message_command_get_command_type (message)) {\n'
+            '                    case MBIM_MESSAGE_COMMAND_TYPE_QUERY:\n'
+            '                        if (${service_underscore}_get_json_callbacks[cid].query_cb)\n'
+            '                            return ${service_underscore}_get_json_callbacks[cid].query_cb (message, output, error);\n'
+            '                        break;\n'
+            '                    case MBIM_MESSAGE_COMMAND_TYPE_SET:\n'
+            '                        if (${service_underscore}_get_json_callbacks[cid].set_cb)\n'
+            '                            return ${service_underscore}_get_json_callbacks[cid].set_cb (message, output, error);\n'
+            '                        break;\n'
+            '                    case MBIM_MESSAGE_COMMAND_TYPE_UNKNOWN:\n'
+            '                    default:\n'
+            '                        g_set_error (error,\n'
+            '                                     MBIM_CORE_ERROR,\n'
+            '                                     MBIM_CORE_ERROR_INVALID_MESSAGE,\n'
+            '                                     \"Invalid command type\");\n'
+            '                        return FALSE;\n'
+            '                }\n'
+            '            }\n'
+            '            break;\n'
+            '        }\n'
+            '\n'
+            '        case MBIM_MESSAGE_TYPE_COMMAND_DONE:\n'
+            '            cid = mbim_message_command_done_get_cid (message);\n'
+            '            if (cid < G_N_ELEMENTS (${service_underscore}_get_json_callbacks)) {\n'
+            '                if (${service_underscore}_get_json_callbacks[cid].response_cb)\n'
+            '                    return ${service_underscore}_get_json_callbacks[cid].response_cb (message, output, error);\n'
+            '            }\n'
+            '            break;\n'
+            '\n'
+            '        case MBIM_MESSAGE_TYPE_INDICATE_STATUS:\n'
+            '            cid = mbim_message_indicate_status_get_cid (message);\n'
+            '            if (cid < G_N_ELEMENTS (${service_underscore}_get_json_callbacks)) {\n'
+            '                if (${service_underscore}_get_json_callbacks[cid].notification_cb)\n'
+            '                    return ${service_underscore}_get_json_callbacks[cid].notification_cb (message, output, error);\n'
+            '            }\n'
+            '            break;\n'
+            '\n'
+            '        case MBIM_MESSAGE_TYPE_OPEN:\n'
+            '        case MBIM_MESSAGE_TYPE_CLOSE:\n'
+            '        case MBIM_MESSAGE_TYPE_INVALID:\n'
+            '        case MBIM_MESSAGE_TYPE_HOST_ERROR:\n'
+            '        case MBIM_MESSAGE_TYPE_OPEN_DONE:\n'
+            '        case MBIM_MESSAGE_TYPE_CLOSE_DONE:\n'
+            '        case MBIM_MESSAGE_TYPE_FUNCTION_ERROR:\n'
+            '        default:\n'
+            '            g_set_error (error,\n'
+            '                         MBIM_CORE_ERROR,\n'
+            '                         MBIM_CORE_ERROR_INVALID_MESSAGE,\n'
+            '                         \"No contents expected in this message type\");\n'
+            '            return FALSE;\n'
+            '    }\n'
+            '\n'
+            '    g_set_error (error,\n'
+            '                 MBIM_CORE_ERROR,\n'
+            '                 MBIM_CORE_ERROR_UNSUPPORTED,\n'
+            '                 \"Unsupported message\");\n'
+            '    return FALSE;\n'
+            '}\n')
+
+        cfile.write(string.Template(template).substitute(translations))
+
+    def emit_json(self, hfile, cfile):
+
+        template = (
+            '\n'
+            '/*****************************************************************************/\n'
+            '/* Service helpers for JSON fields */\n'
+            '\n'
+            '#if defined (LIBMBIM_GLIB_COMPILATION)\n')
+        hfile.write(template)
+
+        template = (
+            '\n'
+            'typedef struct {\n'
+            '  gboolean (* query_cb)        (const MbimMessage *message, GString *output, GError **error);\n'
+            '  gboolean (* set_cb)          (const MbimMessage *message, GString *output, GError **error);\n'
+            '  gboolean (* response_cb)     (const MbimMessage *message, GString *output, GError **error);\n'
+            '  gboolean (* notification_cb) (const MbimMessage *message, GString *output, GError **error);\n'
+            '} GetJsonCallbacks;\n')
+        cfile.write(template)
+
+        for service in self.service_list:
+            self.emit_json_service(hfile, cfile, service)
+
+        template = (
+            '\n'
+            '#endif\n')
+        hfile.write(template)
+
+
     """
     Emit the section for a single service
     """
@@ -274,3 +454,83 @@ class ObjectList:
     def emit_sections(self, sfile):
         for service in self.service_list:
             self.emit_sections_service(sfile, service)
+
+
+    """
+    Emit the CID descriptor tables of all the services, indexed by service and
+    CID; commands defined in several files (e.g. the MBIMEx updates of a
+    service) are merged into the same descriptor
+    """
+    def emit_cid_tables(self, cfile):
+        services = {}
+        for command in self.cid_list:
+            if command.service_enum_name not in services:
+                services[command.service_enum_name] = {}
+            cids = services[command.service_enum_name]
+            if command.cid_enum_name not in cids:
+                cids[command.cid_enum_name] = { 'name'  : utils.build_dashed_name(command.name if command.name != '' else command.service),
+                                                'flags' : [] }
+            flags = cids[command.cid_enum_name]['flags']
+            for (allowed, flag) in [ (command.has_set or 'set' in command.not_implemented,                   'MBIM_CID_FLAG_CAN_SET'),
+                                     (command.has_query or 'query' in command.not_implemented,               'MBIM_CID_FLAG_CAN_QUERY'),
+                                     (command.has_notification or 'notification' in command.not_implemented, 'MBIM_CID_FLAG_CAN_NOTIFY'),
+                                     (command.has_set,                                                        'MBIM_CID_FLAG_SET_MESSAGE'),
+                                     (command.has_query,                                                      'MBIM_CID_FLAG_QUERY_MESSAGE'),
+                                     (command.has_response,                                                   'MBIM_CID_FLAG_RESPONSE_MESSAGE'),
+                                     (command.has_notification,                                               'MBIM_CID_FLAG_NOTIFICATION_MESSAGE') ]:
+                if allowed and flag not in flags:
+                    flags.append(flag)
+
+        cfile.write(
+            '\n'
+            '#include "mbim-cid-private.h"\n')
+
+        for service_enum_name, cids in services.items():
+            translations = { 'service_enum_name'  : service_enum_name,
+                             'service_underscore' : utils.remove_prefix(service_enum_name, 'MBIM_SERVICE_').lower(),
+                             'service_dashed'     : utils.remove_prefix(service_enum_name, 'MBIM_SERVICE_').lower().replace('_', '-') }
+            template = (
+                '\n'
+                '/*****************************************************************************/\n'
+                '/* ${service_enum_name} */\n'
+                '\n'
+                'static const MbimCidDescriptor ${service_underscore}_cid_descriptors[] = {\n')
+            for cid_enum_name, cid in cids.items():
+                # Keep the flags in the order they are declared
+                flags = [ flag for flag in [ 'MBIM_CID_FLAG_CAN_SET',
+                                             'MBIM_CID_FLAG_CAN_QUERY',
+                                             'MBIM_CID_FLAG_CAN_NOTIFY',
+                                             'MBIM_CID_FLAG_SET_MESSAGE',
+                                             'MBIM_CID_FLAG_QUERY_MESSAGE',
+                                             'MBIM_CID_FLAG_RESPONSE_MESSAGE',
+                                             'MBIM_CID_FLAG_NOTIFICATION_MESSAGE' ] if flag in cid['flags'] ]
+                inner_translations = { 'cid'   : cid_enum_name,
+                                       'name'  : cid['name'],
+                                       'flags' : ' |\n                        '.join(flags) if flags else 'MBIM_CID_FLAG_NONE' }
+                inner_template = (
+                    '    [${cid}] = {\n'
+                    '        .service_name = "${service_dashed}",\n'
+                    '        .name         = "${name}",\n'
+                    '        .flags        = ${flags},\n'
+                    '    },\n')
+                template += string.Template(inner_template).substitute(dict(translations, **inner_translations))
+            template += (
+                '};\n')
+            cfile.write(string.Template(template).substitute(translations))
+
+        template = (
+            '\n'
+            '/*****************************************************************************/\n'
+            '\n'
+            'const MbimCidTable _mbim_cid_tables[MBIM_SERVICE_LAST] = {\n')
+        for service_enum_name in services:
+            translations = { 'service_enum_name'  : service_enum_name,
+                             'service_underscore' : utils.remove_prefix(service_enum_name, 'MBIM_SERVICE_').lower() }
+            template += string.Template(
+                '    [${service_enum_name}] = {\n'
+                '        .descriptors   = ${service_underscore}_cid_descriptors,\n'
+                '        .n_descriptors = G_N_ELEMENTS (${service_underscore}_cid_descriptors),\n'
+                '    },\n').substitute(translations)
+        template += (
+            '};\n')
+        cfile.write(template)
@@ -35,6 +35,12 @@ class Struct:
         self.ref_struct_array_member = False
         self.struct_array_member = False
         self.ms_struct_array_member = False
+        # The array formats in which the struct elements are visited one by
+        # one. Will be updated after having created the object.
+        self.visit_formats = []
+        # Whether the arrays of the struct are read in place through a packed
+        # overlay type. Will be updated after having created the object.
+        self.overlay = False
 
         # Check whether the struct is composed of fixed-sized fields
         self.size = 0
@@ -58,6 +64,21 @@ class Struct:
                 break
 
 
+    """
+    Whether the struct can be read as a view borrowing the contents of the
+    message, i.e. without any field requiring a memory allocation
+    """
+    def viewable(self):
+        for field in self.contents:
+            if field['format'] in ['guint16', 'guint32', 'gint32', 'guint64', 'uuid', 'ipv4', 'ipv6', 'byte-array',
+                                   'unsized-byte-array', 'ref-byte-array', 'ref-byte-array-no-offset']:
+                continue
+            if field['format'] == 'string' and not ('encoding' in field and field['encoding'] == 'utf-8'):
+                continue
+            return False
+        return True
+
+
     """
     Emit the new struct type
     """
@@ -500,6 +521,196 @@ class Struct:
             '}\n')
         cfile.write(string.Template(template).substitute(translations))
 
+    """
+    Emit the type's JSON serializer
+    """
+    def _emit_json(self, cfile):
+        translations = { 'name'            : self.name,
+                         'name_underscore' : utils.build_underscore_name_from_camelcase(self.name) }
+
+        template = (
+            '\n'
+            'static void\n'
+            '_mbim_message_json_${name_underscore}_struct (\n'
+            '    const ${name} *self,\n'
+            '    GString *output)\n'
+            '{\n')
+
+        for field in self.contents:
+            if 'personal-info' in field:
+                template += (
+                    '    gboolean show_field;\n'
+                    '\n'
+                    '    show_field = mbim_utils_get_show_personal_info ();\n')
+                break
+
+        template += (
+            '\n'
+            '    g_string_append_c (output, \'{\');\n')
+
+        for field in self.contents:
+            translations['field_name']              = field['name']
+            translations['field_name_underscore']   = utils.build_underscore_name_from_camelcase(field['name'])
+            translations['public']                  = field['public-format'] if 'public-format' in field else field['format']
+            translations['public_underscore']       = utils.build_underscore_name_from_camelcase(field['public-format']) if 'public-format' in field else ''
+            translations['public_underscore_upper'] = utils.build_underscore_name_from_camelcase(field['public-format']).upper() if 'public-format' in field else ''
+
+            inner_template = (
+                '\n'
+                '    _mbim_json_append_key (output, "${field_name}");\n')
+
+            if 'personal-info' in field:
+                inner_template += (
+                    '    if (!show_field)\n'
+                    '        g_string_append (output, "\\"###\\"");\n'
+                    '    else {\n')
+            else:
+                inner_template += (
+                    '    {\n')
+
+            if field['format'] == 'uuid':
+                inner_template += (
+                    '        _mbim_json_append_uuid (output, &(self->${field_name_underscore}));\n')
+
+            elif field['format'] in ['byte-array', 'ref-byte-array', 'ref-byte-array-no-offset', 'unsized-byte-array']:
+                if field['format'] == 'byte-array':
+                    translations['array_size'] = field['array-size']
+                elif 'array-size-field' in field:
+                    translations['array_size'] = 'self->' + utils.build_underscore_name_from_camelcase(field['array-size-field'])
+                else:
+                    translations['array_size'] = 'self->' + translations['field_name_underscore'] + '_size'
+                inner_template += (
+                    '        _mbim_json_append_hex (output, self->${field_name_underscore}, ${array_size});\n')
+
+            elif field['format'] in ['guint16', 'guint32', 'guint64']:
+                if 'public-format' in field:
+                    if field['public-format'] == 'gboolean':
+                        inner_template += (
+                            '        _mbim_json_append_boolean (output, (${public})self->${field_name_underscore});\n')
+                    else:
+                        inner_template += (
+                            '#if defined __${public_underscore_upper}_IS_ENUM__\n'
+                            '        _mbim_json_append_enum (output, ${public_underscore}_get_string ((${public})self->${field_name_underscore}), self->${field_name_underscore});\n'
+                            '#elif defined __${public_underscore_upper}_IS_FLAGS__\n'
+                            '        _mbim_json_append_flags (output, ${public_underscore}_get_type (), self->${field_name_underscore});\n'
+                            '#else\n'
+                            '# error neither enum nor flags\n'
+                            '#endif\n')
+
+                elif field['format'] == 'guint16':
+                    inner_template += (
+                        '        g_string_append_printf (output, "%" G_GUINT16_FORMAT, self->${field_name_underscore});\n')
+                elif field['format'] == 'guint32':
+                    inner_template += (
+                        '        g_string_append_printf (output, "%" G_GUINT32_FORMAT, self->${field_name_underscore});\n')
+                elif field['format'] == 'guint64':
+                    inner_template += (
+                        '        g_string_append_printf (output, "%" G_GUINT64_FORMAT, self->${field_name_underscore});\n')
+
+            elif field['format'] == 'gint32':
+                inner_template += (
+                    '        g_string_append_printf (output, "%" G_GINT32_FORMAT, self->${field_name_underscore});\n')
+
+            elif field['format'] == 'guint32-array':
+                translations['array_size_field_name_underscore'] = utils.build_underscore_name_from_camelcase(field['array-size-field'])
+                inner_template += (
+                    '        guint i;\n'
+                    '\n'
+                    '        g_string_append_c (output, \'[\');\n'
+                    '        for (i = 0; i < self->${array_size_field_name_underscore}; i++) {\n'
+                    '            _mbim_json_append_separator (output);\n'
+                    '            g_string_append_printf (output, "%" G_GUINT32_FORMAT, self->${field_name_underscore}[i]);\n'
+                    '        }\n'
+                    '        g_string_append_c (output, \']\');\n')
+
+            elif field['format'] == 'string':
+                inner_template += (
+                    '        _mbim_json_append_string (output, self->${field_name_underscore});\n')
+
+            elif field['format'] == 'string-array':
+                translations['array_size_field_name_underscore'] = utils.build_underscore_name_from_camelcase(field['array-size-field'])
+                inner_template += (
+                    '        guint i;\n'
+                    '\n'
+                    '        g_string_append_c (output, \'[\');\n'
+                    '        for (i = 0; i < self->${array_size_field_name_underscore}; i++) {\n'
+                    '            _mbim_json_append_separator (output);\n'
+                    '            _mbim_json_append_string (output, self->${field_name_underscore}[i]);\n'
+                    '        }\n'
+                    '        g_string_append_c (output, \']\');\n')
+
+            elif field['format'] == 'ipv4':
+                inner_template += (
+                    '        _mbim_json_append_ipv4 (output, &(self->${field_name_underscore}));\n')
+
+            elif field['format'] == 'ipv6':
+                inner_template += (
+                    '        _mbim_json_append_ipv6 (output, &(self->${field_name_underscore}));\n')
+
+            else:
+                raise ValueError('Cannot handle format \'%s\' in struct' % field['format'])
+
+            inner_template += (
+                '    }\n')
+            template += (string.Template(inner_template).substitute(translations))
+
+        template += (
+            '\n'
+            '    g_string_append_c (output, \'}\');\n'
+            '}\n')
+        cfile.write(string.Template(template).substitute(translations))
+
+    """
+    Emit the reading of a struct field already validated through the cursor;
+    returns an empty template if the field is not read through the cursor
+    """
+    def _emit_read_fixed_field(self, field, translations):
+        if field['format'] == 'uuid':
+            template = (
+                '\n'
+                '    memcpy (&(out->${field_name_underscore}), _mbim_message_cursor_peek (&cursor, offset), 16);\n'
+                '    offset += 16;\n')
+        elif field['format'] == 'byte-array':
+            translations['array_size'] = field['array-size']
+            template = (
+                '\n'
+                '    memcpy (out->${field_name_underscore}, _mbim_message_cursor_peek (&cursor, offset), ${array_size});\n'
+                '    offset += ${array_size};\n')
+        elif field['format'] == 'guint16':
+            template = (
+                '\n'
+                '    out->${field_name_underscore} = _mbim_message_cursor_get_guint16 (&cursor, offset);\n'
+                '    offset += 2;\n')
+        elif field['format'] == 'guint32':
+            template = (
+                '\n'
+                '    out->${field_name_underscore} = _mbim_message_cursor_get_guint32 (&cursor, offset);\n'
+                '    offset += 4;\n')
+        elif field['format'] == 'gint32':
+            template = (
+                '\n'
+                '    out->${field_name_underscore} = _mbim_message_cursor_get_gint32 (&cursor, offset);\n'
+                '    offset += 4;\n')
+        elif field['format'] == 'guint64':
+            template = (
+                '\n'
+                '    out->${field_name_underscore} = _mbim_message_cursor_get_guint64 (&cursor, offset);\n'
+                '    offset += 8;\n')
+        elif field['format'] == 'ipv4':
+            template = (
+                '\n'
+                '    memcpy (&(out->${field_name_underscore}), _mbim_message_cursor_peek (&cursor, offset), 4);\n'
+                '    offset += 4;\n')
+        elif field['format'] == 'ipv6':
+            template = (
+                '\n'
+                '    memcpy (&(out->${field_name_underscore}), _mbim_message_cursor_peek (&cursor, offset), 16);\n'
+                '    offset += 16;\n')
+        else:
+            template = ''
+        return template
+
+
     """
     Emit the type's read methods
     """
@@ -525,6 +736,14 @@ class Struct:
             template += (
                 '    guint32 extra_bytes_read = 0;\n')
 
+        # The leading fixed-size fields are validated at once, and then read
+        # through the cursor without any further check
+        (fixed_size, fixed_count) = utils.fixed_size_prefix(self.contents)
+        translations['fixed_size'] = fixed_size
+        if fixed_count > 0:
+            template += (
+                '    MbimMessageCursor cursor;\n')
+
         template += (
             '\n'
             '    g_assert (self != NULL);\n'
@@ -532,11 +751,20 @@ class Struct:
             '    out = g_new0 (${name}, 1);\n'
             '\n')
 
-        for field in self.contents:
+        if fixed_count > 0:
+            template += (
+                '    _mbim_message_cursor_init (&cursor, self);\n'
+                '    if (!_mbim_message_cursor_check (&cursor, relative_offset, ${fixed_size}, error))\n'
+                '        goto out;\n')
+
+        for field_index, field in enumerate(self.contents):
             translations['field_name_underscore'] = utils.build_underscore_name_from_camelcase(field['name'])
 
             inner_template = ''
-            if field['format'] == 'uuid':
+            fixed_template = self._emit_read_fixed_field(field, translations) if field_index < fixed_count else ''
+            if fixed_template:
+                inner_template += fixed_template
+            elif field['format'] == 'uuid':
                 inner_template += (
                     '\n'
                     '    if (!_mbim_message_read_uuid (self, offset, NULL, &(out->${field_name_underscore}), error))\n'
@@ -915,6 +1143,449 @@ class Struct:
                 '}\n')
             cfile.write(string.Template(template).substitute(translations))
 
+    """
+    Emit the view type, borrowing the contents of the message, and the
+    callback type used when visiting arrays of the struct
+    """
+    def _emit_view_type(self, hfile):
+        translations = { 'name'  : self.name }
+        template = (
+            '\n'
+            '/**\n'
+            ' * ${name}View:\n')
+        for field in self.contents:
+            translations['field_name_underscore'] = utils.build_underscore_name_from_camelcase(field['name'])
+            translations['public'] = field['public-format'] if 'public-format' in field else ''
+            if field['format'] == 'uuid':
+                inner_template = (' * @${field_name_underscore}: a #MbimUuid.\n')
+            elif field['format'] == 'byte-array':
+                translations['array_size'] = field['array-size']
+                inner_template = (' * @${field_name_underscore}: an array of ${array_size} #guint8 values.\n')
+            elif field['format'] in ['unsized-byte-array', 'ref-byte-array', 'ref-byte-array-no-offset']:
+                inner_template = ''
+                if 'array-size-field' not in field:
+                    inner_template += (' * @${field_name_underscore}_size: size of the ${field_name_underscore} array.\n')
+                inner_template += (' * @${field_name_underscore}: an array of #guint8 values.\n')
+            elif field['format'] in ['guint16', 'guint32', 'guint64']:
+                translations['format'] = field['format']
+                if 'public-format' in field:
+                    inner_template = (' * @${field_name_underscore}: a #${public} given as a #${format}.\n')
+                else:
+                    inner_template = (' * @${field_name_underscore}: a #${format}.\n')
+            elif field['format'] == 'gint32':
+                inner_template = (' * @${field_name_underscore}: a #gint32.\n')
+            elif field['format'] == 'string':
+                inner_template = (' * @${field_name_underscore}: a #MbimStringView.\n')
+            elif field['format'] == 'ipv4':
+                inner_template = (' * @${field_name_underscore}: a #MbimIPv4.\n')
+            elif field['format'] == 'ipv6':
+                inner_template = (' * @${field_name_underscore}: a #MbimIPv6.\n')
+            else:
+                raise ValueError('Cannot handle format \'%s\' in struct view' % field['format'])
+            template += string.Template(inner_template).substitute(translations)
+
+        template += (
+            ' *\n'
+            ' * A #${name} element read without copying its strings and arrays,\n'
+            ' * which point to the contents of the message being visited and are\n'
+            ' * only valid during the #${name}VisitFunc call.\n'
+            ' *\n'
+            ' * Since: 1.36\n'
+            ' */\n'
+            'typedef struct {\n')
+        for field in self.contents:
+            translations['field_name_underscore'] = utils.build_underscore_name_from_camelcase(field['name'])
+            if field['format'] == 'uuid':
+                inner_template = ('    MbimUuid ${field_name_underscore};\n')
+            elif field['format'] == 'byte-array':
+                inner_template = ('    const guint8 *${field_name_underscore};\n')
+            elif field['format'] in ['unsized-byte-array', 'ref-byte-array', 'ref-byte-array-no-offset']:
+                inner_template = ''
+                if 'array-size-field' not in field:
+                    inner_template += ('    guint32 ${field_name_underscore}_size;\n')
+                inner_template += ('    const guint8 *${field_name_underscore};\n')
+            elif field['format'] in ['guint16', 'guint32', 'gint32', 'guint64']:
+                translations['format'] = field['format']
+                inner_template = ('    ${format} ${field_name_underscore};\n')
+            elif field['format'] == 'string':
+                inner_template = ('    MbimStringView ${field_name_underscore};\n')
+            elif field['format'] == 'ipv4':
+                inner_template = ('    MbimIPv4 ${field_name_underscore};\n')
+            elif field['format'] == 'ipv6':
+                inner_template = ('    MbimIPv6 ${field_name_underscore};\n')
+            template += string.Template(inner_template).substitute(translations)
+
+        template += (
+            '} ${name}View;\n'
+            '\n'
+            '/**\n'
+            ' * ${name}VisitFunc:\n'
+            ' * @view: a #${name}View.\n'
+            ' * @user_data: the data given when the visit was started.\n'
+            ' *\n'
+            ' * Function run for each #${name} element when visiting an array of them.\n'
+            ' *\n'
+            ' * Returns: %TRUE to continue with the next element, %FALSE to stop.\n'
+            ' *\n'
+            ' * Since: 1.36\n'
+            ' */\n'
+            'typedef gboolean (* ${name}VisitFunc) (const ${name}View *view, gpointer user_data);\n')
+        hfile.write(string.Template(template).substitute(translations))
+
+
+    """
+    Emit the methods to read the view of a single struct and to visit the
+    arrays of structs, without any memory allocation
+    """
+    def _emit_view_read(self, cfile):
+        translations = { 'name'            : self.name,
+                         'name_underscore' : utils.build_underscore_name_from_camelcase(self.name),
+                         'struct_size'     : self.size }
+
+        template = (
+            '\n'
+            'static gboolean\n'
+            '_mbim_message_view_${name_underscore}_struct (\n'
+            '    const MbimMessage *self,\n'
+            '    guint32 relative_offset,\n'
+            '    guint32 explicit_struct_size,\n'
+            '    guint32 *bytes_read,\n'
+            '    ${name}View *out,\n'
+            '    GError **error)\n'
+            '{\n'
+            '    guint32 offset = relative_offset;\n'
+            '    guint32 total_bytes_read;\n')
+        if self.ms_struct_array_member == True:
+            template += (
+                '    guint32 extra_bytes_read = 0;\n')
+
+        (fixed_size, fixed_count) = utils.fixed_size_prefix(self.contents)
+        translations['fixed_size'] = fixed_size
+        if fixed_count > 0:
+            template += (
+                '    MbimMessageCursor cursor;\n'
+                '\n'
+                '    _mbim_message_cursor_init (&cursor, self);\n'
+                '    if (!_mbim_message_cursor_check (&cursor, relative_offset, ${fixed_size}, error))\n'
+                '        return FALSE;\n')
+
+        for field_index, field in enumerate(self.contents):
+            translations['field_name_underscore'] = utils.build_underscore_name_from_camelcase(field['name'])
+
+            inner_template = ''
+            fixed_template = self._emit_read_fixed_field(field, translations) if field_index < fixed_count else ''
+            if fixed_template and field['format'] == 'byte-array':
+                # Borrowed, never copied
+                inner_template += (
+                    '\n'
+                    '    out->${field_name_underscore} = _mbim_message_cursor_peek (&cursor, offset);\n'
+                    '    offset += ${array_size};\n')
+            elif fixed_template:
+                inner_template += fixed_template
+            elif field['format'] == 'uuid':
+                inner_template += (
+                    '\n'
+                    '    if (!_mbim_message_read_uuid (self, offset, NULL, &(out->${field_name_underscore}), error))\n'
+                    '        return FALSE;\n'
+                    '    offset += 16;\n')
+            elif field['format'] in ['ref-byte-array', 'ref-byte-array-no-offset']:
+                translations['has_offset'] = 'TRUE' if field['format'] == 'ref-byte-array' else 'FALSE'
+                if 'array-size-field' in field:
+                    translations['array_size_field_name_underscore'] = utils.build_underscore_name_from_camelcase(field['array-size-field'])
+                    inner_template += (
+                        '\n'
+                        '    if (!_mbim_message_read_byte_array (self, relative_offset, offset, ${has_offset}, FALSE, out->${array_size_field_name_underscore}, &(out->${field_name_underscore}), NULL, error, FALSE))\n'
+                        '        return FALSE;\n'
+                        '    offset += 4;\n')
+                else:
+                    inner_template += (
+                        '\n'
+                        '    if (!_mbim_message_read_byte_array (self, relative_offset, offset, ${has_offset}, TRUE, 0, &(out->${field_name_underscore}), &(out->${field_name_underscore}_size), error, FALSE))\n'
+                        '        return FALSE;\n'
+                        '    offset += 8;\n')
+            elif field['format'] == 'unsized-byte-array':
+                if self.ref_struct_array_member == True:
+                    # Same as when reading the full struct, the length of the
+                    # OL pair defines the size of the trailing byte array
+                    inner_template += (
+                        '\n'
+                        '    out->${field_name_underscore}_size = explicit_struct_size - (offset - relative_offset);\n'
+                        '    if (!_mbim_message_read_byte_array (self, relative_offset, offset, FALSE, FALSE, out->${field_name_underscore}_size, &(out->${field_name_underscore}), NULL, error, FALSE))\n'
+                        '        return FALSE;\n')
+                else:
+                    inner_template += (
+                        '\n'
+                        '    if (!_mbim_message_read_byte_array (self, relative_offset, offset, FALSE, FALSE, 0, &(out->${field_name_underscore}), &(out->${field_name_underscore}_size), error, FALSE))\n'
+                        '        return FALSE;\n')
+                inner_template += (
+                    '    offset += out->${field_name_underscore}_size;\n')
+            elif field['format'] == 'byte-array':
+                translations['array_size'] = field['array-size']
+                inner_template += (
+                    '\n'
+                    '    if (!_mbim_message_read_byte_array (self, relative_offset, offset, FALSE, FALSE, ${array_size}, &(out->${field_name_underscore}), NULL, error, FALSE))\n'
+                    '        return FALSE;\n'
+                    '    offset += ${array_size};\n')
+            elif field['format'] in ['guint16', 'guint32', 'gint32', 'guint64']:
+                translations['format'] = field['format']
+                translations['format_size'] = utils.fixed_field_size(field)
+                inner_template += (
+                    '\n'
+                    '    if (!_mbim_message_read_${format} (self, offset, &out->${field_name_underscore}, error))\n'
+                    '        return FALSE;\n'
+                    '    offset += ${format_size};\n')
+            elif field['format'] == 'string':
+                if self.ms_struct_array_member == True:
+                    inner_template += (
+                        '\n'
+                        '    {\n'
+                        '        guint32 str_bytes_read;\n'
+                        '\n'
+                        '        if (!_mbim_message_read_string_view (self, relative_offset, offset, &out->${field_name_underscore}, &str_bytes_read, error))\n'
+                        '            return FALSE;\n'
+                        '        if (str_bytes_read % 4)\n'
+                        '            str_bytes_read = (str_bytes_read + (4 - (str_bytes_read % 4)));\n'
+                        '        extra_bytes_read += str_bytes_read;\n'
+                        '        offset += 8;\n'
+                        '    }\n')
+                else:
+                    inner_template += (
+                        '\n'
+                        '    if (!_mbim_message_read_string_view (self, relative_offset, offset, &out->${field_name_underscore}, NULL, error))\n'
+                        '        return FALSE;\n'
+                        '    offset += 8;\n')
+            elif field['format'] == 'ipv4':
+                inner_template += (
+                    '\n'
+                    '    if (!_mbim_message_read_ipv4 (self, offset, FALSE, NULL, &(out->${field_name_underscore}), error))\n'
+                    '        return FALSE;\n'
+                    '    offset += 4;\n')
+            elif field['format'] == 'ipv6':
+                inner_template += (
+                    '\n'
+                    '    if (!_mbim_message_read_ipv6 (self, offset, FALSE, NULL, &(out->${field_name_underscore}), error))\n'
+                    '        return FALSE;\n'
+                    '    offset += 16;\n')
+            else:
+                raise ValueError('Cannot handle format \'%s\' in struct view' % field['format'])
+
+            template += string.Template(inner_template).substitute(translations)
+
+        template += (
+            '\n'
+            '    total_bytes_read = (offset - relative_offset);\n')
+        if self.ms_struct_array_member == True:
+            template += (
+                '    total_bytes_read += extra_bytes_read;\n')
+        template += (
+            '    if (explicit_struct_size && total_bytes_read > explicit_struct_size) {\n'
+            '        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,\n'
+            '                     \"Read %u bytes from struct with size %u\", total_bytes_read, explicit_struct_size);\n'
+            '        return FALSE;\n'
+            '    }\n'
+            '    if (bytes_read)\n'
+            '        *bytes_read = total_bytes_read;\n'
+            '    return TRUE;\n'
+            '}\n')
+        cfile.write(string.Template(template).substitute(translations))
+
+        # The arrays are visited element by element; an element is only
+        # validated when reached, so the callback may have already been run
+        # for the previous elements when an error is reported.
+        if 'struct-array' in self.visit_formats:
+            template = (
+                '\n'
+                'static gboolean\n'
+                '_mbim_message_visit_${name_underscore}_struct_array (\n'
+                '    const MbimMessage *self,\n'
+                '    guint32 array_size,\n'
+                '    guint32 relative_offset_array_start,\n'
+                '    ${name}VisitFunc callback,\n'
+                '    gpointer user_data,\n'
+                '    GError **error)\n'
+                '{\n'
+                '    guint32 i;\n'
+                '    guint32 offset;\n'
+                '\n'
+                '    if (!array_size)\n'
+                '        return TRUE;\n'
+                '\n'
+                '    if (!_mbim_message_read_guint32 (self, relative_offset_array_start, &offset, error))\n'
+                '        return FALSE;\n'
+                '\n'
+                '    for (i = 0; i < array_size; i++, offset += ${struct_size}) {\n'
+                '        ${name}View view;\n'
+                '\n'
+                '        if (!_mbim_message_view_${name_underscore}_struct (self, offset, ${struct_size}, NULL, &view, error))\n'
+                '            return FALSE;\n'
+                '        if (!callback (&view, user_data))\n'
+                '            break;\n'
+                '    }\n'
+                '    return TRUE;\n'
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
+
+        if 'ref-struct-array' in self.visit_formats:
+            template = (
+                '\n'
+                'static gboolean\n'
+                '_mbim_message_visit_${name_underscore}_ref_struct_array (\n'
+                '    const MbimMessage *self,\n'
+                '    guint32 array_size,\n'
+                '    guint32 relative_offset_array_start,\n'
+                '    ${name}VisitFunc callback,\n'
+                '    gpointer user_data,\n'
+                '    GError **error)\n'
+                '{\n'
+                '    guint32 i;\n'
+                '    guint32 offset;\n'
+                '\n'
+                '    offset = relative_offset_array_start;\n'
+                '    for (i = 0; i < array_size; i++, offset += 8) {\n'
+                '        guint32 tmp_offset;\n'
+                '        guint32 tmp_length;\n'
+                '        ${name}View view;\n'
+                '\n'
+                '        if (!_mbim_message_read_guint32 (self, offset, &tmp_offset, error))\n'
+                '            return FALSE;\n'
+                '        if (!_mbim_message_read_guint32 (self, offset + 4, &tmp_length, error))\n'
+                '            return FALSE;\n'
+                '\n'
+                '        if (!_mbim_message_view_${name_underscore}_struct (self, tmp_offset, tmp_length, NULL, &view, error))\n'
+                '            return FALSE;\n'
+                '        if (!callback (&view, user_data))\n'
+                '            break;\n'
+                '    }\n'
+                '    return TRUE;\n'
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
+
+        if 'ms-struct-array' in self.visit_formats:
+            template = (
+                '\n'
+                'static gboolean\n'
+                '_mbim_message_visit_${name_underscore}_ms_struct_array (\n'
+                '    const MbimMessage *self,\n'
+                '    guint32 offset,\n'
+                '    ${name}VisitFunc callback,\n'
+                '    gpointer user_data,\n'
+                '    GError **error)\n'
+                '{\n'
+                '    guint32 i;\n'
+                '    guint32 intermediate_struct_offset;\n'
+                '    guint32 array_size;\n'
+                '    guint32 bytes_read = 0;\n'
+                '\n'
+                '    if (!_mbim_message_read_guint32 (self, offset, &intermediate_struct_offset, error))\n'
+                '        return FALSE;\n'
+                '\n'
+                '    if (!intermediate_struct_offset)\n'
+                '        return TRUE;\n'
+                '\n'
+                '    if (!_mbim_message_read_guint32 (self, intermediate_struct_offset, &array_size, error))\n'
+                '        return FALSE;\n'
+                '    intermediate_struct_offset += 4;\n'
+                '\n'
+                '    for (i = 0; i < array_size; i++, intermediate_struct_offset += bytes_read) {\n'
+                '        ${name}View view;\n'
+                '\n'
+                '        if (!_mbim_message_view_${name_underscore}_struct (self, intermediate_struct_offset, 0, &bytes_read, &view, error))\n'
+                '            return FALSE;\n'
+                '        if (!callback (&view, user_data))\n'
+                '            break;\n'
+                '    }\n'
+                '    return TRUE;\n'
+                '}\n')
+            cfile.write(string.Template(template).substitute(translations))
+
+    """
+    Emit the packed overlay type with the wire layout of a fixed-size struct,
+    and the inline accessors converting its fields to host byte order
+    """
+    def _emit_overlay_type(self, hfile):
+        translations = { 'name'            : self.name,
+                         'name_underscore' : utils.build_underscore_name_from_camelcase(self.name),
+                         'struct_size'     : self.size }
+        template = (
+            '\n'
+            '/**\n'
+            ' * ${name}Overlay:\n'
+            ' *\n'
+            ' * The ${struct_size} bytes of a #${name} element as found in the message,\n'
+            ' * with all its fields in little endian byte order. Overlays point to\n'
+            ' * the contents of the message and may not be aligned, so they should\n'
+            ' * only be read with the ${name_underscore}_overlay_get_*() methods.\n'
+            ' *\n'
+            ' * Since: 1.36\n'
+            ' */\n'
+            '#define MBIM_PACKED __attribute__((__packed__))\n'
+            'typedef struct MBIM_PACKED {\n')
+        for field in self.contents:
+            translations['field_name_underscore'] = utils.build_underscore_name_from_camelcase(field['name'])
+            if field['format'] == 'uuid':
+                inner_template = ('    MbimUuid ${field_name_underscore};\n')
+            elif field['format'] == 'ipv4':
+                inner_template = ('    MbimIPv4 ${field_name_underscore};\n')
+            elif field['format'] == 'ipv6':
+                inner_template = ('    MbimIPv6 ${field_name_underscore};\n')
+            elif field['format'] == 'gint32':
+                inner_template = ('    guint32 ${field_name_underscore};\n')
+            else:
+                translations['format'] = field['format']
+                inner_template = ('    ${format} ${field_name_underscore};\n')
+            template += string.Template(inner_template).substitute(translations)
+        template += (
+            '} ${name}Overlay;\n'
+            '#undef MBIM_PACKED\n')
+        hfile.write(string.Template(template).substitute(translations))
+
+        for field in self.contents:
+            translations['field_name_underscore'] = utils.build_underscore_name_from_camelcase(field['name'])
+            template = (
+                '\n'
+                '/**\n'
+                ' * ${name_underscore}_overlay_get_${field_name_underscore}:\n'
+                ' * @self: a #${name}Overlay.\n'
+                ' *\n')
+            if field['format'] in ['uuid', 'ipv4', 'ipv6']:
+                translations['type'] = { 'uuid' : 'MbimUuid', 'ipv4' : 'MbimIPv4', 'ipv6' : 'MbimIPv6' }[field['format']]
+                template += (
+                    ' * Gets the \'${field_name_underscore}\' field of the element.\n'
+                    ' *\n'
+                    ' * Returns: (transfer none): the #${type}, owned by the message.\n'
+                    ' *\n'
+                    ' * Since: 1.36\n'
+                    ' */\n'
+                    'static inline const ${type} *\n'
+                    '${name_underscore}_overlay_get_${field_name_underscore} (const ${name}Overlay *self)\n'
+                    '{\n'
+                    '    return &self->${field_name_underscore};\n'
+                    '}\n')
+                hfile.write(string.Template(template).substitute(translations))
+                continue
+
+            translations['bits'] = { 'guint16' : '16', 'guint32' : '32', 'gint32' : '32', 'guint64' : '64' }[field['format']]
+            if field['format'] == 'gint32':
+                translations['type'] = 'gint32'
+            elif 'public-format' in field:
+                translations['type'] = field['public-format']
+            else:
+                translations['type'] = field['format']
+            template += (
+                ' * Gets the \'${field_name_underscore}\' field of the element, in host\n'
+                ' * byte order.\n'
+                ' *\n'
+                ' * Returns: a #${type}.\n'
+                ' *\n'
+                ' * Since: 1.36\n'
+                ' */\n'
+                'static inline ${type}\n'
+                '${name_underscore}_overlay_get_${field_name_underscore} (const ${name}Overlay *self)\n'
+                '{\n'
+                '    return (${type}) GUINT${bits}_FROM_LE (self->${field_name_underscore});\n'
+                '}\n')
+            hfile.write(string.Template(template).substitute(translations))
+
     """
     Emit the type's append methods
     """
@@ -1129,8 +1800,21 @@ class Struct:
         self._emit_free(hfile, cfile)
         # Emit type's read
         self._emit_read(cfile)
+        # Emit type's view and visitors
+        if self.visit_formats:
+            self._emit_view_type(hfile)
+            self._emit_view_read(cfile)
+        # Emit type's overlay
+        if self.overlay:
+            self._emit_overlay_type(hfile)
+            cfile.write(string.Template(
+                '\n'
+                'G_STATIC_ASSERT (sizeof (${name}Overlay) == ${struct_size});\n').substitute({ 'name'        : self.name,
+                                                                                         'struct_size' : self.size }))
         # Emit type's print
         self._emit_print(cfile)
+        # Emit type's JSON serializer
+        self._emit_json(cfile)
         # Emit type's append
         self._emit_append(cfile)
 
@@ -1153,4 +1837,13 @@ class Struct:
         if self.struct_array_member == True or self.ref_struct_array_member == True or self.ms_struct_array_member == True:
             template += (
                 '${name_underscore}_array_free\n')
+        if self.visit_formats:
+            template += (
+                '${struct_name}View\n'
+                '${struct_name}VisitFunc\n')
+        if self.overlay:
+            template += (
+                '${struct_name}Overlay\n')
+            for field in self.contents:
+                template += ('${name_underscore}_overlay_get_' + utils.build_underscore_name_from_camelcase(field['name']) + '\n')
         sfile.write(string.Template(template).substitute(translations))
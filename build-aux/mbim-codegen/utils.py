@@ -96,6 +96,8 @@ def add_source_start(f, output_name):
         "\n"
         "#include \"${name}.h\"\n"
         "#include \"mbim-message-private.h\"\n"
+        "#include \"mbim-message-codec.h\"\n"
+        "#include \"mbim-message-json.h\"\n"
         "#include \"mbim-tlv-private.h\"\n"
         "#include \"mbim-enum-types.h\"\n"
         "#include \"mbim-flag-types.h\"\n"
@@ -206,3 +208,43 @@ def version_compare(v1,v2):
         return -1
     # minor_v2 == minor_v1
     return 0
+
+"""
+Size of the given field within the message or struct, if always the same;
+fields referencing variable-size data by offset have a fixed size themselves.
+Returns None if the size of the field is only known when parsing.
+"""
+def fixed_field_size(field):
+    if field['format'] == 'guint16':
+        return 2
+    if field['format'] in ['guint32', 'gint32', 'ipv4', 'ref-ipv4', 'ref-ipv6', 'ipv4-array', 'ipv6-array', 'struct-array']:
+        return 4
+    if field['format'] in ['guint64', 'string', 'uicc-ref-byte-array', 'ms-struct', 'ms-struct-array']:
+        return 8
+    if field['format'] in ['uuid', 'ipv6']:
+        return 16
+    if field['format'] == 'byte-array':
+        return int(field['array-size'])
+    if field['format'] in ['ref-byte-array', 'ref-byte-array-no-offset']:
+        return 4 if 'array-size-field' in field else 8
+    return None
+
+"""
+Leading fields of a message or struct which are always at the same offset
+and have a fixed size, so that they can all be validated with a single
+bounds check before reading them.
+Returns the total size of those fields and how many they are.
+"""
+def fixed_size_prefix(fields):
+    size = 0
+    count = 0
+    for field in fields:
+        # Optional fields may not be there at all
+        if 'available-if' in field:
+            break
+        field_size = fixed_field_size(field)
+        if field_size is None:
+            break
+        size += field_size
+        count += 1
+    return (size, count)
@@ -0,0 +1,43 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libmbim-glib -- GLib/GIO based library to control MBIM devices
+ *
+ * This is a private non-installed header
+ */
+
+#ifndef _LIBMBIM_GLIB_MBIM_CID_PRIVATE_H_
+#define _LIBMBIM_GLIB_MBIM_CID_PRIVATE_H_
+
+#if !defined (LIBMBIM_GLIB_COMPILATION)
+#error "This is a private header!!"
+#endif
+
+#include <glib.h>
+
+#include "mbim-uuid.h"
+#include "mbim-cid.h"
+
+G_BEGIN_DECLS
+
+/*****************************************************************************/
+/* Command descriptors of the known services, generated from the service data
+ * files. The descriptors of each service are indexed by CID, and the entries
+ * for CIDs without a command (e.g. 0 or reserved ones) have a NULL name. */
+
+typedef struct {
+    const MbimCidDescriptor *descriptors;
+    guint                    n_descriptors;
+} MbimCidTable;
+
+extern const MbimCidTable _mbim_cid_tables[MBIM_SERVICE_LAST];
+
+/*****************************************************************************/
+/* Descriptor shared by all the commands of a custom service, implemented along
+ * with the custom service registry. */
+
+const MbimCidDescriptor *_mbim_custom_service_get_cid_descriptor (guint service);
+
+G_END_DECLS
+
+#endif /* _LIBMBIM_GLIB_MBIM_CID_PRIVATE_H_ */
@@ -240,15 +240,21 @@ typedef enum { /*< since=1.26 >*/
  * @MBIM_CID_PROXY_CONTROL_UNKNOWN: Unknown command.
  * @MBIM_CID_PROXY_CONTROL_CONFIGURATION: Configuration.
  * @MBIM_CID_PROXY_CONTROL_VERSION: MBIM and MBIMEx Version reporting.
+ * @MBIM_CID_PROXY_CONTROL_CLIENT_SETTINGS: Per-client settings. Since 1.36.
+ * @MBIM_CID_PROXY_CONTROL_STATISTICS: Proxy statistics. Since 1.36.
+ * @MBIM_CID_PROXY_CONTROL_SHARED_MEMORY: Shared memory transport setup. Since 1.36.
  *
  * MBIM commands in the %MBIM_SERVICE_PROXY_CONTROL service.
  *
  * Since: 1.10
  */
 typedef enum { /*< since=1.10 >*/
-    MBIM_CID_PROXY_CONTROL_UNKNOWN       = 0,
-    MBIM_CID_PROXY_CONTROL_CONFIGURATION = 1,
-    MBIM_CID_PROXY_CONTROL_VERSION       = 2,
+    MBIM_CID_PROXY_CONTROL_UNKNOWN         = 0,
+    MBIM_CID_PROXY_CONTROL_CONFIGURATION   = 1,
+    MBIM_CID_PROXY_CONTROL_VERSION         = 2,
+    MBIM_CID_PROXY_CONTROL_CLIENT_SETTINGS = 3,
+    MBIM_CID_PROXY_CONTROL_STATISTICS      = 4,
+    MBIM_CID_PROXY_CONTROL_SHARED_MEMORY   = 5,
 } MbimCidProxyControl;
 
 /**
@@ -587,6 +593,70 @@ gboolean mbim_cid_can_notify (MbimService service,
 const gchar *mbim_cid_get_printable (MbimService service,
                                      guint       cid);
 
+/**
+ * MbimCidFlags:
+ * @MBIM_CID_FLAG_NONE: None.
+ * @MBIM_CID_FLAG_CAN_SET: The command allows setting.
+ * @MBIM_CID_FLAG_CAN_QUERY: The command allows querying.
+ * @MBIM_CID_FLAG_CAN_NOTIFY: The command allows notifying.
+ * @MBIM_CID_FLAG_SET_MESSAGE: The library can build set requests of the command.
+ * @MBIM_CID_FLAG_QUERY_MESSAGE: The library can build query requests of the command.
+ * @MBIM_CID_FLAG_RESPONSE_MESSAGE: The library can parse responses of the command.
+ * @MBIM_CID_FLAG_NOTIFICATION_MESSAGE: The library can parse notifications of the command.
+ * @MBIM_CID_FLAG_CUSTOM_SERVICE: The command belongs to a custom service, and
+ *  therefore nothing else is known about it.
+ *
+ * Capabilities of a command.
+ *
+ * Since: 1.36
+ */
+typedef enum { /*< since=1.36 >*/
+    MBIM_CID_FLAG_NONE                 = 0,
+    MBIM_CID_FLAG_CAN_SET              = 1 << 0,
+    MBIM_CID_FLAG_CAN_QUERY            = 1 << 1,
+    MBIM_CID_FLAG_CAN_NOTIFY           = 1 << 2,
+    MBIM_CID_FLAG_SET_MESSAGE          = 1 << 3,
+    MBIM_CID_FLAG_QUERY_MESSAGE        = 1 << 4,
+    MBIM_CID_FLAG_RESPONSE_MESSAGE     = 1 << 5,
+    MBIM_CID_FLAG_NOTIFICATION_MESSAGE = 1 << 6,
+    MBIM_CID_FLAG_CUSTOM_SERVICE       = 1 << 7,
+} MbimCidFlags;
+
+/**
+ * MbimCidDescriptor:
+ * @service_name: printable name of the service.
+ * @name: printable name of the command, or %NULL for commands in custom services.
+ * @flags: a bitmask of #MbimCidFlags.
+ *
+ * Description of a command.
+ *
+ * Since: 1.36
+ */
+typedef struct {
+    const gchar  *service_name;
+    const gchar  *name;
+    MbimCidFlags  flags;
+} MbimCidDescriptor;
+
+/**
+ * mbim_cid_get_descriptor:
+ * @service: a #MbimService or custom service.
+ * @cid: a command ID.
+ *
+ * Gets the description of the command specified by the @service and the @cid,
+ * in a single lookup.
+ *
+ * Any command ID in a registered custom service is described with the
+ * %MBIM_CID_FLAG_CUSTOM_SERVICE flag; the returned descriptor is owned by the
+ * custom service and is no longer valid once it is unregistered.
+ *
+ * Returns: (transfer none): a #MbimCidDescriptor, or %NULL if the command is unknown.
+ *
+ * Since: 1.36
+ */
+const MbimCidDescriptor *mbim_cid_get_descriptor (guint service,
+                                                  guint cid);
+
 G_END_DECLS
 
 #endif /* _LIBMBIM_GLIB_MBIM_CID_H_ */
@@ -22,7 +22,10 @@
 #include <unistd.h>
 #include <gio/gio.h>
 #include <gio/gunixsocketaddress.h>
+#include <gio/gunixfdmessage.h>
+#include <glib-unix.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #define IOCTL_WDM_MAX_COMMAND _IOR('H', 0xA0, guint16)
 
 #define OPEN_RETRY_TIMEOUT_SECS 5
@@ -38,6 +41,7 @@
 #include "mbim-helpers.h"
 #include "mbim-proxy.h"
 #include "mbim-proxy-control.h"
+#include "mbim-shm-transport.h"
 #include "mbim-net-port-manager.h"
 #include "mbim-net-port-manager-wdm.h"
 #include "mbim-net-port-manager-wwan.h"
@@ -106,6 +110,16 @@ struct _MbimDevicePrivate {
     /* Support for mbim-proxy */
     GSocketClient *socket_client;
     GSocketConnection *socket_connection;
+    /* Whether the proxy connection preserves message boundaries */
+    gboolean proxy_seqpacket;
+    /* Shared memory transport with the proxy: the descriptors still to be
+     * sent, the transport itself and its own receive buffer, and whether
+     * messages are already being sent through it */
+    GUnixFDList      *proxy_shm_fd_list;
+    MbimShmTransport *proxy_shm;
+    GSource          *proxy_shm_source;
+    GByteArray       *proxy_shm_response;
+    gboolean          proxy_shm_active;
 
     /* HT to keep track of ongoing host/function transactions
      *  Host transactions:  created by us
@@ -128,12 +142,15 @@ struct _MbimDevicePrivate {
 
     /* Link management */
     MbimNetPortManager *net_port_manager;
+    GHashTable         *ip_configuration_follows;
 
     /* Number of consecutive timeouts detected */
     guint consecutive_timeouts;
 };
 
 #define MAX_SPAWN_RETRIES             10
+#define SPAWN_READY_TIMEOUT_MS        1000
+#define SPAWN_RETRY_TIMEOUT_MS        100
 #define MAX_CONTROL_TRANSFER          4096
 #define MAX_TIME_BETWEEN_FRAGMENTS_MS 1250
 
@@ -690,6 +707,105 @@ mbim_device_add_link (MbimDevice          *self,
                                     task);
 }
 
+typedef struct {
+    GPtrArray *links;
+    GArray    *session_ids;
+} AddLinksResult;
+
+static void
+add_links_result_free (AddLinksResult *ctx)
+{
+    g_clear_pointer (&ctx->links, g_ptr_array_unref);
+    g_clear_pointer (&ctx->session_ids, g_array_unref);
+    g_free (ctx);
+}
+
+GPtrArray *
+mbim_device_add_links_finish (MbimDevice    *self,
+                              GAsyncResult  *res,
+                              GArray       **out_session_ids,
+                              GError       **error)
+{
+    AddLinksResult *ctx;
+    GPtrArray      *links;
+
+    ctx = g_task_propagate_pointer (G_TASK (res), error);
+    if (!ctx)
+        return NULL;
+
+    if (out_session_ids)
+        *out_session_ids = g_steal_pointer (&ctx->session_ids);
+
+    links = g_steal_pointer (&ctx->links);
+    add_links_result_free (ctx);
+    return links;
+}
+
+static void
+device_add_links_ready (MbimNetPortManager *net_port_manager,
+                        GAsyncResult       *res,
+                        GTask              *task)
+{
+    GError         *error = NULL;
+    AddLinksResult *ctx;
+
+    ctx = g_new0 (AddLinksResult, 1);
+    ctx->links = mbim_net_port_manager_add_links_finish (net_port_manager, &ctx->session_ids, res, &error);
+
+    if (!ctx->links) {
+        g_prefix_error (&error, "Could not allocate links: ");
+        g_task_return_error (task, error);
+        add_links_result_free (ctx);
+    } else
+        g_task_return_pointer (task, ctx, (GDestroyNotify) add_links_result_free);
+
+    g_object_unref (task);
+}
+
+void
+mbim_device_add_links (MbimDevice          *self,
+                       const guint         *session_ids,
+                       guint                n_session_ids,
+                       const gchar         *base_ifname,
+                       const gchar         *ifname_prefix,
+                       GCancellable        *cancellable,
+                       GAsyncReadyCallback  callback,
+                       gpointer             user_data)
+{
+    GTask  *task;
+    GError *error = NULL;
+    guint   i;
+
+    g_return_if_fail (MBIM_IS_DEVICE (self));
+    g_return_if_fail (base_ifname);
+    g_return_if_fail (session_ids);
+    g_return_if_fail (n_session_ids > 0);
+    for (i = 0; i < n_session_ids; i++)
+        g_return_if_fail ((session_ids[i] <= MBIM_DEVICE_SESSION_ID_MAX) || (session_ids[i] == MBIM_DEVICE_SESSION_ID_AUTOMATIC));
+
+    task = g_task_new (self, cancellable, callback, user_data);
+
+    if (!setup_net_port_manager (self, &error)) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    g_assert (self->priv->net_port_manager);
+    mbim_net_port_manager_add_links (self->priv->net_port_manager,
+                                     session_ids,
+                                     n_session_ids,
+                                     base_ifname,
+                                     ifname_prefix,
+                                     5,
+                                     cancellable,
+                                     (GAsyncReadyCallback) device_add_links_ready,
+                                     task);
+}
+
+static void ip_configuration_unfollow_link (MbimDevice  *self,
+                                            const gchar *ifname);
+
 gboolean
 mbim_device_delete_link_finish (MbimDevice    *self,
                                 GAsyncResult  *res,
@@ -733,6 +849,10 @@ mbim_device_delete_link (MbimDevice          *self,
         return;
     }
 
+    /* The updates of the IP configuration are no longer applied to the link,
+     * not even while it is being deleted */
+    ip_configuration_unfollow_link (self, ifname);
+
     g_assert (self->priv->net_port_manager);
     mbim_net_port_manager_del_link (self->priv->net_port_manager,
                                     ifname,
@@ -773,8 +893,10 @@ mbim_device_delete_all_links (MbimDevice          *self,
                               GAsyncReadyCallback  callback,
                               gpointer             user_data)
 {
-    GTask  *task;
-    GError *error = NULL;
+    GTask               *task;
+    GError              *error = NULL;
+    g_autoptr(GPtrArray) links = NULL;
+    guint                i;
 
     g_return_if_fail (MBIM_IS_DEVICE (self));
     g_return_if_fail (base_ifname);
@@ -788,6 +910,14 @@ mbim_device_delete_all_links (MbimDevice          *self,
     }
 
     g_assert (self->priv->net_port_manager);
+
+    /* Same for all the links deleted; if they cannot be listed, deleting
+     * them fails anyway */
+    if (mbim_net_port_manager_list_links (self->priv->net_port_manager, base_ifname, &links, NULL)) {
+        for (i = 0; links && i < links->len; i++)
+            ip_configuration_unfollow_link (self, g_ptr_array_index (links, i));
+    }
+
     mbim_net_port_manager_del_all_links (self->priv->net_port_manager,
                                          base_ifname,
                                          cancellable,
@@ -818,6 +948,169 @@ mbim_device_list_links (MbimDevice   *self,
 
 /*****************************************************************************/
 
+typedef struct {
+    gchar *ifname;
+    guint  route_metric;
+} IpConfigurationFollow;
+
+static void
+ip_configuration_follow_free (IpConfigurationFollow *follow)
+{
+    g_free (follow->ifname);
+    g_slice_free (IpConfigurationFollow, follow);
+}
+
+static void
+ip_configuration_unfollow_link (MbimDevice  *self,
+                                const gchar *ifname)
+{
+    GHashTableIter         iter;
+    IpConfigurationFollow *follow;
+
+    if (!self->priv->ip_configuration_follows)
+        return;
+
+    g_hash_table_iter_init (&iter, self->priv->ip_configuration_follows);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &follow)) {
+        if (g_str_equal (follow->ifname, ifname))
+            g_hash_table_iter_remove (&iter);
+    }
+}
+
+static gboolean
+ip_configuration_get_session_id (MbimMessage *message,
+                                 guint32     *session_id)
+{
+    if (mbim_message_get_message_type (message) == MBIM_MESSAGE_TYPE_INDICATE_STATUS)
+        return mbim_message_ip_configuration_notification_parse (message, session_id,
+                                                                 NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                                                 NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                                                 NULL);
+    return mbim_message_ip_configuration_response_parse (message, session_id,
+                                                         NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                                         NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                                         NULL);
+}
+
+static void
+ip_configuration_follow_ready (MbimNetPortManager *net_port_manager,
+                               GAsyncResult       *res)
+{
+    g_autoptr(GError) error = NULL;
+
+    if (!mbim_net_port_manager_apply_ip_configuration_finish (net_port_manager, res, &error))
+        g_debug ("Couldn't apply IP configuration update: %s", error->message);
+}
+
+static void
+ip_configuration_follow (MbimDevice  *self,
+                         MbimMessage *indication)
+{
+    IpConfigurationFollow *follow;
+    guint32                session_id;
+
+    if (!self->priv->ip_configuration_follows ||
+        !self->priv->net_port_manager ||
+        !ip_configuration_get_session_id (indication, &session_id))
+        return;
+
+    follow = g_hash_table_lookup (self->priv->ip_configuration_follows, GUINT_TO_POINTER (session_id));
+    if (!follow)
+        return;
+
+    g_debug ("[%s] applying IP configuration update of session %u to %s",
+             self->priv->path_display, session_id, follow->ifname);
+    mbim_net_port_manager_apply_ip_configuration (self->priv->net_port_manager,
+                                                  follow->ifname,
+                                                  indication,
+                                                  follow->route_metric,
+                                                  5, /* timeout */
+                                                  NULL,
+                                                  (GAsyncReadyCallback) ip_configuration_follow_ready,
+                                                  NULL);
+}
+
+gboolean
+mbim_device_apply_ip_configuration_finish (MbimDevice    *self,
+                                           GAsyncResult  *res,
+                                           GError       **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static void
+device_apply_ip_configuration_ready (MbimNetPortManager *net_port_manager,
+                                     GAsyncResult       *res,
+                                     GTask              *task)
+{
+    GError *error = NULL;
+
+    if (!mbim_net_port_manager_apply_ip_configuration_finish (net_port_manager, res, &error))
+        g_task_return_error (task, error);
+    else
+        g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+void
+mbim_device_apply_ip_configuration (MbimDevice                          *self,
+                                    const gchar                         *ifname,
+                                    MbimMessage                         *ip_configuration,
+                                    guint                                route_metric,
+                                    MbimDeviceApplyIpConfigurationFlags  flags,
+                                    GCancellable                        *cancellable,
+                                    GAsyncReadyCallback                  callback,
+                                    gpointer                             user_data)
+{
+    GTask   *task;
+    GError  *error = NULL;
+    guint32  session_id;
+
+    g_return_if_fail (MBIM_IS_DEVICE (self));
+    g_return_if_fail (ifname);
+    g_return_if_fail (ip_configuration);
+
+    task = g_task_new (self, cancellable, callback, user_data);
+
+    if (!setup_net_port_manager (self, &error)) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    /* Applying a configuration without following the indications also stops
+     * following them in the session */
+    if (ip_configuration_get_session_id (ip_configuration, &session_id)) {
+        if (flags & MBIM_DEVICE_APPLY_IP_CONFIGURATION_FLAGS_FOLLOW_INDICATIONS) {
+            IpConfigurationFollow *follow;
+
+            if (!self->priv->ip_configuration_follows)
+                self->priv->ip_configuration_follows =
+                    g_hash_table_new_full (g_direct_hash,
+                                           g_direct_equal,
+                                           NULL,
+                                           (GDestroyNotify) ip_configuration_follow_free);
+            follow = g_slice_new0 (IpConfigurationFollow);
+            follow->ifname = g_strdup (ifname);
+            follow->route_metric = route_metric;
+            g_hash_table_insert (self->priv->ip_configuration_follows, GUINT_TO_POINTER (session_id), follow);
+        } else if (self->priv->ip_configuration_follows)
+            g_hash_table_remove (self->priv->ip_configuration_follows, GUINT_TO_POINTER (session_id));
+    }
+
+    g_assert (self->priv->net_port_manager);
+    mbim_net_port_manager_apply_ip_configuration (self->priv->net_port_manager,
+                                                  ifname,
+                                                  ip_configuration,
+                                                  route_metric,
+                                                  5, /* timeout */
+                                                  cancellable,
+                                                  (GAsyncReadyCallback) device_apply_ip_configuration_ready,
+                                                  task);
+}
+
+/*****************************************************************************/
+
 gboolean
 mbim_device_check_link_supported (MbimDevice  *self,
                                   GError     **error)
@@ -868,6 +1161,12 @@ indication_ready (MbimDevice   *self,
         }
     }
 
+    /* Start applying the IP configuration updates of the followed sessions
+     * before anyone else is notified about them */
+    if ((mbim_message_indicate_status_get_service (indication) == MBIM_SERVICE_BASIC_CONNECT) &&
+        (mbim_message_indicate_status_get_cid (indication) == MBIM_CID_BASIC_CONNECT_IP_CONFIGURATION))
+        ip_configuration_follow (self, indication);
+
     g_signal_emit (self, signals[SIGNAL_INDICATE_STATUS], 0, indication);
 }
 
@@ -1142,14 +1441,15 @@ process_message (MbimDevice        *self,
 }
 
 static void
-parse_response (MbimDevice *self)
+parse_response (MbimDevice  *self,
+                GByteArray **response)
 {
     do {
         const MbimMessage *message;
         guint32            len;
         g_autoptr(GError)  error = NULL;
 
-        message = (const MbimMessage *)self->priv->response;
+        message = (const MbimMessage *)*response;
 
         /* Invalid message? */
         if (!_mbim_message_validate_internal (message, TRUE, &error)) {
@@ -1159,9 +1459,9 @@ parse_response (MbimDevice *self)
 
             /* Invalid MBIM message */
             g_warning ("[%s] discarding %u bytes in stream as message validation fails: %s",
-                       self->priv->path_display, self->priv->response->len,
+                       self->priv->path_display, (*response)->len,
                        error->message);
-            g_byte_array_remove_range (self->priv->response, 0, self->priv->response->len);
+            g_byte_array_remove_range (*response, 0, (*response)->len);
             return;
         }
 
@@ -1171,12 +1471,106 @@ parse_response (MbimDevice *self)
 
         /* If we were force-closed during the processing of a message, we'd be
          * losing the response array directly, so check just in case */
-        if (!self->priv->response)
+        if (!*response)
             break;
 
         /* Remove message from buffer */
-        g_byte_array_remove_range (self->priv->response, 0, len);
-    } while (self->priv->response->len > 0);
+        g_byte_array_remove_range (*response, 0, len);
+    } while ((*response)->len > 0);
+}
+
+static gboolean
+proxy_shm_available (gint          fd,
+                     GIOCondition  condition,
+                     MbimDevice   *self)
+{
+    g_autoptr(GError) error = NULL;
+
+    /* Messages from the proxy are kept in their own buffer, as there may
+     * still be partial messages received through the socket */
+    if (G_UNLIKELY (!self->priv->proxy_shm_response))
+        self->priv->proxy_shm_response = g_byte_array_sized_new (500);
+
+    if (!_mbim_shm_transport_read (self->priv->proxy_shm, self->priv->proxy_shm_response, &error)) {
+        g_warning ("[%s] error reading from the shared memory: '%s'",
+                   self->priv->path_display,
+                   error->message);
+        return TRUE;
+    }
+
+    if (self->priv->proxy_shm_response->len > 0) {
+        g_object_ref (self);
+        parse_response (self, &self->priv->proxy_shm_response);
+        g_object_unref (self);
+    }
+
+    return TRUE;
+}
+
+static void
+proxy_shm_reset (MbimDevice *self)
+{
+    if (self->priv->proxy_shm_source) {
+        g_source_destroy (self->priv->proxy_shm_source);
+        g_source_unref (self->priv->proxy_shm_source);
+        self->priv->proxy_shm_source = NULL;
+    }
+    g_clear_object (&self->priv->proxy_shm_fd_list);
+    g_clear_pointer (&self->priv->proxy_shm, _mbim_shm_transport_free);
+    g_clear_pointer (&self->priv->proxy_shm_response, g_byte_array_unref);
+    self->priv->proxy_shm_active = FALSE;
+}
+
+static void
+receive_datagrams (MbimDevice *self)
+{
+    /* Each datagram received from the proxy is a full message or fragment,
+     * so it is processed right away without any framing */
+    while (self->priv->iochannel_source && self->priv->socket_connection) {
+        g_autoptr(GByteArray)  datagram = NULL;
+        g_autoptr(GError)      error = NULL;
+        GSocket               *socket;
+        gssize                 size;
+        gssize                 r;
+
+        /* Peek the size of the next datagram */
+        socket = g_socket_connection_get_socket (self->priv->socket_connection);
+        size = recv (g_socket_get_fd (socket), NULL, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT);
+        if (size < 0)
+            break;
+
+        /* An empty datagram must still be consumed, or the socket would be
+         * reported as readable forever; as it cannot be told apart from the
+         * end of the connection, stop here and let the next dispatch (or
+         * the hangup) take care of the rest */
+        if (size == 0) {
+            if (recv (g_socket_get_fd (socket), NULL, 0, MSG_DONTWAIT) == 0)
+                g_debug ("[%s] discarding empty datagram", self->priv->path_display);
+            break;
+        }
+
+        datagram = g_byte_array_sized_new (size);
+        g_byte_array_set_size (datagram, size);
+        r = g_socket_receive_with_blocking (socket, (gchar *)datagram->data, size, FALSE, NULL, &error);
+        if (r <= 0) {
+            if (r < 0 && !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+                g_warning ("[%s] error reading from the socket: '%s'",
+                           self->priv->path_display,
+                           error->message);
+            break;
+        }
+        g_byte_array_set_size (datagram, r);
+
+        if (!_mbim_message_validate_internal ((const MbimMessage *)datagram, TRUE, &error) ||
+            mbim_message_get_message_length ((const MbimMessage *)datagram) != (guint32)r) {
+            g_warning ("[%s] discarding %u bytes datagram as message validation fails: %s",
+                       self->priv->path_display, datagram->len,
+                       error ? error->message : "length mismatch");
+            continue;
+        }
+
+        process_message (self, (const MbimMessage *)datagram);
+    }
 }
 
 static gboolean
@@ -1208,6 +1602,14 @@ data_available (GIOChannel   *source,
         return TRUE;
     }
 
+    /* No need to reassemble the stream if message boundaries are kept */
+    if (self->priv->proxy_seqpacket) {
+        g_object_ref (self);
+        receive_datagrams (self);
+        g_object_unref (self);
+        return TRUE;
+    }
+
     /* If not ready yet, prepare the response with default initial size. */
     if (G_UNLIKELY (!self->priv->response))
         self->priv->response = g_byte_array_sized_new (500);
@@ -1243,7 +1645,7 @@ data_available (GIOChannel   *source,
                 g_byte_array_append (self->priv->response, (const guint8 *)buffer, bytes_read);
 
             /* Try to parse what we already got */
-            parse_response (self);
+            parse_response (self, &self->priv->response);
 
             /* And keep on if we were told to keep on */
         } while (bytes_read == self->priv->max_control_transfer || status == G_IO_STATUS_AGAIN);
@@ -1365,11 +1767,35 @@ read_max_control_transfer (MbimDevice *self)
 
 typedef struct {
     guint spawn_retries;
+    /* Waiting for the spawned proxy to be ready */
+    gint     ready_fd;
+    GSource *ready_source;
+    GSource *ready_timeout_source;
 } CreateIoChannelContext;
 
+static void
+create_iochannel_context_wait_reset (CreateIoChannelContext *ctx)
+{
+    if (ctx->ready_source) {
+        g_source_destroy (ctx->ready_source);
+        g_source_unref (ctx->ready_source);
+        ctx->ready_source = NULL;
+    }
+    if (ctx->ready_timeout_source) {
+        g_source_destroy (ctx->ready_timeout_source);
+        g_source_unref (ctx->ready_timeout_source);
+        ctx->ready_timeout_source = NULL;
+    }
+    if (ctx->ready_fd >= 0) {
+        close (ctx->ready_fd);
+        ctx->ready_fd = -1;
+    }
+}
+
 static void
 create_iochannel_context_free (CreateIoChannelContext *ctx)
 {
+    create_iochannel_context_wait_reset (ctx);
     g_slice_free (CreateIoChannelContext, ctx);
 }
 
@@ -1471,39 +1897,61 @@ static void create_iochannel_with_socket (GTask *task);
 static gboolean
 wait_for_proxy_cb (GTask *task)
 {
+    create_iochannel_context_wait_reset (g_task_get_task_data (task));
     create_iochannel_with_socket (task);
     return FALSE;
 }
 
+static gboolean
+proxy_ready_cb (gint          fd,
+                GIOCondition  condition,
+                GTask        *task)
+{
+    MbimDevice *self;
+
+    self = g_task_get_source_object (task);
+
+    /* Either the proxy reported it is ready, or it exited (e.g. because
+     * another one was already running); retry the connection right away
+     * in both cases */
+    g_debug ("[%s] spawned mbim-proxy %s", self->priv->path_display,
+             (condition & G_IO_IN) ? "ready" : "exited");
+    return wait_for_proxy_cb (task);
+}
+
 static void
-spawn_child_setup (void)
+spawn_child_setup (gpointer user_data)
 {
+    gint ready_fd = GPOINTER_TO_INT (user_data);
+
     if (setpgid (0, 0) < 0)
         g_warning ("couldn't setup proxy specific process group");
+
+    /* All descriptors are flagged close-on-exec before running the child
+     * setup; the write end of the readiness pipe must be inherited */
+    if (ready_fd >= 0 && fcntl (ready_fd, F_SETFD, 0) < 0)
+        g_warning ("couldn't setup proxy readiness descriptor");
 }
 
-static void
-create_iochannel_with_socket (GTask *task)
+static gboolean
+connect_to_proxy (MbimDevice   *self,
+                  GSocketType   socket_type,
+                  const gchar  *socket_path,
+                  GError      **error)
 {
-    MbimDevice                *self;
-    CreateIoChannelContext    *ctx;
-    g_autoptr(GSocketAddress)  socket_address = NULL;
-    GError                    *error = NULL;
-
-    self = g_task_get_source_object (task);
-    ctx = g_task_get_task_data (task);
+    g_autoptr(GSocketAddress) socket_address = NULL;
 
     /* Create socket client */
     if (self->priv->socket_client)
         g_object_unref (self->priv->socket_client);
     self->priv->socket_client = g_socket_client_new ();
     g_socket_client_set_family (self->priv->socket_client, G_SOCKET_FAMILY_UNIX);
-    g_socket_client_set_socket_type (self->priv->socket_client, G_SOCKET_TYPE_STREAM);
+    g_socket_client_set_socket_type (self->priv->socket_client, socket_type);
     g_socket_client_set_protocol (self->priv->socket_client, G_SOCKET_PROTOCOL_DEFAULT);
 
     /* Setup socket address */
     socket_address = (g_unix_socket_address_new_with_type (
-                          MBIM_PROXY_SOCKET_PATH,
+                          socket_path,
                           -1,
                           G_UNIX_SOCKET_ADDRESS_ABSTRACT));
 
@@ -1514,11 +1962,35 @@ create_iochannel_with_socket (GTask *task)
                                               self->priv->socket_client,
                                               G_SOCKET_CONNECTABLE (socket_address),
                                               NULL,
-                                              &error));
+                                              error));
+    return !!self->priv->socket_connection;
+}
+
+static void
+create_iochannel_with_socket (GTask *task)
+{
+    MbimDevice             *self;
+    CreateIoChannelContext *ctx;
+    GError                 *error = NULL;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+
+    /* Prefer the transport keeping message boundaries, which is not
+     * available in older proxies */
+    self->priv->proxy_seqpacket = connect_to_proxy (self,
+                                                    G_SOCKET_TYPE_SEQPACKET,
+                                                    MBIM_PROXY_SEQPACKET_SOCKET_PATH,
+                                                    &error);
+    if (!self->priv->proxy_seqpacket) {
+        g_debug ("[%s] cannot connect to proxy seqpacket socket: %s", self->priv->path_display, error->message);
+        g_clear_error (&error);
+        connect_to_proxy (self, G_SOCKET_TYPE_STREAM, MBIM_PROXY_SOCKET_PATH, &error);
+    }
 
     if (!self->priv->socket_connection) {
-        g_auto(GStrv)      argc = NULL;
-        g_autoptr(GSource) source = NULL;
+        g_auto(GStrv) argc = NULL;
+        gint          ready_fds[2] = { -1, -1 };
 
         g_debug ("[%s] cannot connect to proxy: %s", self->priv->path_display, error->message);
         g_clear_error (&error);
@@ -1537,24 +2009,48 @@ create_iochannel_with_socket (GTask *task)
 
         g_debug ("[%s] spawning new mbim-proxy (try %u)...", self->priv->path_display, ctx->spawn_retries);
 
-        argc = g_new0 (gchar *, 2);
+        /* The proxy reports through this pipe when it is ready to accept
+         * connections, so that we don't need to poll */
+        if (!g_unix_open_pipe (ready_fds, FD_CLOEXEC, &error)) {
+            g_debug ("[%s] couldn't create proxy readiness pipe: %s", self->priv->path_display, error->message);
+            g_clear_error (&error);
+        }
+
+        argc = g_new0 (gchar *, 3);
         argc[0] = g_strdup (LIBEXEC_PATH "/mbim-proxy");
+        if (ready_fds[1] >= 0)
+            argc[1] = g_strdup_printf ("--ready-fd=%d", ready_fds[1]);
         if (!g_spawn_async (NULL, /* working directory */
                             argc,
                             NULL, /* envp */
                             G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
                             (GSpawnChildSetupFunc) spawn_child_setup,
-                            NULL, /* child_setup_user_data */
+                            GINT_TO_POINTER (ready_fds[1]),
                             NULL,
                             &error)) {
             g_debug ("[%s] error spawning mbim-proxy: %s", self->priv->path_display, error->message);
             g_clear_error (&error);
+            if (ready_fds[0] >= 0) {
+                close (ready_fds[0]);
+                ready_fds[0] = -1;
+            }
         }
 
-        /* Wait some ms and retry */
-        source = g_timeout_source_new (100);
-        g_source_set_callback (source, (GSourceFunc)wait_for_proxy_cb, task, NULL);
-        g_source_attach (source, g_main_context_get_thread_default ());
+        /* Only the child keeps the write end open, so that we get a HUP if
+         * it exits without reporting */
+        if (ready_fds[1] >= 0)
+            close (ready_fds[1]);
+
+        /* Wait until the proxy is ready, or some ms if we cannot know */
+        if (ready_fds[0] >= 0) {
+            ctx->ready_fd = ready_fds[0];
+            ctx->ready_source = g_unix_fd_source_new (ctx->ready_fd, G_IO_IN | G_IO_ERR | G_IO_HUP);
+            g_source_set_callback (ctx->ready_source, (GSourceFunc)proxy_ready_cb, task, NULL);
+            g_source_attach (ctx->ready_source, g_main_context_get_thread_default ());
+        }
+        ctx->ready_timeout_source = g_timeout_source_new (ctx->ready_source ? SPAWN_READY_TIMEOUT_MS : SPAWN_RETRY_TIMEOUT_MS);
+        g_source_set_callback (ctx->ready_timeout_source, (GSourceFunc)wait_for_proxy_cb, task, NULL);
+        g_source_attach (ctx->ready_timeout_source, g_main_context_get_thread_default ());
         return;
     }
 
@@ -1577,8 +2073,8 @@ create_iochannel (MbimDevice           *self,
     CreateIoChannelContext *ctx;
     GTask *task;
 
-    ctx = g_slice_new (CreateIoChannelContext);
-    ctx->spawn_retries = 0;
+    ctx = g_slice_new0 (CreateIoChannelContext);
+    ctx->ready_fd = -1;
 
     task = g_task_new (self, NULL, callback, user_data);
     g_task_set_task_data (task, ctx, (GDestroyNotify)create_iochannel_context_free);
@@ -1605,6 +2101,7 @@ typedef enum {
     DEVICE_OPEN_CONTEXT_STEP_FIRST = 0,
     DEVICE_OPEN_CONTEXT_STEP_CREATE_IOCHANNEL,
     DEVICE_OPEN_CONTEXT_STEP_FLAGS_PROXY,
+    DEVICE_OPEN_CONTEXT_STEP_PROXY_SHARED_MEMORY,
     DEVICE_OPEN_CONTEXT_STEP_CLOSE_MESSAGE,
     DEVICE_OPEN_CONTEXT_STEP_OPEN_MESSAGE,
     DEVICE_OPEN_CONTEXT_STEP_DEVICE_SERVICES,
@@ -1963,6 +2460,83 @@ proxy_cfg_message (GTask *task)
                          task);
 }
 
+static void
+proxy_shm_message_ready (MbimDevice   *self,
+                         GAsyncResult *res,
+                         GTask        *task)
+{
+    DeviceOpenContext      *ctx;
+    GError                 *error = NULL;
+    g_autoptr(MbimMessage)  response = NULL;
+
+    ctx = g_task_get_task_data (task);
+
+    response = mbim_device_command_finish (self, res, &error);
+    if (!response && g_error_matches (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_TIMEOUT)) {
+        /* Hard error if we don't know which transport the proxy uses */
+        g_debug ("[%s] shared memory transport setup timed out: closed", self->priv->path_display);
+        self->priv->open_status = OPEN_STATUS_CLOSED;
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
+        /* Older proxies don't support it, just keep on using the socket */
+        g_debug ("[%s] shared memory transport unavailable: %s", self->priv->path_display, error->message);
+        g_clear_error (&error);
+        proxy_shm_reset (self);
+    } else {
+        g_debug ("[%s] shared memory transport enabled", self->priv->path_display);
+        self->priv->proxy_shm_active = TRUE;
+    }
+
+    ctx->step++;
+    device_open_context_step (task);
+}
+
+static void
+proxy_shm_message (GTask *task)
+{
+    MbimDevice             *self;
+    DeviceOpenContext      *ctx;
+    g_autoptr(MbimMessage)  request = NULL;
+    g_autoptr(GError)       error = NULL;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+
+    self->priv->proxy_shm = _mbim_shm_transport_new (MBIM_SHM_TRANSPORT_RING_SIZE_DEFAULT, &error);
+    if (self->priv->proxy_shm)
+        self->priv->proxy_shm_fd_list = _mbim_shm_transport_get_fd_list (self->priv->proxy_shm, &error);
+    if (!self->priv->proxy_shm_fd_list) {
+        g_debug ("[%s] couldn't setup shared memory transport: %s", self->priv->path_display, error->message);
+        proxy_shm_reset (self);
+        ctx->step++;
+        device_open_context_step (task);
+        return;
+    }
+
+    /* The proxy sends the response to this request and everything else
+     * after it through the shared memory */
+    self->priv->proxy_shm_source = g_unix_fd_source_new (_mbim_shm_transport_get_wake_fd (self->priv->proxy_shm), G_IO_IN);
+    g_source_set_callback (self->priv->proxy_shm_source,
+                           (GSourceFunc)proxy_shm_available,
+                           self,
+                           NULL);
+    g_source_attach (self->priv->proxy_shm_source, g_main_context_get_thread_default ());
+
+    /* The descriptors are sent along with the request */
+    request = mbim_message_proxy_control_shared_memory_set_new (_mbim_shm_transport_get_ring_size (self->priv->proxy_shm), NULL);
+    g_assert (request);
+    mbim_device_command (self,
+                         request,
+                         OPEN_RETRY_TIMEOUT_SECS,
+                         g_task_get_cancellable (task),
+                         (GAsyncReadyCallback)proxy_shm_message_ready,
+                         task);
+}
+
 static void
 create_iochannel_ready (MbimDevice   *self,
                         GAsyncResult *res,
@@ -2048,6 +2622,14 @@ device_open_context_step (GTask *task)
         ctx->step++;
         /* Fall through */
 
+    case DEVICE_OPEN_CONTEXT_STEP_PROXY_SHARED_MEMORY:
+        if (ctx->flags & MBIM_DEVICE_OPEN_FLAGS_PROXY) {
+            proxy_shm_message (task);
+            return;
+        }
+        ctx->step++;
+        /* Fall through */
+
     case DEVICE_OPEN_CONTEXT_STEP_CLOSE_MESSAGE:
         /* Only send an explicit close during open if needed */
         if (ctx->close_before_open) {
@@ -2164,6 +2746,7 @@ destroy_iochannel (MbimDevice  *self,
     /* Failures when closing still make the device to get closed */
     g_clear_object (&self->priv->socket_connection);
     g_clear_object (&self->priv->socket_client);
+    proxy_shm_reset (self);
 
     /* Pending error indications are always cleared if the channel is
      * closed */
@@ -2339,6 +2922,46 @@ mbim_device_get_transaction_id (MbimDevice *self)
 
 /*****************************************************************************/
 
+static gboolean device_write (MbimDevice    *self,
+                              const guint8  *data,
+                              guint32        data_length,
+                              GError       **error);
+
+static gboolean
+device_write_with_fds (MbimDevice    *self,
+                       const guint8  *data,
+                       guint32        data_length,
+                       GError       **error)
+{
+    g_autoptr(GSocketControlMessage) fd_message = NULL;
+    GOutputVector                    vector = { data, data_length };
+    gssize                           sent;
+
+    fd_message = g_unix_fd_message_new_with_fd_list (self->priv->proxy_shm_fd_list);
+    g_clear_object (&self->priv->proxy_shm_fd_list);
+
+    sent = g_socket_send_message (g_socket_connection_get_socket (self->priv->socket_connection),
+                                  NULL,
+                                  &vector,
+                                  1,
+                                  &fd_message,
+                                  1,
+                                  G_SOCKET_MSG_NONE,
+                                  NULL,
+                                  error);
+    if (sent < 0) {
+        g_prefix_error (error, "Cannot write message: ");
+        return FALSE;
+    }
+
+    /* The descriptors are sent along with the first chunk, any remaining
+     * data is written as usual */
+    if ((guint32) sent < data_length)
+        return device_write (self, data + sent, data_length - (guint32) sent, error);
+
+    return TRUE;
+}
+
 static gboolean
 device_write (MbimDevice    *self,
               const guint8  *data,
@@ -2348,6 +2971,20 @@ device_write (MbimDevice    *self,
     gsize     written;
     GIOStatus write_status;
 
+    /* Descriptors pending to be sent to the proxy go along with the next
+     * message written to the socket */
+    if (G_UNLIKELY (self->priv->proxy_shm_fd_list))
+        return device_write_with_fds (self, data, data_length, error);
+
+    /* Once negotiated, everything goes through the shared memory */
+    if (self->priv->proxy_shm_active) {
+        if (!_mbim_shm_transport_write (self->priv->proxy_shm, data, data_length, error)) {
+            g_prefix_error (error, "Cannot write message: ");
+            return FALSE;
+        }
+        return TRUE;
+    }
+
     written = 0;
     write_status = G_IO_STATUS_AGAIN;
     while (write_status == G_IO_STATUS_AGAIN) {
@@ -2833,6 +3470,7 @@ finalize (GObject *object)
     g_free (self->priv->path);
     g_free (self->priv->path_display);
     g_free (self->priv->wwan_iface);
+    g_clear_pointer (&self->priv->ip_configuration_follows, g_hash_table_unref);
 
     G_OBJECT_CLASS (mbim_device_parent_class)->finalize (object);
 }
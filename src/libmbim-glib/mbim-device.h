@@ -601,6 +601,68 @@ gchar *mbim_device_add_link_finish (MbimDevice    *self,
                                     guint         *session_id,
                                     GError       **error);
 
+/**
+ * mbim_device_add_links:
+ * @self: a #MbimDevice.
+ * @session_ids: (array length=n_session_ids): the session ids for the links,
+ *   each in the [#MBIM_DEVICE_SESSION_ID_MIN,#MBIM_DEVICE_SESSION_ID_MAX]
+ *   range, or #MBIM_DEVICE_SESSION_ID_AUTOMATIC to find the first available
+ *   session id.
+ * @n_session_ids: the number of elements in @session_ids.
+ * @base_ifname: the interface which the new links will be created on.
+ * @ifname_prefix: the prefix suggested to be used for the name of the new links
+ *   created.
+ * @cancellable: a #GCancellable, or %NULL.
+ * @callback: a #GAsyncReadyCallback to call when the operation is finished.
+ * @user_data: the data to pass to callback function.
+ *
+ * Asynchronously creates several new virtual network device nodes on top of
+ * @base_ifname, in the same way as mbim_device_add_link() does for a single one.
+ *
+ * All the link creation requests are sent to the kernel at once, so this
+ * method should be preferred over several mbim_device_add_link() calls when
+ * setting up multiple sessions.
+ *
+ * The operation fails if any of the links cannot be created. The links that
+ * were successfully created in the same operation are not removed in that
+ * case.
+ *
+ * When the operation is finished @callback will be called. You can then call
+ * mbim_device_add_links_finish() to get the result of the operation.
+ *
+ * Since: 1.36
+ */
+void mbim_device_add_links (MbimDevice          *self,
+                            const guint         *session_ids,
+                            guint                n_session_ids,
+                            const gchar         *base_ifname,
+                            const gchar         *ifname_prefix,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data);
+
+/**
+ * mbim_device_add_links_finish:
+ * @self: a #MbimDevice.
+ * @res: a #GAsyncResult.
+ * @out_session_ids: (out)(optional)(transfer full)(element-type guint): return
+ *   location for a #GArray with the session ids of the links created, in the
+ *   same order as requested.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mbim_device_add_links().
+ *
+ * Returns: (transfer full)(element-type utf8): a #GPtrArray with the names of
+ * the net interfaces created, in the same order as requested, or %NULL if
+ * @error is set. The returned value should be freed with g_ptr_array_unref().
+ *
+ * Since: 1.36
+ */
+GPtrArray *mbim_device_add_links_finish (MbimDevice    *self,
+                                         GAsyncResult  *res,
+                                         GArray       **out_session_ids,
+                                         GError       **error);
+
 /**
  * mbim_device_delete_link:
  * @self: a #MbimDevice.
@@ -653,6 +715,8 @@ gboolean mbim_device_delete_link_finish (MbimDevice    *self,
  * Asynchronously deletes all virtual network interfaces that have been previously
  * created with mbim_device_add_link() in @base_ifname.
  *
+ * All the link deletion requests are sent to the kernel at once.
+ *
  * When the operation is finished @callback will be called. You can then call
  * mbim_device_delete_link_finish() to get the result of the operation.
  *
@@ -707,6 +771,85 @@ gboolean mbim_device_list_links (MbimDevice   *self,
                                  GPtrArray   **out_links,
                                  GError      **error);
 
+/**
+ * MbimDeviceApplyIpConfigurationFlags:
+ * @MBIM_DEVICE_APPLY_IP_CONFIGURATION_FLAGS_NONE: None.
+ * @MBIM_DEVICE_APPLY_IP_CONFIGURATION_FLAGS_FOLLOW_INDICATIONS: Also apply the
+ *  %MBIM_CID_BASIC_CONNECT_IP_CONFIGURATION indications received afterwards for
+ *  the same session.
+ *
+ * Flags to specify how the IP configuration is applied.
+ *
+ * Since: 1.36
+ */
+typedef enum { /*< since=1.36 >*/
+    MBIM_DEVICE_APPLY_IP_CONFIGURATION_FLAGS_NONE              = 0,
+    MBIM_DEVICE_APPLY_IP_CONFIGURATION_FLAGS_FOLLOW_INDICATIONS = 1 << 0,
+} MbimDeviceApplyIpConfigurationFlags;
+
+/**
+ * mbim_device_apply_ip_configuration:
+ * @self: a #MbimDevice.
+ * @ifname: the net interface of the session.
+ * @ip_configuration: a %MBIM_CID_BASIC_CONNECT_IP_CONFIGURATION response or
+ *  indication.
+ * @route_metric: the metric of the default routes added.
+ * @flags: a set of #MbimDeviceApplyIpConfigurationFlags.
+ * @cancellable: a #GCancellable, or %NULL.
+ * @callback: a #GAsyncReadyCallback to call when the operation is finished.
+ * @user_data: the data to pass to callback function.
+ *
+ * Asynchronously applies the IP settings reported by the modem to @ifname,
+ * talking directly to the kernel instead of going through external tools.
+ *
+ * The net interface is brought up, with the MTU reported by the modem if any,
+ * the reported IPv4 and IPv6 addresses are added, and a default route with
+ * @route_metric is set up for each IP family with addresses, through the
+ * reported gateway if any. Default routes with the same metric in the same
+ * interface are replaced. DNS servers are not applied, as the kernel has no
+ * notion of them; that is left to the caller.
+ *
+ * The addresses and routes added by a previous call for the same @ifname that
+ * are no longer in @ip_configuration are removed.
+ *
+ * If %MBIM_DEVICE_APPLY_IP_CONFIGURATION_FLAGS_FOLLOW_INDICATIONS is given,
+ * the IP configuration indications received afterwards for the same session
+ * are also applied to @ifname as soon as they arrive. Calling this method again
+ * for the same session without the flag, or deleting @ifname with
+ * mbim_device_delete_link() or mbim_device_delete_all_links(), stops following
+ * them.
+ *
+ * When the operation is finished @callback will be called. You can then call
+ * mbim_device_apply_ip_configuration_finish() to get the result of the
+ * operation.
+ *
+ * Since: 1.36
+ */
+void mbim_device_apply_ip_configuration (MbimDevice                          *self,
+                                         const gchar                         *ifname,
+                                         MbimMessage                         *ip_configuration,
+                                         guint                                route_metric,
+                                         MbimDeviceApplyIpConfigurationFlags  flags,
+                                         GCancellable                        *cancellable,
+                                         GAsyncReadyCallback                  callback,
+                                         gpointer                             user_data);
+
+/**
+ * mbim_device_apply_ip_configuration_finish:
+ * @self: a #MbimDevice.
+ * @res: a #GAsyncResult.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mbim_device_apply_ip_configuration().
+ *
+ * Returns: %TRUE if successful, %FALSE if @error is set.
+ *
+ * Since: 1.36
+ */
+gboolean mbim_device_apply_ip_configuration_finish (MbimDevice    *self,
+                                                    GAsyncResult  *res,
+                                                    GError       **error);
+
 /**
  * mbim_device_check_link_supported:
  * @self: a #MbimDevice.
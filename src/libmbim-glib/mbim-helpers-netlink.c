@@ -18,7 +18,11 @@
 /* This is a built-in file, not provided by the kernel headers,
  * used to add wwan symbols if not available */
 #include <kernel/wwan.h>
+#include <kernel/if_link.h>
 
+#include <errno.h>
+#include <string.h>
+#include <net/if.h>
 #include <sys/socket.h>
 
 #include "mbim-helpers-netlink.h"
@@ -146,6 +150,249 @@ mbim_helpers_netlink_message_free (NetlinkMessage *msg)
     g_byte_array_unref (msg);
 }
 
+NetlinkMessage *
+mbim_helpers_netlink_message_new_dump_links (void)
+{
+    NetlinkMessage *msg;
+
+    msg = mbim_helpers_netlink_message_new (RTM_GETLINK, NLM_F_DUMP);
+    /* A dump is terminated by NLMSG_DONE, not by an ACK */
+    mbim_helpers_netlink_get_message_header (msg)->msghdr.nlmsg_flags &= ~NLM_F_ACK;
+    return msg;
+}
+
+static NetlinkMessage *
+message_new_with_family_header (guint16       type,
+                                guint16       extra_flags,
+                                gconstpointer family_header,
+                                gsize         family_header_len)
+{
+    NetlinkMessage  *msg;
+    struct nlmsghdr  hdr;
+
+    memset (&hdr, 0, sizeof (hdr));
+    hdr.nlmsg_len = NLMSG_LENGTH (family_header_len);
+    hdr.nlmsg_type = type;
+    hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | extra_flags;
+
+    /* Only the netlink header is accessed through NetlinkHeader in these
+     * messages, the family header is not a struct ifinfomsg */
+    msg = g_byte_array_sized_new (NLMSG_SPACE (family_header_len));
+    g_byte_array_append (msg, (const guint8 *) &hdr, NLMSG_HDRLEN);
+    g_byte_array_append (msg, family_header, family_header_len);
+    return msg;
+}
+
+static gsize
+address_length (guint8 family)
+{
+    g_assert (family == AF_INET || family == AF_INET6);
+    return (family == AF_INET) ? 4 : 16;
+}
+
+NetlinkMessage *
+mbim_helpers_netlink_message_new_link_up (guint ifindex,
+                                          guint mtu)
+{
+    NetlinkMessage *msg;
+    NetlinkHeader  *hdr;
+
+    msg = mbim_helpers_netlink_message_new (RTM_NEWLINK, 0);
+    hdr = mbim_helpers_netlink_get_message_header (msg);
+    hdr->ifreq.ifi_index = ifindex;
+    hdr->ifreq.ifi_flags = IFF_UP;
+    hdr->ifreq.ifi_change = IFF_UP;
+    if (mtu)
+        mbim_helpers_netlink_append_attribute_uint32 (msg, IFLA_MTU, mtu);
+    return msg;
+}
+
+NetlinkMessage *
+mbim_helpers_netlink_message_new_address (guint16       type,
+                                          guint         ifindex,
+                                          guint8        family,
+                                          const guint8 *address,
+                                          guint8        prefix_length)
+{
+    NetlinkMessage   *msg;
+    struct ifaddrmsg  ifa;
+
+    g_assert (type == RTM_NEWADDR || type == RTM_DELADDR);
+
+    memset (&ifa, 0, sizeof (ifa));
+    ifa.ifa_family = family;
+    ifa.ifa_prefixlen = prefix_length;
+    ifa.ifa_scope = RT_SCOPE_UNIVERSE;
+    ifa.ifa_index = ifindex;
+    /* The address is given by the network, there is no need to wait for
+     * duplicate address detection before using it */
+    if (family == AF_INET6 && type == RTM_NEWADDR)
+        ifa.ifa_flags = IFA_F_NODAD;
+
+    msg = message_new_with_family_header (type,
+                                          (type == RTM_NEWADDR) ? (NLM_F_CREATE | NLM_F_REPLACE) : 0,
+                                          &ifa, sizeof (ifa));
+    append_netlink_attribute (msg, IFA_LOCAL, address, address_length (family));
+    append_netlink_attribute (msg, IFA_ADDRESS, address, address_length (family));
+    return msg;
+}
+
+NetlinkMessage *
+mbim_helpers_netlink_message_new_default_route (guint16       type,
+                                                guint         ifindex,
+                                                guint8        family,
+                                                const guint8 *gateway,
+                                                guint32       metric)
+{
+    NetlinkMessage *msg;
+    struct rtmsg    rtm;
+
+    g_assert (type == RTM_NEWROUTE || type == RTM_DELROUTE);
+
+    memset (&rtm, 0, sizeof (rtm));
+    rtm.rtm_family = family;
+    rtm.rtm_table = RT_TABLE_MAIN;
+    rtm.rtm_type = RTN_UNICAST;
+    if (type == RTM_NEWROUTE) {
+        rtm.rtm_protocol = RTPROT_STATIC;
+        rtm.rtm_scope = (family == AF_INET && !gateway) ? RT_SCOPE_LINK : RT_SCOPE_UNIVERSE;
+        /* The gateway is always reachable through the link, even when it is
+         * not in the prefix of any of the addresses */
+        if (gateway)
+            rtm.rtm_flags = RTNH_F_ONLINK;
+    } else
+        rtm.rtm_scope = RT_SCOPE_NOWHERE;
+
+    msg = message_new_with_family_header (type,
+                                          (type == RTM_NEWROUTE) ? (NLM_F_CREATE | NLM_F_REPLACE) : 0,
+                                          &rtm, sizeof (rtm));
+    mbim_helpers_netlink_append_attribute_uint32 (msg, RTA_OIF, ifindex);
+    mbim_helpers_netlink_append_attribute_uint32 (msg, RTA_PRIORITY, metric);
+    if (gateway)
+        append_netlink_attribute (msg, RTA_GATEWAY, gateway, address_length (family));
+    return msg;
+}
+
+/*****************************************************************************/
+/*
+ * Netlink message parsing functions
+ */
+
+static const gchar *
+attribute_get_string (struct rtattr *rta)
+{
+    /* Strings must be NUL-terminated within the attribute */
+    if (!RTA_PAYLOAD (rta) || !memchr (RTA_DATA (rta), '\0', RTA_PAYLOAD (rta)))
+        return NULL;
+    return (const gchar *) RTA_DATA (rta);
+}
+
+gboolean
+mbim_helpers_netlink_parse_link (struct nlmsghdr  *hdr,
+                                 guint            *ifindex,
+                                 const gchar     **ifname,
+                                 guint            *link_ifindex,
+                                 const gchar     **parent_dev_name)
+{
+    struct ifinfomsg *ifi;
+    struct rtattr    *rta;
+    gint              len;
+    gboolean          link_netnsid = FALSE;
+
+    if (hdr->nlmsg_type != RTM_NEWLINK && hdr->nlmsg_type != RTM_DELLINK)
+        return FALSE;
+    if (hdr->nlmsg_len < NLMSG_LENGTH (sizeof (struct ifinfomsg)))
+        return FALSE;
+
+    ifi = NLMSG_DATA (hdr);
+    /* Other families (e.g. AF_BRIDGE) report changes in a port, not in the link */
+    if (ifi->ifi_family != AF_UNSPEC || ifi->ifi_index <= 0)
+        return FALSE;
+
+    *ifindex = (guint) ifi->ifi_index;
+    *ifname = NULL;
+    *link_ifindex = 0;
+    *parent_dev_name = NULL;
+
+    len = (gint) IFLA_PAYLOAD (hdr);
+#if defined(__clang__) || defined(__GNUC__)
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wcast-align"
+#endif
+    for (rta = IFLA_RTA (ifi); RTA_OK (rta, len); rta = RTA_NEXT (rta, len)) {
+#if defined(__clang__) || defined(__GNUC__)
+# pragma GCC diagnostic pop
+#endif
+        switch (rta->rta_type) {
+        case IFLA_IFNAME:
+            *ifname = attribute_get_string (rta);
+            break;
+        case IFLA_LINK:
+            if (RTA_PAYLOAD (rta) >= sizeof (guint32))
+                memcpy (link_ifindex, RTA_DATA (rta), sizeof (guint32));
+            break;
+        case IFLA_LINK_NETNSID:
+            link_netnsid = TRUE;
+            break;
+        case MBIM_IFLA_PARENT_DEV_NAME:
+            *parent_dev_name = attribute_get_string (rta);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /* The lower link lives in a different network namespace */
+    if (link_netnsid)
+        *link_ifindex = 0;
+
+    return !!*ifname;
+}
+
+gboolean
+mbim_helpers_netlink_send_batch (GSocket       *socket,
+                                 GPtrArray     *msgs,
+                                 GCancellable  *cancellable,
+                                 GError       **error)
+{
+    g_autoptr(GByteArray) batch = NULL;
+    gssize                bytes_sent;
+    guint                 i;
+
+    g_assert (msgs->len > 0);
+
+    batch = g_byte_array_new ();
+    for (i = 0; i < msgs->len; i++) {
+        NetlinkMessage *msg;
+        guint           old_len;
+
+        msg = g_ptr_array_index (msgs, i);
+
+        /* Each message starts aligned in the batch */
+        old_len = batch->len;
+        g_byte_array_set_size (batch, NLMSG_ALIGN (old_len));
+        memset (batch->data + old_len, 0, batch->len - old_len);
+        g_byte_array_append (batch, msg->data, msg->len);
+    }
+
+    bytes_sent = g_socket_send (socket,
+                                (const gchar *) batch->data,
+                                batch->len,
+                                cancellable,
+                                error);
+    if (bytes_sent < 0)
+        return FALSE;
+
+    if ((guint) bytes_sent != batch->len) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                     "Netlink batch of %u messages only partially sent (%" G_GSSIZE_FORMAT " < %u)",
+                     msgs->len, bytes_sent, batch->len);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 /*****************************************************************************/
 /*
  * Transaction management functions
@@ -258,13 +505,23 @@ mbim_helpers_netlink_transaction_new (guint          *sequence_id,
 
 /*****************************************************************************/
 
+/* Large enough for the error ACKs of a batch, which echo the request, and for
+ * the parts of a link dump, which the kernel sizes after the receive buffer */
+#define NETLINK_RECEIVE_BUFFER_SIZE 8192
+
+typedef struct {
+    GHashTable           *transactions;
+    NetlinkLinkEventFunc  link_event_func;
+    gpointer              user_data;
+} NetlinkCallbackContext;
+
 static gboolean
-netlink_message_cb (GSocket      *socket,
-                    GIOCondition  condition,
-                    GHashTable   *transactions)
+netlink_message_cb (GSocket                *socket,
+                    GIOCondition            condition,
+                    NetlinkCallbackContext *ctx)
 {
     GError          *error = NULL;
-    gchar            buf[512];
+    gchar            buf[NETLINK_RECEIVE_BUFFER_SIZE];
     int              bytes_received;
     unsigned int     buffer_len;
     struct nlmsghdr *hdr;
@@ -277,6 +534,14 @@ netlink_message_cb (GSocket      *socket,
     bytes_received = g_socket_receive (socket, buf, sizeof (buf), NULL, &error);
 
     if (bytes_received < 0) {
+        /* ENOBUFS: the receive buffer overflowed and notifications were lost */
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE)) {
+            g_debug ("[netlink] notifications lost: %s", error->message);
+            g_error_free (error);
+            if (ctx->link_event_func)
+                ctx->link_event_func (NULL, ctx->user_data);
+            return G_SOURCE_CONTINUE;
+        }
         g_warning ("[netlink] socket i/o failure: %s", error->message);
         g_error_free (error);
         return G_SOURCE_REMOVE;
@@ -290,7 +555,7 @@ netlink_message_cb (GSocket      *socket,
 #endif
     for (hdr = (struct nlmsghdr *) buf;
          NLMSG_OK (hdr, buffer_len);
-         NLMSG_NEXT (hdr, buffer_len)) {
+         hdr = NLMSG_NEXT (hdr, buffer_len)) {
 #if defined(__clang__) || defined(__GNUC__)
 # pragma GCC diagnostic pop
 #endif
@@ -298,31 +563,58 @@ netlink_message_cb (GSocket      *socket,
         NetlinkTransaction *tr;
         struct nlmsgerr    *err;
 
-        if (hdr->nlmsg_type != NLMSG_ERROR)
+        if (hdr->nlmsg_type == RTM_NEWLINK || hdr->nlmsg_type == RTM_DELLINK) {
+            if (ctx->link_event_func)
+                ctx->link_event_func (hdr, ctx->user_data);
             continue;
+        }
 
-        tr = g_hash_table_lookup (transactions,
+        if (hdr->nlmsg_type != NLMSG_ERROR && hdr->nlmsg_type != NLMSG_DONE)
+            continue;
+
+        tr = g_hash_table_lookup (ctx->transactions,
                                   GUINT_TO_POINTER (hdr->nlmsg_seq));
         if (!tr)
             continue;
 
-        err = NLMSG_DATA (buf);
-        mbim_helpers_netlink_transaction_complete (tr, transactions, err->error);
+        /* Dumps are completed with NLMSG_DONE, which carries just the error */
+        if (hdr->nlmsg_type == NLMSG_DONE) {
+            gint done_error = 0;
+
+            if (hdr->nlmsg_len >= NLMSG_LENGTH (sizeof (gint)))
+                memcpy (&done_error, NLMSG_DATA (hdr), sizeof (gint));
+            if (!done_error && (hdr->nlmsg_flags & NLM_F_DUMP_INTR))
+                done_error = -EINTR;
+            mbim_helpers_netlink_transaction_complete (tr, ctx->transactions, -done_error);
+            continue;
+        }
+
+        err = NLMSG_DATA (hdr);
+        mbim_helpers_netlink_transaction_complete (tr, ctx->transactions, -err->error);
     }
     return G_SOURCE_CONTINUE;
 }
 
 void
-mbim_helpers_netlink_set_callback (GSource    **source,
-                                   GSocket     *socket,
-                                   GHashTable  *transactions)
+mbim_helpers_netlink_set_callback (GSource              **source,
+                                   GSocket               *socket,
+                                   GHashTable            *transactions,
+                                   NetlinkLinkEventFunc   link_event_func,
+                                   gpointer               user_data)
 {
+    NetlinkCallbackContext *ctx;
+
+    ctx = g_new0 (NetlinkCallbackContext, 1);
+    ctx->transactions = transactions;
+    ctx->link_event_func = link_event_func;
+    ctx->user_data = user_data;
+
     *source = g_socket_create_source (socket,
                                       G_IO_IN | G_IO_ERR | G_IO_HUP,
                                       NULL);
     g_source_set_callback (*source,
                            (GSourceFunc) netlink_message_cb,
-                           transactions,
-                           NULL);
+                           ctx,
+                           g_free);
     g_source_attach (*source, g_main_context_get_thread_default ());
 }
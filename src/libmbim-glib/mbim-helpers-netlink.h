@@ -21,6 +21,9 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
 G_BEGIN_DECLS
 
 typedef GByteArray NetlinkMessage;
@@ -67,6 +70,14 @@ NetlinkMessage *mbim_helpers_netlink_message_new (guint16 type,
 G_GNUC_INTERNAL
 void mbim_helpers_netlink_message_free (NetlinkMessage *msg);
 
+/* Sends all the given messages in a single datagram, so that the kernel
+ * processes them in order in one go. Each message gets its own ACK. */
+G_GNUC_INTERNAL
+gboolean mbim_helpers_netlink_send_batch (GSocket       *socket,
+                                          GPtrArray     *msgs,
+                                          GCancellable  *cancellable,
+                                          GError       **error);
+
 typedef struct {
     guint32  sequence_id;
     GSource *timeout_source;
@@ -93,10 +104,54 @@ NetlinkTransaction *mbim_helpers_netlink_transaction_new (guint          *sequen
                                                           guint           timeout,
                                                           GTask          *task);
 
+/* Link notifications, either received from the RTNLGRP_LINK group or as part
+ * of a RTM_GETLINK dump. Called with a NULL header when notifications have
+ * been lost and the caller needs to dump the links again. */
+typedef void (* NetlinkLinkEventFunc) (struct nlmsghdr *hdr,
+                                       gpointer         user_data);
+
+G_GNUC_INTERNAL
+NetlinkMessage *mbim_helpers_netlink_message_new_dump_links (void);
+
+/* Requests to configure IP settings in a link. Addresses are given in
+ * network byte order, 4 bytes long for AF_INET and 16 bytes for AF_INET6.
+ * The RTM_NEW* requests create or replace; the RTM_DEL* ones built with the
+ * same arguments undo them. */
+G_GNUC_INTERNAL
+NetlinkMessage *mbim_helpers_netlink_message_new_link_up (guint ifindex,
+                                                          guint mtu);
+
+G_GNUC_INTERNAL
+NetlinkMessage *mbim_helpers_netlink_message_new_address (guint16       type,
+                                                          guint         ifindex,
+                                                          guint8        family,
+                                                          const guint8 *address,
+                                                          guint8        prefix_length);
+
+G_GNUC_INTERNAL
+NetlinkMessage *mbim_helpers_netlink_message_new_default_route (guint16       type,
+                                                                guint         ifindex,
+                                                                guint8        family,
+                                                                const guint8 *gateway,
+                                                                guint32       metric);
+
+/* Parses a RTM_NEWLINK or RTM_DELLINK message. The returned strings point
+ * to the message contents. @link_ifindex is the index of the lower link
+ * (e.g. of a VLAN), @parent_dev_name the name of the parent device (e.g. of
+ * a WWAN link); 0 and NULL respectively if not given. */
+G_GNUC_INTERNAL
+gboolean mbim_helpers_netlink_parse_link (struct nlmsghdr  *hdr,
+                                          guint            *ifindex,
+                                          const gchar     **ifname,
+                                          guint            *link_ifindex,
+                                          const gchar     **parent_dev_name);
+
 G_GNUC_INTERNAL
-void mbim_helpers_netlink_set_callback (GSource    **source,
-                                        GSocket     *socket,
-                                        GHashTable  *transactions);
+void mbim_helpers_netlink_set_callback (GSource              **source,
+                                        GSocket               *socket,
+                                        GHashTable            *transactions,
+                                        NetlinkLinkEventFunc   link_event_func,
+                                        gpointer               user_data);
 
 G_END_DECLS
 
@@ -0,0 +1,427 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libmbim-glib -- GLib/GIO based library to control MBIM devices
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include "mbim-message-codec.h"
+#include "mbim-message-private.h"
+#include "mbim-error-types.h"
+#include "mbim-utils.h"
+
+/*****************************************************************************/
+
+static gboolean
+field_has_size_output (const MbimMessageCodecField *field)
+{
+    return (field->format == MBIM_MESSAGE_CODEC_FORMAT_UNSIZED_BYTE_ARRAY ||
+            field->format == MBIM_MESSAGE_CODEC_FORMAT_REF_BYTE_ARRAY);
+}
+
+/* Whether the field is read through the cursor, as it is fully within the
+ * leading fixed-size fields already validated */
+static gboolean
+field_in_fixed_prefix (const MbimMessageCodecMessage *descriptor,
+                       const MbimMessageCodecField   *field,
+                       guint32                        offset)
+{
+    guint32 size;
+
+    switch (field->format) {
+    case MBIM_MESSAGE_CODEC_FORMAT_GUINT16:
+        size = 2;
+        break;
+    case MBIM_MESSAGE_CODEC_FORMAT_GUINT32:
+        size = 4;
+        break;
+    case MBIM_MESSAGE_CODEC_FORMAT_GUINT64:
+        size = 8;
+        break;
+    case MBIM_MESSAGE_CODEC_FORMAT_UUID:
+        size = 16;
+        break;
+    case MBIM_MESSAGE_CODEC_FORMAT_BYTE_ARRAY:
+        size = field->array_size;
+        break;
+    default:
+        return FALSE;
+    }
+
+    return ((guint64) offset + size <= descriptor->fixed_size);
+}
+
+static gboolean
+message_has_information_buffer (const MbimMessage *message)
+{
+    switch (mbim_message_get_message_type (message)) {
+    case MBIM_MESSAGE_TYPE_COMMAND:
+        return !!mbim_message_command_get_raw_information_buffer (message, NULL);
+    case MBIM_MESSAGE_TYPE_COMMAND_DONE:
+        return !!mbim_message_command_done_get_raw_information_buffer (message, NULL);
+    case MBIM_MESSAGE_TYPE_INDICATE_STATUS:
+        return !!mbim_message_indicate_status_get_raw_information_buffer (message, NULL);
+    case MBIM_MESSAGE_TYPE_INVALID:
+    case MBIM_MESSAGE_TYPE_OPEN:
+    case MBIM_MESSAGE_TYPE_CLOSE:
+    case MBIM_MESSAGE_TYPE_HOST_ERROR:
+    case MBIM_MESSAGE_TYPE_OPEN_DONE:
+    case MBIM_MESSAGE_TYPE_CLOSE_DONE:
+    case MBIM_MESSAGE_TYPE_FUNCTION_ERROR:
+    default:
+        return FALSE;
+    }
+}
+
+/*****************************************************************************/
+
+MbimMessage *
+_mbim_message_codec_build (MbimService                    service,
+                           guint32                        cid,
+                           MbimMessageCommandType         command_type,
+                           const MbimMessageCodecMessage *descriptor,
+                           const MbimMessageCodecValue   *values)
+{
+    MbimMessageCommandBuilder *builder;
+    guint                      i;
+
+    builder = _mbim_message_command_builder_new (0, service, cid, command_type);
+
+    for (i = 0; i < descriptor->n_fields; i++) {
+        const MbimMessageCodecField *field = &descriptor->fields[i];
+        gboolean                     pad_array;
+
+        pad_array = !(field->flags & MBIM_MESSAGE_CODEC_FLAG_NO_PAD);
+
+        switch (field->format) {
+        case MBIM_MESSAGE_CODEC_FORMAT_GUINT16:
+            _mbim_message_command_builder_append_guint16 (builder, (guint16) values[i].integer);
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_GUINT32:
+            _mbim_message_command_builder_append_guint32 (builder, (guint32) values[i].integer);
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_GUINT64:
+            _mbim_message_command_builder_append_guint64 (builder, values[i].integer);
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_UUID:
+            _mbim_message_command_builder_append_uuid (builder, values[i].pointer);
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_BYTE_ARRAY:
+            _mbim_message_command_builder_append_byte_array (builder, FALSE, FALSE, pad_array, values[i].pointer, field->array_size, FALSE);
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_UNSIZED_BYTE_ARRAY:
+            _mbim_message_command_builder_append_byte_array (builder, FALSE, FALSE, pad_array, values[i].pointer, values[i].size, FALSE);
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_REF_BYTE_ARRAY:
+            _mbim_message_command_builder_append_byte_array (builder, TRUE, TRUE, pad_array, values[i].pointer, values[i].size, FALSE);
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_STRING:
+            _mbim_message_command_builder_append_string (builder, values[i].pointer);
+            break;
+        default:
+            g_assert_not_reached ();
+        }
+    }
+
+    return _mbim_message_command_builder_complete (builder);
+}
+
+/*****************************************************************************/
+
+gboolean
+_mbim_message_codec_parse (const MbimMessage             *message,
+                           MbimMessageType                message_type,
+                           const MbimMessageCodecMessage *descriptor,
+                           gpointer                      *out,
+                           GError                       **error)
+{
+    MbimMessageCursor   cursor;
+    gboolean            success = FALSE;
+    guint32             offset = 0;
+    guint               slot = 0;
+    guint               i;
+    gchar             **strings;
+
+    if (mbim_message_get_message_type (message) != message_type) {
+        g_set_error (error,
+                     MBIM_CORE_ERROR,
+                     MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     (message_type == MBIM_MESSAGE_TYPE_COMMAND_DONE) ?
+                     "Message is not a response" :
+                     "Message is not a notification");
+        return FALSE;
+    }
+
+    if (!message_has_information_buffer (message)) {
+        g_set_error (error,
+                     MBIM_CORE_ERROR,
+                     MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "Message does not have information buffer");
+        return FALSE;
+    }
+
+    _mbim_message_cursor_init (&cursor, message);
+    if (descriptor->fixed_size > 0 && !_mbim_message_cursor_check (&cursor, 0, descriptor->fixed_size, error))
+        return FALSE;
+
+    /* Allocated outputs are only given on success */
+    strings = g_newa (gchar *, descriptor->n_fields);
+    memset (strings, 0, sizeof (gchar *) * descriptor->n_fields);
+
+    for (i = 0; i < descriptor->n_fields; i++) {
+        const MbimMessageCodecField *field = &descriptor->fields[i];
+        gboolean                     in_prefix;
+
+        in_prefix = field_in_fixed_prefix (descriptor, field, offset);
+
+        switch (field->format) {
+        case MBIM_MESSAGE_CODEC_FORMAT_GUINT16:
+            if (out[slot]) {
+                if (in_prefix)
+                    *((guint16 *) out[slot]) = _mbim_message_cursor_get_guint16 (&cursor, offset);
+                else if (!_mbim_message_read_guint16 (message, offset, out[slot], error))
+                    goto out;
+            }
+            offset += 2;
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_GUINT32:
+            if (out[slot]) {
+                if (in_prefix)
+                    *((guint32 *) out[slot]) = _mbim_message_cursor_get_guint32 (&cursor, offset);
+                else if (!_mbim_message_read_guint32 (message, offset, out[slot], error))
+                    goto out;
+            }
+            offset += 4;
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_GUINT64:
+            if (out[slot]) {
+                if (in_prefix)
+                    *((guint64 *) out[slot]) = _mbim_message_cursor_get_guint64 (&cursor, offset);
+                else if (!_mbim_message_read_guint64 (message, offset, out[slot], error))
+                    goto out;
+            }
+            offset += 8;
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_UUID:
+            /* NOTE: The output MbimUuid address would be broken if the contents of the message are misaligned. */
+            if (out[slot]) {
+                if (in_prefix)
+                    *((const MbimUuid **) out[slot]) = (const MbimUuid *) _mbim_message_cursor_peek (&cursor, offset);
+                else if (!_mbim_message_read_uuid (message, offset, out[slot], NULL, error))
+                    goto out;
+            }
+            offset += 16;
+            break;
+        case MBIM_MESSAGE_CODEC_FORMAT_BYTE_ARRAY: {
+            const guint8 *tmp;
+
+            if (in_prefix)
+                tmp = _mbim_message_cursor_peek (&cursor, offset);
+            else if (!_mbim_message_read_byte_array (message, 0, offset, FALSE, FALSE, field->array_size, &tmp, NULL, error, FALSE))
+                goto out;
+            if (out[slot])
+                *((const guint8 **) out[slot]) = tmp;
+            offset += field->array_size;
+            break;
+        }
+        case MBIM_MESSAGE_CODEC_FORMAT_UNSIZED_BYTE_ARRAY:
+        case MBIM_MESSAGE_CODEC_FORMAT_REF_BYTE_ARRAY: {
+            const guint8 *tmp;
+            guint32       tmpsize;
+            gboolean      ref;
+
+            ref = (field->format == MBIM_MESSAGE_CODEC_FORMAT_REF_BYTE_ARRAY);
+            if (!_mbim_message_read_byte_array (message, 0, offset, ref, ref, 0, &tmp, &tmpsize, error, FALSE))
+                goto out;
+            if (out[slot])
+                *((guint32 *) out[slot]) = tmpsize;
+            if (out[slot + 1])
+                *((const guint8 **) out[slot + 1]) = tmp;
+            offset += (ref ? 8 : tmpsize);
+            break;
+        }
+        case MBIM_MESSAGE_CODEC_FORMAT_STRING:
+            if (out[slot] &&
+                !_mbim_message_read_string (message, 0, offset,
+                                            (field->flags & MBIM_MESSAGE_CODEC_FLAG_UTF8) ? MBIM_STRING_ENCODING_UTF8 : MBIM_STRING_ENCODING_UTF16,
+                                            &strings[i], NULL, error))
+                goto out;
+            offset += 8;
+            break;
+        default:
+            g_assert_not_reached ();
+        }
+
+        slot += field_has_size_output (field) ? 2 : 1;
+    }
+
+    /* All variables successfully parsed */
+    success = TRUE;
+
+ out:
+
+    for (i = 0, slot = 0; i < descriptor->n_fields; i++) {
+        const MbimMessageCodecField *field = &descriptor->fields[i];
+
+        if (field->format == MBIM_MESSAGE_CODEC_FORMAT_STRING) {
+            if (success && out[slot])
+                *((gchar **) out[slot]) = strings[i];
+            else
+                g_free (strings[i]);
+        }
+        slot += field_has_size_output (field) ? 2 : 1;
+    }
+
+    return success;
+}
+
+/*****************************************************************************/
+
+static void
+print_integer (GString                     *str,
+               const MbimMessageCodecField *field,
+               guint64                      value)
+{
+    if (field->flags & MBIM_MESSAGE_CODEC_FLAG_BOOLEAN)
+        g_string_append_printf (str, "'%s'", value ? "true" : "false");
+    else if (field->flags & MBIM_MESSAGE_CODEC_FLAG_ENUM)
+        g_string_append_printf (str, "'%s'", ((MbimMessageCodecEnumGetString) field->printable) ((guint) value));
+    else if (field->flags & MBIM_MESSAGE_CODEC_FLAG_FLAGS) {
+        g_autofree gchar *tmpstr = NULL;
+
+        tmpstr = ((MbimMessageCodecFlagsBuildString) field->printable) ((guint) value);
+        g_string_append_printf (str, "'%s'", tmpstr);
+    } else
+        g_string_append_printf (str, "'%" G_GUINT64_FORMAT "'", value);
+}
+
+gchar *
+_mbim_message_codec_print (const MbimMessage             *message,
+                           const MbimMessageCodecMessage *descriptor,
+                           const gchar                   *line_prefix)
+{
+    GString  *str;
+    GError   *inner_error = NULL;
+    guint32   offset = 0;
+    gboolean  show_field;
+    guint     i;
+
+    if (!message_has_information_buffer (message))
+        return NULL;
+
+    show_field = mbim_utils_get_show_personal_info ();
+
+    str = g_string_new ("");
+
+    for (i = 0; i < descriptor->n_fields; i++) {
+        const MbimMessageCodecField *field = &descriptor->fields[i];
+        gboolean                     hidden;
+
+        hidden = ((field->flags & MBIM_MESSAGE_CODEC_FLAG_PERSONAL_INFO) && !show_field);
+
+        g_string_append_printf (str, "%s  %s = ", line_prefix, field->name);
+
+        switch (field->format) {
+        case MBIM_MESSAGE_CODEC_FORMAT_GUINT16: {
+            guint16 tmp;
+
+            if (!_mbim_message_read_guint16 (message, offset, &tmp, &inner_error))
+                goto out;
+            offset += 2;
+            if (!hidden)
+                print_integer (str, field, tmp);
+            break;
+        }
+        case MBIM_MESSAGE_CODEC_FORMAT_GUINT32: {
+            guint32 tmp;
+
+            if (!_mbim_message_read_guint32 (message, offset, &tmp, &inner_error))
+                goto out;
+            offset += 4;
+            if (!hidden)
+                print_integer (str, field, tmp);
+            break;
+        }
+        case MBIM_MESSAGE_CODEC_FORMAT_GUINT64: {
+            guint64 tmp;
+
+            if (!_mbim_message_read_guint64 (message, offset, &tmp, &inner_error))
+                goto out;
+            offset += 8;
+            if (!hidden)
+                print_integer (str, field, tmp);
+            break;
+        }
+        case MBIM_MESSAGE_CODEC_FORMAT_UUID: {
+            MbimUuid          tmp;
+            g_autofree gchar *tmpstr = NULL;
+
+            if (!_mbim_message_read_uuid (message, offset, NULL, &tmp, &inner_error))
+                goto out;
+            offset += 16;
+            if (!hidden) {
+                tmpstr = mbim_uuid_get_printable (&tmp);
+                g_string_append_printf (str, "'%s'", tmpstr);
+            }
+            break;
+        }
+        case MBIM_MESSAGE_CODEC_FORMAT_BYTE_ARRAY:
+        case MBIM_MESSAGE_CODEC_FORMAT_UNSIZED_BYTE_ARRAY:
+        case MBIM_MESSAGE_CODEC_FORMAT_REF_BYTE_ARRAY: {
+            const guint8 *tmp;
+            guint32       tmpsize;
+            guint         j;
+
+            if (field->format == MBIM_MESSAGE_CODEC_FORMAT_BYTE_ARRAY) {
+                if (!_mbim_message_read_byte_array (message, 0, offset, FALSE, FALSE, field->array_size, &tmp, NULL, &inner_error, FALSE))
+                    goto out;
+                tmpsize = field->array_size;
+                offset += field->array_size;
+            } else if (field->format == MBIM_MESSAGE_CODEC_FORMAT_UNSIZED_BYTE_ARRAY) {
+                if (!_mbim_message_read_byte_array (message, 0, offset, FALSE, FALSE, 0, &tmp, &tmpsize, &inner_error, FALSE))
+                    goto out;
+                offset += tmpsize;
+            } else {
+                if (!_mbim_message_read_byte_array (message, 0, offset, TRUE, TRUE, 0, &tmp, &tmpsize, &inner_error, FALSE))
+                    goto out;
+                offset += 8;
+            }
+            if (!hidden) {
+                g_string_append (str, "'");
+                for (j = 0; j < tmpsize; j++)
+                    g_string_append_printf (str, "%02x%s", tmp[j], (j == (tmpsize - 1)) ? "" : ":" );
+                g_string_append (str, "'");
+            }
+            break;
+        }
+        case MBIM_MESSAGE_CODEC_FORMAT_STRING: {
+            g_autofree gchar *tmp = NULL;
+
+            if (!_mbim_message_read_string (message, 0, offset,
+                                            (field->flags & MBIM_MESSAGE_CODEC_FLAG_UTF8) ? MBIM_STRING_ENCODING_UTF8 : MBIM_STRING_ENCODING_UTF16,
+                                            &tmp, NULL, &inner_error))
+                goto out;
+            offset += 8;
+            if (!hidden)
+                g_string_append_printf (str, "'%s'", tmp);
+            break;
+        }
+        default:
+            g_assert_not_reached ();
+        }
+
+        if (hidden)
+            g_string_append (str, "'###'");
+        g_string_append (str, "\n");
+    }
+
+ out:
+    if (inner_error) {
+        g_string_append_printf (str, "n/a: %s", inner_error->message);
+        g_clear_error (&inner_error);
+    }
+
+    return g_string_free (str, FALSE);
+}
@@ -0,0 +1,102 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libmbim-glib -- GLib/GIO based library to control MBIM devices
+ *
+ * This is a private non-installed header
+ */
+
+#ifndef _LIBMBIM_GLIB_MBIM_MESSAGE_CODEC_H_
+#define _LIBMBIM_GLIB_MBIM_MESSAGE_CODEC_H_
+
+#if !defined (LIBMBIM_GLIB_COMPILATION)
+#error "This is a private header!!"
+#endif
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "mbim-uuid.h"
+#include "mbim-message.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Table-driven message codec.
+ *
+ * When the code generator runs with --tables, the messages with only simple
+ * fields are described by constant field tables, and their creator, parser
+ * and printable functions are thin wrappers around the generic interpreter
+ * implemented here, instead of each one having its own generated code.
+ *
+ * The behavior of the interpreter must be the same as the one of the
+ * generated code, including the printable output and the error messages.
+ */
+
+typedef enum {
+    MBIM_MESSAGE_CODEC_FORMAT_GUINT16,
+    MBIM_MESSAGE_CODEC_FORMAT_GUINT32,
+    MBIM_MESSAGE_CODEC_FORMAT_GUINT64,
+    MBIM_MESSAGE_CODEC_FORMAT_UUID,
+    MBIM_MESSAGE_CODEC_FORMAT_BYTE_ARRAY,
+    MBIM_MESSAGE_CODEC_FORMAT_UNSIZED_BYTE_ARRAY,
+    MBIM_MESSAGE_CODEC_FORMAT_REF_BYTE_ARRAY,
+    MBIM_MESSAGE_CODEC_FORMAT_STRING,
+} MbimMessageCodecFormat;
+
+typedef enum {
+    MBIM_MESSAGE_CODEC_FLAG_NONE          = 0,
+    MBIM_MESSAGE_CODEC_FLAG_PERSONAL_INFO = 1 << 0,
+    MBIM_MESSAGE_CODEC_FLAG_UTF8          = 1 << 1, /* strings only */
+    MBIM_MESSAGE_CODEC_FLAG_NO_PAD        = 1 << 2, /* byte arrays only */
+    MBIM_MESSAGE_CODEC_FLAG_BOOLEAN       = 1 << 3, /* integers only */
+    MBIM_MESSAGE_CODEC_FLAG_ENUM          = 1 << 4, /* integers only, with printable */
+    MBIM_MESSAGE_CODEC_FLAG_FLAGS         = 1 << 5, /* integers only, with printable */
+} MbimMessageCodecFlag;
+
+/* Types of the printable callback, as given in the field as a GCallback */
+typedef const gchar *(* MbimMessageCodecEnumGetString)    (guint value);
+typedef gchar       *(* MbimMessageCodecFlagsBuildString) (guint value);
+
+typedef struct {
+    const gchar *name;
+    guint8       format;     /* MbimMessageCodecFormat */
+    guint8       flags;      /* MbimMessageCodecFlag */
+    guint16      array_size; /* fixed-size byte arrays only */
+    GCallback    printable;  /* enum or flags string builder */
+} MbimMessageCodecField;
+
+typedef struct {
+    guint32                      fixed_size; /* size of the leading fixed-size fields */
+    guint32                      n_fields;
+    const MbimMessageCodecField *fields;
+} MbimMessageCodecMessage;
+
+/* One value per field when building; byte arrays use both size and pointer */
+typedef struct {
+    guint64       integer;
+    guint32       size;
+    gconstpointer pointer;
+} MbimMessageCodecValue;
+
+MbimMessage *_mbim_message_codec_build (MbimService                    service,
+                                        guint32                        cid,
+                                        MbimMessageCommandType         command_type,
+                                        const MbimMessageCodecMessage *descriptor,
+                                        const MbimMessageCodecValue   *values);
+
+/* One output location per field, or %NULL if not requested; the unsized and
+ * ref byte arrays take two, the size and then the array */
+gboolean     _mbim_message_codec_parse (const MbimMessage             *message,
+                                        MbimMessageType                message_type,
+                                        const MbimMessageCodecMessage *descriptor,
+                                        gpointer                      *out,
+                                        GError                       **error);
+
+gchar       *_mbim_message_codec_print (const MbimMessage             *message,
+                                        const MbimMessageCodecMessage *descriptor,
+                                        const gchar                   *line_prefix);
+
+G_END_DECLS
+
+#endif /* _LIBMBIM_GLIB_MBIM_MESSAGE_CODEC_H_ */
@@ -0,0 +1,293 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libmbim-glib -- GLib/GIO based library to control MBIM devices
+ */
+
+#include <config.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "mbim-message-json.h"
+#include "mbim-enum-types.h"
+
+/*****************************************************************************/
+
+void
+_mbim_json_append_separator (GString *output)
+{
+    gchar last;
+
+    if (!output->len)
+        return;
+
+    last = output->str[output->len - 1];
+    if (last != '{' && last != '[')
+        g_string_append_c (output, ',');
+}
+
+void
+_mbim_json_append_key (GString     *output,
+                       const gchar *key)
+{
+    _mbim_json_append_separator (output);
+    _mbim_json_append_string (output, key);
+    g_string_append_c (output, ':');
+}
+
+/*****************************************************************************/
+
+static void
+append_unichar_escaped (GString  *output,
+                        gunichar  c)
+{
+    switch (c) {
+    case '"':
+        g_string_append (output, "\\\"");
+        break;
+    case '\\':
+        g_string_append (output, "\\\\");
+        break;
+    case '\n':
+        g_string_append (output, "\\n");
+        break;
+    case '\r':
+        g_string_append (output, "\\r");
+        break;
+    case '\t':
+        g_string_append (output, "\\t");
+        break;
+    default:
+        if (c < 0x20)
+            g_string_append_printf (output, "\\u%04x", c);
+        else
+            g_string_append_unichar (output, c);
+        break;
+    }
+}
+
+void
+_mbim_json_append_string (GString     *output,
+                          const gchar *str)
+{
+    if (!str) {
+        g_string_append (output, "null");
+        return;
+    }
+
+    _mbim_json_append_utf8 (output, (const guint8 *)str, strlen (str));
+}
+
+void
+_mbim_json_append_utf8 (GString      *output,
+                        const guint8 *data,
+                        guint32       size)
+{
+    const gchar *p;
+    const gchar *end;
+
+    /* Like when parsing the message, the size may include the trailing NUL
+     * bytes, which are not part of the string */
+    while (size > 0 && data[size - 1] == '\0')
+        size--;
+
+    p = (const gchar *)data;
+    end = p + size;
+
+    g_string_append_c (output, '"');
+    while (p < end) {
+        gunichar c;
+
+        /* Plain ASCII characters are appended as they are */
+        if ((guint8)*p >= 0x20 && (guint8)*p < 0x80 && *p != '"' && *p != '\\') {
+            g_string_append_c (output, *p);
+            p++;
+            continue;
+        }
+
+        c = g_utf8_get_char_validated (p, end - p);
+        if (c == (gunichar)-1 || c == (gunichar)-2) {
+            /* Invalid sequences are replaced byte by byte */
+            g_string_append_unichar (output, 0xFFFD);
+            p++;
+            continue;
+        }
+        append_unichar_escaped (output, c);
+        p = g_utf8_next_char (p);
+    }
+    g_string_append_c (output, '"');
+}
+
+void
+_mbim_json_append_utf16 (GString              *output,
+                         const MbimStringView *view)
+{
+    guint32 i;
+
+    g_string_append_c (output, '"');
+    for (i = 0; i + 1 < view->size; i += 2) {
+        gunichar c;
+
+        c = view->data[i] | (view->data[i + 1] << 8);
+        /* The string ends at the first NUL, as when converted to UTF-8 */
+        if (c == 0)
+            break;
+        if (c >= 0xD800 && c < 0xDC00) {
+            gunichar low;
+
+            /* A high surrogate must be followed by a low surrogate */
+            if (i + 3 < view->size) {
+                low = view->data[i + 2] | (view->data[i + 3] << 8);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    i += 2;
+                } else
+                    c = 0xFFFD;
+            } else
+                c = 0xFFFD;
+        } else if (c >= 0xDC00 && c < 0xE000)
+            c = 0xFFFD;
+
+        append_unichar_escaped (output, c);
+    }
+    g_string_append_c (output, '"');
+}
+
+/*****************************************************************************/
+
+void
+_mbim_json_append_boolean (GString  *output,
+                           gboolean  value)
+{
+    g_string_append (output, value ? "true" : "false");
+}
+
+void
+_mbim_json_append_hex (GString      *output,
+                       const guint8 *data,
+                       guint32       size)
+{
+    static const gchar digits[] = "0123456789abcdef";
+    guint32            i;
+
+    g_string_append_c (output, '"');
+    for (i = 0; i < size; i++) {
+        if (i > 0)
+            g_string_append_c (output, ':');
+        g_string_append_c (output, digits[data[i] >> 4]);
+        g_string_append_c (output, digits[data[i] & 0x0F]);
+    }
+    g_string_append_c (output, '"');
+}
+
+void
+_mbim_json_append_uuid (GString        *output,
+                        const MbimUuid *uuid)
+{
+    g_string_append_printf (output,
+                            "\""
+                            "%02x%02x%02x%02x-"
+                            "%02x%02x-"
+                            "%02x%02x-"
+                            "%02x%02x-"
+                            "%02x%02x%02x%02x%02x%02x"
+                            "\"",
+                            uuid->a[0], uuid->a[1], uuid->a[2], uuid->a[3],
+                            uuid->b[0], uuid->b[1],
+                            uuid->c[0], uuid->c[1],
+                            uuid->d[0], uuid->d[1],
+                            uuid->e[0], uuid->e[1], uuid->e[2], uuid->e[3], uuid->e[4], uuid->e[5]);
+}
+
+void
+_mbim_json_append_ipv4 (GString        *output,
+                        const MbimIPv4 *ipv4)
+{
+    gchar str[INET_ADDRSTRLEN];
+
+    if (!inet_ntop (AF_INET, ipv4->addr, str, sizeof (str))) {
+        g_string_append (output, "null");
+        return;
+    }
+    g_string_append_printf (output, "\"%s\"", str);
+}
+
+void
+_mbim_json_append_ipv6 (GString        *output,
+                        const MbimIPv6 *ipv6)
+{
+    gchar str[INET6_ADDRSTRLEN];
+
+    if (!inet_ntop (AF_INET6, ipv6->addr, str, sizeof (str))) {
+        g_string_append (output, "null");
+        return;
+    }
+    g_string_append_printf (output, "\"%s\"", str);
+}
+
+/*****************************************************************************/
+
+void
+_mbim_json_append_enum (GString     *output,
+                        const gchar *nick,
+                        guint64      value)
+{
+    if (nick)
+        _mbim_json_append_string (output, nick);
+    else
+        g_string_append_printf (output, "%" G_GUINT64_FORMAT, value);
+}
+
+void
+_mbim_json_append_flags (GString *output,
+                         GType    flags_type,
+                         guint    value)
+{
+    GFlagsClass *flags_class;
+    guint        unknown;
+    guint        i;
+
+    /* The class of a static type is never finalized, so taking a reference
+     * here does not allocate anything after the first time */
+    flags_class = G_FLAGS_CLASS (g_type_class_ref (flags_type));
+
+    unknown = value;
+    g_string_append_c (output, '[');
+    for (i = 0; i < flags_class->n_values; i++) {
+        const GFlagsValue *flags_value = &flags_class->values[i];
+
+        if (!flags_value->value || (value & flags_value->value) != flags_value->value)
+            continue;
+        _mbim_json_append_separator (output);
+        _mbim_json_append_string (output, flags_value->value_nick);
+        unknown &= ~flags_value->value;
+    }
+    if (unknown) {
+        _mbim_json_append_separator (output);
+        g_string_append_printf (output, "%u", unknown);
+    }
+    g_string_append_c (output, ']');
+
+    g_type_class_unref (flags_class);
+}
+
+/*****************************************************************************/
+
+void
+_mbim_json_append_tlv (GString       *output,
+                       const MbimTlv *tlv)
+{
+    MbimTlvType   tlv_type;
+    const guint8 *data;
+    guint32       data_size = 0;
+
+    tlv_type = mbim_tlv_get_tlv_type (tlv);
+    data = mbim_tlv_get_tlv_data (tlv, &data_size);
+
+    g_string_append_c (output, '{');
+    _mbim_json_append_key (output, "type");
+    _mbim_json_append_enum (output, mbim_tlv_type_get_string (tlv_type), tlv_type);
+    _mbim_json_append_key (output, "data");
+    _mbim_json_append_hex (output, data, data_size);
+    g_string_append_c (output, '}');
+}
@@ -0,0 +1,74 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libmbim-glib -- GLib/GIO based library to control MBIM devices
+ *
+ * This is a private non-installed header
+ */
+
+#ifndef _LIBMBIM_GLIB_MBIM_MESSAGE_JSON_H_
+#define _LIBMBIM_GLIB_MBIM_MESSAGE_JSON_H_
+
+#if !defined (LIBMBIM_GLIB_COMPILATION)
+#error "This is a private header!!"
+#endif
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "mbim-uuid.h"
+#include "mbim-message.h"
+#include "mbim-tlv.h"
+
+G_BEGIN_DECLS
+
+/*
+ * JSON writer used by the generated message serializers.
+ *
+ * All values are appended directly to the output string, without building
+ * any intermediate string per field. Object members and array elements are
+ * separated automatically: a comma is added unless the previous character is
+ * the start of the enclosing object or array.
+ */
+
+void _mbim_json_append_separator (GString *output);
+void _mbim_json_append_key       (GString     *output,
+                                  const gchar *key);
+
+/* NULL strings are written as null */
+void _mbim_json_append_string    (GString     *output,
+                                  const gchar *str);
+void _mbim_json_append_utf8      (GString      *output,
+                                  const guint8 *data,
+                                  guint32       size);
+void _mbim_json_append_utf16     (GString              *output,
+                                  const MbimStringView *view);
+
+void _mbim_json_append_boolean   (GString  *output,
+                                  gboolean  value);
+void _mbim_json_append_hex       (GString      *output,
+                                  const guint8 *data,
+                                  guint32       size);
+void _mbim_json_append_uuid      (GString        *output,
+                                  const MbimUuid *uuid);
+void _mbim_json_append_ipv4      (GString        *output,
+                                  const MbimIPv4 *ipv4);
+void _mbim_json_append_ipv6      (GString        *output,
+                                  const MbimIPv6 *ipv6);
+
+/* Enums are written as their nick, or as a number if the value is unknown;
+ * flags are written as an array of nicks, plus a number with the unknown
+ * bits if any */
+void _mbim_json_append_enum      (GString     *output,
+                                  const gchar *nick,
+                                  guint64      value);
+void _mbim_json_append_flags     (GString *output,
+                                  GType    flags_type,
+                                  guint    value);
+
+void _mbim_json_append_tlv       (GString       *output,
+                                  const MbimTlv *tlv);
+
+G_END_DECLS
+
+#endif /* _LIBMBIM_GLIB_MBIM_MESSAGE_JSON_H_ */
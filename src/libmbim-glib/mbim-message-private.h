@@ -16,6 +16,7 @@
 #endif
 
 #include <glib.h>
+#include <string.h>
 
 #include "mbim-message.h"
 #include "mbim-tlv.h"
@@ -313,6 +314,12 @@ gboolean _mbim_message_read_string        (const MbimMessage  *self,
                                            gchar             **str,
                                            guint32            *bytes_read,
                                            GError            **error);
+gboolean _mbim_message_read_string_view   (const MbimMessage   *self,
+                                           guint32              struct_start_offset,
+                                           guint32              relative_offset,
+                                           MbimStringView      *view,
+                                           guint32             *bytes_read,
+                                           GError             **error);
 gboolean _mbim_message_read_string_array  (const MbimMessage   *self,
                                            guint32              array_size,
                                            guint32              struct_start_offset,
@@ -364,6 +371,93 @@ gboolean _mbim_message_read_tlv_list          (const MbimMessage  *self,
                                                GList             **tlv,
                                                guint32            *bytes_read,
                                                GError            **error);
+gboolean _mbim_message_skip_tlv               (const MbimMessage  *self,
+                                               guint32             relative_offset,
+                                               guint32            *bytes_read,
+                                               GError            **error);
+/* Advances the offset over an array of fixed-size elements (e.g. the offset/size
+ * pairs of a ref-struct-array), failing if the array exceeds the message */
+gboolean _mbim_message_skip_array             (const MbimMessage  *self,
+                                               guint32            *relative_offset,
+                                               guint32             n_elements,
+                                               guint32             element_size,
+                                               GError            **error);
+gboolean _mbim_message_tlv_iter_init          (const MbimMessage  *self,
+                                               guint32             relative_offset,
+                                               MbimTlvIter        *iter,
+                                               GError            **error);
+
+/*****************************************************************************/
+/* Parse cursor
+ *
+ * The information buffer of the message is resolved once, and the fixed-size
+ * fields at the beginning of a message or struct are validated with a single
+ * check; those fields are then read without any further bounds check. Only
+ * offsets within a range validated with _mbim_message_cursor_check() may be
+ * given to the getters. */
+
+typedef struct {
+    const guint8 *data; /* start of the information buffer */
+    guint32       len;  /* bytes available from the start of the information buffer */
+} MbimMessageCursor;
+
+void     _mbim_message_cursor_init  (MbimMessageCursor        *cursor,
+                                     const MbimMessage        *self);
+gboolean _mbim_message_cursor_check (const MbimMessageCursor  *cursor,
+                                     guint32                   relative_offset,
+                                     guint32                   size,
+                                     GError                  **error);
+/* Validates an array of fixed-size elements at once, e.g. to be read in place
+ * through the generated struct overlays */
+gboolean _mbim_message_cursor_check_array (const MbimMessageCursor  *cursor,
+                                           guint32                   relative_offset,
+                                           guint32                   n_elements,
+                                           guint32                   element_size,
+                                           GError                  **error);
+
+static inline const guint8 *
+_mbim_message_cursor_peek (const MbimMessageCursor *cursor,
+                           guint32                  relative_offset)
+{
+    return cursor->data + relative_offset;
+}
+
+static inline guint16
+_mbim_message_cursor_get_guint16 (const MbimMessageCursor *cursor,
+                                  guint32                  relative_offset)
+{
+    guint16 tmp;
+
+    memcpy (&tmp, cursor->data + relative_offset, 2);
+    return GUINT16_FROM_LE (tmp);
+}
+
+static inline guint32
+_mbim_message_cursor_get_guint32 (const MbimMessageCursor *cursor,
+                                  guint32                  relative_offset)
+{
+    guint32 tmp;
+
+    memcpy (&tmp, cursor->data + relative_offset, 4);
+    return GUINT32_FROM_LE (tmp);
+}
+
+static inline gint32
+_mbim_message_cursor_get_gint32 (const MbimMessageCursor *cursor,
+                                 guint32                  relative_offset)
+{
+    return (gint32) _mbim_message_cursor_get_guint32 (cursor, relative_offset);
+}
+
+static inline guint64
+_mbim_message_cursor_get_guint64 (const MbimMessageCursor *cursor,
+                                  guint32                  relative_offset)
+{
+    guint64 tmp;
+
+    memcpy (&tmp, cursor->data + relative_offset, 8);
+    return GUINT64_FROM_LE (tmp);
+}
 
 G_END_DECLS
 
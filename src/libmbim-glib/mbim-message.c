@@ -16,6 +16,7 @@
 
 #include "mbim-message.h"
 #include "mbim-message-private.h"
+#include "mbim-message-json.h"
 #include "mbim-error-types.h"
 #include "mbim-enum-types.h"
 #include "mbim-tlv-private.h"
@@ -99,6 +100,81 @@ set_error_from_status (GError          **error,
 
 /*****************************************************************************/
 
+gchar *
+mbim_string_view_dup (const MbimStringView  *view,
+                      GError               **error)
+{
+    g_autofree gunichar2 *utf16d = NULL;
+    gchar                *str;
+
+    g_return_val_if_fail (view != NULL, NULL);
+
+    if (!view->data || !view->size)
+        return g_strdup ("");
+
+    /* Always duplicate to avoid memory alignment issues */
+    utf16d = g_memdup (view->data, view->size);
+
+    /* For BE systems, convert from LE to BE */
+    if (G_BYTE_ORDER == G_BIG_ENDIAN) {
+        guint i;
+
+        for (i = 0; i < (view->size / 2); i++)
+            utf16d[i] = GUINT16_FROM_LE (utf16d[i]);
+    }
+
+    str = g_utf16_to_utf8 (utf16d, view->size / 2, NULL, NULL, error);
+    if (!str)
+        g_prefix_error (error, "Error converting string to UTF-8: ");
+    return str;
+}
+
+gboolean
+mbim_string_view_equal (const MbimStringView *view,
+                        const gchar          *str)
+{
+    guint32 n_units;
+    guint32 i;
+
+    g_return_val_if_fail (view != NULL, FALSE);
+    g_return_val_if_fail (str != NULL, FALSE);
+
+    n_units = view->data ? (view->size / 2) : 0;
+
+    for (i = 0; i < n_units; i++) {
+        gunichar c;
+        guint16  unit;
+
+        if (!*str)
+            return FALSE;
+
+        unit = (guint16) (view->data[2 * i] | (view->data[2 * i + 1] << 8));
+        if (unit >= 0xD800 && unit < 0xDC00) {
+            guint16 low;
+
+            /* High surrogate must be followed by a low surrogate */
+            if (i + 1 >= n_units)
+                return FALSE;
+            i++;
+            low = (guint16) (view->data[2 * i] | (view->data[2 * i + 1] << 8));
+            if (low < 0xDC00 || low >= 0xE000)
+                return FALSE;
+            c = 0x10000 + (((gunichar) (unit - 0xD800)) << 10) + (low - 0xDC00);
+        } else if (unit >= 0xDC00 && unit < 0xE000)
+            return FALSE;
+        else
+            c = unit;
+
+        if (g_utf8_get_char_validated (str, -1) != c)
+            return FALSE;
+        str = g_utf8_next_char (str);
+    }
+
+    return (*str == '\0');
+}
+
+/*****************************************************************************/
+
 GType
 mbim_message_get_type (void)
 {
@@ -391,6 +467,59 @@ _mbim_message_get_information_buffer_offset (const MbimMessage *self)
     }
 }
 
+void
+_mbim_message_cursor_init (MbimMessageCursor *cursor,
+                           const MbimMessage *self)
+{
+    guint32 information_buffer_offset;
+
+    g_assert (cursor);
+
+    information_buffer_offset = _mbim_message_get_information_buffer_offset (self);
+
+    cursor->data = self->data + information_buffer_offset;
+    cursor->len = (self->len > information_buffer_offset) ? (self->len - information_buffer_offset) : 0;
+}
+
+gboolean
+_mbim_message_cursor_check (const MbimMessageCursor  *cursor,
+                            guint32                   relative_offset,
+                            guint32                   size,
+                            GError                  **error)
+{
+    guint64 required_size;
+
+    required_size = (guint64)relative_offset + (guint64)size;
+    if ((guint64)cursor->len < required_size) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "cannot read fixed-size fields (%u bytes) (%u < %" G_GUINT64_FORMAT ")",
+                     size, cursor->len, required_size);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+gboolean
+_mbim_message_cursor_check_array (const MbimMessageCursor  *cursor,
+                                  guint32                   relative_offset,
+                                  guint32                   n_elements,
+                                  guint32                   element_size,
+                                  GError                  **error)
+{
+    guint64 required_size;
+
+    required_size = (guint64)relative_offset + ((guint64)n_elements * (guint64)element_size);
+    if ((guint64)cursor->len < required_size) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "cannot read array of %u fixed-size elements (%u bytes each) (%u < %" G_GUINT64_FORMAT ")",
+                     n_elements, element_size, cursor->len, required_size);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 gboolean
 _mbim_message_read_guint16 (const MbimMessage  *self,
                             guint32             relative_offset,
@@ -613,6 +742,52 @@ _mbim_message_read_string (const MbimMessage   *self,
     return TRUE;
 }
 
+gboolean
+_mbim_message_read_string_view (const MbimMessage  *self,
+                                guint32             struct_start_offset,
+                                guint32             relative_offset,
+                                MbimStringView     *view,
+                                guint32            *bytes_read,
+                                GError            **error)
+{
+    guint64 required_size;
+    guint32 offset;
+    guint32 size;
+    guint32 information_buffer_offset;
+
+    information_buffer_offset = _mbim_message_get_information_buffer_offset (self);
+
+    required_size = (guint64)information_buffer_offset + (guint64)relative_offset + 8;
+    if ((guint64)self->len < required_size) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "cannot read string offset and size (%u < %" G_GUINT64_FORMAT ")",
+                     self->len, required_size);
+        return FALSE;
+    }
+
+    offset = mbim_helpers_read_unaligned_guint32 (self->data + information_buffer_offset + relative_offset);
+    size = mbim_helpers_read_unaligned_guint32 (self->data + information_buffer_offset + relative_offset + 4);
+    if (bytes_read)
+        *bytes_read = size;
+    if (!size) {
+        view->data = NULL;
+        view->size = 0;
+        return TRUE;
+    }
+
+    required_size = (guint64)information_buffer_offset + (guint64)struct_start_offset + (guint64)offset + (guint64)size;
+    if ((guint64)self->len < required_size) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "cannot read string data (%u bytes) (%u < %" G_GUINT64_FORMAT ")",
+                     size, self->len, required_size);
+        return FALSE;
+    }
+
+    view->data = self->data + information_buffer_offset + struct_start_offset + offset;
+    view->size = size;
+    return TRUE;
+}
+
 gboolean
 _mbim_message_read_string_array (const MbimMessage   *self,
                                  guint32              array_size,
@@ -1201,7 +1376,7 @@ _mbim_message_read_tlv_list (const MbimMessage  *self,
         if (!tlv)
             break;
 
-        list = g_list_append (list, tlv);
+        list = g_list_prepend (list, tlv);
         total_bytes_read += tlv_bytes_read;
 
         g_assert (tlv_list_raw_size >= tlv_bytes_read);
@@ -1216,7 +1391,82 @@ _mbim_message_read_tlv_list (const MbimMessage  *self,
     }
 
     *bytes_read = total_bytes_read;
-    *tlv_list = list;
+    *tlv_list = g_list_reverse (list);
+    return TRUE;
+}
+
+gboolean
+_mbim_message_skip_tlv (const MbimMessage  *self,
+                        guint32             relative_offset,
+                        guint32            *bytes_read,
+                        GError            **error)
+{
+    guint32 information_buffer_offset;
+    guint64 tlv_offset;
+
+    information_buffer_offset = _mbim_message_get_information_buffer_offset (self);
+    tlv_offset = (guint64)information_buffer_offset + (guint64)relative_offset;
+
+    if ((guint64)self->len < tlv_offset) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "TLV has invalid offset %" G_GUINT64_FORMAT
+                     " and will exceed message bounds (%u)",
+                     tlv_offset, self->len);
+        return FALSE;
+    }
+
+    return _mbim_tlv_get_raw_size (self->data + tlv_offset, self->len - (guint32)tlv_offset, bytes_read, error);
+}
+
+gboolean
+_mbim_message_skip_array (const MbimMessage  *self,
+                          guint32            *relative_offset,
+                          guint32             n_elements,
+                          guint32             element_size,
+                          GError            **error)
+{
+    guint32 information_buffer_offset;
+    guint64 array_size;
+    guint64 required_size;
+
+    information_buffer_offset = _mbim_message_get_information_buffer_offset (self);
+    array_size = (guint64)n_elements * (guint64)element_size;
+    required_size = (guint64)information_buffer_offset + (guint64)*relative_offset + array_size;
+
+    if ((guint64)self->len < required_size) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "cannot skip array of %u elements (%u bytes each) (%u < %" G_GUINT64_FORMAT ")",
+                     n_elements, element_size, self->len, required_size);
+        return FALSE;
+    }
+
+    /* Fits in 32bit, as it's bounded by the message length */
+    *relative_offset += (guint32)array_size;
+    return TRUE;
+}
+
+gboolean
+_mbim_message_tlv_iter_init (const MbimMessage  *self,
+                             guint32             relative_offset,
+                             MbimTlvIter        *iter,
+                             GError            **error)
+{
+    guint32 information_buffer_offset;
+    guint64 tlv_list_offset;
+
+    information_buffer_offset = _mbim_message_get_information_buffer_offset (self);
+    tlv_list_offset = (guint64)information_buffer_offset + (guint64)relative_offset;
+
+    /* TLV list always at the end of the message */
+    if ((guint64)self->len < tlv_list_offset) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "TLV list item has invalid offset %" G_GUINT64_FORMAT
+                     " and will exceed message bounds (%u)",
+                     tlv_list_offset, self->len);
+        return FALSE;
+    }
+
+    _mbim_tlv_iter_init (iter, self->data + tlv_list_offset, self->len - (guint32)tlv_list_offset);
     return TRUE;
 }
 
@@ -1919,6 +2169,81 @@ mbim_message_get_raw (const MbimMessage  *self,
     return self->data;
 }
 
+/*****************************************************************************/
+/* Message fields of the known services */
+
+typedef struct {
+    MbimService   service;
+    guint8        mbimex_version_major; /* first MBIMEx version with these fields */
+    gchar      *(* get_printable_fields) (const MbimMessage  *self,
+                                          const gchar        *line_prefix,
+                                          GError            **error);
+    gboolean    (* get_json_fields)      (const MbimMessage  *self,
+                                          GString            *output,
+                                          GError            **error);
+} FieldsHandler;
+
+#define FIELDS_HANDLER(prefix) \
+    __mbim_message_##prefix##_get_printable_fields, __mbim_message_##prefix##_get_json_fields
+
+/* The handlers of the same service are listed from the newest MBIMEx version
+ * to the oldest one, which is the order in which they are tried: when the
+ * handler of a newer version does not support the message, the one of the
+ * previous version is used instead. */
+static const FieldsHandler fields_handlers[] = {
+    { MBIM_SERVICE_BASIC_CONNECT,               3, FIELDS_HANDLER (ms_basic_connect_v3) },
+    { MBIM_SERVICE_BASIC_CONNECT,               2, FIELDS_HANDLER (ms_basic_connect_v2) },
+    { MBIM_SERVICE_BASIC_CONNECT,               1, FIELDS_HANDLER (basic_connect) },
+    { MBIM_SERVICE_SMS,                         1, FIELDS_HANDLER (sms) },
+    { MBIM_SERVICE_USSD,                        1, FIELDS_HANDLER (ussd) },
+    { MBIM_SERVICE_PHONEBOOK,                   1, FIELDS_HANDLER (phonebook) },
+    { MBIM_SERVICE_STK,                         1, FIELDS_HANDLER (stk) },
+    { MBIM_SERVICE_AUTH,                        1, FIELDS_HANDLER (auth) },
+    { MBIM_SERVICE_DSS,                         1, FIELDS_HANDLER (dss) },
+    { MBIM_SERVICE_MS_FIRMWARE_ID,              1, FIELDS_HANDLER (ms_firmware_id) },
+    { MBIM_SERVICE_MS_HOST_SHUTDOWN,            1, FIELDS_HANDLER (ms_host_shutdown) },
+    { MBIM_SERVICE_MS_SAR,                      1, FIELDS_HANDLER (ms_sar) },
+    { MBIM_SERVICE_PROXY_CONTROL,               1, FIELDS_HANDLER (proxy_control) },
+    { MBIM_SERVICE_QMI,                         1, FIELDS_HANDLER (qmi) },
+    { MBIM_SERVICE_ATDS,                        1, FIELDS_HANDLER (atds) },
+    { MBIM_SERVICE_INTEL_FIRMWARE_UPDATE,       2, FIELDS_HANDLER (intel_firmware_update_v2) },
+    { MBIM_SERVICE_INTEL_FIRMWARE_UPDATE,       1, FIELDS_HANDLER (intel_firmware_update) },
+    { MBIM_SERVICE_QDU,                         1, FIELDS_HANDLER (qdu) },
+    { MBIM_SERVICE_MS_BASIC_CONNECT_EXTENSIONS, 3, FIELDS_HANDLER (ms_basic_connect_extensions_v3) },
+    { MBIM_SERVICE_MS_BASIC_CONNECT_EXTENSIONS, 2, FIELDS_HANDLER (ms_basic_connect_extensions_v2) },
+    { MBIM_SERVICE_MS_BASIC_CONNECT_EXTENSIONS, 1, FIELDS_HANDLER (ms_basic_connect_extensions) },
+    { MBIM_SERVICE_MS_UICC_LOW_LEVEL_ACCESS,    1, FIELDS_HANDLER (ms_uicc_low_level_access) },
+    { MBIM_SERVICE_QUECTEL,                     1, FIELDS_HANDLER (quectel) },
+    { MBIM_SERVICE_INTEL_THERMAL_RF,            1, FIELDS_HANDLER (intel_thermal_rf) },
+    { MBIM_SERVICE_MS_VOICE_EXTENSIONS,         1, FIELDS_HANDLER (ms_voice_extensions) },
+    { MBIM_SERVICE_INTEL_MUTUAL_AUTHENTICATION, 1, FIELDS_HANDLER (intel_mutual_authentication) },
+    { MBIM_SERVICE_INTEL_TOOLS,                 1, FIELDS_HANDLER (intel_tools) },
+    { MBIM_SERVICE_GOOGLE,                      1, FIELDS_HANDLER (google) },
+    { MBIM_SERVICE_FIBOCOM,                     1, FIELDS_HANDLER (fibocom) },
+    { MBIM_SERVICE_COMPAL,                      1, FIELDS_HANDLER (compal) },
+    { MBIM_SERVICE_INTEL_AT_TUNNEL,             1, FIELDS_HANDLER (intel_at_tunnel) },
+};
+
+#undef FIELDS_HANDLER
+
+/* Returns the next handler to try for the fields of a message of the given
+ * service after @previous (or the first one, if %NULL), given the agreed
+ * MBIMEx version; %NULL if there are no more. */
+static const FieldsHandler *
+fields_handler_lookup (MbimService          service,
+                       guint8               mbimex_version_major,
+                       const FieldsHandler *previous)
+{
+    guint i;
+
+    for (i = previous ? (guint)(previous - fields_handlers) + 1 : 0; i < G_N_ELEMENTS (fields_handlers); i++) {
+        if (fields_handlers[i].service == service &&
+            fields_handlers[i].mbimex_version_major <= MAX (mbimex_version_major, 1))
+            return &fields_handlers[i];
+    }
+    return NULL;
+}
+
 gchar *
 mbim_message_get_printable (const MbimMessage *self,
                             const gchar       *line_prefix,
@@ -2112,145 +2437,19 @@ mbim_message_get_printable_full (const MbimMessage  *self,
     }
 
     if (service_read_fields != MBIM_SERVICE_INVALID) {
-        g_autofree gchar  *fields_printable = NULL;
-        g_autoptr(GError)  inner_error = NULL;
-
-        switch (service_read_fields) {
-        case MBIM_SERVICE_BASIC_CONNECT:
-            if (mbimex_version_major < 2)
-                fields_printable = __mbim_message_basic_connect_get_printable_fields (self, line_prefix, &inner_error);
-            else if (mbimex_version_major == 2) {
-                fields_printable = __mbim_message_ms_basic_connect_v2_get_printable_fields (self, line_prefix, &inner_error);
-                /* attempt fallback to v1 printable */
-                if (g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED)) {
-                    g_clear_error (&inner_error);
-                    fields_printable = __mbim_message_basic_connect_get_printable_fields (self, line_prefix, &inner_error);
-                }
-            } else if (mbimex_version_major == 3) {
-                fields_printable = __mbim_message_ms_basic_connect_v3_get_printable_fields (self, line_prefix, &inner_error);
-                /* attempt fallback to v2 printable */
-                if (g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED)) {
-                    g_clear_error (&inner_error);
-                    fields_printable = __mbim_message_ms_basic_connect_v2_get_printable_fields (self, line_prefix, &inner_error);
-                    /* attempt fallback to v1 printable */
-                    if (g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED)) {
-                        g_clear_error (&inner_error);
-                        fields_printable = __mbim_message_basic_connect_get_printable_fields (self, line_prefix, &inner_error);
-                    }
-                }
-            } else
-                g_assert_not_reached ();
-            break;
-        case MBIM_SERVICE_SMS:
-            fields_printable = __mbim_message_sms_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_USSD:
-            fields_printable = __mbim_message_ussd_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_PHONEBOOK:
-            fields_printable = __mbim_message_phonebook_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_STK:
-            fields_printable = __mbim_message_stk_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_AUTH:
-            fields_printable = __mbim_message_auth_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_DSS:
-            fields_printable = __mbim_message_dss_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_MS_FIRMWARE_ID:
-            fields_printable = __mbim_message_ms_firmware_id_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_MS_HOST_SHUTDOWN:
-            fields_printable = __mbim_message_ms_host_shutdown_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_MS_SAR:
-            fields_printable = __mbim_message_ms_sar_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_PROXY_CONTROL:
-            fields_printable = __mbim_message_proxy_control_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_QMI:
-            fields_printable = __mbim_message_qmi_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_ATDS:
-            fields_printable = __mbim_message_atds_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_INTEL_FIRMWARE_UPDATE:
-            if (mbimex_version_major < 2)
-                fields_printable = __mbim_message_intel_firmware_update_get_printable_fields (self, line_prefix, &inner_error);
-            else if (mbimex_version_major >= 2) {
-                fields_printable = __mbim_message_intel_firmware_update_v2_get_printable_fields (self, line_prefix, &inner_error);
-                if (g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED)) {
-                    g_clear_error (&inner_error);
-                    fields_printable = __mbim_message_intel_firmware_update_get_printable_fields (self, line_prefix, &inner_error);
-                }
-            }
-            break;
-        case MBIM_SERVICE_QDU:
-            fields_printable = __mbim_message_qdu_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_MS_BASIC_CONNECT_EXTENSIONS:
-            if (mbimex_version_major < 2)
-                fields_printable = __mbim_message_ms_basic_connect_extensions_get_printable_fields (self, line_prefix, &inner_error);
-            else if (mbimex_version_major == 2) {
-                fields_printable = __mbim_message_ms_basic_connect_extensions_v2_get_printable_fields (self, line_prefix, &inner_error);
-                /* attempt fallback to v1 printable */
-                if (g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED)) {
-                    g_clear_error (&inner_error);
-                    fields_printable = __mbim_message_ms_basic_connect_extensions_get_printable_fields (self, line_prefix, &inner_error);
-                }
-            } else if (mbimex_version_major == 3) {
-                fields_printable = __mbim_message_ms_basic_connect_extensions_v3_get_printable_fields (self, line_prefix, &inner_error);
-                /* attempt fallback to v2 printable */
-                if (g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED)) {
-                    g_clear_error (&inner_error);
-                    fields_printable = __mbim_message_ms_basic_connect_extensions_v2_get_printable_fields (self, line_prefix, &inner_error);
-                    /* attempt fallback to v1 printable */
-                    if (g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED)) {
-                        g_clear_error (&inner_error);
-                        fields_printable = __mbim_message_ms_basic_connect_extensions_get_printable_fields (self, line_prefix, &inner_error);
-                    }
-                }
-             } else
-               g_assert_not_reached ();
-            break;
-        case MBIM_SERVICE_MS_UICC_LOW_LEVEL_ACCESS:
-            fields_printable = __mbim_message_ms_uicc_low_level_access_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_QUECTEL:
-            fields_printable = __mbim_message_quectel_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_INTEL_THERMAL_RF:
-            fields_printable = __mbim_message_intel_thermal_rf_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_MS_VOICE_EXTENSIONS:
-            fields_printable = __mbim_message_ms_voice_extensions_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_INTEL_MUTUAL_AUTHENTICATION:
-            fields_printable = __mbim_message_intel_mutual_authentication_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_INTEL_TOOLS:
-            fields_printable = __mbim_message_intel_tools_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_GOOGLE:
-            fields_printable = __mbim_message_google_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_FIBOCOM:
-            fields_printable = __mbim_message_fibocom_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_COMPAL:
-            fields_printable = __mbim_message_compal_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_INTEL_AT_TUNNEL:
-            fields_printable = __mbim_message_intel_at_tunnel_get_printable_fields (self, line_prefix, &inner_error);
-            break;
-        case MBIM_SERVICE_INVALID:
-        case MBIM_SERVICE_LAST:
-            g_assert_not_reached ();
-        default:
-            break;
+        g_autofree gchar    *fields_printable = NULL;
+        g_autoptr(GError)    inner_error = NULL;
+        const FieldsHandler *handler;
+
+        for (handler = fields_handler_lookup (service_read_fields, mbimex_version_major, NULL);
+             handler;
+             handler = fields_handler_lookup (service_read_fields, mbimex_version_major, handler)) {
+            g_clear_pointer (&fields_printable, g_free);
+            g_clear_error (&inner_error);
+            fields_printable = handler->get_printable_fields (self, line_prefix, &inner_error);
+            /* attempt fallback to the fields of the previous MBIMEx version */
+            if (!g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED))
+                break;
         }
 
         if (inner_error)
@@ -2267,6 +2466,214 @@ mbim_message_get_printable_full (const MbimMessage  *self,
     return g_string_free (printable, FALSE);
 }
 
+/*****************************************************************************/
+/* Serializing */
+
+static gboolean
+serialize_json_fields (const MbimMessage  *self,
+                       MbimService         service,
+                       guint8              mbimex_version_major,
+                       GString            *output,
+                       GError            **error)
+{
+    g_autoptr(GError)    inner_error = NULL;
+    gboolean             serialized = FALSE;
+    const FieldsHandler *handler;
+
+    for (handler = fields_handler_lookup (service, mbimex_version_major, NULL);
+         handler;
+         handler = fields_handler_lookup (service, mbimex_version_major, handler)) {
+        g_clear_error (&inner_error);
+        serialized = handler->get_json_fields (self, output, &inner_error);
+        /* attempt fallback to the fields of the previous MBIMEx version */
+        if (!g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED))
+            break;
+    }
+
+    if (serialized)
+        return TRUE;
+
+    /* Messages without known fields are serialized without contents */
+    if (!inner_error || g_error_matches (inner_error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED)) {
+        g_string_append (output, "null");
+        return TRUE;
+    }
+
+    g_propagate_error (error, g_steal_pointer (&inner_error));
+    return FALSE;
+}
+
+static void
+serialize_json_status (GString         *output,
+                       const gchar     *key,
+                       MbimStatusError  status)
+{
+    _mbim_json_append_key (output, key);
+    _mbim_json_append_enum (output, mbim_status_error_get_string (status), status);
+}
+
+static void
+serialize_json_service (GString        *output,
+                        MbimService     service,
+                        const MbimUuid *service_id,
+                        guint32         cid)
+{
+    const gchar *cid_printable = NULL;
+
+    _mbim_json_append_key (output, "service");
+    _mbim_json_append_string (output, mbim_service_lookup_name (service));
+    _mbim_json_append_key (output, "service-id");
+    _mbim_json_append_uuid (output, service_id);
+
+    if (cid && service != MBIM_SERVICE_INVALID && service < MBIM_SERVICE_LAST)
+        cid_printable = mbim_cid_get_printable (service, cid);
+    _mbim_json_append_key (output, "cid");
+    _mbim_json_append_enum (output, cid_printable, cid);
+}
+
+static void
+serialize_json_fragment (const MbimMessage *self,
+                         GString           *output)
+{
+    _mbim_json_append_key (output, "fragment");
+    g_string_append_printf (output,
+                            "{\"total\":%u,\"current\":%u}",
+                            _mbim_message_fragment_get_total (self),
+                            _mbim_message_fragment_get_current (self));
+}
+
+static gboolean
+serialize_json (const MbimMessage  *self,
+                guint8              mbimex_version_major,
+                GString            *output,
+                GError            **error)
+{
+    MbimService service_read_fields = MBIM_SERVICE_INVALID;
+
+    g_string_append_c (output, '{');
+    _mbim_json_append_key (output, "length");
+    g_string_append_printf (output, "%u", MBIM_MESSAGE_GET_MESSAGE_LENGTH (self));
+    _mbim_json_append_key (output, "type");
+    _mbim_json_append_enum (output,
+                            mbim_message_type_get_string (MBIM_MESSAGE_GET_MESSAGE_TYPE (self)),
+                            MBIM_MESSAGE_GET_MESSAGE_TYPE (self));
+    _mbim_json_append_key (output, "transaction");
+    g_string_append_printf (output, "%u", MBIM_MESSAGE_GET_TRANSACTION_ID (self));
+
+    switch (MBIM_MESSAGE_GET_MESSAGE_TYPE (self)) {
+    case MBIM_MESSAGE_TYPE_INVALID:
+        g_warn_if_reached ();
+        break;
+
+    case MBIM_MESSAGE_TYPE_OPEN:
+        _mbim_json_append_key (output, "max-control-transfer");
+        g_string_append_printf (output, "%u", mbim_message_open_get_max_control_transfer (self));
+        break;
+
+    case MBIM_MESSAGE_TYPE_CLOSE:
+        break;
+
+    case MBIM_MESSAGE_TYPE_OPEN_DONE:
+        serialize_json_status (output, "status", mbim_message_open_done_get_status_code (self));
+        break;
+
+    case MBIM_MESSAGE_TYPE_CLOSE_DONE:
+        serialize_json_status (output, "status", mbim_message_close_done_get_status_code (self));
+        break;
+
+    case MBIM_MESSAGE_TYPE_HOST_ERROR:
+    case MBIM_MESSAGE_TYPE_FUNCTION_ERROR: {
+        MbimProtocolError protocol_error;
+
+        protocol_error = mbim_message_error_get_error_status_code (self);
+        _mbim_json_append_key (output, "error");
+        _mbim_json_append_enum (output, mbim_protocol_error_get_string (protocol_error), protocol_error);
+        break;
+    }
+
+    case MBIM_MESSAGE_TYPE_COMMAND: {
+        MbimMessageCommandType command_type;
+
+        serialize_json_fragment (self, output);
+        service_read_fields = mbim_message_command_get_service (self);
+        serialize_json_service (output,
+                                service_read_fields,
+                                mbim_message_command_get_service_id (self),
+                                mbim_message_command_get_cid (self));
+        command_type = mbim_message_command_get_command_type (self);
+        _mbim_json_append_key (output, "command-type");
+        _mbim_json_append_enum (output, mbim_message_command_type_get_string (command_type), command_type);
+        break;
+    }
+
+    case MBIM_MESSAGE_TYPE_COMMAND_DONE:
+        serialize_json_fragment (self, output);
+        serialize_json_status (output, "status", mbim_message_command_done_get_status_code (self));
+        service_read_fields = mbim_message_command_done_get_service (self);
+        serialize_json_service (output,
+                                service_read_fields,
+                                mbim_message_command_done_get_service_id (self),
+                                mbim_message_command_done_get_cid (self));
+        break;
+
+    case MBIM_MESSAGE_TYPE_INDICATE_STATUS:
+        serialize_json_fragment (self, output);
+        service_read_fields = mbim_message_indicate_status_get_service (self);
+        serialize_json_service (output,
+                                service_read_fields,
+                                mbim_message_indicate_status_get_service_id (self),
+                                mbim_message_indicate_status_get_cid (self));
+        break;
+
+    default:
+        g_assert_not_reached ();
+    }
+
+    if (service_read_fields != MBIM_SERVICE_INVALID) {
+        _mbim_json_append_key (output, "fields");
+        if (!serialize_json_fields (self, service_read_fields, mbimex_version_major, output, error))
+            return FALSE;
+    }
+
+    g_string_append_c (output, '}');
+    return TRUE;
+}
+
+gboolean
+mbim_message_serialize (const MbimMessage           *self,
+                        MbimMessageSerializeFormat   format,
+                        guint8                       mbimex_version_major,
+                        guint8                       mbimex_version_minor,
+                        GString                     *output,
+                        GError                     **error)
+{
+    gsize initial_len;
+
+    g_return_val_if_fail (self != NULL, FALSE);
+    g_return_val_if_fail (output != NULL, FALSE);
+    g_return_val_if_fail (_mbim_message_validate_internal (self, TRUE, NULL), FALSE);
+
+    if (mbimex_version_major > 3) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                     "MBIMEx version %x.%02x is unsupported",
+                     mbimex_version_major, mbimex_version_minor);
+        return FALSE;
+    }
+
+    if (format != MBIM_MESSAGE_SERIALIZE_FORMAT_JSON) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                     "Serialize format %u is unsupported", format);
+        return FALSE;
+    }
+
+    initial_len = output->len;
+    if (!serialize_json (self, mbimex_version_major, output, error)) {
+        g_string_truncate (output, initial_len);
+        return FALSE;
+    }
+    return TRUE;
+}
+
 /*****************************************************************************/
 /* Fragment interface */
 
@@ -2772,6 +3179,131 @@ mbim_message_command_get_raw_information_buffer (const MbimMessage *self,
             NULL);
 }
 
+gboolean
+mbim_message_command_patch_guint32 (MbimMessage  *self,
+                                    guint32       offset,
+                                    guint32       value,
+                                    GError      **error)
+{
+    guint32 length;
+    guint32 value_le;
+
+    g_return_val_if_fail (self != NULL, FALSE);
+
+    if (!_mbim_message_validate_internal (self, FALSE, error))
+        return FALSE;
+
+    if (MBIM_MESSAGE_GET_MESSAGE_TYPE (self) != MBIM_MESSAGE_TYPE_COMMAND) {
+        g_set_error (error,
+                     MBIM_CORE_ERROR,
+                     MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "Message is not a command");
+        return FALSE;
+    }
+
+    length = GUINT32_FROM_LE (((struct full_message *)(self->data))->message.command.buffer_length);
+    if ((guint64) offset + 4 > length) {
+        g_set_error (error,
+                     MBIM_CORE_ERROR,
+                     MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "Cannot patch 4 bytes at offset %u: information buffer is only %u bytes",
+                     offset, length);
+        return FALSE;
+    }
+
+    /* The information buffer may not be aligned */
+    value_le = GUINT32_TO_LE (value);
+    memcpy (&(((struct full_message *)(self->data))->message.command.buffer[offset]), &value_le, sizeof (value_le));
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Command templates */
+
+struct _MbimMessageTemplate {
+    volatile gint  ref_count;
+    /* The complete command as given, never modified */
+    MbimMessage   *message;
+};
+
+GType
+mbim_message_template_get_type (void)
+{
+    static gsize g_define_type_id_initialized = 0;
+
+    if (g_once_init_enter (&g_define_type_id_initialized)) {
+        GType g_define_type_id =
+            g_boxed_type_register_static (g_intern_static_string ("MbimMessageTemplate"),
+                                          (GBoxedCopyFunc) mbim_message_template_ref,
+                                          (GBoxedFreeFunc) mbim_message_template_unref);
+
+        g_once_init_leave (&g_define_type_id_initialized, g_define_type_id);
+    }
+
+    return g_define_type_id_initialized;
+}
+
+MbimMessageTemplate *
+mbim_message_template_new (const MbimMessage  *message,
+                           GError            **error)
+{
+    MbimMessageTemplate *self;
+
+    g_return_val_if_fail (message != NULL, NULL);
+
+    if (!_mbim_message_validate_internal (message, FALSE, error))
+        return NULL;
+
+    if (MBIM_MESSAGE_GET_MESSAGE_TYPE (message) != MBIM_MESSAGE_TYPE_COMMAND) {
+        g_set_error (error,
+                     MBIM_CORE_ERROR,
+                     MBIM_CORE_ERROR_INVALID_MESSAGE,
+                     "Message is not a command");
+        return NULL;
+    }
+
+    self = g_slice_new0 (MbimMessageTemplate);
+    self->ref_count = 1;
+    self->message = mbim_message_dup (message);
+    return self;
+}
+
+MbimMessageTemplate *
+mbim_message_template_ref (MbimMessageTemplate *self)
+{
+    g_return_val_if_fail (self != NULL, NULL);
+
+    g_atomic_int_inc (&self->ref_count);
+    return self;
+}
+
+void
+mbim_message_template_unref (MbimMessageTemplate *self)
+{
+    g_return_if_fail (self != NULL);
+
+    if (g_atomic_int_dec_and_test (&self->ref_count)) {
+        mbim_message_unref (self->message);
+        g_slice_free (MbimMessageTemplate, self);
+    }
+}
+
+MbimMessage *
+mbim_message_template_build (const MbimMessageTemplate *self,
+                             guint32                    transaction_id)
+{
+    GByteArray *out;
+
+    g_return_val_if_fail (self != NULL, NULL);
+
+    /* A single copy of the already encoded message */
+    out = g_byte_array_sized_new (self->message->len);
+    g_byte_array_append (out, self->message->data, self->message->len);
+    ((struct header *)(out->data))->transaction_id = GUINT32_TO_LE (transaction_id);
+
+    return (MbimMessage *)out;
+}
+
 /*****************************************************************************/
 /* 'Command Done' message interface */
 
@@ -69,6 +69,54 @@ struct _MbimIPv6 {
     guint8 addr[16];
 };
 
+/**
+ * MbimStringView:
+ * @data: the string in UTF-16LE, not NUL-terminated and possibly not aligned,
+ *  or %NULL if the string is empty.
+ * @size: size of @data, in bytes.
+ *
+ * A string borrowed from the contents of a #MbimMessage, as given in the
+ * message and without any conversion. It is only valid as long as the
+ * message it was read from.
+ *
+ * Since: 1.36
+ */
+typedef struct _MbimStringView MbimStringView;
+struct _MbimStringView {
+    const guint8 *data;
+    guint32       size;
+};
+
+/**
+ * mbim_string_view_dup:
+ * @view: a #MbimStringView.
+ * @error: return location for error or %NULL.
+ *
+ * Converts the borrowed string to a new UTF-8 string.
+ *
+ * Returns: (transfer full): a newly allocated string, which may be empty, or
+ * %NULL if @error is set. The returned value should be freed with g_free().
+ *
+ * Since: 1.36
+ */
+gchar *mbim_string_view_dup (const MbimStringView  *view,
+                             GError               **error);
+
+/**
+ * mbim_string_view_equal:
+ * @view: a #MbimStringView.
+ * @str: a UTF-8 string.
+ *
+ * Compares the borrowed string with a UTF-8 string, without converting or
+ * allocating anything.
+ *
+ * Returns: %TRUE if both strings are equal, %FALSE otherwise.
+ *
+ * Since: 1.36
+ */
+gboolean mbim_string_view_equal (const MbimStringView *view,
+                                 const gchar          *str);
+
 /**
  * MbimMessageType:
  * @MBIM_MESSAGE_TYPE_INVALID: Invalid MBIM message.
@@ -210,6 +258,51 @@ gchar *mbim_message_get_printable_full (const MbimMessage  *self,
                                         gboolean            headers_only,
                                         GError            **error);
 
+/**
+ * MbimMessageSerializeFormat:
+ * @MBIM_MESSAGE_SERIALIZE_FORMAT_JSON: A single JSON object.
+ *
+ * Format of the output generated by mbim_message_serialize().
+ *
+ * Since: 1.36
+ */
+typedef enum { /*< since=1.36 >*/
+    MBIM_MESSAGE_SERIALIZE_FORMAT_JSON = 0,
+} MbimMessageSerializeFormat;
+
+/**
+ * mbim_message_serialize:
+ * @self: a #MbimMessage.
+ * @format: a #MbimMessageSerializeFormat.
+ * @mbimex_version_major: major version of the agreed MBIMEx support.
+ * @mbimex_version_minor: minor version of the agreed MBIMEx support.
+ * @output: a #GString where the serialized message is appended.
+ * @error: return location for error or %NULL.
+ *
+ * Serializes the contents of the whole MBIM message in a machine-readable
+ * format, appending them to @output.
+ *
+ * The header values and the message fields are written with their own types:
+ * integers as numbers, booleans as booleans, enumerations as the nick of the
+ * value, flags as a list of nicks, and strings, UUIDs, IP addresses and byte
+ * arrays as strings. The values are appended directly to @output, so the same
+ * #GString may be reused to serialize multiple messages without allocating
+ * memory for each one of them.
+ *
+ * Unlike mbim_message_get_printable_full(), this method fails if the parsing
+ * of the message contents fails; in this case @output is left unchanged.
+ *
+ * Returns: %TRUE if the message was serialized, %FALSE if @error is set.
+ *
+ * Since: 1.36
+ */
+gboolean mbim_message_serialize (const MbimMessage           *self,
+                                 MbimMessageSerializeFormat   format,
+                                 guint8                       mbimex_version_major,
+                                 guint8                       mbimex_version_minor,
+                                 GString                     *output,
+                                 GError                     **error);
+
 /**
  * mbim_message_get_raw:
  * @self: a #MbimMessage.
@@ -613,6 +706,106 @@ MbimMessageCommandType mbim_message_command_get_command_type (const MbimMessage
 const guint8 *mbim_message_command_get_raw_information_buffer (const MbimMessage *self,
                                                                guint32           *out_length);
 
+/**
+ * mbim_message_command_patch_guint32:
+ * @self: a #MbimMessage.
+ * @offset: offset of the field in the information buffer.
+ * @value: the new value of the field.
+ * @error: return location for error or %NULL.
+ *
+ * Overwrites in place a 32-bit integer field of a %MBIM_MESSAGE_TYPE_COMMAND
+ * message, without building the message again.
+ *
+ * The offsets of the fields that can be patched are given by the
+ * <literal>MBIM_MESSAGE_*_OFFSET</literal> definitions generated for each
+ * query and set command, e.g. %MBIM_MESSAGE_CONNECT_SET_SESSION_ID_OFFSET.
+ * Using the offset of a different command than the one in @self gives a
+ * malformed message.
+ *
+ * Returns: %TRUE if the field was updated, %FALSE if @error is set.
+ *
+ * Since: 1.36
+ */
+gboolean mbim_message_command_patch_guint32 (MbimMessage  *self,
+                                             guint32       offset,
+                                             guint32       value,
+                                             GError      **error);
+
+/*****************************************************************************/
+/* Command templates */
+
+/**
+ * MbimMessageTemplate:
+ *
+ * An opaque type representing a %MBIM_MESSAGE_TYPE_COMMAND message built
+ * once, from which copies with different transaction IDs can be created
+ * without encoding all the fields again.
+ *
+ * Since: 1.36
+ */
+typedef struct _MbimMessageTemplate MbimMessageTemplate;
+
+GType mbim_message_template_get_type (void) G_GNUC_CONST;
+#define MBIM_TYPE_MESSAGE_TEMPLATE (mbim_message_template_get_type ())
+
+/**
+ * mbim_message_template_new:
+ * @message: a %MBIM_MESSAGE_TYPE_COMMAND #MbimMessage.
+ * @error: return location for error or %NULL.
+ *
+ * Create a #MbimMessageTemplate from the contents of @message, e.g. as
+ * created by mbim_message_connect_set_new(). The contents are copied, so
+ * @message may be modified or freed afterwards.
+ *
+ * Returns: (transfer full): a newly created #MbimMessageTemplate, which should be freed with mbim_message_template_unref(), or %NULL if @error is set.
+ *
+ * Since: 1.36
+ */
+MbimMessageTemplate *mbim_message_template_new (const MbimMessage  *message,
+                                                GError            **error);
+
+/**
+ * mbim_message_template_ref:
+ * @self: a #MbimMessageTemplate.
+ *
+ * Atomically increments the reference count of @self by one.
+ *
+ * Returns: (transfer full): the new reference to @self.
+ *
+ * Since: 1.36
+ */
+MbimMessageTemplate *mbim_message_template_ref (MbimMessageTemplate *self);
+
+/**
+ * mbim_message_template_unref:
+ * @self: a #MbimMessageTemplate.
+ *
+ * Atomically decrements the reference count of @self by one.
+ * If the reference count drops to 0, @self is completely disposed.
+ *
+ * Since: 1.36
+ */
+void mbim_message_template_unref (MbimMessageTemplate *self);
+
+/**
+ * mbim_message_template_build:
+ * @self: a #MbimMessageTemplate.
+ * @transaction_id: transaction ID of the new message, or 0 to let
+ *  mbim_device_command() set one.
+ *
+ * Create a new %MBIM_MESSAGE_TYPE_COMMAND message with the contents of @self
+ * and the given transaction ID. Single fields of the new message may then be
+ * updated with mbim_message_command_patch_guint32().
+ *
+ * Returns: (transfer full): a newly created #MbimMessage, which should be freed with mbim_message_unref().
+ *
+ * Since: 1.36
+ */
+MbimMessage *mbim_message_template_build (const MbimMessageTemplate *self,
+                                          guint32                    transaction_id);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MbimMessageTemplate, mbim_message_template_unref)
+
 /*****************************************************************************/
 /* 'Command Done' message interface */
 
@@ -48,9 +48,9 @@ session_id_to_vlan_id (guint session_id)
 /*****************************************************************************/
 
 static NetlinkMessage *
-netlink_message_new_link (guint  vlan_id,
-                          gchar *ifname,
-                          guint  base_if_index)
+netlink_message_new_link (guint        vlan_id,
+                          const gchar *ifname,
+                          guint        base_if_index)
 {
     NetlinkMessage *msg;
     guint           linkinfo_pos, datainfo_pos;
@@ -84,134 +84,53 @@ netlink_message_new_link (guint  vlan_id,
 
 /*****************************************************************************/
 
-static gboolean
-mbim_net_port_manager_wdm_list_links (MbimNetPortManager  *self,
-                                      const gchar         *base_ifname,
-                                      GPtrArray          **out_links,
-                                      GError             **error)
-{
-    g_autoptr(GFile)  sysfs_file = NULL;
-    g_autofree gchar *sysfs_path = NULL;
-
-    sysfs_path = g_strdup_printf ("/sys/class/net/%s", base_ifname);
-    sysfs_file = g_file_new_for_path (sysfs_path);
-
-    return mbim_helpers_list_links_wdm (sysfs_file, NULL, NULL, out_links, error);
-}
-
-/*****************************************************************************/
-
-typedef struct {
-    guint  session_id;
-    guint  vlan_id;
-    gchar *ifname;
-} AddLinkContext;
-
-static void
-add_link_context_free (AddLinkContext *ctx)
-{
-    g_free (ctx->ifname);
-    g_free (ctx);
-}
-
-static gchar *
-mbim_net_port_manager_wdm_add_link_finish (MbimNetPortManager  *self,
-                                           guint               *session_id,
-                                           GAsyncResult        *res,
-                                           GError             **error)
-{
-    AddLinkContext *ctx;
-
-    ctx = g_task_get_task_data (G_TASK (res));
-
-    if (!g_task_propagate_boolean (G_TASK (res), error)) {
-        g_prefix_error (error, "Failed to add link with session id %d: ",
-                        ctx->session_id);
-        return NULL;
-    }
-
-    *session_id = ctx->session_id;
-    return g_steal_pointer (&ctx->ifname);
-}
-
-static void
-mbim_net_port_manager_wdm_add_link (MbimNetPortManager  *self,
-                                    guint                session_id,
-                                    const gchar         *base_ifname,
-                                    const gchar         *ifname_prefix,
-                                    guint                timeout,
-                                    GCancellable        *cancellable,
-                                    GAsyncReadyCallback  callback,
-                                    gpointer             user_data)
+static NetlinkMessage *
+mbim_net_port_manager_wdm_new_link_message (MbimNetPortManager  *self,
+                                            guint                session_id,
+                                            const gchar         *base_ifname,
+                                            const gchar         *ifname,
+                                            GError             **error)
 {
-    NetlinkMessage     *msg;
-    NetlinkTransaction *tr;
-    GTask              *task;
-    GError             *error = NULL;
-    gssize              bytes_sent;
-    guint               base_if_index;
-    AddLinkContext     *ctx;
-
-    task = g_task_new (self, cancellable, callback, user_data);
-
-    ctx = g_new0 (AddLinkContext, 1);
-    ctx->session_id = session_id;
-    g_task_set_task_data (task, ctx, (GDestroyNotify) add_link_context_free);
-
-    if (ctx->session_id == MBIM_DEVICE_SESSION_ID_AUTOMATIC) {
-        if (!mbim_net_port_manager_util_get_first_free_session_id (ifname_prefix, &ctx->session_id)) {
-            g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
-                                     "Failed to find an available session ID");
-            g_object_unref (task);
-            return;
-        }
-        g_debug ("Using dynamic session ID %u", ctx->session_id);
-    } else
-        g_debug ("Using static session ID %u", ctx->session_id);
+    guint base_if_index;
 
     /* validate interface to use */
-    if (g_strcmp0 (mbim_net_port_manager_peek_iface (self),
-                   base_ifname) != 0) {
-        g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
-                                 "Invalid network interface %s: expected %s",
-                                 base_ifname, mbim_net_port_manager_peek_iface (self));
-        g_object_unref (task);
-        return;
+    if (g_strcmp0 (mbim_net_port_manager_peek_iface (self), base_ifname) != 0) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                     "Invalid network interface %s: expected %s",
+                     base_ifname, mbim_net_port_manager_peek_iface (self));
+        return NULL;
     }
 
-    base_if_index = if_nametoindex (base_ifname);
+    base_if_index = mbim_net_port_manager_get_ifindex (self, base_ifname);
     if (!base_if_index) {
-        g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
-                                 "%s interface is not available",
-                                 base_ifname);
-        g_object_unref (task);
-        return;
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                     "%s interface is not available",
+                     base_ifname);
+        return NULL;
     }
 
-    ctx->ifname = mbim_net_port_manager_util_session_id_to_ifname (ifname_prefix, ctx->session_id);
-    ctx->vlan_id = session_id_to_vlan_id (ctx->session_id);
-    g_debug ("Using ifname '%s' and vlan id %u", ctx->ifname, ctx->vlan_id);
+    g_debug ("Using ifname '%s' and vlan id %u", ifname, session_id_to_vlan_id (session_id));
+    return netlink_message_new_link (session_id_to_vlan_id (session_id), ifname, base_if_index);
+}
 
-    msg = netlink_message_new_link (ctx->vlan_id, ctx->ifname, base_if_index);
+/*****************************************************************************/
 
-    /* The task ownership is transferred to the transaction. */
-    tr = mbim_helpers_netlink_transaction_new (mbim_net_port_manager_peek_current_sequence_id (MBIM_NET_PORT_MANAGER (self)),
-                                               mbim_net_port_manager_peek_transactions (MBIM_NET_PORT_MANAGER (self)),
-                                               msg, timeout, task);
+static gboolean
+mbim_net_port_manager_wdm_list_links (MbimNetPortManager  *self,
+                                      const gchar         *base_ifname,
+                                      GPtrArray          **out_links,
+                                      GError             **error)
+{
+    g_autoptr(GFile)  sysfs_file = NULL;
+    g_autofree gchar *sysfs_path = NULL;
 
-    bytes_sent = g_socket_send (mbim_net_port_manager_peek_socket (MBIM_NET_PORT_MANAGER (self)),
-                                (const gchar *) msg->data,
-                                msg->len,
-                                cancellable,
-                                &error);
-    mbim_helpers_netlink_message_free (msg);
+    if (mbim_net_port_manager_index_list_upper_links (self, base_ifname, out_links))
+        return TRUE;
 
-    if (bytes_sent < 0)
-        mbim_helpers_netlink_transaction_complete_with_error (tr,
-                                                              mbim_net_port_manager_peek_transactions (MBIM_NET_PORT_MANAGER (self)),
-                                                              error);
+    sysfs_path = g_strdup_printf ("/sys/class/net/%s", base_ifname);
+    sysfs_file = g_file_new_for_path (sysfs_path);
 
-    g_object_unref (task);
+    return mbim_helpers_list_links_wdm (sysfs_file, NULL, NULL, out_links, error);
 }
 
 /*****************************************************************************/
@@ -257,6 +176,5 @@ mbim_net_port_manager_wdm_class_init (MbimNetPortManagerWdmClass *klass)
     MbimNetPortManagerClass *net_port_manager_class = MBIM_NET_PORT_MANAGER_CLASS (klass);
 
     net_port_manager_class->list_links = mbim_net_port_manager_wdm_list_links;
-    net_port_manager_class->add_link = mbim_net_port_manager_wdm_add_link;
-    net_port_manager_class->add_link_finish = mbim_net_port_manager_wdm_add_link_finish;
+    net_port_manager_class->new_link_message = mbim_net_port_manager_wdm_new_link_message;
 }
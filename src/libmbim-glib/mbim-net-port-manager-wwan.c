@@ -41,7 +41,7 @@ G_DEFINE_TYPE (MbimNetPortManagerWwan, mbim_net_port_manager_wwan, MBIM_TYPE_NET
 
 static NetlinkMessage *
 netlink_message_new_link (guint        link_id,
-                          gchar       *ifname,
+                          const gchar *ifname,
                           const gchar *base_if_name)
 {
     NetlinkMessage *msg;
@@ -77,6 +77,26 @@ netlink_message_new_link (guint        link_id,
 
 /*****************************************************************************/
 
+static NetlinkMessage *
+mbim_net_port_manager_wwan_new_link_message (MbimNetPortManager  *self,
+                                             guint                session_id,
+                                             const gchar         *base_ifname,
+                                             const gchar         *ifname,
+                                             GError             **error)
+{
+    if (!mbim_net_port_manager_get_ifindex (self, base_ifname)) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                     "%s interface is not available",
+                     base_ifname);
+        return NULL;
+    }
+
+    g_debug ("Using ifname '%s' and link id %u", ifname, session_id);
+    return netlink_message_new_link (session_id, ifname, base_ifname);
+}
+
+/*****************************************************************************/
+
 static gboolean
 mbim_net_port_manager_wwan_list_links (MbimNetPortManager  *self,
                                        const gchar         *base_ifname,
@@ -86,6 +106,9 @@ mbim_net_port_manager_wwan_list_links (MbimNetPortManager  *self,
     g_autoptr(GFile)  sysfs_file = NULL;
     g_autofree gchar *sysfs_path = NULL;
 
+    if (mbim_net_port_manager_index_list_sibling_links (self, base_ifname, out_links))
+        return TRUE;
+
     sysfs_path = g_strdup_printf ("/sys/class/net/%s/device/net", base_ifname);
     sysfs_file = g_file_new_for_path (sysfs_path);
 
@@ -94,111 +117,6 @@ mbim_net_port_manager_wwan_list_links (MbimNetPortManager  *self,
 
 /*****************************************************************************/
 
-typedef struct {
-    guint  session_id;
-    guint  link_id;
-    gchar *ifname;
-} AddLinkContext;
-
-static void
-add_link_context_free (AddLinkContext *ctx)
-{
-    g_free (ctx->ifname);
-    g_free (ctx);
-}
-
-static gchar *
-mbim_net_port_manager_wwan_add_link_finish (MbimNetPortManager  *self,
-                                            guint               *session_id,
-                                            GAsyncResult        *res,
-                                            GError             **error)
-{
-    AddLinkContext *ctx;
-
-    ctx = g_task_get_task_data (G_TASK (res));
-
-    if (!g_task_propagate_boolean (G_TASK (res), error)) {
-        g_prefix_error (error, "Failed to add link with session id %d: ",
-                        ctx->session_id);
-        return NULL;
-    }
-
-    *session_id = ctx->session_id;
-    return g_steal_pointer (&ctx->ifname);
-}
-
-static void
-mbim_net_port_manager_wwan_add_link (MbimNetPortManager  *self,
-                                     guint                session_id,
-                                     const gchar         *base_ifname,
-                                     const gchar         *ifname_prefix,
-                                     guint                timeout,
-                                     GCancellable        *cancellable,
-                                     GAsyncReadyCallback  callback,
-                                     gpointer             user_data)
-{
-    NetlinkMessage     *msg;
-    NetlinkTransaction *tr;
-    GTask              *task;
-    GError             *error = NULL;
-    gssize              bytes_sent;
-    guint               base_if_index;
-    AddLinkContext     *ctx;
-
-    task = g_task_new (self, cancellable, callback, user_data);
-
-    ctx = g_new0 (AddLinkContext, 1);
-    ctx->session_id = session_id;
-    g_task_set_task_data (task, ctx, (GDestroyNotify) add_link_context_free);
-
-    if (ctx->session_id == MBIM_DEVICE_SESSION_ID_AUTOMATIC) {
-        if (!mbim_net_port_manager_util_get_first_free_session_id (ifname_prefix, &ctx->session_id)) {
-            g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
-                                     "Failed to find an available session ID");
-            g_object_unref (task);
-            return;
-        }
-        g_debug ("Using dynamic session ID %u", ctx->session_id);
-    } else
-        g_debug ("Using static session ID %u", ctx->session_id);
-
-    base_if_index = if_nametoindex (base_ifname);
-    if (!base_if_index) {
-        g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
-                                 "%s interface is not available",
-                                 base_ifname);
-        g_object_unref (task);
-        return;
-    }
-
-    ctx->ifname = mbim_net_port_manager_util_session_id_to_ifname (ifname_prefix, ctx->session_id);
-    ctx->link_id = ctx->session_id;
-    g_debug ("Using ifname '%s' and link id %u", ctx->ifname, ctx->link_id);
-
-    msg = netlink_message_new_link (ctx->link_id, ctx->ifname, base_ifname);
-
-    /* The task ownership is transferred to the transaction. */
-    tr = mbim_helpers_netlink_transaction_new (mbim_net_port_manager_peek_current_sequence_id (MBIM_NET_PORT_MANAGER (self)),
-                                               mbim_net_port_manager_peek_transactions (MBIM_NET_PORT_MANAGER (self)),
-                                               msg, timeout, task);
-
-    bytes_sent = g_socket_send (mbim_net_port_manager_peek_socket (MBIM_NET_PORT_MANAGER (self)),
-                                (const gchar *) msg->data,
-                                msg->len,
-                                cancellable,
-                                &error);
-    mbim_helpers_netlink_message_free (msg);
-
-    if (bytes_sent < 0)
-        mbim_helpers_netlink_transaction_complete_with_error (tr,
-                                                              mbim_net_port_manager_peek_transactions (MBIM_NET_PORT_MANAGER (self)),
-                                                              error);
-
-    g_object_unref (task);
-}
-
-/*****************************************************************************/
-
 MbimNetPortManagerWwan *
 mbim_net_port_manager_wwan_new (GError **error)
 {
@@ -240,6 +158,5 @@ mbim_net_port_manager_wwan_class_init (MbimNetPortManagerWwanClass *klass)
     MbimNetPortManagerClass *net_port_manager_class = MBIM_NET_PORT_MANAGER_CLASS (klass);
 
     net_port_manager_class->list_links = mbim_net_port_manager_wwan_list_links;
-    net_port_manager_class->add_link = mbim_net_port_manager_wwan_add_link;
-    net_port_manager_class->add_link_finish = mbim_net_port_manager_wwan_add_link_finish;
+    net_port_manager_class->new_link_message = mbim_net_port_manager_wwan_new_link_message;
 }
@@ -14,8 +14,10 @@
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
 #include <net/if.h>
+#include <sys/socket.h>
 
 #include "mbim-device.h"
+#include "mbim-basic-connect.h"
 #include "mbim-helpers.h"
 #include "mbim-error-types.h"
 #include "mbim-net-port-manager.h"
@@ -33,8 +35,316 @@ struct _MbimNetPortManagerPrivate {
     /* Netlink state */
     guint       current_sequence_id;
     GHashTable *transactions;
+
+    /* Link index */
+    gboolean    links_synced;
+    gboolean    links_dump_pending;
+    gboolean    links_dump_restart;
+    GSource    *links_dump_retry_source;
+    GHashTable *links_by_index;
+    GHashTable *links_by_name;
+
+    /* Requests undoing the IP configuration applied in each link */
+    GHashTable *ip_configurations;
 };
 
+#ifndef SOL_NETLINK
+# define SOL_NETLINK 270
+#endif
+
+/*****************************************************************************/
+/* Link index
+ *
+ * All the net links known by the kernel, seeded with a RTM_GETLINK dump and
+ * kept up to date with the notifications of the RTNLGRP_LINK group, so that
+ * listing links or looking for free link names doesn't need to go through
+ * sysfs or the kernel each time. If notifications are lost, the index is
+ * cleared and dumped again, and until then the lookups fall back to sysfs
+ * and if_nametoindex(). Dumps that fail, e.g. interrupted by concurrent
+ * changes, are retried after a short delay. */
+
+#define LINKS_DUMP_RETRY_SECS 1
+
+typedef struct {
+    guint  ifindex;
+    gchar *ifname;
+    guint  link_ifindex;
+    gchar *parent_dev_name;
+} LinkInfo;
+
+static void
+link_info_free (LinkInfo *info)
+{
+    g_free (info->ifname);
+    g_free (info->parent_dev_name);
+    g_slice_free (LinkInfo, info);
+}
+
+static void
+links_index_remove (MbimNetPortManager *self,
+                    guint               ifindex)
+{
+    LinkInfo *info;
+
+    info = g_hash_table_lookup (self->priv->links_by_index, GUINT_TO_POINTER (ifindex));
+    if (!info)
+        return;
+
+    /* A different link may have been given the same name already */
+    if (g_hash_table_lookup (self->priv->links_by_name, info->ifname) == info)
+        g_hash_table_remove (self->priv->links_by_name, info->ifname);
+    g_hash_table_remove (self->priv->links_by_index, GUINT_TO_POINTER (ifindex));
+}
+
+static void
+link_event (struct nlmsghdr    *hdr,
+            MbimNetPortManager *self);
+
+static gboolean
+links_index_dump_retry_cb (MbimNetPortManager *self)
+{
+    g_clear_pointer (&self->priv->links_dump_retry_source, g_source_unref);
+    link_event (NULL, self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+links_index_dump_ready (MbimNetPortManager *self,
+                        GAsyncResult       *res)
+{
+    g_autoptr(GError) error = NULL;
+
+    self->priv->links_dump_pending = FALSE;
+
+    if (self->priv->links_dump_restart) {
+        self->priv->links_dump_restart = FALSE;
+        link_event (NULL, self);
+        return;
+    }
+
+    if (!g_task_propagate_boolean (G_TASK (res), &error)) {
+        g_debug ("Couldn't dump links, retrying in %u secs: %s", LINKS_DUMP_RETRY_SECS, error->message);
+        if (!self->priv->links_dump_retry_source) {
+            self->priv->links_dump_retry_source = g_timeout_source_new_seconds (LINKS_DUMP_RETRY_SECS);
+            g_source_set_callback (self->priv->links_dump_retry_source,
+                                   (GSourceFunc) links_index_dump_retry_cb,
+                                   self,
+                                   NULL);
+            g_source_attach (self->priv->links_dump_retry_source, g_main_context_get_thread_default ());
+        }
+        return;
+    }
+
+    self->priv->links_synced = TRUE;
+}
+
+static void
+links_index_resync (MbimNetPortManager *self)
+{
+    NetlinkMessage     *msg;
+    NetlinkTransaction *tr;
+    GTask              *task;
+    GError             *error = NULL;
+    gssize              bytes_sent;
+
+    self->priv->links_synced = FALSE;
+    g_hash_table_remove_all (self->priv->links_by_name);
+    g_hash_table_remove_all (self->priv->links_by_index);
+
+    if (self->priv->links_dump_retry_source) {
+        g_source_destroy (self->priv->links_dump_retry_source);
+        g_clear_pointer (&self->priv->links_dump_retry_source, g_source_unref);
+    }
+
+    /* Notifications lost while dumping may be older than the dump or not,
+     * so just dump again once the ongoing one finishes */
+    if (self->priv->links_dump_pending) {
+        self->priv->links_dump_restart = TRUE;
+        return;
+    }
+
+    self->priv->links_dump_pending = TRUE;
+    task = g_task_new (self, NULL, (GAsyncReadyCallback) links_index_dump_ready, NULL);
+
+    msg = mbim_helpers_netlink_message_new_dump_links ();
+    /* The task ownership is transferred to the transaction. */
+    tr = mbim_helpers_netlink_transaction_new (&self->priv->current_sequence_id,
+                                               self->priv->transactions,
+                                               msg,
+                                               5,
+                                               task);
+
+    bytes_sent = g_socket_send (self->priv->socket,
+                                (const gchar *) msg->data,
+                                msg->len,
+                                NULL,
+                                &error);
+    mbim_helpers_netlink_message_free (msg);
+
+    if (bytes_sent < 0)
+        mbim_helpers_netlink_transaction_complete_with_error (tr, self->priv->transactions, error);
+
+    g_object_unref (task);
+}
+
+static void
+link_event (struct nlmsghdr    *hdr,
+            MbimNetPortManager *self)
+{
+    guint        ifindex;
+    const gchar *ifname;
+    guint        link_ifindex;
+    const gchar *parent_dev_name;
+    LinkInfo    *info;
+
+    if (!hdr) {
+        links_index_resync (self);
+        return;
+    }
+
+    if (!mbim_helpers_netlink_parse_link (hdr, &ifindex, &ifname, &link_ifindex, &parent_dev_name))
+        return;
+
+    /* New links, and changes (e.g. renames) in existing ones */
+    links_index_remove (self, ifindex);
+    if (hdr->nlmsg_type != RTM_NEWLINK) {
+        /* Nothing left to undo in links that are gone */
+        g_hash_table_remove (self->priv->ip_configurations, ifname);
+        return;
+    }
+
+    info = g_slice_new0 (LinkInfo);
+    info->ifindex = ifindex;
+    info->ifname = g_strdup (ifname);
+    info->link_ifindex = link_ifindex;
+    info->parent_dev_name = g_strdup (parent_dev_name);
+    g_hash_table_insert (self->priv->links_by_index, GUINT_TO_POINTER (ifindex), info);
+    /* Another link may still have the same name if a rename was missed; the
+     * key must be replaced as well, as it's owned by the info of that link */
+    g_hash_table_replace (self->priv->links_by_name, info->ifname, info);
+}
+
+static gint
+links_cmp (const gchar **a,
+           const gchar **b)
+{
+    return g_ascii_strcasecmp (*a, *b);
+}
+
+static gboolean
+links_index_list (MbimNetPortManager  *self,
+                  const gchar         *base_ifname,
+                  gboolean             by_parent_dev_name,
+                  GPtrArray          **out_links)
+{
+    LinkInfo            *base;
+    GHashTableIter       iter;
+    LinkInfo            *info;
+    g_autoptr(GPtrArray) links = NULL;
+
+    if (!self->priv->links_synced)
+        return FALSE;
+
+    /* Let the fallback report the errors with the base link */
+    base = g_hash_table_lookup (self->priv->links_by_name, base_ifname);
+    if (!base || (by_parent_dev_name && !base->parent_dev_name))
+        return FALSE;
+
+    links = g_ptr_array_new_with_free_func (g_free);
+    g_hash_table_iter_init (&iter, self->priv->links_by_index);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+        if (info == base)
+            continue;
+        if (by_parent_dev_name ?
+            (g_strcmp0 (info->parent_dev_name, base->parent_dev_name) != 0) :
+            (info->link_ifindex != base->ifindex))
+            continue;
+        g_ptr_array_add (links, g_strdup (info->ifname));
+    }
+
+    if (!links->len) {
+        *out_links = NULL;
+        return TRUE;
+    }
+
+    g_ptr_array_sort (links, (GCompareFunc) links_cmp);
+    *out_links = g_steal_pointer (&links);
+    return TRUE;
+}
+
+gboolean
+mbim_net_port_manager_index_list_upper_links (MbimNetPortManager  *self,
+                                              const gchar         *base_ifname,
+                                              GPtrArray          **out_links)
+{
+    return links_index_list (self, base_ifname, FALSE, out_links);
+}
+
+gboolean
+mbim_net_port_manager_index_list_sibling_links (MbimNetPortManager  *self,
+                                                const gchar         *base_ifname,
+                                                GPtrArray          **out_links)
+{
+    return links_index_list (self, base_ifname, TRUE, out_links);
+}
+
+void
+mbim_net_port_manager_index_link_event (MbimNetPortManager *self,
+                                        struct nlmsghdr    *hdr)
+{
+    g_assert (hdr);
+    link_event (hdr, self);
+}
+
+void
+mbim_net_port_manager_index_set_synced (MbimNetPortManager *self)
+{
+    self->priv->links_synced = TRUE;
+}
+
+guint
+mbim_net_port_manager_get_ifindex (MbimNetPortManager *self,
+                                   const gchar        *ifname)
+{
+    LinkInfo *info;
+
+    if (!self->priv->links_synced)
+        return if_nametoindex (ifname);
+
+    info = g_hash_table_lookup (self->priv->links_by_name, ifname);
+    return info ? info->ifindex : 0;
+}
+
+/*****************************************************************************/
+
+static gboolean
+get_first_free_session_id (MbimNetPortManager *self,
+                           const gchar        *ifname_prefix,
+                           const gboolean     *reserved,
+                           guint              *session_id)
+{
+    guint i;
+
+    /* The minimum session id is really 0 (MBIM_DEVICE_SESSION_ID_MIN), but
+     * when we have to automatically allocate a new session id we'll start at
+     * 1, because 0 is also used by the non-muxed setup. */
+    for (i = 1; i <= MBIM_DEVICE_SESSION_ID_MAX; i++) {
+        g_autofree gchar *ifname = NULL;
+
+        /* Ids already taken by other links of the same batch */
+        if (reserved && reserved[i])
+            continue;
+
+        ifname = mbim_net_port_manager_util_session_id_to_ifname (ifname_prefix, i);
+        if (!mbim_net_port_manager_get_ifindex (self, ifname)) {
+            *session_id = i;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 /*****************************************************************************/
 
 void
@@ -162,7 +472,7 @@ net_port_manager_del_link (MbimNetPortManager  *self,
 
     task = g_task_new (self, cancellable, callback, user_data);
 
-    ifindex = if_nametoindex (ifname);
+    ifindex = mbim_net_port_manager_get_ifindex (self, ifname);
     if (ifindex == 0) {
         g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
                                  "Failed to retrieve interface index for interface %s",
@@ -192,16 +502,130 @@ net_port_manager_del_link (MbimNetPortManager  *self,
     g_object_unref (task);
 }
 
+/*****************************************************************************/
+/* Batches of requests
+ *
+ * All the requests of a batch are sent in a single datagram. Each request is
+ * still a separate netlink transaction, matched to its own ACK through the
+ * sequence id, and the batch completes once all of them have completed. */
+
 typedef struct {
-    GPtrArray *links;
-    guint      link_i;
-} DelAllLinksContext;
+    GPtrArray *requests;    /* what each request does, for error messages; NULL
+                             * for cleanup requests whose errors are ignored */
+    GPtrArray *links;       /* only when adding or deleting links */
+    GArray    *session_ids; /* only when adding links */
+    gchar     *ifname;      /* only when applying IP configurations */
+    GPtrArray *undo_msgs;   /* only when applying IP configurations */
+    gboolean   cleanup_failed;
+    guint      n_pending;
+    GError    *error;
+} BatchContext;
+
+static BatchContext *
+batch_context_new (void)
+{
+    BatchContext *ctx;
+
+    ctx = g_slice_new0 (BatchContext);
+    ctx->requests = g_ptr_array_new_with_free_func (g_free);
+    return ctx;
+}
 
 static void
-del_all_links_context_free (DelAllLinksContext *ctx)
+batch_context_free (BatchContext *ctx)
 {
+    g_clear_pointer (&ctx->requests, g_ptr_array_unref);
     g_clear_pointer (&ctx->links, g_ptr_array_unref);
-    g_slice_free (DelAllLinksContext, ctx);
+    g_clear_pointer (&ctx->session_ids, g_array_unref);
+    g_free (ctx->ifname);
+    g_clear_pointer (&ctx->undo_msgs, g_ptr_array_unref);
+    g_clear_error (&ctx->error);
+    g_slice_free (BatchContext, ctx);
+}
+
+static void ip_configuration_update_undo (MbimNetPortManager *self,
+                                         const gchar        *ifname,
+                                         GPtrArray          *undo_msgs,
+                                         gboolean            applied);
+
+static void
+batch_request_ready (MbimNetPortManager *self,
+                     GAsyncResult       *res,
+                     GTask              *task)
+{
+    BatchContext *ctx;
+    const gchar  *request;
+    GError       *error = NULL;
+
+    ctx = g_task_get_task_data (task);
+    request = g_task_get_task_data (G_TASK (res));
+
+    if (!g_task_propagate_boolean (G_TASK (res), &error)) {
+        if (!request) {
+            g_debug ("Ignored cleanup request error: %s", error->message);
+            ctx->cleanup_failed = TRUE;
+            g_error_free (error);
+        } else if (!ctx->error) {
+            /* Only the first error is reported */
+            g_prefix_error (&error, "Failed to %s: ", request);
+            ctx->error = error;
+        } else
+            g_error_free (error);
+    }
+
+    g_assert (ctx->n_pending > 0);
+    if (--ctx->n_pending == 0) {
+        if (ctx->undo_msgs)
+            ip_configuration_update_undo (self, ctx->ifname, ctx->undo_msgs, !ctx->error && !ctx->cleanup_failed);
+        if (ctx->error)
+            g_task_return_error (task, g_steal_pointer (&ctx->error));
+        else
+            g_task_return_boolean (task, TRUE);
+    }
+    g_object_unref (task);
+}
+
+static void
+batch_send (MbimNetPortManager *self,
+            GTask              *task,
+            GPtrArray          *msgs,
+            guint               timeout,
+            GCancellable       *cancellable)
+{
+    BatchContext        *ctx;
+    g_autoptr(GPtrArray) transactions = NULL;
+    GError              *error = NULL;
+    guint                i;
+
+    ctx = g_task_get_task_data (task);
+    g_assert (msgs->len > 0);
+    g_assert (msgs->len == ctx->requests->len);
+
+    transactions = g_ptr_array_sized_new (msgs->len);
+    for (i = 0; i < msgs->len; i++) {
+        GTask *request_task;
+
+        /* Each request keeps a reference to the batch until it completes */
+        request_task = g_task_new (self, cancellable, (GAsyncReadyCallback) batch_request_ready, g_object_ref (task));
+        g_task_set_task_data (request_task, g_ptr_array_index (ctx->requests, i), NULL);
+        /* The task ownership is transferred to the transaction. */
+        g_ptr_array_add (transactions,
+                         mbim_helpers_netlink_transaction_new (&self->priv->current_sequence_id,
+                                                               self->priv->transactions,
+                                                               g_ptr_array_index (msgs, i),
+                                                               timeout,
+                                                               request_task));
+        g_object_unref (request_task);
+    }
+    ctx->n_pending = msgs->len;
+
+    if (!mbim_helpers_netlink_send_batch (self->priv->socket, msgs, cancellable, &error)) {
+        for (i = 0; i < transactions->len; i++)
+            mbim_helpers_netlink_transaction_complete_with_error (g_ptr_array_index (transactions, i),
+                                                                  self->priv->transactions,
+                                                                  g_error_copy (error));
+        g_error_free (error);
+    }
 }
 
 static gboolean
@@ -212,73 +636,521 @@ net_port_manager_del_all_links_finish (MbimNetPortManager  *self,
     return g_task_propagate_boolean (G_TASK (res), error);
 }
 
-static void delete_next_link (GTask *task);
-
 static void
-port_manager_del_link_ready (MbimNetPortManager *self,
-                             GAsyncResult       *res,
-                             GTask              *task)
+net_port_manager_del_all_links (MbimNetPortManager   *self,
+                                const gchar          *base_ifname,
+                                GCancellable         *cancellable,
+                                GAsyncReadyCallback   callback,
+                                gpointer              user_data)
 {
-    DelAllLinksContext *ctx;
-    GError             *error = NULL;
+    GTask               *task;
+    BatchContext        *ctx;
+    g_autoptr(GPtrArray) msgs = NULL;
+    GError              *error = NULL;
+    guint                i;
 
-    ctx = g_task_get_task_data (task);
+    task = g_task_new (self, cancellable, callback, user_data);
+    ctx = batch_context_new ();
+    g_task_set_task_data (task, ctx, (GDestroyNotify)batch_context_free);
 
-    if (!mbim_net_port_manager_del_link_finish (self, res, &error)) {
+    if (!mbim_net_port_manager_list_links (self, base_ifname, &ctx->links, &error)) {
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
     }
 
-    g_ptr_array_remove_index_fast (ctx->links, 0);
-    delete_next_link (task);
+    if (!ctx->links || ctx->links->len == 0) {
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
+    msgs = g_ptr_array_new_with_free_func ((GDestroyNotify) mbim_helpers_netlink_message_free);
+    for (i = 0; i < ctx->links->len; i++) {
+        const gchar *ifname;
+        guint        ifindex;
+
+        ifname = g_ptr_array_index (ctx->links, i);
+        ifindex = mbim_net_port_manager_get_ifindex (self, ifname);
+        if (ifindex == 0) {
+            g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                                     "Failed to retrieve interface index for interface %s",
+                                     ifname);
+            g_object_unref (task);
+            return;
+        }
+        g_ptr_array_add (msgs, netlink_message_del_link (ifindex));
+        g_ptr_array_add (ctx->requests, g_strdup_printf ("delete link %s", ifname));
+    }
+
+    /* All links deleted in one go */
+    batch_send (self, task, msgs, 5, cancellable);
+    g_object_unref (task);
 }
 
-static void
-delete_next_link (GTask *task)
+/*****************************************************************************/
+/* Batched link creation */
+
+GPtrArray *
+mbim_net_port_manager_add_links_finish (MbimNetPortManager  *self,
+                                        GArray             **session_ids,
+                                        GAsyncResult        *res,
+                                        GError             **error)
 {
-    MbimNetPortManager *self;
-    DelAllLinksContext *ctx;
+    BatchContext *ctx;
 
-    self = g_task_get_source_object (task);
-    ctx = g_task_get_task_data (task);
+    if (!g_task_propagate_boolean (G_TASK (res), error))
+        return NULL;
 
-    if (!ctx->links || ctx->links->len == 0) {
+    ctx = g_task_get_task_data (G_TASK (res));
+    if (session_ids)
+        *session_ids = g_array_ref (ctx->session_ids);
+    return g_ptr_array_ref (ctx->links);
+}
+
+void
+mbim_net_port_manager_add_links (MbimNetPortManager  *self,
+                                 const guint         *session_ids,
+                                 guint                n_session_ids,
+                                 const gchar         *base_ifname,
+                                 const gchar         *ifname_prefix,
+                                 guint                timeout,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+    GTask               *task;
+    BatchContext        *ctx;
+    g_autoptr(GPtrArray) msgs = NULL;
+    gboolean             reserved[MBIM_DEVICE_SESSION_ID_MAX + 1] = { FALSE };
+    GError              *error = NULL;
+    guint                i;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    ctx = batch_context_new ();
+    ctx->links = g_ptr_array_new_with_free_func (g_free);
+    ctx->session_ids = g_array_sized_new (FALSE, FALSE, sizeof (guint), n_session_ids);
+    g_task_set_task_data (task, ctx, (GDestroyNotify)batch_context_free);
+
+    if (!MBIM_NET_PORT_MANAGER_GET_CLASS (self)->new_link_message) {
+        g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED,
+                                 "Adding several links at once is unsupported");
+        g_object_unref (task);
+        return;
+    }
+
+    if (!n_session_ids) {
         g_task_return_boolean (task, TRUE);
         g_object_unref (task);
         return;
     }
 
-    mbim_net_port_manager_del_link (self,
-                                    g_ptr_array_index (ctx->links, 0),
-                                    5,
-                                    g_task_get_cancellable (task),
-                                    (GAsyncReadyCallback) port_manager_del_link_ready,
-                                    task);
+    /* Reserve the static session ids first, so that the automatic ones
+     * allocated in the same batch never take them */
+    for (i = 0; i < n_session_ids; i++) {
+        if (session_ids[i] == MBIM_DEVICE_SESSION_ID_AUTOMATIC)
+            continue;
+        g_assert (session_ids[i] <= MBIM_DEVICE_SESSION_ID_MAX);
+        if (reserved[session_ids[i]]) {
+            g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                                     "Session id %u requested more than once",
+                                     session_ids[i]);
+            g_object_unref (task);
+            return;
+        }
+        reserved[session_ids[i]] = TRUE;
+    }
+
+    /* Build all requests before sending anything */
+    msgs = g_ptr_array_new_with_free_func ((GDestroyNotify) mbim_helpers_netlink_message_free);
+    for (i = 0; i < n_session_ids; i++) {
+        guint           session_id;
+        gchar          *ifname;
+        NetlinkMessage *msg;
+
+        session_id = session_ids[i];
+        if (session_id == MBIM_DEVICE_SESSION_ID_AUTOMATIC) {
+            if (!get_first_free_session_id (self, ifname_prefix, reserved, &session_id)) {
+                g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                                         "Failed to find an available session ID");
+                g_object_unref (task);
+                return;
+            }
+            reserved[session_id] = TRUE;
+            g_debug ("Using dynamic session ID %u", session_id);
+        } else
+            g_debug ("Using static session ID %u", session_id);
+
+        ifname = mbim_net_port_manager_util_session_id_to_ifname (ifname_prefix, session_id);
+        msg = MBIM_NET_PORT_MANAGER_GET_CLASS (self)->new_link_message (self, session_id, base_ifname, ifname, &error);
+        if (!msg) {
+            g_prefix_error (&error, "Failed to add link with session id %u: ", session_id);
+            g_task_return_error (task, error);
+            g_object_unref (task);
+            g_free (ifname);
+            return;
+        }
+
+        g_array_append_val (ctx->session_ids, session_id);
+        g_ptr_array_add (ctx->requests, g_strdup_printf ("add link %s", ifname));
+        g_ptr_array_add (ctx->links, ifname);
+        g_ptr_array_add (msgs, msg);
+    }
+
+    batch_send (self, task, msgs, timeout, cancellable);
+    g_object_unref (task);
+}
+
+/* A single link is added as a batch of one */
+
+static gchar *
+net_port_manager_add_link_finish (MbimNetPortManager  *self,
+                                  guint               *session_id,
+                                  GAsyncResult        *res,
+                                  GError             **error)
+{
+    g_autoptr(GPtrArray) links = NULL;
+    g_autoptr(GArray)    session_ids = NULL;
+
+    links = mbim_net_port_manager_add_links_finish (self, &session_ids, res, error);
+    if (!links)
+        return NULL;
+
+    g_assert (links->len == 1);
+    *session_id = g_array_index (session_ids, guint, 0);
+    return g_strdup (g_ptr_array_index (links, 0));
 }
 
 static void
-net_port_manager_del_all_links (MbimNetPortManager   *self,
-                                const gchar          *base_ifname,
-                                GCancellable         *cancellable,
-                                GAsyncReadyCallback   callback,
-                                gpointer              user_data)
+net_port_manager_add_link (MbimNetPortManager  *self,
+                           guint                session_id,
+                           const gchar         *base_ifname,
+                           const gchar         *ifname_prefix,
+                           guint                timeout,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
 {
-    GTask              *task;
-    DelAllLinksContext *ctx;
-    GError             *error = NULL;
+    mbim_net_port_manager_add_links (self,
+                                     &session_id,
+                                     1,
+                                     base_ifname,
+                                     ifname_prefix,
+                                     timeout,
+                                     cancellable,
+                                     callback,
+                                     user_data);
+}
+
+/*****************************************************************************/
+/* IP configuration
+ *
+ * The settings reported by the modem in MBIM_CID_IP_CONFIGURATION are applied
+ * to the link with a single batch of rtnetlink requests. The requests needed
+ * to undo them are kept per link, so that when the configuration changes
+ * only the stale addresses and routes are removed, also in the same batch. */
+
+static gchar *
+address_to_string (const guint8  *address,
+                   GSocketFamily  family)
+{
+    g_autoptr(GInetAddress) addr = NULL;
+
+    addr = g_inet_address_new_from_bytes (address, family);
+    return g_inet_address_to_string (addr);
+}
+
+static gboolean
+address_is_any (const guint8 *address,
+                gsize         address_length)
+{
+    gsize i;
+
+    for (i = 0; i < address_length; i++) {
+        if (address[i])
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void
+build_default_route (guint8        family,
+                     const guint8 *gateway,
+                     const gchar  *ifname,
+                     guint         ifindex,
+                     guint         route_metric,
+                     GPtrArray    *msgs,
+                     GPtrArray    *requests,
+                     GPtrArray    *undo_msgs)
+{
+    g_autofree gchar *gateway_str = NULL;
+
+    if (gateway)
+        gateway_str = address_to_string (gateway, family == AF_INET ? G_SOCKET_FAMILY_IPV4 : G_SOCKET_FAMILY_IPV6);
+
+    g_ptr_array_add (msgs, mbim_helpers_netlink_message_new_default_route (RTM_NEWROUTE, ifindex, family, gateway, route_metric));
+    g_ptr_array_add (undo_msgs, mbim_helpers_netlink_message_new_default_route (RTM_DELROUTE, ifindex, family, gateway, route_metric));
+    if (gateway_str)
+        g_ptr_array_add (requests, g_strdup_printf ("add %s default route via %s to %s",
+                                                    family == AF_INET ? "IPv4" : "IPv6", gateway_str, ifname));
+    else
+        g_ptr_array_add (requests, g_strdup_printf ("add %s default route to %s",
+                                                    family == AF_INET ? "IPv4" : "IPv6", ifname));
+}
+
+gboolean
+mbim_net_port_manager_util_build_ip_configuration (MbimMessage  *message,
+                                                   const gchar  *ifname,
+                                                   guint         ifindex,
+                                                   guint         route_metric,
+                                                   GPtrArray    *msgs,
+                                                   GPtrArray    *requests,
+                                                   GPtrArray    *undo_msgs,
+                                                   GError      **error)
+{
+    MbimMessageType                  type;
+    MbimIPConfigurationAvailableFlag ipv4_available;
+    MbimIPConfigurationAvailableFlag ipv6_available;
+    guint32                          ipv4_address_count;
+    g_autoptr(MbimIPv4ElementArray)  ipv4_address = NULL;
+    guint32                          ipv6_address_count;
+    g_autoptr(MbimIPv6ElementArray)  ipv6_address = NULL;
+    const MbimIPv4                  *ipv4_gateway = NULL;
+    const MbimIPv6                  *ipv6_gateway = NULL;
+    guint32                          ipv4_mtu;
+    guint32                          ipv6_mtu;
+    guint                            mtu = 0;
+    guint                            i;
+
+    type = mbim_message_get_message_type (message);
+    if (type == MBIM_MESSAGE_TYPE_COMMAND_DONE &&
+        mbim_message_command_done_get_service (message) == MBIM_SERVICE_BASIC_CONNECT &&
+        mbim_message_command_done_get_cid (message) == MBIM_CID_BASIC_CONNECT_IP_CONFIGURATION) {
+        if (!mbim_message_response_get_result (message, MBIM_MESSAGE_TYPE_COMMAND_DONE, error) ||
+            !mbim_message_ip_configuration_response_parse (message,
+                                                           NULL, /* session id */
+                                                           &ipv4_available,
+                                                           &ipv6_available,
+                                                           &ipv4_address_count,
+                                                           &ipv4_address,
+                                                           &ipv6_address_count,
+                                                           &ipv6_address,
+                                                           &ipv4_gateway,
+                                                           &ipv6_gateway,
+                                                           NULL, NULL, /* IPv4 DNS */
+                                                           NULL, NULL, /* IPv6 DNS */
+                                                           &ipv4_mtu,
+                                                           &ipv6_mtu,
+                                                           error))
+            return FALSE;
+    } else if (type == MBIM_MESSAGE_TYPE_INDICATE_STATUS &&
+               mbim_message_indicate_status_get_service (message) == MBIM_SERVICE_BASIC_CONNECT &&
+               mbim_message_indicate_status_get_cid (message) == MBIM_CID_BASIC_CONNECT_IP_CONFIGURATION) {
+        if (!mbim_message_ip_configuration_notification_parse (message,
+                                                               NULL, /* session id */
+                                                               &ipv4_available,
+                                                               &ipv6_available,
+                                                               &ipv4_address_count,
+                                                               &ipv4_address,
+                                                               &ipv6_address_count,
+                                                               &ipv6_address,
+                                                               &ipv4_gateway,
+                                                               &ipv6_gateway,
+                                                               NULL, NULL, /* IPv4 DNS */
+                                                               NULL, NULL, /* IPv6 DNS */
+                                                               &ipv4_mtu,
+                                                               &ipv6_mtu,
+                                                               error))
+            return FALSE;
+    } else {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                     "Not an IP configuration response or notification");
+        return FALSE;
+    }
+
+    if (!(ipv4_available & MBIM_IP_CONFIGURATION_AVAILABLE_FLAG_ADDRESS))
+        ipv4_address_count = 0;
+    if (!(ipv6_available & MBIM_IP_CONFIGURATION_AVAILABLE_FLAG_ADDRESS))
+        ipv6_address_count = 0;
+    if (!(ipv4_available & MBIM_IP_CONFIGURATION_AVAILABLE_FLAG_GATEWAY) ||
+        (ipv4_gateway && address_is_any (ipv4_gateway->addr, sizeof (ipv4_gateway->addr))))
+        ipv4_gateway = NULL;
+    if (!(ipv6_available & MBIM_IP_CONFIGURATION_AVAILABLE_FLAG_GATEWAY) ||
+        (ipv6_gateway && address_is_any (ipv6_gateway->addr, sizeof (ipv6_gateway->addr))))
+        ipv6_gateway = NULL;
+
+    /* A single MTU applies to both families, so take the lowest one; the
+     * kernel disables IPv6 in links with a MTU below 1280 */
+    if ((ipv4_available & MBIM_IP_CONFIGURATION_AVAILABLE_FLAG_MTU) && ipv4_mtu)
+        mtu = ipv4_mtu;
+    if ((ipv6_available & MBIM_IP_CONFIGURATION_AVAILABLE_FLAG_MTU) && ipv6_mtu && (!mtu || ipv6_mtu < mtu))
+        mtu = ipv6_mtu;
+    if (ipv6_address_count && mtu && mtu < 1280)
+        mtu = 1280;
+
+    g_ptr_array_add (msgs, mbim_helpers_netlink_message_new_link_up (ifindex, mtu));
+    if (mtu)
+        g_ptr_array_add (requests, g_strdup_printf ("bring up %s with MTU %u", ifname, mtu));
+    else
+        g_ptr_array_add (requests, g_strdup_printf ("bring up %s", ifname));
+
+    for (i = 0; i < ipv4_address_count; i++) {
+        const guint8     *address = ipv4_address[i]->ipv4_address.addr;
+        guint8            prefix_length = ipv4_address[i]->on_link_prefix_length;
+        g_autofree gchar *address_str = NULL;
+
+        address_str = address_to_string (address, G_SOCKET_FAMILY_IPV4);
+        g_ptr_array_add (msgs, mbim_helpers_netlink_message_new_address (RTM_NEWADDR, ifindex, AF_INET, address, prefix_length));
+        g_ptr_array_add (undo_msgs, mbim_helpers_netlink_message_new_address (RTM_DELADDR, ifindex, AF_INET, address, prefix_length));
+        g_ptr_array_add (requests, g_strdup_printf ("add address %s/%u to %s", address_str, prefix_length, ifname));
+    }
+
+    for (i = 0; i < ipv6_address_count; i++) {
+        const guint8     *address = ipv6_address[i]->ipv6_address.addr;
+        guint8            prefix_length = ipv6_address[i]->on_link_prefix_length;
+        g_autofree gchar *address_str = NULL;
+
+        address_str = address_to_string (address, G_SOCKET_FAMILY_IPV6);
+        g_ptr_array_add (msgs, mbim_helpers_netlink_message_new_address (RTM_NEWADDR, ifindex, AF_INET6, address, prefix_length));
+        g_ptr_array_add (undo_msgs, mbim_helpers_netlink_message_new_address (RTM_DELADDR, ifindex, AF_INET6, address, prefix_length));
+        g_ptr_array_add (requests, g_strdup_printf ("add address %s/%u to %s", address_str, prefix_length, ifname));
+    }
+
+    /* Routes go last, as the kernel rejects a gateway that isn't reachable
+     * yet unless it is flagged as on-link */
+    if (ipv4_address_count)
+        build_default_route (AF_INET, ipv4_gateway ? ipv4_gateway->addr : NULL,
+                             ifname, ifindex, route_metric, msgs, requests, undo_msgs);
+    if (ipv6_address_count)
+        build_default_route (AF_INET6, ipv6_gateway ? ipv6_gateway->addr : NULL,
+                             ifname, ifindex, route_metric, msgs, requests, undo_msgs);
+
+    return TRUE;
+}
+
+static gboolean
+netlink_message_list_contains (GPtrArray      *msgs,
+                               NetlinkMessage *msg)
+{
+    guint i;
+
+    /* Undo requests are never sent themselves, so they all have the same
+     * (unset) sequence id and can be compared as a whole */
+    for (i = 0; i < msgs->len; i++) {
+        NetlinkMessage *other = g_ptr_array_index (msgs, i);
+
+        if (other->len == msg->len && memcmp (other->data, msg->data, msg->len) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static void
+ip_configuration_update_undo (MbimNetPortManager *self,
+                              const gchar        *ifname,
+                              GPtrArray          *undo_msgs,
+                              gboolean            applied)
+{
+    GPtrArray *previous_undo_msgs;
+    guint      i;
+
+    previous_undo_msgs = g_hash_table_lookup (self->priv->ip_configurations, ifname);
+    if (applied || !previous_undo_msgs) {
+        g_hash_table_insert (self->priv->ip_configurations, g_strdup (ifname), g_ptr_array_ref (undo_msgs));
+        return;
+    }
+
+    /* It isn't known which of the previous and new settings are left on the
+     * link, so all of them are removed if stale next time */
+    for (i = 0; i < undo_msgs->len; i++) {
+        NetlinkMessage *undo_msg = g_ptr_array_index (undo_msgs, i);
+
+        if (netlink_message_list_contains (previous_undo_msgs, undo_msg))
+            continue;
+        g_ptr_array_add (previous_undo_msgs, g_byte_array_append (g_byte_array_sized_new (undo_msg->len),
+                                                                  undo_msg->data,
+                                                                  undo_msg->len));
+    }
+}
+
+gboolean
+mbim_net_port_manager_apply_ip_configuration_finish (MbimNetPortManager  *self,
+                                                     GAsyncResult        *res,
+                                                     GError             **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+void
+mbim_net_port_manager_apply_ip_configuration (MbimNetPortManager  *self,
+                                              const gchar         *ifname,
+                                              MbimMessage         *message,
+                                              guint                route_metric,
+                                              guint                timeout,
+                                              GCancellable        *cancellable,
+                                              GAsyncReadyCallback  callback,
+                                              gpointer             user_data)
+{
+    GTask               *task;
+    BatchContext        *ctx;
+    guint                ifindex;
+    g_autoptr(GPtrArray) msgs = NULL;
+    GPtrArray           *previous_undo_msgs;
+    GError              *error = NULL;
+    guint                n_stale = 0;
+    guint                i;
 
     task = g_task_new (self, cancellable, callback, user_data);
-    ctx = g_slice_new0 (DelAllLinksContext);
-    g_task_set_task_data (task, ctx, (GDestroyNotify)del_all_links_context_free);
+    ctx = batch_context_new ();
+    g_task_set_task_data (task, ctx, (GDestroyNotify)batch_context_free);
 
-    if (!mbim_net_port_manager_list_links (self, base_ifname, &ctx->links, &error)) {
+    ifindex = mbim_net_port_manager_get_ifindex (self, ifname);
+    if (ifindex == 0) {
+        g_task_return_new_error (task, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                                 "Failed to retrieve interface index for interface %s",
+                                 ifname);
+        g_object_unref (task);
+        return;
+    }
+
+    /* The undo requests replace the previous ones only once the new
+     * configuration has been applied */
+    ctx->ifname = g_strdup (ifname);
+    ctx->undo_msgs = g_ptr_array_new_with_free_func ((GDestroyNotify) mbim_helpers_netlink_message_free);
+
+    msgs = g_ptr_array_new_with_free_func ((GDestroyNotify) mbim_helpers_netlink_message_free);
+    if (!mbim_net_port_manager_util_build_ip_configuration (message,
+                                                            ifname,
+                                                            ifindex,
+                                                            route_metric,
+                                                            msgs,
+                                                            ctx->requests,
+                                                            ctx->undo_msgs,
+                                                            &error)) {
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
     }
 
-    delete_next_link (task);
+    /* Remove first whatever the previous configuration added and the new one
+     * doesn't have; these may fail if e.g. the link was reset meanwhile */
+    previous_undo_msgs = g_hash_table_lookup (self->priv->ip_configurations, ifname);
+    for (i = 0; previous_undo_msgs && i < previous_undo_msgs->len; i++) {
+        NetlinkMessage *undo_msg = g_ptr_array_index (previous_undo_msgs, i);
+
+        if (netlink_message_list_contains (ctx->undo_msgs, undo_msg))
+            continue;
+        g_ptr_array_insert (msgs, n_stale, g_byte_array_append (g_byte_array_sized_new (undo_msg->len),
+                                                                undo_msg->data,
+                                                                undo_msg->len));
+        g_ptr_array_insert (ctx->requests, n_stale, NULL);
+        n_stale++;
+    }
+    g_debug ("Applying IP configuration to %s: %u requests, %u stale settings removed",
+             ifname, msgs->len - n_stale, n_stale);
+
+    batch_send (self, task, msgs, timeout, cancellable);
+    g_object_unref (task);
 }
 
 /*****************************************************************************/
@@ -312,6 +1184,9 @@ mbim_net_port_manager_common_setup (MbimNetPortManager *self,
                                     const gchar        *iface,
                                     GSocket            *gsocket)
 {
+    g_autoptr(GError) error = NULL;
+    gboolean          subscribed = TRUE;
+
     self->priv->iface = g_strdup (iface);
     self->priv->socket = gsocket;
     self->priv->current_sequence_id = 0;
@@ -320,9 +1195,35 @@ mbim_net_port_manager_common_setup (MbimNetPortManager *self,
                                g_direct_equal,
                                NULL,
                                (GDestroyNotify) mbim_helpers_netlink_transaction_free);
+    self->priv->links_by_index =
+        g_hash_table_new_full (g_direct_hash,
+                               g_direct_equal,
+                               NULL,
+                               (GDestroyNotify) link_info_free);
+    self->priv->links_by_name = g_hash_table_new (g_str_hash, g_str_equal);
+    self->priv->ip_configurations =
+        g_hash_table_new_full (g_str_hash,
+                               g_str_equal,
+                               g_free,
+                               (GDestroyNotify) g_ptr_array_unref);
+
+    /* Subscribe to link notifications before seeding the index, so that no
+     * change is missed in between */
+    if (!g_socket_set_option (self->priv->socket, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, RTNLGRP_LINK, &error)) {
+        g_debug ("Couldn't subscribe to link notifications: %s", error->message);
+        subscribed = FALSE;
+    }
+
     mbim_helpers_netlink_set_callback (&self->priv->source,
                                        self->priv->socket,
-                                       self->priv->transactions);
+                                       self->priv->transactions,
+                                       subscribed ? (NetlinkLinkEventFunc) link_event : NULL,
+                                       self);
+
+    /* Seed the index in the background, as this is run from async methods;
+     * lookups fall back to sysfs until then */
+    if (subscribed)
+        links_index_resync (self);
 }
 
 gchar *
@@ -334,25 +1235,11 @@ mbim_net_port_manager_util_session_id_to_ifname (const gchar *ifname_prefix,
 }
 
 gboolean
-mbim_net_port_manager_util_get_first_free_session_id (const gchar *ifname_prefix,
-                                                      guint       *session_id)
+mbim_net_port_manager_get_first_free_session_id (MbimNetPortManager *self,
+                                                 const gchar        *ifname_prefix,
+                                                 guint              *session_id)
 {
-    guint i;
-
-    /* The minimum session id is really 0 (MBIM_DEVICE_SESSION_ID_MIN), but
-     * when we have to automatically allocate a new session id we'll start at
-     * 1, because 0 is also used by the non-muxed setup. */
-    for (i = 1; i <= MBIM_DEVICE_SESSION_ID_MAX; i++) {
-        g_autofree gchar *ifname = NULL;
-
-        ifname = mbim_net_port_manager_util_session_id_to_ifname (ifname_prefix, i);
-        if (!if_nametoindex (ifname)) {
-            *session_id = i;
-            return TRUE;
-        }
-    }
-
-    return FALSE;
+    return get_first_free_session_id (self, ifname_prefix, NULL, session_id);
 }
 
 /*****************************************************************************/
@@ -370,7 +1257,20 @@ finalize (GObject *object)
     MbimNetPortManager *self = MBIM_NET_PORT_MANAGER (object);
 
     g_assert (g_hash_table_size (self->priv->transactions) == 0);
+    /* The socket source refers to the manager through the link events */
+    if (self->priv->source) {
+        g_source_destroy (self->priv->source);
+        g_source_unref (self->priv->source);
+    }
+    if (self->priv->links_dump_retry_source) {
+        g_source_destroy (self->priv->links_dump_retry_source);
+        g_source_unref (self->priv->links_dump_retry_source);
+    }
+    g_clear_object (&self->priv->socket);
     g_hash_table_unref (self->priv->transactions);
+    g_hash_table_unref (self->priv->links_by_name);
+    g_hash_table_unref (self->priv->links_by_index);
+    g_hash_table_unref (self->priv->ip_configurations);
     g_free (self->priv->iface);
 
     G_OBJECT_CLASS (mbim_net_port_manager_parent_class)->finalize (object);
@@ -385,6 +1285,8 @@ mbim_net_port_manager_class_init (MbimNetPortManagerClass *klass)
 
     object_class->finalize = finalize;
 
+    klass->add_link = net_port_manager_add_link;
+    klass->add_link_finish = net_port_manager_add_link_finish;
     klass->del_link = net_port_manager_del_link;
     klass->del_link_finish = net_port_manager_del_link_finish;
     klass->del_all_links = net_port_manager_del_all_links;
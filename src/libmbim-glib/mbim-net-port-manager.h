@@ -16,6 +16,9 @@
 #include <gio/gio.h>
 #include <glib-object.h>
 
+#include "mbim-message.h"
+#include "mbim-helpers-netlink.h"
+
 #define MBIM_TYPE_NET_PORT_MANAGER            (mbim_net_port_manager_get_type ())
 #define MBIM_NET_PORT_MANAGER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MBIM_TYPE_NET_PORT_MANAGER, MbimNetPortManager))
 #define MBIM_NET_PORT_MANAGER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  MBIM_TYPE_NET_PORT_MANAGER, MbimNetPortManagerClass))
@@ -71,6 +74,15 @@ struct _MbimNetPortManagerClass {
     gboolean (* del_all_links_finish) (MbimNetPortManager   *self,
                                        GAsyncResult         *res,
                                        GError              **error);
+
+    /* Builds the RTM_NEWLINK request for a single link, so that the requests
+     * of several links can be sent at once; the default add_link() sends it
+     * as a batch of one */
+    NetlinkMessage * (* new_link_message) (MbimNetPortManager  *self,
+                                           guint                session_id,
+                                           const gchar         *base_ifname,
+                                           const gchar         *ifname,
+                                           GError             **error);
 };
 
 GType mbim_net_port_manager_get_type (void);
@@ -94,6 +106,20 @@ gchar    *mbim_net_port_manager_add_link_finish (MbimNetPortManager   *self,
                                                  GAsyncResult         *res,
                                                  GError              **error);
 
+void       mbim_net_port_manager_add_links        (MbimNetPortManager   *self,
+                                                   const guint          *session_ids,
+                                                   guint                 n_session_ids,
+                                                   const gchar          *base_ifname,
+                                                   const gchar          *ifname_prefix,
+                                                   guint                 timeout,
+                                                   GCancellable         *cancellable,
+                                                   GAsyncReadyCallback   callback,
+                                                   gpointer              user_data);
+GPtrArray *mbim_net_port_manager_add_links_finish (MbimNetPortManager   *self,
+                                                   GArray              **session_ids,
+                                                   GAsyncResult         *res,
+                                                   GError              **error);
+
 void      mbim_net_port_manager_del_link        (MbimNetPortManager   *self,
                                                  const gchar          *ifname,
                                                  guint                 timeout,
@@ -113,6 +139,18 @@ gboolean  mbim_net_port_manager_del_all_links_finish (MbimNetPortManager   *self
                                                       GAsyncResult         *res,
                                                       GError              **error);
 
+void      mbim_net_port_manager_apply_ip_configuration        (MbimNetPortManager   *self,
+                                                               const gchar          *ifname,
+                                                               MbimMessage          *message,
+                                                               guint                 route_metric,
+                                                               guint                 timeout,
+                                                               GCancellable         *cancellable,
+                                                               GAsyncReadyCallback   callback,
+                                                               gpointer              user_data);
+gboolean  mbim_net_port_manager_apply_ip_configuration_finish (MbimNetPortManager   *self,
+                                                               GAsyncResult         *res,
+                                                               GError              **error);
+
 GHashTable *mbim_net_port_manager_peek_transactions (MbimNetPortManager *self);
 
 gchar *mbim_net_port_manager_peek_iface (MbimNetPortManager *self);
@@ -128,7 +166,42 @@ void mbim_net_port_manager_common_setup (MbimNetPortManager *self,
 gchar *mbim_net_port_manager_util_session_id_to_ifname (const gchar *ifname_prefix,
                                                         guint        session_id);
 
-gboolean mbim_net_port_manager_util_get_first_free_session_id (const gchar *ifname_prefix,
-                                                               guint       *session_id);
+gboolean mbim_net_port_manager_get_first_free_session_id (MbimNetPortManager *self,
+                                                          const gchar        *ifname_prefix,
+                                                          guint              *session_id);
+
+/* Builds the requests applying the settings of a MBIM_CID_IP_CONFIGURATION
+ * response or notification to a link, along with a description of each one,
+ * and the requests that undo them. */
+gboolean mbim_net_port_manager_util_build_ip_configuration (MbimMessage  *message,
+                                                            const gchar  *ifname,
+                                                            guint         ifindex,
+                                                            guint         route_metric,
+                                                            GPtrArray    *msgs,
+                                                            GPtrArray    *requests,
+                                                            GPtrArray    *undo_msgs,
+                                                            GError      **error);
+
+/* Index of the kernel net links, kept in sync with link notifications.
+ * Returns 0 if there is no link named @ifname. */
+guint mbim_net_port_manager_get_ifindex (MbimNetPortManager *self,
+                                         const gchar        *ifname);
+
+/* Links on top of @base_ifname (e.g. VLANs), or sharing the parent device
+ * with @base_ifname (e.g. WWAN links). These return FALSE if the index
+ * cannot tell, and the caller should look at sysfs instead. */
+gboolean mbim_net_port_manager_index_list_upper_links   (MbimNetPortManager  *self,
+                                                         const gchar         *base_ifname,
+                                                         GPtrArray          **out_links);
+gboolean mbim_net_port_manager_index_list_sibling_links (MbimNetPortManager  *self,
+                                                         const gchar         *base_ifname,
+                                                         GPtrArray          **out_links);
+
+/* Feed a link notification to the index as if received from the kernel, and
+ * mark the index in sync as the initial dump does; used by the tests, which
+ * have no kernel to dump the links from. */
+void mbim_net_port_manager_index_link_event (MbimNetPortManager *self,
+                                             struct nlmsghdr    *hdr);
+void mbim_net_port_manager_index_set_synced (MbimNetPortManager *self);
 
 #endif /* _LIBMBIM_GLIB_MBIM_NET_PORT_MANAGER_H_ */
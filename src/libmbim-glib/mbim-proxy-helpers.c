@@ -7,6 +7,7 @@
  * Copyright (C) 2014 Smith Micro Software, Inc.
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include "mbim-proxy-helpers.h"
 #include "mbim-message-private.h"
@@ -306,6 +307,83 @@ _mbim_proxy_helper_service_subscribe_list_dup (MbimEventEntry **in,
 
 /*****************************************************************************/
 
+gchar **
+_mbim_proxy_helper_service_subscribe_list_to_strv (const MbimEventEntry * const *list,
+                                                   gsize                         list_size)
+{
+    gchar **out;
+    guint   i;
+
+    out = g_new0 (gchar *, list_size + 1);
+    for (i = 0; i < list_size; i++) {
+        g_autofree gchar *uuid = NULL;
+        GString          *str;
+        guint             j;
+
+        uuid = mbim_uuid_get_printable (&list[i]->device_service_id);
+        str = g_string_new (uuid);
+        for (j = 0; j < list[i]->cids_count; j++)
+            g_string_append_printf (str, "%c%u", j == 0 ? ':' : ',', list[i]->cids[j]);
+        out[i] = g_string_free (str, FALSE);
+    }
+
+    return out;
+}
+
+MbimEventEntry **
+_mbim_proxy_helper_service_subscribe_list_from_strv (const gchar * const  *strv,
+                                                     gsize                *out_size,
+                                                     GError              **error)
+{
+    g_autoptr(MbimEventEntryArray) out = NULL;
+    guint                          n;
+    guint                          i;
+
+    g_assert (out_size != NULL);
+
+    n = strv ? g_strv_length ((gchar **)strv) : 0;
+    out = g_new0 (MbimEventEntry *, n + 1);
+    for (i = 0; i < n; i++) {
+        g_auto(GStrv)   split = NULL;
+        MbimEventEntry *entry;
+
+        split = g_strsplit (strv[i], ":", 2);
+        entry = g_new0 (MbimEventEntry, 1);
+        out[i] = entry;
+
+        if (!mbim_uuid_from_printable (split[0], &entry->device_service_id)) {
+            g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                         "Invalid service UUID: '%s'", split[0]);
+            return NULL;
+        }
+
+        /* No CIDs given means all of them */
+        if (split[1]) {
+            g_auto(GStrv) cids = NULL;
+            guint         j;
+
+            cids = g_strsplit (split[1], ",", -1);
+            entry->cids_count = g_strv_length (cids);
+            entry->cids = g_new0 (guint32, entry->cids_count);
+            for (j = 0; j < entry->cids_count; j++) {
+                guint64 cid;
+
+                if (!g_ascii_string_to_unsigned (cids[j], 10, 1, G_MAXUINT32, &cid, NULL)) {
+                    g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                                 "Invalid CID: '%s'", cids[j]);
+                    return NULL;
+                }
+                entry->cids[j] = (guint32) cid;
+            }
+        }
+    }
+
+    *out_size = n;
+    return g_steal_pointer (&out);
+}
+
+/*****************************************************************************/
+
 MbimEventEntry **
 _mbim_proxy_helper_service_subscribe_list_new_standard (gsize *out_size)
 {
@@ -399,3 +477,281 @@ _mbim_proxy_helper_service_subscribe_list_new_standard (gsize *out_size)
     *out_size = i;
     return out;
 }
+
+/*****************************************************************************/
+
+typedef struct {
+    MbimUuid    device_service_id;
+    /* Number of subscriptions to all the CIDs of the service */
+    guint       all_cids_refs;
+    /* Number of subscriptions to each specific CID */
+    GHashTable *cids_refs;
+} ServiceSubscription;
+
+struct _MbimProxySubscriptionSet {
+    GHashTable *services;
+    gboolean    changed;
+};
+
+static guint
+uuid_hash (gconstpointer key)
+{
+    const guint8 *bytes = key;
+    guint         hash = 5381;
+    guint         i;
+
+    for (i = 0; i < sizeof (MbimUuid); i++)
+        hash = (hash << 5) + hash + bytes[i];
+    return hash;
+}
+
+static gboolean
+uuid_equal (gconstpointer a,
+            gconstpointer b)
+{
+    return mbim_uuid_cmp ((const MbimUuid *)a, (const MbimUuid *)b);
+}
+
+static void
+service_subscription_free (ServiceSubscription *service)
+{
+    g_hash_table_unref (service->cids_refs);
+    g_slice_free (ServiceSubscription, service);
+}
+
+static gboolean
+is_standard_service (const MbimUuid *uuid)
+{
+    MbimService id;
+
+    /* Same rule as when merging lists: additions for standard services are
+     * ignored, as the standard list is always enabled */
+    id = mbim_uuid_to_service (uuid);
+    return (id >= MBIM_SERVICE_BASIC_CONNECT && id <= MBIM_SERVICE_DSS);
+}
+
+MbimProxySubscriptionSet *
+_mbim_proxy_helper_subscription_set_new (void)
+{
+    MbimProxySubscriptionSet *set;
+
+    set = g_slice_new0 (MbimProxySubscriptionSet);
+    set->services = g_hash_table_new_full (uuid_hash,
+                                           uuid_equal,
+                                           NULL,
+                                           (GDestroyNotify)service_subscription_free);
+    return set;
+}
+
+void
+_mbim_proxy_helper_subscription_set_free (MbimProxySubscriptionSet *set)
+{
+    g_hash_table_unref (set->services);
+    g_slice_free (MbimProxySubscriptionSet, set);
+}
+
+void
+_mbim_proxy_helper_subscription_set_reset (MbimProxySubscriptionSet *set)
+{
+    g_hash_table_remove_all (set->services);
+    set->changed = FALSE;
+}
+
+static void
+subscription_set_add_entry (MbimProxySubscriptionSet *set,
+                            const MbimEventEntry     *entry)
+{
+    ServiceSubscription *service;
+    guint32              i;
+
+    if (is_standard_service (&entry->device_service_id))
+        return;
+
+    service = g_hash_table_lookup (set->services, &entry->device_service_id);
+    if (!service) {
+        service = g_slice_new0 (ServiceSubscription);
+        memcpy (&service->device_service_id, &entry->device_service_id, sizeof (MbimUuid));
+        service->cids_refs = g_hash_table_new (g_direct_hash, g_direct_equal);
+        g_hash_table_insert (set->services, &service->device_service_id, service);
+    }
+
+    /* No CIDs given means all CIDs enabled */
+    if (entry->cids_count == 0) {
+        if (service->all_cids_refs++ == 0)
+            set->changed = TRUE;
+        return;
+    }
+
+    for (i = 0; i < entry->cids_count; i++) {
+        guint refs;
+
+        refs = GPOINTER_TO_UINT (g_hash_table_lookup (service->cids_refs, GUINT_TO_POINTER (entry->cids[i])));
+        g_hash_table_insert (service->cids_refs, GUINT_TO_POINTER (entry->cids[i]), GUINT_TO_POINTER (refs + 1));
+        /* A new CID only changes the set if not all CIDs are already enabled */
+        if (refs == 0 && service->all_cids_refs == 0)
+            set->changed = TRUE;
+    }
+}
+
+static void
+subscription_set_remove_entry (MbimProxySubscriptionSet *set,
+                               const MbimEventEntry     *entry)
+{
+    ServiceSubscription *service;
+    guint32              i;
+
+    if (is_standard_service (&entry->device_service_id))
+        return;
+
+    service = g_hash_table_lookup (set->services, &entry->device_service_id);
+    g_return_if_fail (service != NULL);
+
+    if (entry->cids_count == 0) {
+        g_return_if_fail (service->all_cids_refs > 0);
+        if (--service->all_cids_refs == 0)
+            set->changed = TRUE;
+    }
+
+    for (i = 0; i < entry->cids_count; i++) {
+        guint refs;
+
+        refs = GPOINTER_TO_UINT (g_hash_table_lookup (service->cids_refs, GUINT_TO_POINTER (entry->cids[i])));
+        if (refs == 0) {
+            g_warn_if_reached ();
+            continue;
+        }
+
+        if (refs > 1) {
+            g_hash_table_insert (service->cids_refs, GUINT_TO_POINTER (entry->cids[i]), GUINT_TO_POINTER (refs - 1));
+            continue;
+        }
+
+        g_hash_table_remove (service->cids_refs, GUINT_TO_POINTER (entry->cids[i]));
+        if (service->all_cids_refs == 0)
+            set->changed = TRUE;
+    }
+
+    if (service->all_cids_refs == 0 && g_hash_table_size (service->cids_refs) == 0)
+        g_hash_table_remove (set->services, &entry->device_service_id);
+}
+
+void
+_mbim_proxy_helper_subscription_set_update (MbimProxySubscriptionSet     *set,
+                                            const MbimEventEntry * const *removed,
+                                            gsize                         removed_size,
+                                            const MbimEventEntry * const *added,
+                                            gsize                         added_size)
+{
+    gsize i;
+
+    /* Additions are applied first, so that the entries both removed and added
+     * never drop their reference count to zero, and the set is only flagged
+     * as changed if the effective list of services and CIDs changes */
+    for (i = 0; i < added_size; i++)
+        subscription_set_add_entry (set, added[i]);
+    for (i = 0; i < removed_size; i++)
+        subscription_set_remove_entry (set, removed[i]);
+}
+
+gboolean
+_mbim_proxy_helper_subscription_set_changed (MbimProxySubscriptionSet *set)
+{
+    return set->changed;
+}
+
+static gint
+cid_cmp (gconstpointer a,
+         gconstpointer b)
+{
+    guint32 cid_a = *((const guint32 *)a);
+    guint32 cid_b = *((const guint32 *)b);
+
+    return (cid_a < cid_b) ? -1 : (cid_a > cid_b);
+}
+
+MbimEventEntry **
+_mbim_proxy_helper_subscription_set_build (MbimProxySubscriptionSet *set,
+                                           gsize                    *out_size)
+{
+    MbimEventEntry      **out;
+    gsize                 n;
+    GHashTableIter        iter;
+    ServiceSubscription  *service;
+
+    g_assert (out_size != NULL);
+
+    out = _mbim_proxy_helper_service_subscribe_list_new_standard (&n);
+    out = g_renew (MbimEventEntry *, out, n + g_hash_table_size (set->services) + 1);
+
+    g_hash_table_iter_init (&iter, set->services);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&service)) {
+        MbimEventEntry *entry;
+
+        entry = g_new0 (MbimEventEntry, 1);
+        memcpy (&entry->device_service_id, &service->device_service_id, sizeof (MbimUuid));
+
+        /* If all CIDs enabled, leave the list of CIDs empty */
+        if (service->all_cids_refs == 0) {
+            GHashTableIter  cids_iter;
+            gpointer        cid;
+            guint32         i = 0;
+
+            entry->cids_count = g_hash_table_size (service->cids_refs);
+            entry->cids = g_new (guint32, entry->cids_count);
+            g_hash_table_iter_init (&cids_iter, service->cids_refs);
+            while (g_hash_table_iter_next (&cids_iter, &cid, NULL))
+                entry->cids[i++] = GPOINTER_TO_UINT (cid);
+            qsort (entry->cids, entry->cids_count, sizeof (guint32), cid_cmp);
+        }
+
+        out[n++] = entry;
+    }
+    out[n] = NULL;
+
+    set->changed = FALSE;
+    *out_size = n;
+    return out;
+}
+
+/*****************************************************************************/
+
+void
+_mbim_proxy_helper_latency_histogram_add (MbimProxyLatencyHistogram *histogram,
+                                          gint64                     latency_us)
+{
+    guint bucket = 0;
+
+    /* Anything longer than the last bucket is accounted in the last bucket */
+    if (latency_us > 0)
+        bucket = MIN (g_bit_storage ((gulong) MIN (latency_us, G_MAXUINT32)) - 1, MBIM_PROXY_LATENCY_HISTOGRAM_BUCKETS - 1);
+
+    histogram->buckets[bucket]++;
+    histogram->count++;
+}
+
+guint32
+_mbim_proxy_helper_latency_histogram_percentile (const MbimProxyLatencyHistogram *histogram,
+                                                 guint                            percentile)
+{
+    guint64 rank;
+    guint64 accumulated = 0;
+    guint   i;
+
+    g_assert (percentile <= 100);
+
+    if (!histogram->count)
+        return 0;
+
+    /* Nearest-rank percentile, reported as the upper bound of the bucket
+     * where it falls */
+    rank = MAX ((histogram->count * percentile + 99) / 100, 1);
+    for (i = 0; i < MBIM_PROXY_LATENCY_HISTOGRAM_BUCKETS; i++) {
+        accumulated += histogram->buckets[i];
+        if (accumulated >= rank)
+            break;
+    }
+
+    if (i >= MBIM_PROXY_LATENCY_HISTOGRAM_BUCKETS - 1)
+        return G_MAXUINT32;
+    return (guint32) ((G_GUINT64_CONSTANT (1) << (i + 1)) - 1);
+}
@@ -41,6 +41,46 @@ MbimEventEntry **_mbim_proxy_helper_service_subscribe_list_dup          (MbimEve
                                                                          gsize           *out_size);
 MbimEventEntry **_mbim_proxy_helper_service_subscribe_list_new_standard (gsize           *out_size);
 
+/* Subscribe lists as strings, one per service, with the printable service
+ * UUID optionally followed by a colon and the comma-separated list of CIDs,
+ * e.g. "a289cc33-bcbb-8b4f-b6b0-133ec2aae6df:1,2" */
+gchar          **_mbim_proxy_helper_service_subscribe_list_to_strv      (const MbimEventEntry * const *list,
+                                                                         gsize                         list_size);
+MbimEventEntry **_mbim_proxy_helper_service_subscribe_list_from_strv    (const gchar * const          *strv,
+                                                                         gsize                        *out_size,
+                                                                         GError                      **error);
+
+/* Reference counted set of the services and CIDs subscribed by all the clients
+ * of a device, on top of the standard ones. Each client update only modifies
+ * the reference counts of the entries it adds or removes. */
+typedef struct _MbimProxySubscriptionSet MbimProxySubscriptionSet;
+
+MbimProxySubscriptionSet *_mbim_proxy_helper_subscription_set_new     (void);
+void                      _mbim_proxy_helper_subscription_set_free    (MbimProxySubscriptionSet      *set);
+void                      _mbim_proxy_helper_subscription_set_reset   (MbimProxySubscriptionSet      *set);
+void                      _mbim_proxy_helper_subscription_set_update  (MbimProxySubscriptionSet      *set,
+                                                                       const MbimEventEntry * const  *removed,
+                                                                       gsize                          removed_size,
+                                                                       const MbimEventEntry * const  *added,
+                                                                       gsize                          added_size);
+gboolean                  _mbim_proxy_helper_subscription_set_changed (MbimProxySubscriptionSet      *set);
+MbimEventEntry          **_mbim_proxy_helper_subscription_set_build   (MbimProxySubscriptionSet      *set,
+                                                                       gsize                         *out_size);
+
+/* Latency histogram, with power of two buckets in microseconds, so that bucket
+ * N holds the latencies in the [2^N, 2^(N+1)) range. */
+#define MBIM_PROXY_LATENCY_HISTOGRAM_BUCKETS 32
+
+typedef struct {
+    guint64 count;
+    guint64 buckets[MBIM_PROXY_LATENCY_HISTOGRAM_BUCKETS];
+} MbimProxyLatencyHistogram;
+
+void             _mbim_proxy_helper_latency_histogram_add               (MbimProxyLatencyHistogram       *histogram,
+                                                                         gint64                           latency_us);
+guint32          _mbim_proxy_helper_latency_histogram_percentile        (const MbimProxyLatencyHistogram *histogram,
+                                                                         guint                            percentile);
+
 G_END_DECLS
 
 #endif /* _LIBMBIM_GLIB_MBIM_PROXY_HELPERS_H_ */
@@ -11,11 +11,15 @@
 #include <ctype.h>
 #include <sys/file.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <gio/gunixsocketaddress.h>
+#include <gio/gunixfdmessage.h>
+#include <glib-unix.h>
 
 #include "config.h"
 #include "mbim-device.h"
@@ -28,45 +32,149 @@
 #include "mbim-error-types.h"
 #include "mbim-basic-connect.h"
 #include "mbim-ms-basic-connect-extensions.h"
+#include "mbim-proxy-control.h"
 #include "mbim-proxy-helpers.h"
+#include "mbim-shm-transport.h"
 
 /* The mbim-proxy may be used for bulk data transfer, such as modem
  * firmware upgrade, and the BUFFER_SIZE should be at least equal
  * to MAX_CONTROL_TRANSFER which defined in mbim-device.c, which
- * will bring better performance in such case.
+ * will bring better performance in such case. The per-client receive
+ * buffer is reused across reads, and it always has at least this amount
+ * of free space before reading, so that bursts of several messages can
+ * be received in a single read.
  */
-#define BUFFER_SIZE 4096
+#define BUFFER_SIZE 16384
 
 /* The proxy control "Version" indication reporting the last agreed
  * MBIMEx version, if any */
 #define MBIM_DEVICE_PROXY_CONTROL_VERSION "mbim-device-proxy-control-version"
 
+/* Default maximum number of requests a single client may have ongoing in a
+ * given device; any other request is queued in the proxy until one of the
+ * ongoing ones completes. */
+#define CLIENT_MAX_IN_FLIGHT_DEFAULT 4
+
+/* Number of requests dispatched for a client on each round-robin turn;
+ * clients may request a different one with the proxy control client
+ * settings, up to the given maximum. */
+#define CLIENT_WEIGHT_DEFAULT 1
+#define CLIENT_WEIGHT_MAX     16
+
+/* The default timeout needs to be big enough for any kind of transaction to
+ * complete, otherwise the remote clients will lose the reply if they
+ * configured a timeout bigger than this internal one. Clients may request
+ * a different one with the proxy control client settings. */
+#define CLIENT_COMMAND_TIMEOUT_DEFAULT_SECS 300
+
+/* Maximum number of descriptors a client may send before they're used */
+#define CLIENT_MAX_RECEIVED_FDS 8
+
+/* Maximum amount of bytes waiting to be written to a client socket; a client
+ * not reading its responses and indications is disconnected when reached */
+#define CLIENT_MAX_OUTGOING_BYTES (1024 * 1024)
+
 G_DEFINE_TYPE (MbimProxy, mbim_proxy, G_TYPE_OBJECT)
 
 enum {
     PROP_0,
     PROP_N_CLIENTS,
     PROP_N_DEVICES,
+    PROP_CLIENT_MAX_IN_FLIGHT,
+    PROP_N_SHARDS,
     PROP_LAST
 };
 
 static GParamSpec *properties[PROP_LAST];
 
+/* Shards: each one runs its own set of clients and devices in a given main
+ * context. The proxy always has a main shard, running in the main context,
+ * where clients are run until they're bound to a device; if shard threads
+ * are enabled, devices (and their clients) are run in them instead.
+ *
+ * The clients and devices of a shard, and all their state, are only ever
+ * modified in the shard context, with the shard lock held; other threads
+ * take the lock just to read them (e.g. statistics). The lock is never held
+ * while writing to the client sockets. */
+typedef struct {
+    guint         index;
+    guint         n_paths;
+    GMainContext *context;
+    GMainLoop    *loop;
+    GThread      *thread;
+
+    GRecMutex  lock;
+    GList     *clients;
+    GList     *devices;
+    GList     *opening_devices;
+} Shard;
+
 struct _MbimProxyPrivate {
     /* Unix socket service */
     GSocketService *socket_service;
 
-    /* Clients */
-    GList *clients;
+    /* Number of clients and devices, in all shards */
+    gint n_clients;
+    gint n_devices;
 
-    /* Devices */
-    GList *devices;
-    GList *opening_devices;
+    /* Scheduling */
+    guint client_max_in_flight;
+
+    /* Main context, where the socket service runs and where property
+     * notifications are emitted */
+    GMainContext *context;
+    Shard        *main_shard;
+
+    /* Protects the shard setup, the pending property notifications and the
+     * devices kept open; it is only held for short periods of time, and
+     * never while taking a shard lock */
+    GMutex lock;
+
+    /* Shard threads, with their own main context, and the device paths
+     * assigned to each of them */
+    guint       n_shards;
+    GPtrArray  *shards;
+    GHashTable *shard_paths;
+
+    /* Property notifications not yet emitted in the main context */
+    guint pending_notifications;
+
+    /* Paths of the devices kept open regardless of clients, each with the
+     * source scheduled to open the device again, if any */
+    GHashTable *keep_open_paths;
 };
 
-static void        track_device         (MbimProxy *self, MbimDevice *device);
-static void        untrack_device       (MbimProxy *self, MbimDevice *device);
-static MbimDevice *peek_device_for_path (MbimProxy *self, const gchar *path);
+static void        track_device             (MbimProxy *self, Shard *shard, MbimDevice *device);
+static void        untrack_device           (MbimProxy *self, MbimDevice *device);
+static MbimDevice *peek_device_for_path     (Shard *shard, const gchar *path);
+static Shard      *device_peek_shard        (MbimDevice *device);
+static void        keep_open_schedule_retry (MbimProxy *self, const gchar *path);
+
+/*****************************************************************************/
+
+static inline void
+proxy_lock (MbimProxy *self)
+{
+    g_mutex_lock (&self->priv->lock);
+}
+
+static inline void
+proxy_unlock (MbimProxy *self)
+{
+    g_mutex_unlock (&self->priv->lock);
+}
+
+static inline void
+shard_lock (Shard *shard)
+{
+    g_rec_mutex_lock (&shard->lock);
+}
+
+static inline void
+shard_unlock (Shard *shard)
+{
+    g_rec_mutex_unlock (&shard->lock);
+}
 
 /*****************************************************************************/
 
@@ -75,7 +183,7 @@ mbim_proxy_get_n_clients (MbimProxy *self)
 {
     g_return_val_if_fail (MBIM_IS_PROXY (self), 0);
 
-    return g_list_length (self->priv->clients);
+    return (guint) g_atomic_int_get (&self->priv->n_clients);
 }
 
 guint
@@ -83,7 +191,224 @@ mbim_proxy_get_n_devices (MbimProxy *self)
 {
     g_return_val_if_fail (MBIM_IS_PROXY (self), 0);
 
-    return g_list_length (self->priv->devices);
+    return (guint) g_atomic_int_get (&self->priv->n_devices);
+}
+
+/*****************************************************************************/
+/* Property notifications */
+
+static gboolean
+notify_idle (MbimProxy *self)
+{
+    guint pending;
+    guint i;
+
+    proxy_lock (self);
+    pending = self->priv->pending_notifications;
+    self->priv->pending_notifications = 0;
+    proxy_unlock (self);
+
+    for (i = PROP_0 + 1; i < PROP_LAST; i++) {
+        if (pending & (1 << i))
+            g_object_notify_by_pspec (G_OBJECT (self), properties[i]);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+proxy_notify (MbimProxy *self,
+              guint      prop_id)
+{
+    GSource *source;
+
+    /* Without shards everything runs in the main context */
+    if (!self->priv->shards) {
+        g_object_notify_by_pspec (G_OBJECT (self), properties[prop_id]);
+        return;
+    }
+
+    /* Notifications from the shard threads are emitted in the main context,
+     * so that users of the proxy don't need to care about threads; several
+     * changes of the same property are coalesced into a single one. */
+    proxy_lock (self);
+    if (!self->priv->pending_notifications) {
+        source = g_idle_source_new ();
+        g_source_set_callback (source, (GSourceFunc) notify_idle, g_object_ref (self), g_object_unref);
+        g_source_attach (source, self->priv->context);
+        g_source_unref (source);
+    }
+    self->priv->pending_notifications |= (1 << prop_id);
+    proxy_unlock (self);
+}
+
+/*****************************************************************************/
+/* Shards */
+
+static gpointer
+shard_thread_func (Shard *shard)
+{
+    g_main_context_push_thread_default (shard->context);
+    g_main_loop_run (shard->loop);
+    g_main_context_pop_thread_default (shard->context);
+    return NULL;
+}
+
+static gboolean
+shard_quit_cb (Shard *shard)
+{
+    g_main_loop_quit (shard->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+shard_attach_idle (Shard       *shard,
+                   GSourceFunc  func,
+                   gpointer     user_data)
+{
+    GSource *source;
+
+    /* Always go through a source, so that the function runs in the shard
+     * thread even if its loop isn't running yet */
+    source = g_idle_source_new ();
+    g_source_set_callback (source, func, user_data, NULL);
+    g_source_attach (source, shard->context);
+    g_source_unref (source);
+}
+
+static void
+shard_stop (Shard *shard)
+{
+    g_debug ("stopping shard %u...", shard->index);
+
+    shard_attach_idle (shard, (GSourceFunc) shard_quit_cb, shard);
+    g_thread_join (shard->thread);
+    shard->thread = NULL;
+}
+
+static void
+shard_free (Shard *shard)
+{
+    g_assert (!shard->thread);
+    g_assert (!shard->clients);
+    g_assert (!shard->devices);
+    g_assert (!shard->opening_devices);
+    if (shard->loop)
+        g_main_loop_unref (shard->loop);
+    g_main_context_unref (shard->context);
+    g_rec_mutex_clear (&shard->lock);
+    g_slice_free (Shard, shard);
+}
+
+static Shard *
+shard_new_main (GMainContext *context)
+{
+    Shard *shard;
+
+    shard = g_slice_new0 (Shard);
+    shard->context = g_main_context_ref (context);
+    g_rec_mutex_init (&shard->lock);
+    return shard;
+}
+
+static Shard *
+shard_new (guint index)
+{
+    Shard            *shard;
+    g_autofree gchar *name = NULL;
+
+    shard = g_slice_new0 (Shard);
+    shard->index = index;
+    shard->context = g_main_context_new ();
+    shard->loop = g_main_loop_new (shard->context, FALSE);
+    g_rec_mutex_init (&shard->lock);
+
+    name = g_strdup_printf ("mbim-proxy-shard-%u", index);
+    shard->thread = g_thread_new (name, (GThreadFunc) shard_thread_func, shard);
+
+    g_debug ("shard %u started", index);
+    return shard;
+}
+
+static GPtrArray *
+peek_all_shards (MbimProxy *self)
+{
+    GPtrArray *all;
+    guint      i;
+
+    all = g_ptr_array_new ();
+    g_ptr_array_add (all, self->priv->main_shard);
+
+    proxy_lock (self);
+    for (i = 0; self->priv->shards && i < self->priv->shards->len; i++)
+        g_ptr_array_add (all, g_ptr_array_index (self->priv->shards, i));
+    proxy_unlock (self);
+
+    return all;
+}
+
+static Shard *
+lookup_shard_for_path (MbimProxy   *self,
+                       const gchar *path)
+{
+    Shard *shard = NULL;
+
+    if (!self->priv->n_shards)
+        return self->priv->main_shard;
+
+    proxy_lock (self);
+    if (self->priv->shard_paths)
+        shard = g_hash_table_lookup (self->priv->shard_paths, path);
+    proxy_unlock (self);
+
+    return shard;
+}
+
+static Shard *
+peek_shard_for_path (MbimProxy   *self,
+                     const gchar *path)
+{
+    Shard *shard;
+    guint  i;
+
+    /* Without shard threads, everything is run in the main shard */
+    if (!self->priv->n_shards)
+        return self->priv->main_shard;
+
+    proxy_lock (self);
+
+    /* Shard threads are started only once they're really needed */
+    if (!self->priv->shards) {
+        self->priv->shards = g_ptr_array_new_with_free_func ((GDestroyNotify) shard_free);
+        self->priv->shard_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        for (i = 0; i < self->priv->n_shards; i++)
+            g_ptr_array_add (self->priv->shards, shard_new (i));
+    }
+
+    /* A given device path is always run in the same shard, even after
+     * the device has been removed and added again */
+    shard = g_hash_table_lookup (self->priv->shard_paths, path);
+    if (shard) {
+        proxy_unlock (self);
+        return shard;
+    }
+
+    /* Assign new paths to the shard with the least paths */
+    shard = g_ptr_array_index (self->priv->shards, 0);
+    for (i = 1; i < self->priv->shards->len; i++) {
+        Shard *other;
+
+        other = g_ptr_array_index (self->priv->shards, i);
+        if (other->n_paths < shard->n_paths)
+            shard = other;
+    }
+
+    shard->n_paths++;
+    g_hash_table_insert (self->priv->shard_paths, g_strdup (path), shard);
+    g_debug ("[%s] assigned to shard %u", path, shard->index);
+
+    proxy_unlock (self);
+    return shard;
 }
 
 /*****************************************************************************/
@@ -96,7 +421,33 @@ typedef struct {
     MbimProxy *self; /* not full ref */
     GSocketConnection *connection;
     GSource *connection_readable_source;
+
+    /* Messages waiting to be written to the socket, with the amount of bytes
+     * of the first one already written; only accessed in the client shard.
+     * The total amount of bytes queued is also read in statistics. */
+    GQueue        *outgoing;
+    gsize          outgoing_offset;
+    volatile gint  outgoing_bytes;
+    gboolean       outgoing_overflow;
+    GSource       *connection_writable_source;
+
+    /* Whether each message or fragment is received as a single datagram */
+    gboolean seqpacket;
+
+    /* Receive buffer, with the amount of bytes already consumed at the
+     * beginning */
     GByteArray *buffer;
+    guint       buffer_offset;
+
+    /* Descriptors received along with the client messages, not yet used
+     * by the request they were sent with */
+    GArray *received_fds;
+
+    /* Shared memory transport, if negotiated, with its own receive buffer */
+    MbimShmTransport *shm;
+    GSource          *shm_source;
+    GByteArray       *shm_buffer;
+    guint             shm_buffer_offset;
 
     /* Only one proxy config allowed at a time */
     gboolean config_ongoing;
@@ -105,15 +456,69 @@ typedef struct {
     guint indication_id;
     MbimEventEntry **mbim_event_entry_array;
     gsize mbim_event_entry_array_size;
+
+    /* Scheduling: requests waiting to be sent to the device, non-last
+     * fragments of a multi-fragment command not yet fully received, and
+     * requests currently sent to the device */
+    GQueue *pending;
+    GList  *pending_fragments;
+    GList  *in_flight;
+    guint   n_in_flight;
+    guint   weight;
+
+    /* Timeout of the commands sent to the device on behalf of this client */
+    guint32 timeout_secs;
+
+    /* Shard where the client is run: the main one until it's bound to a
+     * device, and then the one running the device */
+    Shard *shard;
+
+    /* Statistics */
+    guint64                   requests_forwarded;
+    guint64                   requests_timed_out;
+    guint64                   indications_forwarded;
+    guint64                   cache_hits;
+    guint                     queued_bytes;
+    MbimProxyLatencyHistogram device_latency;
+    MbimProxyLatencyHistogram queue_latency;
 } Client;
 
-static gboolean connection_readable_cb (GSocket *socket, GIOCondition condition, Client *client);
-static void     track_client           (MbimProxy *self, Client *client);
-static void     untrack_client         (MbimProxy *self, Client *client);
+static gboolean connection_readable_cb     (GSocket *socket, GIOCondition condition, Client *client);
+static gboolean connection_writable_cb     (GSocket *socket, GIOCondition condition, Client *client);
+static void     track_client               (MbimProxy *self, Client *client);
+static void     untrack_client             (MbimProxy *self, Client *client);
+static void     client_flush_pending       (Client *client);
+static void     stats_indication_forwarded (Client *client);
+static void     stats_cache_hit            (Client *client);
+
+static void device_update_subscriptions (MbimDevice                   *device,
+                                         const MbimEventEntry * const *removed,
+                                         gsize                         removed_size,
+                                         const MbimEventEntry * const *added,
+                                         gsize                         added_size);
+
+static void
+client_clear_received_fds (Client *client)
+{
+    guint i;
+
+    if (!client->received_fds)
+        return;
+
+    for (i = 0; i < client->received_fds->len; i++)
+        close (g_array_index (client->received_fds, gint, i));
+    g_array_set_size (client->received_fds, 0);
+}
 
 static void
 client_disconnect (Client *client)
 {
+    /* The subscriptions of the client no longer apply to the device */
+    if (client->device && client->mbim_event_entry_array)
+        device_update_subscriptions (client->device,
+                                     (const MbimEventEntry * const *)client->mbim_event_entry_array,
+                                     client->mbim_event_entry_array_size,
+                                     NULL, 0);
     g_clear_pointer (&client->mbim_event_entry_array, mbim_event_entry_array_free);
     client->mbim_event_entry_array_size = 0;
 
@@ -123,6 +528,24 @@ client_disconnect (Client *client)
         client->connection_readable_source = 0;
     }
 
+    if (client->connection_writable_source) {
+        g_source_destroy (client->connection_writable_source);
+        g_source_unref (client->connection_writable_source);
+        client->connection_writable_source = NULL;
+    }
+    while (!g_queue_is_empty (client->outgoing))
+        mbim_message_unref ((MbimMessage *) g_queue_pop_head (client->outgoing));
+    client->outgoing_offset = 0;
+    g_atomic_int_set (&client->outgoing_bytes, 0);
+
+    if (client->shm_source) {
+        g_source_destroy (client->shm_source);
+        g_source_unref (client->shm_source);
+        client->shm_source = NULL;
+    }
+    g_clear_pointer (&client->shm, _mbim_shm_transport_free);
+    client_clear_received_fds (client);
+
     if (client->connection) {
         g_debug ("[client %lu] connection closed", client->id);
         g_output_stream_close (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)), NULL, NULL);
@@ -142,6 +565,11 @@ client_set_device (Client *client,
     if (client->device) {
         if (g_signal_handler_is_connected (client->device, client->indication_id))
             g_signal_handler_disconnect (client->device, client->indication_id);
+        if (client->mbim_event_entry_array)
+            device_update_subscriptions (client->device,
+                                         (const MbimEventEntry * const *)client->mbim_event_entry_array,
+                                         client->mbim_event_entry_array_size,
+                                         NULL, 0);
         g_object_unref (client->device);
     }
 
@@ -151,6 +579,11 @@ client_set_device (Client *client,
                                                   MBIM_DEVICE_SIGNAL_INDICATE_STATUS,
                                                   G_CALLBACK (client_indication_cb),
                                                   client);
+        if (client->mbim_event_entry_array)
+            device_update_subscriptions (client->device,
+                                         NULL, 0,
+                                         (const MbimEventEntry * const *)client->mbim_event_entry_array,
+                                         client->mbim_event_entry_array_size);
     } else {
         client->device = NULL;
         client->indication_id = 0;
@@ -168,10 +601,20 @@ client_unref (Client *client)
 
         if (client->buffer)
             g_byte_array_unref (client->buffer);
+        if (client->shm_buffer)
+            g_byte_array_unref (client->shm_buffer);
+        if (client->received_fds)
+            g_array_unref (client->received_fds);
 
         if (client->mbim_event_entry_array)
             mbim_event_entry_array_free (client->mbim_event_entry_array);
 
+        g_assert (g_queue_is_empty (client->pending));
+        g_assert (client->in_flight == NULL);
+        g_queue_free (client->pending);
+        g_queue_free (client->outgoing);
+        g_list_free_full (client->pending_fragments, (GDestroyNotify)mbim_message_unref);
+
         g_slice_free (Client, client);
     }
 }
@@ -185,6 +628,44 @@ client_ref (Client *client)
     return client;
 }
 
+static void
+client_attach_writable_source (Client *client)
+{
+    if (client->connection_writable_source || g_queue_is_empty (client->outgoing))
+        return;
+
+    client->connection_writable_source = g_socket_create_source (g_socket_connection_get_socket (client->connection),
+                                                                 G_IO_OUT | G_IO_ERR | G_IO_HUP,
+                                                                 NULL);
+    g_source_set_callback (client->connection_writable_source,
+                           (GSourceFunc)connection_writable_cb,
+                           client,
+                           NULL);
+    g_source_attach (client->connection_writable_source, client->shard->context);
+}
+
+static gboolean
+client_outgoing_overflow_cb (Client *client)
+{
+    Shard *shard;
+
+    shard = client->shard;
+    shard_lock (shard);
+    untrack_client (client->self, client);
+    shard_unlock (shard);
+    client_unref (client);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+client_schedule_untrack (Client *client)
+{
+    if (client->outgoing_overflow)
+        return;
+    client->outgoing_overflow = TRUE;
+    shard_attach_idle (client->shard, (GSourceFunc) client_outgoing_overflow_cb, client_ref (client));
+}
+
 static gboolean
 client_send_message (Client       *client,
                      MbimMessage  *message,
@@ -198,16 +679,35 @@ client_send_message (Client       *client,
         return FALSE;
     }
 
-    if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)),
-                                    message->data,
-                                    message->len,
-                                    NULL, /* bytes_written */
-                                    NULL, /* cancellable */
-                                    error)) {
-        g_prefix_error (error, "Cannot send message to client: ");
+    /* A client not reading would make the proxy buffer without bound; it is
+     * untracked once the caller is done, as callers may be iterating over
+     * the clients. The shared memory transport has its own limit. */
+    if (client->shm) {
+        if (!_mbim_shm_transport_write (client->shm, message->data, message->len, error)) {
+            g_prefix_error (error, "Cannot send message to client through shared memory: ");
+            client_schedule_untrack (client);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    if (client->outgoing_overflow ||
+        (gsize) g_atomic_int_get (&client->outgoing_bytes) + message->len > CLIENT_MAX_OUTGOING_BYTES) {
+        client_schedule_untrack (client);
+        g_set_error (error,
+                     MBIM_CORE_ERROR,
+                     MBIM_CORE_ERROR_FAILED,
+                     "Cannot send message: client not reading, %d bytes already queued",
+                     g_atomic_int_get (&client->outgoing_bytes));
         return FALSE;
     }
 
+    /* Messages are never written to the socket right away, as the shard lock
+     * is held while processing; they're written without blocking once the
+     * socket is writable, so a slow client never stalls the shard */
+    g_queue_push_tail (client->outgoing, mbim_message_ref (message));
+    g_atomic_int_add (&client->outgoing_bytes, message->len);
+    client_attach_writable_source (client);
     return TRUE;
 }
 
@@ -218,8 +718,9 @@ static void
 track_client (MbimProxy *self,
               Client *client)
 {
-    self->priv->clients = g_list_append (self->priv->clients, client_ref (client));
-    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_CLIENTS]);
+    client->shard->clients = g_list_append (client->shard->clients, client_ref (client));
+    g_atomic_int_inc (&self->priv->n_clients);
+    proxy_notify (self, PROP_N_CLIENTS);
 }
 
 static void
@@ -229,11 +730,69 @@ untrack_client (MbimProxy *self,
     /* Disconnect the client explicitly when untracking */
     client_disconnect (client);
 
-    if (g_list_find (self->priv->clients, client)) {
-        self->priv->clients = g_list_remove (self->priv->clients, client);
+    /* Requests not yet sent to the device are discarded right away, and
+     * the ones already sent are cancelled */
+    client_flush_pending (client);
+
+    if (g_list_find (client->shard->clients, client)) {
+        client->shard->clients = g_list_remove (client->shard->clients, client);
+        g_atomic_int_add (&self->priv->n_clients, -1);
         client_unref (client);
-        g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_CLIENTS]);
+        proxy_notify (self, PROP_N_CLIENTS);
+    }
+}
+
+static gboolean
+connection_writable_cb (GSocket      *socket,
+                        GIOCondition  condition,
+                        Client       *client)
+{
+    g_autoptr(GError)  error = NULL;
+    MbimMessage       *message;
+    Shard             *shard;
+    gssize             r;
+
+    /* The outgoing messages are only accessed in the client shard context,
+     * so they're written without holding the shard lock */
+    while ((message = (MbimMessage *) g_queue_peek_head (client->outgoing)) != NULL) {
+        r = g_socket_send_with_blocking (socket,
+                                         (const gchar *) message->data + client->outgoing_offset,
+                                         message->len - client->outgoing_offset,
+                                         FALSE,
+                                         NULL,
+                                         &error);
+        if (r < 0) {
+            if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+                return G_SOURCE_CONTINUE;
+            break;
+        }
+
+        /* Stream sockets may write just part of the message */
+        client->outgoing_offset += r;
+        if (client->outgoing_offset < message->len)
+            continue;
+
+        g_queue_pop_head (client->outgoing);
+        g_atomic_int_add (&client->outgoing_bytes, - (gint) message->len);
+        mbim_message_unref (message);
+        client->outgoing_offset = 0;
+    }
+
+    if (!error) {
+        g_source_unref (client->connection_writable_source);
+        client->connection_writable_source = NULL;
+        return G_SOURCE_REMOVE;
     }
+
+    /* If writing fails, always assume we have to close the connection */
+    g_warning ("[client %lu] couldn't write to client: %s", client->id, error->message);
+    shard = client->shard;
+    shard_lock (shard);
+    client_ref (client);
+    untrack_client (client->self, client);
+    client_unref (client);
+    shard_unlock (shard);
+    return G_SOURCE_REMOVE;
 }
 
 /*****************************************************************************/
@@ -245,14 +804,17 @@ forward_indication (Client      *client,
 {
     g_autoptr(GError) error = NULL;
 
-    if (!client_send_message (client, message, &error))
+    if (!client_send_message (client, message, &error)) {
         g_warning ("[client %lu] couldn't forward indication: %s", client->id, error->message);
+        return;
+    }
+
+    stats_indication_forwarded (client);
 }
 
 static void
-client_indication_cb (MbimDevice *device,
-                      MbimMessage *message,
-                      Client *client)
+client_indication (Client      *client,
+                   MbimMessage *message)
 {
     MbimEventEntry *entry;
     guint           i;
@@ -291,6 +853,18 @@ client_indication_cb (MbimDevice *device,
     }
 }
 
+static void
+client_indication_cb (MbimDevice *device,
+                      MbimMessage *message,
+                      Client *client)
+{
+    Shard *shard = client->shard;
+
+    shard_lock (shard);
+    client_indication (client, message);
+    shard_unlock (shard);
+}
+
 /*****************************************************************************/
 /* Request info */
 
@@ -302,11 +876,30 @@ typedef struct {
     guint32 original_transaction_id;
     /* Only used in proxy config */
     guint32 timeout_secs;
+    /* Only used in scheduled commands */
+    GList        *fragments;
+    gboolean      in_flight;
+    GCancellable *cancellable;
+    guint32       size;
+    gint64        received_time;
+    gint64        dispatch_time;
 } Request;
 
+static void device_schedule          (MbimProxy    *self,
+                                      MbimDevice   *device);
+static void stats_request_dispatched (Request      *request);
+static void stats_request_completed  (Request      *request,
+                                      const GError *error);
+
 static void
 request_complete_and_free (Request *request)
 {
+    if (request->in_flight) {
+        g_assert (request->client->n_in_flight > 0);
+        request->client->n_in_flight--;
+        request->client->in_flight = g_list_remove (request->client->in_flight, request);
+    }
+
     if (request->response) {
         g_autoptr(GError) error = NULL;
 
@@ -322,8 +915,14 @@ request_complete_and_free (Request *request)
         mbim_message_unref (request->response);
     }
 
+    /* A slot in the device was released, schedule the next pending request */
+    if (request->in_flight && request->client->device)
+        device_schedule (request->self, request->client->device);
+
     if (request->message)
         mbim_message_unref (request->message);
+    g_list_free_full (request->fragments, (GDestroyNotify)mbim_message_unref);
+    g_clear_object (&request->cancellable);
     client_unref (request->client);
     g_object_unref (request->self);
     g_slice_free (Request, request);
@@ -341,6 +940,7 @@ request_new (MbimProxy   *self,
     request->client = client_ref (client);
     request->message = mbim_message_ref (message);
     request->original_transaction_id = mbim_message_get_transaction_id (message);
+    request->received_time = g_get_monotonic_time ();
 
     return request;
 }
@@ -408,7 +1008,7 @@ peek_opening_device_info (MbimProxy  *self,
     GList *l;
 
     /* If already being opened, queue it up */
-    for (l = self->priv->opening_devices; l; l = g_list_next (l)) {
+    for (l = device_peek_shard (device)->opening_devices; l; l = g_list_next (l)) {
         OpeningDevice *info;
 
         info = (OpeningDevice *)(l->data);
@@ -425,12 +1025,14 @@ complete_opening_device (MbimProxy    *self,
                          const GError *error)
 {
     OpeningDevice *info;
+    Shard         *shard;
 
     info = peek_opening_device_info (self, device);
     if (!info)
         return;
 
-    self->priv->opening_devices = g_list_remove (self->priv->opening_devices, info);
+    shard = device_peek_shard (device);
+    shard->opening_devices = g_list_remove (shard->opening_devices, info);
     opening_device_complete_and_free (info, error);
 }
 
@@ -456,9 +1058,13 @@ device_open_ready (MbimDevice   *device,
                    MbimProxy    *self)
 {
     GError *error = NULL;
+    Shard  *shard;
 
     mbim_device_open_finish (device, res, &error);
 
+    shard = device_peek_shard (device);
+    shard_lock (shard);
+
     /* Complete all pending open actions */
     complete_opening_device (self, device, error);
 
@@ -467,6 +1073,8 @@ device_open_ready (MbimDevice   *device,
         untrack_device (self, device);
         g_error_free (error);
     }
+
+    shard_unlock (shard);
 }
 
 static void
@@ -475,6 +1083,7 @@ internal_open (GTask *task)
     MbimProxy                 *self;
     InternalDeviceOpenContext *ctx;
     OpeningDevice             *info;
+    Shard                     *shard;
 
     self = g_task_get_source_object (task);
     ctx  = g_task_get_task_data (task);
@@ -490,7 +1099,8 @@ internal_open (GTask *task)
     info = g_slice_new0 (OpeningDevice);
     info->device = g_object_ref (ctx->device);
     info->pending = g_list_append (info->pending, task);
-    self->priv->opening_devices = g_list_prepend (self->priv->opening_devices, info);
+    shard = device_peek_shard (ctx->device);
+    shard->opening_devices = g_list_prepend (shard->opening_devices, info);
 
     /* Note: for now, only the first timeout request is taken into account */
 
@@ -511,6 +1121,7 @@ internal_device_open_caps_query_ready (MbimDevice   *device,
     MbimProxy              *self;
     g_autoptr(MbimMessage)  response = NULL;
     g_autoptr(GError)       error = NULL;
+    Shard                  *shard;
 
     self = g_task_get_source_object (task);
 
@@ -519,9 +1130,12 @@ internal_device_open_caps_query_ready (MbimDevice   *device,
         /* If we get a not-opened error, well, force closing right away and reopen */
         if (g_error_matches (error, MBIM_PROTOCOL_ERROR, MBIM_PROTOCOL_ERROR_NOT_OPENED)) {
             g_debug ("[%s] device not-opened error reported, reopening", mbim_device_get_path (device));
+            shard = device_peek_shard (device);
+            shard_lock (shard);
             reset_client_service_subscribe_lists (self, device);
             mbim_device_close_force (device, NULL);
             internal_open (task);
+            shard_unlock (shard);
             return;
         }
 
@@ -629,26 +1243,37 @@ process_internal_proxy_close (MbimProxy   *self,
 /* Proxy config */
 
 static MbimMessage *
-build_proxy_control_command_done (MbimMessage     *message,
-                                  MbimStatusError  status)
+build_proxy_control_command_done_full (MbimMessage     *message,
+                                       MbimStatusError  status,
+                                       const guint8    *buffer,
+                                       guint32          buffer_length)
 {
     MbimMessage *response;
     struct command_done_message *command_done;
 
     response = (MbimMessage *) _mbim_message_allocate (MBIM_MESSAGE_TYPE_COMMAND_DONE,
                                                        mbim_message_get_transaction_id (message),
-                                                       sizeof (struct command_done_message));
+                                                       sizeof (struct command_done_message) + buffer_length);
     command_done = &(((struct full_message *)(response->data))->message.command_done);
     command_done->fragment_header.total   = GUINT32_TO_LE (1);
     command_done->fragment_header.current = 0;
     memcpy (command_done->service_id, MBIM_UUID_PROXY_CONTROL, sizeof (MbimUuid));
     command_done->command_id  = GUINT32_TO_LE (mbim_message_command_get_cid (message));
     command_done->status_code = GUINT32_TO_LE (status);
-    command_done->buffer_length = 0;
+    command_done->buffer_length = GUINT32_TO_LE (buffer_length);
+    if (buffer_length)
+        memcpy (&command_done->buffer[0], buffer, buffer_length);
 
     return response;
 }
 
+static MbimMessage *
+build_proxy_control_command_done (MbimMessage     *message,
+                                  MbimStatusError  status)
+{
+    return build_proxy_control_command_done_full (message, status, NULL, 0);
+}
+
 static void
 proxy_config_internal_device_open_ready (MbimProxy    *self,
                                          GAsyncResult *res,
@@ -656,6 +1281,9 @@ proxy_config_internal_device_open_ready (MbimProxy    *self,
 {
     g_autoptr(GError)  error = NULL;
     MbimMessage       *indication;
+    Shard             *shard = request->client->shard;
+
+    shard_lock (shard);
 
     if (!internal_device_open_finish (self, res, &error)) {
         g_warning ("[client %lu,0x%08x] cannot configure proxy: couldn't open MBIM device: %s",
@@ -663,6 +1291,7 @@ proxy_config_internal_device_open_ready (MbimProxy    *self,
         /* Untrack client and complete without response */
         untrack_client (request->self, request->client);
         request_complete_and_free (request);
+        shard_unlock (shard);
         return;
     }
 
@@ -674,14 +1303,18 @@ proxy_config_internal_device_open_ready (MbimProxy    *self,
     if (indication) {
         if (!client_send_message (request->client, indication, &error))
             g_warning ("[client %lu] couldn't report MBIMEx version update: %s", request->client->id, error->message);
-        else
+        else {
             g_debug ("[client %lu] reported MBIMEx version update", request->client->id);
+            stats_cache_hit (request->client);
+        }
     }
 
     if (request->client->config_ongoing == TRUE)
         request->client->config_ongoing = FALSE;
     request->response = build_proxy_control_command_done (request->message, MBIM_STATUS_ERROR_NONE);
     request_complete_and_free (request);
+
+    shard_unlock (shard);
 }
 
 static void
@@ -692,6 +1325,9 @@ device_new_ready (GObject      *source,
     g_autoptr(GError)  error = NULL;
     MbimDevice        *existing;
     MbimDevice        *device;
+    Shard             *shard = request->client->shard;
+
+    shard_lock (shard);
 
     device = mbim_device_new_finish (res, &error);
     if (!device) {
@@ -700,17 +1336,18 @@ device_new_ready (GObject      *source,
         /* Untrack client and complete without response */
         untrack_client (request->self, request->client);
         request_complete_and_free (request);
+        shard_unlock (shard);
         return;
     }
 
     /* Store device in the proxy independently */
-    existing = peek_device_for_path (request->self, mbim_device_get_path (device));
+    existing = peek_device_for_path (shard, mbim_device_get_path (device));
     if (existing) {
         /* Race condition, we created two MbimDevices for the same port, just skip ours, no big deal */
         client_set_device (request->client, existing);
     } else {
         /* Keep the newly added device in the proxy */
-        track_device (request->self, device);
+        track_device (request->self, shard, device);
         /* Also keep track of the device in the client */
         client_set_device (request->client, device);
     }
@@ -721,6 +1358,8 @@ device_new_ready (GObject      *source,
                           request->timeout_secs,
                           (GAsyncReadyCallback)proxy_config_internal_device_open_ready,
                           request);
+
+    shard_unlock (shard);
 }
 
 static gboolean
@@ -795,6 +1434,17 @@ process_internal_proxy_config (MbimProxy   *self,
         return TRUE;
     }
 
+    /* Devices are only created and run in the shard they're assigned to; a
+     * client is moved to that shard with its first configuration, and it
+     * cannot be moved again afterwards */
+    if (peek_shard_for_path (self, path) != client->shard) {
+        g_warning ("[client %lu,0x%08x] cannot configure proxy: device run in a different shard",
+                   request->client->id, request->original_transaction_id);
+        request->response = build_proxy_control_command_done (message, MBIM_STATUS_ERROR_FAILURE);
+        request_complete_and_free (request);
+        return TRUE;
+    }
+
     /* Read requested timeout value */
     if (!_mbim_message_read_guint32 (message, 8, &request->timeout_secs, &error)) {
         g_warning ("[client %lu,0x%08x] cannot configure proxy: couldn't read timeout from request: %s",
@@ -805,7 +1455,7 @@ process_internal_proxy_config (MbimProxy   *self,
     }
 
     /* Check if some other client already handled the same device */
-    device = peek_device_for_path (self, path);
+    device = peek_device_for_path (client->shard, path);
     if (device) {
         /* Keep reference and continue */
         client_set_device (client, device);
@@ -830,45 +1480,178 @@ process_internal_proxy_config (MbimProxy   *self,
 }
 
 /*****************************************************************************/
-/* Subscriber list */
+/* Proxy client settings */
 
-static void
-track_service_subscribe_list (Client      *client,
-                              MbimMessage *message)
+static gboolean
+process_internal_proxy_client_settings (MbimProxy   *self,
+                                        Client      *client,
+                                        MbimMessage *message)
 {
-    g_autoptr(GError)              error = NULL;
-    g_autoptr(MbimEventEntryArray) mbim_event_entry_array = NULL;
-    gsize                          mbim_event_entry_array_size;
+    Request           *request;
+    guint32            timeout_secs;
+    guint32            weight = 0;
+    guint32            buffer_len = 0;
+    g_autoptr(GError)  error = NULL;
 
-    mbim_event_entry_array = _mbim_proxy_helper_service_subscribe_request_parse (message, &mbim_event_entry_array_size, &error);
-    if (error) {
-        g_warning ("[client %lu] invalid subscribe request message: %s", client->id, error->message);
-        return;
-    }
+    /* create request holder */
+    request = request_new (self, client, message);
 
-    /* On each new request from the client, it should provide the FULL list of
-     * events it's subscribed to, so we can safely recreate the whole array each
-     * time. */
-    g_clear_pointer (&client->mbim_event_entry_array, mbim_event_entry_array_free);
-    client->mbim_event_entry_array = g_steal_pointer (&mbim_event_entry_array);
-    client->mbim_event_entry_array_size = mbim_event_entry_array_size;
+    g_debug ("[client %lu,0x%08x] request to update client settings",
+             request->client->id, request->original_transaction_id);
 
-    if (mbim_utils_get_traces_enabled ()) {
-        g_debug ("[client %lu] service subscribe list built", client->id);
-        _mbim_proxy_helper_service_subscribe_list_debug ((const MbimEventEntry * const *)client->mbim_event_entry_array,
-                                                         client->mbim_event_entry_array_size);
+    /* Only allow SET command */
+    if (mbim_message_command_get_command_type (message) != MBIM_MESSAGE_COMMAND_TYPE_SET) {
+        g_warning ("[client %lu,0x%08x] cannot update client settings: invalid request type",
+                   request->client->id, request->original_transaction_id);
+        request->response = build_proxy_control_command_done (message, MBIM_STATUS_ERROR_INVALID_PARAMETERS);
+        request_complete_and_free (request);
+        return TRUE;
     }
-}
-
-static void
-device_service_subscribe_list_set_complete (Request         *request,
-                                            MbimStatusError  status)
-{
-    struct command_done_message *command_done;
-    guint32                      raw_len;
-    const guint8                *raw_data;
 
-    /* The raw message data to send back as response to client */
+    /* Read requested timeout value */
+    if (!_mbim_message_read_guint32 (message, 0, &timeout_secs, &error)) {
+        g_warning ("[client %lu,0x%08x] cannot update client settings: couldn't read timeout from request: %s",
+                   request->client->id, request->original_transaction_id, error->message);
+        request->response = build_proxy_control_command_done (message, MBIM_STATUS_ERROR_INVALID_PARAMETERS);
+        request_complete_and_free (request);
+        return TRUE;
+    }
+
+    /* Read requested weight value, if any; requests with just the timeout
+     * are also accepted */
+    mbim_message_command_get_raw_information_buffer (message, &buffer_len);
+    if (buffer_len >= 8 && !_mbim_message_read_guint32 (message, 4, &weight, &error)) {
+        g_warning ("[client %lu,0x%08x] cannot update client settings: couldn't read weight from request: %s",
+                   request->client->id, request->original_transaction_id, error->message);
+        request->response = build_proxy_control_command_done (message, MBIM_STATUS_ERROR_INVALID_PARAMETERS);
+        request_complete_and_free (request);
+        return TRUE;
+    }
+
+    /* A zero timeout resets the default one */
+    client->timeout_secs = (timeout_secs ? timeout_secs : CLIENT_COMMAND_TIMEOUT_DEFAULT_SECS);
+    g_debug ("[client %lu,0x%08x] client command timeout set to %u seconds",
+             request->client->id, request->original_transaction_id, client->timeout_secs);
+
+    /* A zero weight resets the default one */
+    if (buffer_len >= 8) {
+        client->weight = (weight ? MIN (weight, CLIENT_WEIGHT_MAX) : CLIENT_WEIGHT_DEFAULT);
+        g_debug ("[client %lu,0x%08x] client weight set to %u",
+                 request->client->id, request->original_transaction_id, client->weight);
+    }
+
+    request->response = build_proxy_control_command_done (message, MBIM_STATUS_ERROR_NONE);
+    request_complete_and_free (request);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Shared memory transport */
+
+static void client_attach_shm_source (Client *client, GMainContext *context);
+
+static gboolean
+process_internal_proxy_shared_memory (MbimProxy   *self,
+                                      Client      *client,
+                                      MbimMessage *message)
+{
+    Request                     *request;
+    guint32                      ring_size;
+    g_autoptr(MbimShmTransport)  shm = NULL;
+    g_autoptr(GError)            error = NULL;
+
+    /* create request holder */
+    request = request_new (self, client, message);
+
+    g_debug ("[client %lu,0x%08x] request to setup shared memory transport",
+             request->client->id, request->original_transaction_id);
+
+    if (mbim_message_command_get_command_type (message) != MBIM_MESSAGE_COMMAND_TYPE_SET)
+        g_set_error (&error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS, "invalid request type");
+    else if (client->shm)
+        g_set_error (&error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_WRONG_STATE, "already setup");
+    else if (!_mbim_message_read_guint32 (message, 0, &ring_size, &error))
+        g_prefix_error (&error, "couldn't read ring size from request: ");
+    else if (!client->received_fds || client->received_fds->len != MBIM_SHM_TRANSPORT_N_FDS)
+        g_set_error (&error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                     "expected %u descriptors, got %u",
+                     MBIM_SHM_TRANSPORT_N_FDS, client->received_fds ? client->received_fds->len : 0);
+    else {
+        /* The transport owns the descriptors even on error */
+        shm = _mbim_shm_transport_new_from_fds ((const gint *)client->received_fds->data, ring_size, &error);
+        g_array_set_size (client->received_fds, 0);
+    }
+
+    /* Descriptors are only valid for the request they were sent with */
+    client_clear_received_fds (client);
+
+    if (!shm) {
+        g_warning ("[client %lu,0x%08x] cannot setup shared memory transport: %s",
+                   request->client->id, request->original_transaction_id, error->message);
+        request->response = build_proxy_control_command_done (message, MBIM_STATUS_ERROR_INVALID_PARAMETERS);
+        request_complete_and_free (request);
+        return TRUE;
+    }
+
+    /* Everything is sent to the client through the shared memory from now
+     * on, including the response to this request; the socket is still used
+     * to detect when the client goes away */
+    g_debug ("[client %lu,0x%08x] shared memory transport setup (%u bytes per ring)",
+             request->client->id, request->original_transaction_id, ring_size);
+    client->shm = g_steal_pointer (&shm);
+    client_attach_shm_source (client, client->shard->context);
+
+    request->response = build_proxy_control_command_done (message, MBIM_STATUS_ERROR_NONE);
+    request_complete_and_free (request);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Subscriber list */
+
+static void
+track_service_subscribe_list (Client      *client,
+                              MbimMessage *message)
+{
+    g_autoptr(GError)              error = NULL;
+    g_autoptr(MbimEventEntryArray) mbim_event_entry_array = NULL;
+    gsize                          mbim_event_entry_array_size;
+
+    mbim_event_entry_array = _mbim_proxy_helper_service_subscribe_request_parse (message, &mbim_event_entry_array_size, &error);
+    if (error) {
+        g_warning ("[client %lu] invalid subscribe request message: %s", client->id, error->message);
+        return;
+    }
+
+    /* On each new request from the client, it should provide the FULL list of
+     * events it's subscribed to, so we can safely recreate the whole array each
+     * time; the device only needs the differences with the previous one. */
+    if (client->device)
+        device_update_subscriptions (client->device,
+                                     (const MbimEventEntry * const *)client->mbim_event_entry_array,
+                                     client->mbim_event_entry_array_size,
+                                     (const MbimEventEntry * const *)mbim_event_entry_array,
+                                     mbim_event_entry_array_size);
+    g_clear_pointer (&client->mbim_event_entry_array, mbim_event_entry_array_free);
+    client->mbim_event_entry_array = g_steal_pointer (&mbim_event_entry_array);
+    client->mbim_event_entry_array_size = mbim_event_entry_array_size;
+
+    if (mbim_utils_get_traces_enabled ()) {
+        g_debug ("[client %lu] service subscribe list built", client->id);
+        _mbim_proxy_helper_service_subscribe_list_debug ((const MbimEventEntry * const *)client->mbim_event_entry_array,
+                                                         client->mbim_event_entry_array_size);
+    }
+}
+
+static void
+device_service_subscribe_list_set_complete (Request         *request,
+                                            MbimStatusError  status)
+{
+    struct command_done_message *command_done;
+    guint32                      raw_len;
+    const guint8                *raw_data;
+
+    /* The raw message data to send back as response to client */
     raw_data = mbim_message_command_get_raw_information_buffer (request->message, &raw_len);
 
     request->response = (MbimMessage *)_mbim_message_allocate (MBIM_MESSAGE_TYPE_COMMAND_DONE,
@@ -892,9 +1675,12 @@ device_service_subscribe_list_set_ready (MbimDevice   *device,
                                          GAsyncResult *res,
                                          Request      *request)
 {
-    g_autoptr(MbimMessage) tmp_response = NULL;
-    g_autoptr(GError)      error = NULL;
-    MbimStatusError        error_status_code;
+    g_autoptr(MbimMessage)  tmp_response = NULL;
+    g_autoptr(GError)       error = NULL;
+    MbimStatusError         error_status_code;
+    Shard                  *shard = request->client->shard;
+
+    shard_lock (shard);
 
     tmp_response = mbim_device_command_finish (device, res, &error);
     if (!tmp_response) {
@@ -904,6 +1690,7 @@ device_service_subscribe_list_set_ready (MbimDevice   *device,
                      request->client->id, request->original_transaction_id);
             request->response = mbim_message_function_error_new (mbim_message_get_transaction_id (request->message), MBIM_PROTOCOL_ERROR_NOT_OPENED);
             request_complete_and_free (request);
+            shard_unlock (shard);
             return;
         }
 
@@ -911,6 +1698,7 @@ device_service_subscribe_list_set_ready (MbimDevice   *device,
         g_debug ("[client %lu,0x%08x] sending request to device failed: %s",
                  request->client->id, request->original_transaction_id, error->message);
         request_complete_and_free (request);
+        shard_unlock (shard);
         return;
     }
 
@@ -918,6 +1706,8 @@ device_service_subscribe_list_set_ready (MbimDevice   *device,
              request->client->id, request->original_transaction_id);
     error_status_code = GUINT32_FROM_LE (((struct full_message *)(tmp_response->data))->message.command_done.status_code);
     device_service_subscribe_list_set_complete (request, error_status_code);
+
+    shard_unlock (shard);
 }
 
 static gboolean
@@ -944,6 +1734,7 @@ process_device_service_subscribe_list (MbimProxy   *self,
     if (!updated) {
         g_debug ("[client %lu,0x%08x] service subscribe list update in device not needed",
                  request->client->id, request->original_transaction_id);
+        stats_cache_hit (client);
         device_service_subscribe_list_set_complete (request, MBIM_STATUS_ERROR_NONE);
         return TRUE;
     }
@@ -1027,7 +1818,7 @@ monitor_ms_basic_connect_extensions_version_response (MbimProxy   *self,
 
     /* notify to all clients about the MBIMEx version update */
     indication = build_proxy_control_version_notification (mbim_version, ms_mbimex_version);
-    for (l = self->priv->clients; l; l = g_list_next (l)) {
+    for (l = device_peek_shard (device)->clients; l; l = g_list_next (l)) {
         g_autoptr(GError)  error = NULL;
         Client            *client;
 
@@ -1059,9 +1850,13 @@ device_command_ready (MbimDevice   *device,
                       GAsyncResult *res,
                       Request      *request)
 {
-    g_autoptr(GError) error = NULL;
+    g_autoptr(GError)  error = NULL;
+    Shard             *shard = request->client->shard;
+
+    shard_lock (shard);
 
     request->response = mbim_device_command_finish (device, res, &error);
+    stats_request_completed (request, error);
     if (!request->response) {
         /* Translate a MbimDevice wrong state error into a Not-Opened function error. */
         if (g_error_matches (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_WRONG_STATE)) {
@@ -1069,6 +1864,7 @@ device_command_ready (MbimDevice   *device,
                      request->client->id, request->original_transaction_id);
             request->response = mbim_message_function_error_new (request->original_transaction_id, MBIM_PROTOCOL_ERROR_NOT_OPENED);
             request_complete_and_free (request);
+            shard_unlock (shard);
             return;
         }
 
@@ -1076,6 +1872,7 @@ device_command_ready (MbimDevice   *device,
         g_debug ("[client %lu,0x%08x] sending request to device failed: %s",
                  request->client->id, request->original_transaction_id, error->message);
         request_complete_and_free (request);
+        shard_unlock (shard);
         return;
     }
 
@@ -1088,50 +1885,185 @@ device_command_ready (MbimDevice   *device,
 
     mbim_message_set_transaction_id (request->response, request->original_transaction_id);
     request_complete_and_free (request);
+
+    shard_unlock (shard);
+}
+
+static void
+request_dispatch (Request *request)
+{
+    MbimDevice              *device;
+    GList                   *l;
+    MbimService              service;
+    const MbimCidDescriptor *descriptor;
+    const gchar             *service_name;
+    const gchar             *command_type;
+
+    device = request->client->device;
+
+    /* Single lookup for both service and command names, also valid for custom services */
+    service = mbim_message_command_get_service (request->message);
+    descriptor = mbim_cid_get_descriptor (service, mbim_message_command_get_cid (request->message));
+    service_name = descriptor ? descriptor->service_name : mbim_service_lookup_name (service);
+    command_type = mbim_message_command_type_get_string (mbim_message_command_get_command_type (request->message));
+
+    g_debug ("[client %lu,0x%08x] forwarding request to device: %s, %s, %s",
+             request->client->id, request->original_transaction_id,
+             service_name                     ? service_name     : "unknown service",
+             command_type                     ? command_type     : "unknown command type",
+             (descriptor && descriptor->name) ? descriptor->name : "unknown command");
+
+    request->in_flight = TRUE;
+    request->client->n_in_flight++;
+    request->client->in_flight = g_list_prepend (request->client->in_flight, request);
+    request->cancellable = g_cancellable_new ();
+    stats_request_dispatched (request);
+
+    /* avoid incrementing transaction until the last fragment is processed */
+    for (l = request->fragments; l; l = g_list_next (l)) {
+        mbim_message_set_transaction_id ((MbimMessage *)(l->data), mbim_device_get_transaction_id (device));
+        mbim_device_command (device, (MbimMessage *)(l->data), request->client->timeout_secs, NULL, NULL, NULL);
+    }
+
+    /* replace command transaction id with internal proxy transaction id to avoid collision */
+    mbim_message_set_transaction_id (request->message, mbim_device_get_next_transaction_id (device));
+
+    /* The request is cancelled if the client goes away before the response
+     * arrives */
+    mbim_device_command (device,
+                         request->message,
+                         request->client->timeout_secs,
+                         request->cancellable,
+                         (GAsyncReadyCallback)device_command_ready,
+                         request);
 }
 
+static void     device_enqueue_request            (MbimProxy   *self,
+                                                   Request     *request);
+static gboolean process_internal_proxy_statistics (MbimProxy   *self,
+                                                   Client      *client,
+                                                   MbimMessage *message);
+
 static gboolean
 process_command (MbimProxy   *self,
                  Client      *client,
                  MbimMessage *message)
 {
-    Request     *request;
-    const gchar *command;
-    const gchar *command_type;
-    const gchar *service;
-
-    command = mbim_cid_get_printable (mbim_message_command_get_service (message),
-                                      mbim_message_command_get_cid (message));
-    command_type = mbim_message_command_type_get_string (mbim_message_command_get_command_type (message));
-    service = mbim_service_get_string (mbim_message_command_get_service (message));
+    Request *request;
 
     /* create request holder */
     request = request_new (self, client, message);
 
-    g_debug ("[client %lu,0x%08x] forwarding request to device: %s, %s, %s",
-             client->id, request->original_transaction_id,
-             service      ? service      : "unknown service",
-             command_type ? command_type : "unknown command type",
-             command      ? command      : "unknown command");
-
-    if (_mbim_message_fragment_get_current (message) == _mbim_message_fragment_get_total (message) - 1)
-        /* replace command transaction id with internal proxy transaction id to avoid collision */
-        mbim_message_set_transaction_id (message, mbim_device_get_next_transaction_id (client->device));
-    else
-        /* avoid incrementing transaction until the last fragment is processed */
-        mbim_message_set_transaction_id (message, mbim_device_get_transaction_id (client->device));
+    if (!client->device) {
+        g_debug ("[client %lu,0x%08x] cannot forward request: device not set",
+                 client->id, request->original_transaction_id);
+        request->response = mbim_message_function_error_new (request->original_transaction_id, MBIM_PROTOCOL_ERROR_NOT_OPENED);
+        request_complete_and_free (request);
+        return TRUE;
+    }
 
-    /* The timeout needs to be big enough for any kind of transaction to
-     * complete, otherwise the remote clients will lose the reply if they
-     * configured a timeout bigger than this internal one. We should likely
-     * make this value configurable per-client, instead of a hardcoded value.
-     */
-    mbim_device_command (client->device,
-                         message,
-                         300,
-                         NULL,
-                         (GAsyncReadyCallback)device_command_ready,
-                         request);
+    /* Non-last fragments are kept aside until the whole command has been
+     * received, so that fragments of commands from different clients are
+     * never interleaved when sent to the device. */
+    if (_mbim_message_fragment_get_current (message) < _mbim_message_fragment_get_total (message) - 1) {
+        client->pending_fragments = g_list_append (client->pending_fragments, g_steal_pointer (&request->message));
+        request_complete_and_free (request);
+        return TRUE;
+    }
+
+    request->fragments = g_steal_pointer (&client->pending_fragments);
+    device_enqueue_request (self, request);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Client routing to shards */
+
+static void client_attach_readable_source (Client *client, GMainContext *context);
+static void parse_request                 (MbimProxy *self, Client *client);
+
+typedef struct {
+    Client      *client;
+    MbimMessage *message;
+} RouteContext;
+
+static gboolean
+client_routed_cb (RouteContext *ctx)
+{
+    Client    *client;
+    MbimProxy *self;
+    Shard     *shard;
+
+    client = ctx->client;
+    self = client->self;
+    shard = client->shard;
+
+    shard_lock (shard);
+
+    /* The client isn't in any shard while being routed, so nothing else
+     * may have untracked it; the reference is given to the shard */
+    g_debug ("[client %lu] running in shard %u", client->id, shard->index);
+    shard->clients = g_list_append (shard->clients, client);
+    client_attach_readable_source (client, shard->context);
+    if (client->shm)
+        client_attach_shm_source (client, shard->context);
+    client_attach_writable_source (client);
+    process_internal_proxy_config (self, client, ctx->message);
+
+    /* Process any other message received along with the configuration */
+    if (client->connection)
+        parse_request (self, client);
+
+    mbim_message_unref (ctx->message);
+    g_slice_free (RouteContext, ctx);
+
+    shard_unlock (shard);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+route_client_to_shard (MbimProxy   *self,
+                       Client      *client,
+                       MbimMessage *message)
+{
+    g_autofree gchar  *incoming_path = NULL;
+    g_autofree gchar  *path = NULL;
+    g_autoptr(GError)  error = NULL;
+    RouteContext      *ctx;
+
+    /* Invalid requests are processed right away, as they're replied with an
+     * error by the standard proxy config processing */
+    if (mbim_message_command_get_command_type (message) != MBIM_MESSAGE_COMMAND_TYPE_SET ||
+        !_mbim_message_read_string (message, 0, 0, MBIM_STRING_ENCODING_UTF16, &incoming_path, NULL, &error) ||
+        !(path = mbim_helpers_get_devpath (incoming_path, &error)))
+        return process_internal_proxy_config (self, client, message);
+
+    /* Stop reading and writing in the main context; the proxy config request,
+     * any other data already received and any message pending to be written
+     * are processed in the shard thread */
+    g_source_destroy (client->connection_readable_source);
+    g_source_unref (client->connection_readable_source);
+    client->connection_readable_source = NULL;
+    if (client->shm_source) {
+        g_source_destroy (client->shm_source);
+        g_source_unref (client->shm_source);
+        client->shm_source = NULL;
+    }
+    if (client->connection_writable_source) {
+        g_source_destroy (client->connection_writable_source);
+        g_source_unref (client->connection_writable_source);
+        client->connection_writable_source = NULL;
+    }
+
+    /* The reference of the main shard is given to the routing context */
+    client->shard->clients = g_list_remove (client->shard->clients, client);
+    client->shard = peek_shard_for_path (self, path);
+    g_debug ("[client %lu] moving to shard %u...", client->id, client->shard->index);
+
+    ctx = g_slice_new0 (RouteContext);
+    ctx->client = client;
+    ctx->message = mbim_message_ref (message);
+    shard_attach_idle (client->shard, (GSourceFunc) client_routed_cb, ctx);
     return TRUE;
 }
 
@@ -1151,8 +2083,22 @@ process_message (MbimProxy   *self,
     case MBIM_MESSAGE_TYPE_COMMAND:
         /* Proxy control message? */
         if (mbim_message_command_get_service (message) == MBIM_SERVICE_PROXY_CONTROL &&
-            mbim_message_command_get_cid (message) == MBIM_CID_PROXY_CONTROL_CONFIGURATION)
+            mbim_message_command_get_cid (message) == MBIM_CID_PROXY_CONTROL_CONFIGURATION) {
+            /* Clients are moved to the shard running the device once
+             * they're bound to it */
+            if (self->priv->n_shards > 0 && client->shard == self->priv->main_shard)
+                return route_client_to_shard (self, client, message);
             return process_internal_proxy_config (self, client, message);
+        }
+        if (mbim_message_command_get_service (message) == MBIM_SERVICE_PROXY_CONTROL &&
+            mbim_message_command_get_cid (message) == MBIM_CID_PROXY_CONTROL_CLIENT_SETTINGS)
+            return process_internal_proxy_client_settings (self, client, message);
+        if (mbim_message_command_get_service (message) == MBIM_SERVICE_PROXY_CONTROL &&
+            mbim_message_command_get_cid (message) == MBIM_CID_PROXY_CONTROL_STATISTICS)
+            return process_internal_proxy_statistics (self, client, message);
+        if (mbim_message_command_get_service (message) == MBIM_SERVICE_PROXY_CONTROL &&
+            mbim_message_command_get_cid (message) == MBIM_CID_PROXY_CONTROL_SHARED_MEMORY)
+            return process_internal_proxy_shared_memory (self, client, message);
         /* device service subscribe list message? */
         if (mbim_message_command_get_service (message) == MBIM_SERVICE_BASIC_CONNECT &&
             mbim_message_command_get_cid (message) == MBIM_CID_BASIC_CONNECT_DEVICE_SERVICE_SUBSCRIBE_LIST)
@@ -1175,40 +2121,244 @@ process_message (MbimProxy   *self,
 }
 
 static void
-parse_request (MbimProxy *self,
-               Client    *client)
+client_attach_readable_source (Client       *client,
+                               GMainContext *context)
 {
-    do {
+    g_assert (!client->connection_readable_source);
+    client->connection_readable_source = g_socket_create_source (g_socket_connection_get_socket (client->connection),
+                                                                 G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP,
+                                                                 NULL);
+    g_source_set_callback (client->connection_readable_source,
+                           (GSourceFunc)connection_readable_cb,
+                           client,
+                           NULL);
+    g_source_attach (client->connection_readable_source, context);
+}
+
+static void
+parse_buffer (MbimProxy  *self,
+              Client     *client,
+              GByteArray *buffer,
+              guint      *buffer_offset)
+{
+    Shard *shard = client->shard;
+
+    /* Messages are processed directly from the receive buffer, and the
+     * consumed data is only released once all complete messages have been
+     * processed. */
+    while (*buffer_offset < buffer->len) {
         g_autoptr(MbimMessage) message = NULL;
         g_autoptr(GError)      error = NULL;
+        MbimMessage            view;
+
+        view.data = buffer->data + *buffer_offset;
+        view.len  = buffer->len - *buffer_offset;
 
         /* Invalid message? */
-        if (!_mbim_message_validate_internal ((const MbimMessage *)client->buffer, TRUE, &error)) {
+        if (!_mbim_message_validate_internal (&view, TRUE, &error)) {
             /* No full message yet */
             if (g_error_matches (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INCOMPLETE_MESSAGE))
-                return;
+                break;
             /* Invalid message */
-            g_byte_array_remove_range (client->buffer, 0, client->buffer->len);
+            g_byte_array_set_size (buffer, 0);
+            *buffer_offset = 0;
             return;
         }
 
-        message = mbim_message_dup ((const MbimMessage *)client->buffer);
-        g_assert (message);
-
-        g_byte_array_remove_range (client->buffer, 0, mbim_message_get_message_length (message));
+        /* The message needs to outlive the receive buffer, as it may be
+         * queued or waiting for the response; so build it with a single
+         * copy of exactly the message contents. */
+        message = mbim_message_new (view.data, mbim_message_get_message_length (&view));
+        *buffer_offset += mbim_message_get_message_length (message);
         process_message (self, client, message);
-    } while (client->buffer->len > 0);
+
+        /* The client may have been moved to a shard, which takes care of
+         * the rest of the buffer (and which may already be running it, so
+         * nothing else is checked), or untracked while processing */
+        if (client->shard != shard || !client->connection || !client->connection_readable_source)
+            return;
+    }
+
+    /* Release consumed data; if there is a partial message, move it to the
+     * beginning of the buffer, which happens at most once per read */
+    if (*buffer_offset == buffer->len)
+        g_byte_array_set_size (buffer, 0);
+    else if (*buffer_offset > 0)
+        g_byte_array_remove_range (buffer, 0, *buffer_offset);
+    *buffer_offset = 0;
+}
+
+static void
+parse_request (MbimProxy *self,
+               Client    *client)
+{
+    Shard *shard = client->shard;
+
+    /* Data received through the socket and through the shared memory are
+     * kept in different buffers, as partial messages may be found in both
+     * while the client switches transport */
+    if (client->buffer)
+        parse_buffer (self, client, client->buffer, &client->buffer_offset);
+    if (client->shard == shard && client->shm_buffer && client->connection && client->connection_readable_source)
+        parse_buffer (self, client, client->shm_buffer, &client->shm_buffer_offset);
 }
 
 static gboolean
-connection_readable_cb (GSocket      *socket,
+client_shm_readable (Client       *_client,
+                     GIOCondition  condition)
+{
+    g_autoptr(Client)  client = NULL;
+    MbimProxy         *self;
+    g_autoptr(GError)  error = NULL;
+
+    client = client_ref (_client);
+    self = client->self;
+
+    if (condition & G_IO_ERR) {
+        untrack_client (self, client);
+        return FALSE;
+    }
+
+    if (G_UNLIKELY (!client->shm_buffer))
+        client->shm_buffer = g_byte_array_sized_new (BUFFER_SIZE);
+
+    if (!_mbim_shm_transport_read (client->shm, client->shm_buffer, &error)) {
+        g_warning ("[client %lu] error reading from shared memory: %s", client->id, error->message);
+        untrack_client (self, client);
+        return FALSE;
+    }
+
+    parse_buffer (self, client, client->shm_buffer, &client->shm_buffer_offset);
+    return TRUE;
+}
+
+static gboolean
+client_shm_readable_cb (gint          fd,
                         GIOCondition  condition,
-                        Client       *_client)
+                        Client       *client)
+{
+    Shard    *shard = client->shard;
+    gboolean  keep;
+
+    shard_lock (shard);
+    keep = client_shm_readable (client, condition);
+    shard_unlock (shard);
+    return keep;
+}
+
+static void
+client_attach_shm_source (Client       *client,
+                          GMainContext *context)
+{
+    g_assert (!client->shm_source);
+    client->shm_source = g_unix_fd_source_new (_mbim_shm_transport_get_wake_fd (client->shm), G_IO_IN | G_IO_ERR);
+    g_source_set_callback (client->shm_source,
+                           (GSourceFunc)client_shm_readable_cb,
+                           client,
+                           NULL);
+    g_source_attach (client->shm_source, context);
+}
+
+static gssize
+client_receive (Client  *client,
+                guint8  *buffer,
+                gsize    buffer_size,
+                GError **error)
+{
+    GInputVector            vector = { buffer, buffer_size };
+    GSocketControlMessage **messages = NULL;
+    gint                    n_messages = 0;
+    gint                    flags = 0;
+    gssize                  r;
+    gint                    i;
+
+    /* Descriptors may be sent along with some requests, e.g. the one to
+     * setup the shared memory transport */
+    r = g_socket_receive_message (g_socket_connection_get_socket (client->connection),
+                                  NULL,
+                                  &vector,
+                                  1,
+                                  &messages,
+                                  &n_messages,
+                                  &flags,
+                                  NULL,
+                                  error);
+
+    for (i = 0; i < n_messages; i++) {
+        if (G_IS_UNIX_FD_MESSAGE (messages[i])) {
+            g_autofree gint *fds = NULL;
+            gint             n_fds = 0;
+            gint             j;
+
+            if (!client->received_fds)
+                client->received_fds = g_array_new (FALSE, FALSE, sizeof (gint));
+
+            fds = g_unix_fd_message_steal_fds (G_UNIX_FD_MESSAGE (messages[i]), &n_fds);
+            for (j = 0; j < n_fds; j++) {
+                if (client->received_fds->len < CLIENT_MAX_RECEIVED_FDS)
+                    g_array_append_val (client->received_fds, fds[j]);
+                else
+                    close (fds[j]);
+            }
+        }
+        g_object_unref (messages[i]);
+    }
+    g_free (messages);
+
+    return r;
+}
+
+static gboolean
+client_receive_datagram (MbimProxy *self,
+                         Client    *client)
+{
+    g_autoptr(GByteArray)   datagram = NULL;
+    g_autoptr(MbimMessage)  message = NULL;
+    g_autoptr(GError)       error = NULL;
+    GSocket                *socket;
+    gssize                  size;
+    gssize                  r;
+
+    /* Peek the size of the next datagram */
+    socket = g_socket_connection_get_socket (client->connection);
+    size = recv (g_socket_get_fd (socket), NULL, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT);
+    if (size <= 0)
+        size = BUFFER_SIZE;
+
+    /* The datagram is received in its own buffer, which is used as message
+     * right away, as there is no need to look for message boundaries */
+    datagram = g_byte_array_sized_new (size);
+    g_byte_array_set_size (datagram, size);
+    r = client_receive (client, datagram->data, size, &error);
+    if (r < 0) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+            return TRUE;
+        g_warning ("[client %lu] error reading datagram: %s", client->id, error->message);
+        return FALSE;
+    }
+    if (r == 0)
+        return TRUE;
+    g_byte_array_set_size (datagram, r);
+
+    if (!_mbim_message_validate_internal ((const MbimMessage *)datagram, TRUE, &error) ||
+        mbim_message_get_message_length ((const MbimMessage *)datagram) != (guint32)r) {
+        g_debug ("[client %lu] invalid datagram: %s", client->id, error ? error->message : "length mismatch");
+        return TRUE;
+    }
+
+    message = (MbimMessage *) g_steal_pointer (&datagram);
+    process_message (self, client, message);
+    return TRUE;
+}
+
+static gboolean
+connection_readable (Client       *_client,
+                     GIOCondition  condition)
 {
     g_autoptr(Client)  client = NULL;
     MbimProxy         *self;
-    guint8             buffer[BUFFER_SIZE];
     g_autoptr(GError)  error = NULL;
+    guint              len;
     gssize             r;
 
     /* Recover proxy pointer soon */
@@ -1223,32 +2373,58 @@ connection_readable_cb (GSocket      *socket,
     if (!(condition & G_IO_IN || condition & G_IO_PRI))
         return TRUE;
 
-    r = g_input_stream_read (g_io_stream_get_input_stream (G_IO_STREAM (client->connection)),
-                             buffer,
-                             BUFFER_SIZE,
-                             NULL,
-                             &error);
+    if (client->seqpacket) {
+        if (!client_receive_datagram (self, client)) {
+            untrack_client (self, client);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    /* Read directly into the free space at the end of the receive buffer;
+     * the allocated buffer is never shrunk, so once it has grown enough
+     * no more allocations are needed */
+    if (G_UNLIKELY (!client->buffer))
+        client->buffer = g_byte_array_sized_new (BUFFER_SIZE);
+    len = client->buffer->len;
+    g_byte_array_set_size (client->buffer, len + BUFFER_SIZE);
+
+    r = client_receive (client, client->buffer->data + len, BUFFER_SIZE, &error);
     if (r < 0) {
+        g_byte_array_set_size (client->buffer, len);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+            return TRUE;
         g_warning ("[client %lu] error reading from istream: %s", client->id, error ? error->message : "unknown");
         /* Close the device */
         untrack_client (self, client);
         return FALSE;
     }
 
+    g_byte_array_set_size (client->buffer, len + r);
     if (r == 0)
         return TRUE;
 
-    /* else, r > 0 */
-    if (!G_UNLIKELY (client->buffer))
-        client->buffer = g_byte_array_sized_new (r);
-    g_byte_array_append (client->buffer, buffer, r);
-
     /* Try to parse input messages */
     parse_request (self, client);
 
     return TRUE;
 }
 
+static gboolean
+connection_readable_cb (GSocket      *socket,
+                        GIOCondition  condition,
+                        Client       *client)
+{
+    Shard    *shard = client->shard;
+    gboolean  keep;
+
+    /* The client may be moved to a different shard while processing */
+    shard_lock (shard);
+    keep = connection_readable (client, condition);
+    shard_unlock (shard);
+    return keep;
+}
+
 static void
 incoming_cb (GSocketService    *service,
              GSocketConnection *connection,
@@ -1292,40 +2468,49 @@ incoming_cb (GSocketService    *service,
         g_debug ("[client %lu] member of allowed group", client_id);
     }
 
+    /* New clients are run in the main shard until they're bound to a device */
+    shard_lock (self->priv->main_shard);
+
     /* Create client */
     client = g_slice_new0 (Client);
     client->self = self;
     client->ref_count = 1;
     client->id = client_id;
     client->connection = g_object_ref (connection);
+    client->seqpacket = (g_socket_get_socket_type (g_socket_connection_get_socket (connection)) == G_SOCKET_TYPE_SEQPACKET);
+    /* Reads and writes are only done when the socket is readable or
+     * writable, and never block */
+    g_socket_set_blocking (g_socket_connection_get_socket (connection), FALSE);
+    client->pending = g_queue_new ();
+    client->outgoing = g_queue_new ();
+    client->shard = self->priv->main_shard;
+    client->weight = CLIENT_WEIGHT_DEFAULT;
+    client->timeout_secs = CLIENT_COMMAND_TIMEOUT_DEFAULT_SECS;
 
     /* By default, a new client has all the standard services enabled for indications */
     client->mbim_event_entry_array = _mbim_proxy_helper_service_subscribe_list_new_standard (&client->mbim_event_entry_array_size);
 
-    client->connection_readable_source = g_socket_create_source (g_socket_connection_get_socket (client->connection),
-                                                                 G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP,
-                                                                 NULL);
-    g_source_set_callback (client->connection_readable_source,
-                           (GSourceFunc)connection_readable_cb,
-                           client,
-                           NULL);
-    g_source_attach (client->connection_readable_source, g_main_context_get_thread_default ());
+    client_attach_readable_source (client, client->shard->context);
 
     /* Keep the client info around */
     track_client (self, client);
 
     client_unref (client);
+
+    shard_unlock (self->priv->main_shard);
 }
 
 static gboolean
-setup_socket_service (MbimProxy  *self,
-                      GError    **error)
+add_listening_socket (MbimProxy    *self,
+                      GSocketType   socket_type,
+                      const gchar  *socket_path,
+                      GError      **error)
 {
     g_autoptr(GSocketAddress) socket_address = NULL;
     g_autoptr(GSocket)        socket = NULL;
 
     socket = g_socket_new (G_SOCKET_FAMILY_UNIX,
-                           G_SOCKET_TYPE_STREAM,
+                           socket_type,
                            G_SOCKET_PROTOCOL_DEFAULT,
                            error);
     if (!socket)
@@ -1333,29 +2518,47 @@ setup_socket_service (MbimProxy  *self,
 
     /* Bind to address */
     socket_address = (g_unix_socket_address_new_with_type (
-                          MBIM_PROXY_SOCKET_PATH,
+                          socket_path,
                           -1,
                           G_UNIX_SOCKET_ADDRESS_ABSTRACT));
     if (!g_socket_bind (socket, socket_address, TRUE, error))
         return FALSE;
 
-    g_debug ("creating UNIX socket service...");
-
     /* Listen */
     if (!g_socket_listen (socket, error))
         return FALSE;
 
-    /* Create socket service */
-    self->priv->socket_service = g_socket_service_new ();
-    g_signal_connect (self->priv->socket_service, "incoming", G_CALLBACK (incoming_cb), self);
     if (!g_socket_listener_add_socket (G_SOCKET_LISTENER (self->priv->socket_service),
                                        socket,
                                        NULL, /* don't pass an object, will take a reference */
                                        error)) {
-        g_prefix_error (error, "Error adding socket at '%s' to socket service: ", MBIM_PROXY_SOCKET_PATH);
+        g_prefix_error (error, "Error adding socket at '%s' to socket service: ", socket_path);
         return FALSE;
     }
 
+    return TRUE;
+}
+
+static gboolean
+setup_socket_service (MbimProxy  *self,
+                      GError    **error)
+{
+    g_autoptr(GError) inner_error = NULL;
+
+    g_debug ("creating UNIX socket service...");
+
+    /* Create socket service */
+    self->priv->socket_service = g_socket_service_new ();
+    g_signal_connect (self->priv->socket_service, "incoming", G_CALLBACK (incoming_cb), self);
+
+    if (!add_listening_socket (self, G_SOCKET_TYPE_STREAM, MBIM_PROXY_SOCKET_PATH, error))
+        return FALSE;
+
+    /* The seqpacket transport is optional, clients fallback to the stream
+     * one if not available */
+    if (!add_listening_socket (self, G_SOCKET_TYPE_SEQPACKET, MBIM_PROXY_SEQPACKET_SOCKET_PATH, &inner_error))
+        g_debug ("couldn't setup seqpacket socket at '%s': %s", MBIM_PROXY_SEQPACKET_SOCKET_PATH, inner_error->message);
+
     g_debug ("starting UNIX socket service at '%s'...", MBIM_PROXY_SOCKET_PATH);
     g_socket_service_start (self->priv->socket_service);
     return TRUE;
@@ -1368,15 +2571,47 @@ setup_socket_service (MbimProxy  *self,
 static GQuark device_context_quark;
 
 typedef struct {
-    /* Combined events array */
+    /* Shard running the device */
+    Shard *shard;
+
+    /* Combined events array, as last configured in the device */
     MbimEventEntry **mbim_event_entry_array;
     gsize            mbim_event_entry_array_size;
+
+    /* Reference counted subscriptions of all clients */
+    MbimProxySubscriptionSet *subscriptions;
+
+    /* Clients with requests pending to be sent, in round-robin order */
+    GQueue   *ready_clients;
+    gboolean  scheduling;
+    gboolean  reschedule;
+
+    /* Queue depth metrics */
+    guint n_queued;
+    guint max_queued;
+
+    /* Requests abandoned because the client went away, either before
+     * being sent to the device or while waiting for the response */
+    guint n_abandoned_queued;
+    guint n_abandoned_in_flight;
+
+    /* Statistics */
+    guint64                   requests_forwarded;
+    guint64                   requests_timed_out;
+    guint64                   indications_received;
+    guint64                   indications_forwarded;
+    guint64                   cache_hits;
+    guint                     queued_bytes;
+    MbimProxyLatencyHistogram device_latency;
+    MbimProxyLatencyHistogram queue_latency;
 } DeviceContext;
 
 static void
 device_context_free (DeviceContext *ctx)
 {
     mbim_event_entry_array_free (ctx->mbim_event_entry_array);
+    _mbim_proxy_helper_subscription_set_free (ctx->subscriptions);
+    g_queue_free (ctx->ready_clients);
     g_slice_free (DeviceContext, ctx);
 }
 
@@ -1391,6 +2626,8 @@ device_context_get (MbimDevice *device)
     ctx = g_object_get_qdata (G_OBJECT (device), device_context_quark);
     if (!ctx) {
         ctx = g_slice_new0 (DeviceContext);
+        ctx->ready_clients = g_queue_new ();
+        ctx->subscriptions = _mbim_proxy_helper_subscription_set_new ();
         ctx->mbim_event_entry_array = _mbim_proxy_helper_service_subscribe_list_new_standard (&ctx->mbim_event_entry_array_size);
 
         g_debug ("[%s] initial device subscribe list...", mbim_device_get_path (device));
@@ -1402,12 +2639,36 @@ device_context_get (MbimDevice *device)
     return ctx;
 }
 
+static Shard *
+device_peek_shard (MbimDevice *device)
+{
+    Shard *shard;
+
+    shard = device_context_get (device)->shard;
+    g_assert (shard);
+    return shard;
+}
+
+static void
+device_update_subscriptions (MbimDevice                   *device,
+                             const MbimEventEntry * const *removed,
+                             gsize                         removed_size,
+                             const MbimEventEntry * const *added,
+                             gsize                         added_size)
+{
+    DeviceContext *ctx;
+
+    ctx = device_context_get (device);
+    g_assert (ctx);
+
+    _mbim_proxy_helper_subscription_set_update (ctx->subscriptions, removed, removed_size, added, added_size);
+}
+
 static MbimEventEntry **
 merge_client_service_subscribe_lists (MbimProxy  *self,
                                       MbimDevice *device,
                                       gsize      *out_size)
 {
-    GList                          *l;
     g_autoptr(MbimEventEntryArray)  updated = NULL;
     gsize                           updated_size = 0;
     DeviceContext                  *ctx;
@@ -1418,25 +2679,18 @@ merge_client_service_subscribe_lists (MbimProxy  *self,
 
     g_assert (out_size != NULL);
 
-    /* Init default list */
-    updated = _mbim_proxy_helper_service_subscribe_list_new_standard (&updated_size);
-
-    /* Lookup all clients with this device */
-    for (l = self->priv->clients; l; l = g_list_next (l)) {
-        Client *client;
-
-        client = l->data;
-        if (!client->mbim_event_entry_array)
-            continue;
-
-        /* Add per-client list */
-        if (client->device == device)
-            updated = _mbim_proxy_helper_service_subscribe_list_merge (updated, updated_size,
-                                                                       client->mbim_event_entry_array, client->mbim_event_entry_array_size,
-                                                                       &updated_size);
+    /* The subscriptions of all clients are updated incrementally, so if no
+     * update changed the merged set, there is nothing to do */
+    if (!_mbim_proxy_helper_subscription_set_changed (ctx->subscriptions)) {
+        g_debug ("[%s] merged service subscribe list not updated", mbim_device_get_path (device));
+        return NULL;
     }
 
-    /* If lists are equal, ignore re-setting them up */
+    updated = _mbim_proxy_helper_subscription_set_build (ctx->subscriptions, &updated_size);
+
+    /* Several updates may have cancelled each other, e.g. a client removing
+     * a subscription that another one added later; if lists are equal, ignore
+     * re-setting them up */
     if (_mbim_proxy_helper_service_subscribe_list_cmp (
             (const MbimEventEntry *const *)updated, updated_size,
             (const MbimEventEntry *const *)ctx->mbim_event_entry_array, ctx->mbim_event_entry_array_size)) {
@@ -1471,7 +2725,7 @@ reset_client_service_subscribe_lists (MbimProxy  *self,
     g_assert (ctx);
 
     /* make sure that all clients of this device don't track any event registered */
-    for (l = self->priv->clients; l; l = g_list_next (l)) {
+    for (l = ctx->shard->clients; l; l = g_list_next (l)) {
         Client *client;
 
         client = l->data;
@@ -1487,27 +2741,491 @@ reset_client_service_subscribe_lists (MbimProxy  *self,
     /* And reset the device-specific merged list */
     g_clear_pointer (&ctx->mbim_event_entry_array, mbim_event_entry_array_free);
     ctx->mbim_event_entry_array = _mbim_proxy_helper_service_subscribe_list_new_standard (&ctx->mbim_event_entry_array_size);
+    _mbim_proxy_helper_subscription_set_reset (ctx->subscriptions);
+}
+
+/*****************************************************************************/
+/* Request scheduling
+ *
+ * Each client has its own queue of requests to be sent to the device, and the
+ * device keeps the list of clients with pending requests. Clients are served in
+ * weighted round-robin order (the weight of each client being the number of
+ * requests dispatched on each turn, as requested in the proxy control client
+ * settings), and each client may only have a limited number of
+ * requests ongoing in the device at any given time, so that a single client
+ * flooding the proxy with requests cannot monopolize the device.
+ */
+
+static void
+device_schedule (MbimProxy  *self,
+                 MbimDevice *device)
+{
+    DeviceContext *ctx;
+    guint          max_in_flight;
+    guint          n_dispatched;
+
+    ctx = device_context_get (device);
+    g_assert (ctx);
+
+    /* Avoid reentrant scheduling, e.g. if a request gets completed while
+     * another one is being dispatched */
+    if (ctx->scheduling) {
+        ctx->reschedule = TRUE;
+        return;
+    }
+
+    /* May be updated from any thread */
+    max_in_flight = (guint) g_atomic_int_get (&self->priv->client_max_in_flight);
+
+    ctx->scheduling = TRUE;
+    do {
+        ctx->reschedule = FALSE;
+
+        /* Keep on running full rounds until no more requests can be dispatched */
+        do {
+            guint n_ready;
+
+            n_dispatched = 0;
+            n_ready = g_queue_get_length (ctx->ready_clients);
+            while (n_ready-- > 0) {
+                g_autoptr(Client) client = NULL;
+                guint             n_served = 0;
+
+                client = client_ref ((Client *) g_queue_pop_head (ctx->ready_clients));
+                while (!g_queue_is_empty (client->pending) &&
+                       (n_served < client->weight) &&
+                       (!max_in_flight || client->n_in_flight < max_in_flight)) {
+                    Request *request;
+
+                    request = (Request *) g_queue_pop_head (client->pending);
+                    g_assert (ctx->n_queued > 0);
+                    ctx->n_queued--;
+                    ctx->queued_bytes -= request->size;
+                    client->queued_bytes -= request->size;
+                    request_dispatch (request);
+                    n_served++;
+                }
+
+                /* Back to the end of the round-robin list if still pending */
+                if (!g_queue_is_empty (client->pending))
+                    g_queue_push_tail (ctx->ready_clients, client);
+                n_dispatched += n_served;
+            }
+        } while (n_dispatched > 0);
+    } while (ctx->reschedule);
+    ctx->scheduling = FALSE;
+}
+
+static void
+device_enqueue_request (MbimProxy *self,
+                        Request   *request)
+{
+    Client        *client;
+    DeviceContext *ctx;
+    GList         *l;
+    guint          max_in_flight;
+
+    client = request->client;
+    ctx = device_context_get (client->device);
+    g_assert (ctx);
+
+    if (g_queue_is_empty (client->pending))
+        g_queue_push_tail (ctx->ready_clients, client);
+    g_queue_push_tail (client->pending, request);
+
+    ctx->n_queued++;
+    if (ctx->n_queued > ctx->max_queued)
+        ctx->max_queued = ctx->n_queued;
+
+    request->size = request->message->len;
+    for (l = request->fragments; l; l = g_list_next (l))
+        request->size += ((MbimMessage *)(l->data))->len;
+    ctx->queued_bytes += request->size;
+    client->queued_bytes += request->size;
+
+    max_in_flight = (guint) g_atomic_int_get (&self->priv->client_max_in_flight);
+    if (max_in_flight && client->n_in_flight >= max_in_flight)
+        g_debug ("[client %lu,0x%08x] request queued: %u requests in flight, %u queued in client, %u queued in device (max %u)",
+                 client->id, request->original_transaction_id,
+                 client->n_in_flight, g_queue_get_length (client->pending),
+                 ctx->n_queued, ctx->max_queued);
+
+    device_schedule (self, client->device);
+}
+
+static void
+client_flush_pending (Client *client)
+{
+    DeviceContext *ctx;
+    Request       *request;
+    GList         *cancellables = NULL;
+    GList         *l;
+
+    g_list_free_full (client->pending_fragments, (GDestroyNotify)mbim_message_unref);
+    client->pending_fragments = NULL;
+
+    if (!client->device) {
+        g_assert (g_queue_is_empty (client->pending));
+        g_assert (client->in_flight == NULL);
+        return;
+    }
+
+    if (g_queue_is_empty (client->pending) && !client->in_flight)
+        return;
+
+    ctx = device_context_get (client->device);
+    g_assert (ctx);
+
+    if (!g_queue_is_empty (client->pending)) {
+        g_queue_remove (ctx->ready_clients, client);
+        g_assert (ctx->n_queued >= g_queue_get_length (client->pending));
+        ctx->n_queued -= g_queue_get_length (client->pending);
+        ctx->n_abandoned_queued += g_queue_get_length (client->pending);
+
+        g_debug ("[client %lu] discarding %u requests not yet sent to the device",
+                 client->id, g_queue_get_length (client->pending));
+
+        /* Requests without response are just disposed */
+        while ((request = g_queue_pop_head (client->pending)) != NULL) {
+            g_assert (ctx->queued_bytes >= request->size);
+            ctx->queued_bytes -= request->size;
+            client->queued_bytes -= request->size;
+            request_complete_and_free (request);
+        }
+    }
+
+    if (client->in_flight) {
+        ctx->n_abandoned_in_flight += client->n_in_flight;
+
+        g_debug ("[client %lu] cancelling %u requests ongoing in the device",
+                 client->id, client->n_in_flight);
+
+        /* Cancelling completes the requests, so we cannot iterate the list
+         * of requests directly */
+        for (l = client->in_flight; l; l = g_list_next (l))
+            cancellables = g_list_prepend (cancellables, g_object_ref (((Request *)(l->data))->cancellable));
+        for (l = cancellables; l; l = g_list_next (l))
+            g_cancellable_cancel (G_CANCELLABLE (l->data));
+        g_list_free_full (cancellables, g_object_unref);
+    }
+
+    g_debug ("[%s] requests abandoned by clients: %u queued, %u in flight",
+             mbim_device_get_path (client->device),
+             ctx->n_abandoned_queued, ctx->n_abandoned_in_flight);
+}
+
+/*****************************************************************************/
+/* Proxy statistics */
+
+static void
+stats_request_dispatched (Request *request)
+{
+    DeviceContext *ctx;
+    gint64         queue_latency;
+
+    ctx = device_context_get (request->client->device);
+    g_assert (ctx);
+
+    request->dispatch_time = g_get_monotonic_time ();
+    queue_latency = request->dispatch_time - request->received_time;
+
+    request->client->requests_forwarded++;
+    _mbim_proxy_helper_latency_histogram_add (&request->client->queue_latency, queue_latency);
+    ctx->requests_forwarded++;
+    _mbim_proxy_helper_latency_histogram_add (&ctx->queue_latency, queue_latency);
+}
+
+static void
+stats_request_completed (Request      *request,
+                         const GError *error)
+{
+    DeviceContext *ctx;
+    gint64         device_latency;
+
+    /* Requests cancelled because the client went away may complete when the
+     * client no longer has a device */
+    if (!request->client->device)
+        return;
+
+    ctx = device_context_get (request->client->device);
+    g_assert (ctx);
+
+    if (error) {
+        if (g_error_matches (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_TIMEOUT)) {
+            request->client->requests_timed_out++;
+            ctx->requests_timed_out++;
+        }
+        return;
+    }
+
+    device_latency = g_get_monotonic_time () - request->dispatch_time;
+    _mbim_proxy_helper_latency_histogram_add (&request->client->device_latency, device_latency);
+    _mbim_proxy_helper_latency_histogram_add (&ctx->device_latency, device_latency);
+}
+
+static void
+stats_indication_forwarded (Client *client)
+{
+    client->indications_forwarded++;
+    device_context_get (client->device)->indications_forwarded++;
 }
 
+static void
+stats_cache_hit (Client *client)
+{
+    client->cache_hits++;
+    if (client->device)
+        device_context_get (client->device)->cache_hits++;
+}
+
+static void
+proxy_device_indication_cb (MbimDevice  *device,
+                            MbimMessage *message,
+                            MbimProxy   *self)
+{
+    Shard *shard;
+
+    shard = device_peek_shard (device);
+    shard_lock (shard);
+    device_context_get (device)->indications_received++;
+    shard_unlock (shard);
+}
+
+static void
+append_ref_struct (MbimStructBuilder *builder,
+                   GByteArray        *raw)
+{
+    static const guint8 padding = 0x00;
+    guint32             offset_offset;
+    guint32             offset;
+    guint32             length;
+
+    /* Same layout as the ref-struct-array items built by the generated code:
+     * offset (updated when the builder is completed) and length in the fixed
+     * buffer, and the struct itself in the variable buffer */
+    offset_offset = builder->fixed_buffer->len;
+    offset = builder->variable_buffer->len;
+    g_byte_array_append (builder->fixed_buffer, (guint8 *)&offset, sizeof (offset));
+    g_array_append_val (builder->offsets, offset_offset);
+
+    length = GUINT32_TO_LE (raw->len);
+    g_byte_array_append (builder->fixed_buffer, (guint8 *)&length, sizeof (length));
+
+    g_byte_array_append (builder->variable_buffer, raw->data, raw->len);
+    while (builder->variable_buffer->len % 4 != 0)
+        g_byte_array_append (builder->variable_buffer, &padding, sizeof (padding));
+}
+
+static void
+append_latency_percentiles (MbimStructBuilder               *builder,
+                            const MbimProxyLatencyHistogram *histogram)
+{
+    _mbim_struct_builder_append_guint32 (builder, _mbim_proxy_helper_latency_histogram_percentile (histogram, 50));
+    _mbim_struct_builder_append_guint32 (builder, _mbim_proxy_helper_latency_histogram_percentile (histogram, 90));
+    _mbim_struct_builder_append_guint32 (builder, _mbim_proxy_helper_latency_histogram_percentile (histogram, 99));
+}
+
+static GByteArray *
+build_device_statistics (MbimDevice *device)
+{
+    MbimStructBuilder *builder;
+    DeviceContext     *ctx;
+    guint              n_clients = 0;
+    GList             *l;
+
+    ctx = device_context_get (device);
+    g_assert (ctx);
+
+    /* All the clients of the device are run in the same shard */
+    for (l = ctx->shard->clients; l; l = g_list_next (l)) {
+        if (((Client *)(l->data))->device == device)
+            n_clients++;
+    }
+
+    builder = _mbim_struct_builder_new ();
+    _mbim_struct_builder_append_string  (builder, mbim_device_get_path (device));
+    _mbim_struct_builder_append_guint32 (builder, n_clients);
+    _mbim_struct_builder_append_guint64 (builder, ctx->requests_forwarded);
+    _mbim_struct_builder_append_guint64 (builder, ctx->requests_timed_out);
+    _mbim_struct_builder_append_guint32 (builder, ctx->n_abandoned_queued);
+    _mbim_struct_builder_append_guint32 (builder, ctx->n_abandoned_in_flight);
+    _mbim_struct_builder_append_guint32 (builder, ctx->n_queued);
+    _mbim_struct_builder_append_guint32 (builder, ctx->max_queued);
+    _mbim_struct_builder_append_guint32 (builder, ctx->queued_bytes);
+    append_latency_percentiles (builder, &ctx->device_latency);
+    append_latency_percentiles (builder, &ctx->queue_latency);
+    _mbim_struct_builder_append_guint64 (builder, ctx->indications_received);
+    _mbim_struct_builder_append_guint64 (builder, ctx->indications_forwarded);
+    _mbim_struct_builder_append_guint64 (builder, ctx->cache_hits);
+    return _mbim_struct_builder_complete (builder);
+}
+
+static GByteArray *
+build_client_statistics (Client *client)
+{
+    MbimStructBuilder *builder;
+
+    builder = _mbim_struct_builder_new ();
+    _mbim_struct_builder_append_guint32 (builder, (guint32) client->id);
+    _mbim_struct_builder_append_string  (builder, client->device ? mbim_device_get_path (client->device) : NULL);
+    _mbim_struct_builder_append_guint64 (builder, client->requests_forwarded);
+    _mbim_struct_builder_append_guint64 (builder, client->requests_timed_out);
+    _mbim_struct_builder_append_guint32 (builder, client->n_in_flight);
+    _mbim_struct_builder_append_guint32 (builder, g_queue_get_length (client->pending));
+    _mbim_struct_builder_append_guint32 (builder, client->queued_bytes);
+    append_latency_percentiles (builder, &client->device_latency);
+    append_latency_percentiles (builder, &client->queue_latency);
+    _mbim_struct_builder_append_guint64 (builder, client->indications_forwarded);
+    _mbim_struct_builder_append_guint64 (builder, client->cache_hits);
+    _mbim_struct_builder_append_guint32 (builder, client->weight);
+    _mbim_struct_builder_append_guint32 (builder, (guint32) g_atomic_int_get (&client->outgoing_bytes));
+    return _mbim_struct_builder_complete (builder);
+}
+
+static gboolean
+statistics_complete (Request *request)
+{
+    Shard *shard = request->client->shard;
+
+    shard_lock (shard);
+    request_complete_and_free (request);
+    shard_unlock (shard);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+statistics_collect (Request *request)
+{
+    MbimStructBuilder     *builder;
+    g_autoptr(GPtrArray)   shards = NULL;
+    g_autoptr(GPtrArray)   devices = NULL;
+    g_autoptr(GPtrArray)   clients = NULL;
+    g_autoptr(GByteArray)  buffer = NULL;
+    GList                 *l;
+    guint                  i;
+
+    devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_byte_array_unref);
+    clients = g_ptr_array_new_with_free_func ((GDestroyNotify) g_byte_array_unref);
+
+    /* Only one shard is locked at a time */
+    shards = peek_all_shards (request->self);
+    for (i = 0; i < shards->len; i++) {
+        Shard *shard;
+
+        shard = g_ptr_array_index (shards, i);
+        shard_lock (shard);
+        for (l = shard->devices; l; l = g_list_next (l))
+            g_ptr_array_add (devices, build_device_statistics ((MbimDevice *)(l->data)));
+        for (l = shard->clients; l; l = g_list_next (l))
+            g_ptr_array_add (clients, build_client_statistics ((Client *)(l->data)));
+        shard_unlock (shard);
+    }
+
+    builder = _mbim_struct_builder_new ();
+    _mbim_struct_builder_append_guint32 (builder, devices->len);
+    for (i = 0; i < devices->len; i++)
+        append_ref_struct (builder, g_ptr_array_index (devices, i));
+    _mbim_struct_builder_append_guint32 (builder, clients->len);
+    for (i = 0; i < clients->len; i++)
+        append_ref_struct (builder, g_ptr_array_index (clients, i));
+    buffer = _mbim_struct_builder_complete (builder);
+    request->response = build_proxy_control_command_done_full (request->message, MBIM_STATUS_ERROR_NONE, buffer->data, buffer->len);
+
+    /* The client may have been moved to a different shard in the meantime,
+     * the response is always sent from the one running it */
+    shard_attach_idle (request->client->shard, (GSourceFunc) statistics_complete, request);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+process_internal_proxy_statistics (MbimProxy   *self,
+                                   Client      *client,
+                                   MbimMessage *message)
+{
+    Request *request;
+
+    /* create request holder */
+    request = request_new (self, client, message);
+
+    g_debug ("[client %lu,0x%08x] request to query proxy statistics",
+             request->client->id, request->original_transaction_id);
+
+    /* Only allow QUERY command */
+    if (mbim_message_command_get_command_type (message) != MBIM_MESSAGE_COMMAND_TYPE_QUERY) {
+        g_warning ("[client %lu,0x%08x] cannot query proxy statistics: invalid request type",
+                   request->client->id, request->original_transaction_id);
+        request->response = build_proxy_control_command_done (message, MBIM_STATUS_ERROR_INVALID_PARAMETERS);
+        request_complete_and_free (request);
+        return TRUE;
+    }
+
+    /* Other shards need to be locked to collect their statistics, and that
+     * is never done while holding the lock of the client shard */
+    shard_attach_idle (client->shard, (GSourceFunc) statistics_collect, request);
+    return TRUE;
+}
+
+gboolean
+mbim_proxy_get_device_queue_depth (MbimProxy   *self,
+                                   const gchar *path,
+                                   guint       *out_n_queued,
+                                   guint       *out_max_queued)
+{
+    Shard         *shard;
+    MbimDevice    *device;
+    DeviceContext *ctx;
+
+    g_return_val_if_fail (MBIM_IS_PROXY (self), FALSE);
+    g_return_val_if_fail (path != NULL, FALSE);
+
+    shard = lookup_shard_for_path (self, path);
+    if (!shard)
+        return FALSE;
+
+    shard_lock (shard);
+
+    device = peek_device_for_path (shard, path);
+    if (!device) {
+        shard_unlock (shard);
+        return FALSE;
+    }
+
+    ctx = device_context_get (device);
+    if (out_n_queued)
+        *out_n_queued = ctx->n_queued;
+    if (out_max_queued)
+        *out_max_queued = ctx->max_queued;
+
+    shard_unlock (shard);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 static void
 proxy_device_error_cb (MbimDevice *device,
                        GError     *error,
                        MbimProxy  *self)
 {
     if (g_error_matches (error, MBIM_PROTOCOL_ERROR, MBIM_PROTOCOL_ERROR_NOT_OPENED)) {
+        Shard *shard;
+
         g_debug ("[%s] reports as being closed...", mbim_device_get_path (device));
+        shard = device_peek_shard (device);
+        shard_lock (shard);
         reset_client_service_subscribe_lists (self, device);
         mbim_device_close_force (device, NULL);
+        shard_unlock (shard);
     }
 }
 
 static MbimDevice *
-peek_device_for_path (MbimProxy   *self,
+peek_device_for_path (Shard       *shard,
                       const gchar *path)
 {
     GList *l;
 
-    for (l = self->priv->devices; l; l = g_list_next (l)) {
+    for (l = shard->devices; l; l = g_list_next (l)) {
         /* Return if found */
         if (g_str_equal (mbim_device_get_path ((MbimDevice *)l->data), path))
             return (MbimDevice *)l->data;
@@ -1520,30 +3238,38 @@ static void
 proxy_device_removed_cb (MbimDevice *device,
                          MbimProxy  *self)
 {
+    Shard *shard;
+
+    shard = device_peek_shard (device);
+    shard_lock (shard);
     untrack_device (self, device);
+    shard_unlock (shard);
 }
 
 static void
 untrack_device (MbimProxy  *self,
                 MbimDevice *device)
 {
+    Shard *shard;
     GList *l;
     GList *to_remove = NULL;
 
     g_debug ("[%s] untracking device...", mbim_device_get_path (device));
 
-    if (!g_list_find (self->priv->devices, device))
+    shard = device_peek_shard (device);
+    if (!g_list_find (shard->devices, device))
         return;
 
     /* Disconnect right away */
     g_signal_handlers_disconnect_by_func (device, proxy_device_error_cb, self);
     g_signal_handlers_disconnect_by_func (device, proxy_device_removed_cb, self);
+    g_signal_handlers_disconnect_by_func (device, proxy_device_indication_cb, self);
 
     /* If pending openings ongoing, complete them with error */
     cancel_opening_device (self, device);
 
     /* Lookup all clients with this device */
-    for (l = self->priv->clients; l; l = g_list_next (l)) {
+    for (l = shard->clients; l; l = g_list_next (l)) {
         if (((Client *)(l->data))->device == device)
             to_remove = g_list_append (to_remove, l->data);
     }
@@ -1553,16 +3279,24 @@ untrack_device (MbimProxy  *self,
         untrack_client (self, (Client *)(l->data));
     g_list_free (to_remove);
 
+    /* Devices kept open are opened again once they're back */
+    keep_open_schedule_retry (self, mbim_device_get_path (device));
+
     /* And finally, remove the device */
-    self->priv->devices = g_list_remove (self->priv->devices, device);
+    shard->devices = g_list_remove (shard->devices, device);
+    g_atomic_int_add (&self->priv->n_devices, -1);
     g_object_unref (device);
-    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_DEVICES]);
+    proxy_notify (self, PROP_N_DEVICES);
 }
 
 static void
 track_device (MbimProxy *self,
+              Shard *shard,
               MbimDevice *device)
 {
+    /* The device is run in the given shard from now on */
+    device_context_get (device)->shard = shard;
+
     g_signal_connect (device,
                       MBIM_DEVICE_SIGNAL_REMOVED,
                       G_CALLBACK (proxy_device_removed_cb),
@@ -1573,8 +3307,541 @@ track_device (MbimProxy *self,
                       G_CALLBACK (proxy_device_error_cb),
                       self);
 
-    self->priv->devices = g_list_append (self->priv->devices, g_object_ref (device));
-    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_DEVICES]);
+    g_signal_connect (device,
+                      MBIM_DEVICE_SIGNAL_INDICATE_STATUS,
+                      G_CALLBACK (proxy_device_indication_cb),
+                      self);
+
+    shard->devices = g_list_append (shard->devices, g_object_ref (device));
+    g_atomic_int_inc (&self->priv->n_devices);
+    proxy_notify (self, PROP_N_DEVICES);
+}
+
+/*****************************************************************************/
+/* State handoff */
+
+#define STATE_KEY_TRANSACTION_ID    "transaction-id"
+#define STATE_KEY_MBIM_VERSION      "mbim-version"
+#define STATE_KEY_MS_MBIMEX_VERSION "ms-mbimex-version"
+#define STATE_KEY_SUBSCRIBE_LIST    "subscribe-list"
+
+/* No message is exchanged with the device when resuming the MBIM session,
+ * this is just to open the port */
+#define RESTORE_OPEN_TIMEOUT_SECS 10
+
+gboolean
+mbim_proxy_save_state (MbimProxy    *self,
+                       const gchar  *path,
+                       GError      **error)
+{
+    g_autoptr(GKeyFile)  key_file = NULL;
+    g_autoptr(GPtrArray) shards = NULL;
+    GList               *l;
+    guint                i;
+
+    g_return_val_if_fail (MBIM_IS_PROXY (self), FALSE);
+    g_return_val_if_fail (path != NULL, FALSE);
+
+    key_file = g_key_file_new ();
+
+    shards = peek_all_shards (self);
+    for (i = 0; i < shards->len; i++) {
+        Shard *shard;
+
+        shard = g_ptr_array_index (shards, i);
+        shard_lock (shard);
+        for (l = shard->devices; l; l = g_list_next (l)) {
+            MbimDevice    *device;
+            DeviceContext *ctx;
+            MbimMessage   *indication;
+            const gchar   *device_path;
+            g_auto(GStrv)  subscribe_list = NULL;
+            guint16        mbim_version;
+            guint16        ms_mbimex_version;
+
+            /* Only devices fully open can be resumed */
+            device = l->data;
+            if (!mbim_device_is_open (device))
+                continue;
+
+            device_path = mbim_device_get_path (device);
+            ctx = device_context_get (device);
+
+            g_key_file_set_uint64 (key_file, device_path, STATE_KEY_TRANSACTION_ID, mbim_device_get_transaction_id (device));
+
+            indication = (MbimMessage *) g_object_get_data (G_OBJECT (device), MBIM_DEVICE_PROXY_CONTROL_VERSION);
+            if (indication && mbim_message_proxy_control_version_notification_parse (indication, &mbim_version, &ms_mbimex_version, NULL)) {
+                g_key_file_set_integer (key_file, device_path, STATE_KEY_MBIM_VERSION, mbim_version);
+                g_key_file_set_integer (key_file, device_path, STATE_KEY_MS_MBIMEX_VERSION, ms_mbimex_version);
+            }
+
+            subscribe_list = _mbim_proxy_helper_service_subscribe_list_to_strv ((const MbimEventEntry * const *)ctx->mbim_event_entry_array,
+                                                                                ctx->mbim_event_entry_array_size);
+            g_key_file_set_string_list (key_file, device_path, STATE_KEY_SUBSCRIBE_LIST,
+                                        (const gchar * const *)subscribe_list, g_strv_length (subscribe_list));
+
+            g_debug ("[%s] device state saved", device_path);
+        }
+        shard_unlock (shard);
+    }
+
+    return g_key_file_save_to_file (key_file, path, error);
+}
+
+typedef struct {
+    MbimProxy       *self;
+    gchar           *path;
+    guint32          transaction_id;
+    guint16          mbim_version;
+    guint16          ms_mbimex_version;
+    MbimEventEntry **subscribe_list;
+    gsize            subscribe_list_size;
+} RestoreContext;
+
+static void
+restore_context_free (RestoreContext *ctx)
+{
+    g_clear_pointer (&ctx->subscribe_list, mbim_event_entry_array_free);
+    g_free (ctx->path);
+    g_object_unref (ctx->self);
+    g_slice_free (RestoreContext, ctx);
+}
+
+static void
+restore_device_open_ready (MbimProxy      *self,
+                           GAsyncResult   *res,
+                           RestoreContext *ctx)
+{
+    g_autoptr(GError)  error = NULL;
+    MbimDevice        *device;
+    Shard             *shard;
+
+    shard = peek_shard_for_path (self, ctx->path);
+    shard_lock (shard);
+
+    if (!internal_device_open_finish (self, res, &error))
+        g_warning ("[%s] couldn't restore device: %s", ctx->path, error->message);
+    else
+        g_debug ("[%s] device restored", ctx->path);
+
+    /* Any later reopen must go through the whole open sequence */
+    device = peek_device_for_path (shard, ctx->path);
+    if (device)
+        g_object_set (device, MBIM_DEVICE_IN_SESSION, FALSE, NULL);
+
+    shard_unlock (shard);
+
+    restore_context_free (ctx);
+}
+
+static void
+restore_device_new_ready (GObject        *source,
+                          GAsyncResult   *res,
+                          RestoreContext *ctx)
+{
+    MbimProxy             *self = ctx->self;
+    g_autoptr(MbimDevice)  device = NULL;
+    g_autoptr(GError)      error = NULL;
+    DeviceContext         *device_ctx;
+    Shard                 *shard;
+
+    device = mbim_device_new_finish (res, &error);
+    if (!device) {
+        g_warning ("[%s] couldn't restore device: %s", ctx->path, error->message);
+        restore_context_free (ctx);
+        return;
+    }
+
+    shard = peek_shard_for_path (self, ctx->path);
+    shard_lock (shard);
+
+    /* A client may have added the device in the meantime */
+    if (peek_device_for_path (shard, mbim_device_get_path (device))) {
+        g_debug ("[%s] device already available: not restored", ctx->path);
+        shard_unlock (shard);
+        restore_context_free (ctx);
+        return;
+    }
+
+    /* Reuse the MBIM session established by the previous proxy instance */
+    g_object_set (device,
+                  MBIM_DEVICE_IN_SESSION,     TRUE,
+                  MBIM_DEVICE_TRANSACTION_ID, ctx->transaction_id,
+                  NULL);
+
+    if (ctx->ms_mbimex_version) {
+        mbim_device_set_ms_mbimex_version (device, ctx->ms_mbimex_version >> 8, ctx->ms_mbimex_version & 0xFF, NULL);
+        g_object_set_data_full (G_OBJECT (device),
+                                MBIM_DEVICE_PROXY_CONTROL_VERSION,
+                                build_proxy_control_version_notification (ctx->mbim_version, ctx->ms_mbimex_version),
+                                (GDestroyNotify)mbim_message_unref);
+    }
+
+    track_device (self, shard, device);
+
+    /* The device keeps the subscribe list configured by the previous instance */
+    device_ctx = device_context_get (device);
+    g_clear_pointer (&device_ctx->mbim_event_entry_array, mbim_event_entry_array_free);
+    device_ctx->mbim_event_entry_array = g_steal_pointer (&ctx->subscribe_list);
+    device_ctx->mbim_event_entry_array_size = ctx->subscribe_list_size;
+
+    internal_device_open (self,
+                          device,
+                          RESTORE_OPEN_TIMEOUT_SECS,
+                          (GAsyncReadyCallback)restore_device_open_ready,
+                          ctx);
+
+    shard_unlock (shard);
+}
+
+static gboolean
+restore_device_start (RestoreContext *ctx)
+{
+    g_autoptr(GFile) file = NULL;
+
+    g_debug ("[%s] restoring device...", ctx->path);
+    file = g_file_new_for_path (ctx->path);
+    mbim_device_new (file, NULL, (GAsyncReadyCallback)restore_device_new_ready, ctx);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean
+mbim_proxy_restore_state (MbimProxy    *self,
+                          const gchar  *path,
+                          GError      **error)
+{
+    g_autoptr(GKeyFile)  key_file = NULL;
+    g_auto(GStrv)        groups = NULL;
+    guint                i;
+
+    g_return_val_if_fail (MBIM_IS_PROXY (self), FALSE);
+    g_return_val_if_fail (path != NULL, FALSE);
+
+    key_file = g_key_file_new ();
+    if (!g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, error)) {
+        g_prefix_error (error, "Couldn't load proxy state: ");
+        return FALSE;
+    }
+
+    groups = g_key_file_get_groups (key_file, NULL);
+    for (i = 0; groups[i]; i++) {
+        RestoreContext    *ctx;
+        Shard             *shard;
+        g_auto(GStrv)      subscribe_list = NULL;
+        g_autoptr(GError)  inner_error = NULL;
+
+        ctx = g_slice_new0 (RestoreContext);
+        ctx->self = g_object_ref (self);
+        ctx->path = g_strdup (groups[i]);
+        ctx->transaction_id = (guint32) g_key_file_get_uint64 (key_file, groups[i], STATE_KEY_TRANSACTION_ID, NULL);
+        ctx->mbim_version = (guint16) g_key_file_get_integer (key_file, groups[i], STATE_KEY_MBIM_VERSION, NULL);
+        ctx->ms_mbimex_version = (guint16) g_key_file_get_integer (key_file, groups[i], STATE_KEY_MS_MBIMEX_VERSION, NULL);
+
+        subscribe_list = g_key_file_get_string_list (key_file, groups[i], STATE_KEY_SUBSCRIBE_LIST, NULL, NULL);
+        if (subscribe_list)
+            ctx->subscribe_list = _mbim_proxy_helper_service_subscribe_list_from_strv ((const gchar * const *)subscribe_list,
+                                                                                       &ctx->subscribe_list_size,
+                                                                                       &inner_error);
+        if (!ctx->subscribe_list) {
+            g_warning ("[%s] assuming standard subscribe list: %s", ctx->path,
+                       inner_error ? inner_error->message : "not found in state");
+            ctx->subscribe_list = _mbim_proxy_helper_service_subscribe_list_new_standard (&ctx->subscribe_list_size);
+        }
+
+        /* Devices are created in the shard they're assigned to */
+        shard = peek_shard_for_path (self, ctx->path);
+        if (shard != self->priv->main_shard)
+            shard_attach_idle (shard, (GSourceFunc) restore_device_start, ctx);
+        else
+            restore_device_start (ctx);
+    }
+
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Devices kept open */
+
+/* The whole MBIM open sequence is run, so be generous */
+#define KEEP_OPEN_TIMEOUT_SECS 30
+
+/* Delay before trying to open again a device kept open, e.g. after it has
+ * been removed or if it failed to open */
+#define KEEP_OPEN_RETRY_SECS 5
+
+typedef struct {
+    MbimProxy *self;
+    gchar     *path;
+} KeepOpenContext;
+
+static void
+keep_open_context_free (KeepOpenContext *ctx)
+{
+    g_free (ctx->path);
+    g_object_unref (ctx->self);
+    g_slice_free (KeepOpenContext, ctx);
+}
+
+static KeepOpenContext *
+keep_open_context_new (MbimProxy   *self,
+                       const gchar *path)
+{
+    KeepOpenContext *ctx;
+
+    ctx = g_slice_new0 (KeepOpenContext);
+    ctx->self = g_object_ref (self);
+    ctx->path = g_strdup (path);
+    return ctx;
+}
+
+/* The retry sources are owned by the proxy and destroyed when disposing it,
+ * so they don't hold a reference */
+typedef struct {
+    MbimProxy *self;
+    gchar     *path;
+} KeepOpenRetry;
+
+static void
+keep_open_retry_free (KeepOpenRetry *retry)
+{
+    g_free (retry->path);
+    g_slice_free (KeepOpenRetry, retry);
+}
+
+static void
+keep_open_retry_clear (GSource *source)
+{
+    if (!source)
+        return;
+    g_source_destroy (source);
+    g_source_unref (source);
+}
+
+static gboolean keep_open_device_start (KeepOpenContext *ctx);
+
+static void
+keep_open_subscribe_list_ready (MbimDevice      *device,
+                                GAsyncResult    *res,
+                                KeepOpenContext *ctx)
+{
+    g_autoptr(MbimMessage) response = NULL;
+    g_autoptr(GError)      error = NULL;
+
+    response = mbim_device_command_finish (device, res, &error);
+    if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error))
+        g_warning ("[%s] couldn't subscribe device kept open: %s", ctx->path, error->message);
+    else
+        g_debug ("[%s] device kept open and subscribed", ctx->path);
+
+    keep_open_context_free (ctx);
+}
+
+static void
+keep_open_device_open_ready (MbimProxy       *self,
+                             GAsyncResult    *res,
+                             KeepOpenContext *ctx)
+{
+    g_autoptr(GError)       error = NULL;
+    g_autoptr(MbimMessage)  request = NULL;
+    MbimDevice             *device;
+    DeviceContext          *device_ctx;
+    Shard                  *shard;
+
+    shard = peek_shard_for_path (self, ctx->path);
+    shard_lock (shard);
+
+    /* If the open failed the device is untracked, which already schedules
+     * a new attempt */
+    if (!internal_device_open_finish (self, res, &error)) {
+        g_warning ("[%s] couldn't open device kept open: %s", ctx->path, error->message);
+        goto out;
+    }
+
+    device = peek_device_for_path (shard, ctx->path);
+    if (!device) {
+        g_debug ("[%s] device kept open is gone", ctx->path);
+        goto out;
+    }
+
+    /* Explicitly set the merged subscribe list, which is the standard one
+     * unless clients already updated it, so that indications flow without
+     * waiting for the first client to request them */
+    device_ctx = device_context_get (device);
+    request = mbim_message_device_service_subscribe_list_set_new (device_ctx->mbim_event_entry_array_size,
+                                                                  (const MbimEventEntry *const *)device_ctx->mbim_event_entry_array,
+                                                                  NULL);
+    mbim_message_set_transaction_id (request, mbim_device_get_next_transaction_id (device));
+
+    g_debug ("[%s] subscribing device kept open...", ctx->path);
+    mbim_device_command (device,
+                         request,
+                         10,
+                         NULL,
+                         (GAsyncReadyCallback)keep_open_subscribe_list_ready,
+                         ctx);
+    shard_unlock (shard);
+    return;
+
+out:
+    shard_unlock (shard);
+    keep_open_context_free (ctx);
+}
+
+static void
+keep_open_device_new_ready (GObject         *source,
+                            GAsyncResult    *res,
+                            KeepOpenContext *ctx)
+{
+    MbimProxy             *self = ctx->self;
+    g_autoptr(MbimDevice)  device = NULL;
+    g_autoptr(GError)      error = NULL;
+    MbimDevice            *existing;
+    Shard                 *shard;
+
+    device = mbim_device_new_finish (res, &error);
+
+    shard = peek_shard_for_path (self, ctx->path);
+    shard_lock (shard);
+
+    if (!device) {
+        g_warning ("[%s] couldn't create device kept open: %s", ctx->path, error->message);
+        keep_open_schedule_retry (self, ctx->path);
+        shard_unlock (shard);
+        keep_open_context_free (ctx);
+        return;
+    }
+
+    /* A client may have added the device in the meantime; it is still
+     * checked, and the subscribe list is set anyway */
+    existing = peek_device_for_path (shard, mbim_device_get_path (device));
+    if (existing) {
+        g_debug ("[%s] device kept open already available", ctx->path);
+        g_object_unref (device);
+        device = g_object_ref (existing);
+    } else
+        track_device (self, shard, device);
+
+    internal_device_open (self,
+                          device,
+                          KEEP_OPEN_TIMEOUT_SECS,
+                          (GAsyncReadyCallback)keep_open_device_open_ready,
+                          ctx);
+
+    shard_unlock (shard);
+}
+
+static gboolean
+keep_open_device_start (KeepOpenContext *ctx)
+{
+    g_autoptr(GFile) file = NULL;
+
+    g_debug ("[%s] opening device kept open...", ctx->path);
+    file = g_file_new_for_path (ctx->path);
+    mbim_device_new (file, NULL, (GAsyncReadyCallback)keep_open_device_new_ready, ctx);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+keep_open_retry_cb (KeepOpenRetry *retry)
+{
+    MbimProxy        *self = retry->self;
+    g_autofree gchar *path = NULL;
+    Shard            *shard;
+
+    proxy_lock (self);
+
+    /* Removing the retry source from the table destroys it, so the path
+     * must be copied first */
+    path = g_strdup (retry->path);
+    g_hash_table_insert (self->priv->keep_open_paths, g_strdup (path), NULL);
+
+    proxy_unlock (self);
+
+    /* Already running in the context the device is assigned to */
+    shard = peek_shard_for_path (self, path);
+    shard_lock (shard);
+    if (!peek_device_for_path (shard, path))
+        keep_open_device_start (keep_open_context_new (self, path));
+    shard_unlock (shard);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+keep_open_schedule_retry (MbimProxy   *self,
+                          const gchar *path)
+{
+    KeepOpenRetry *retry;
+    GSource       *source;
+    Shard         *shard;
+
+    /* The shard lookup takes the proxy lock itself */
+    shard = peek_shard_for_path (self, path);
+
+    proxy_lock (self);
+
+    /* Only paths kept open, and only once; never while disposing */
+    if (!self->priv->keep_open_paths ||
+        !g_hash_table_contains (self->priv->keep_open_paths, path) ||
+        g_hash_table_lookup (self->priv->keep_open_paths, path)) {
+        proxy_unlock (self);
+        return;
+    }
+
+    g_debug ("[%s] opening device kept open again in %u secs...", path, KEEP_OPEN_RETRY_SECS);
+
+    retry = g_slice_new0 (KeepOpenRetry);
+    retry->self = self;
+    retry->path = g_strdup (path);
+
+    source = g_timeout_source_new_seconds (KEEP_OPEN_RETRY_SECS);
+    g_source_set_callback (source, (GSourceFunc) keep_open_retry_cb, retry, (GDestroyNotify) keep_open_retry_free);
+    g_source_attach (source, shard->context);
+    g_hash_table_insert (self->priv->keep_open_paths, g_strdup (path), source);
+
+    proxy_unlock (self);
+}
+
+gboolean
+mbim_proxy_keep_device_open (MbimProxy    *self,
+                             const gchar  *path,
+                             GError      **error)
+{
+    g_autofree gchar *devpath = NULL;
+    KeepOpenContext  *ctx;
+    Shard            *shard;
+
+    g_return_val_if_fail (MBIM_IS_PROXY (self), FALSE);
+    g_return_val_if_fail (path != NULL, FALSE);
+
+    /* Devices are tracked with their real path, the same one clients
+     * configure, so a symlink must not end up opening it twice */
+    devpath = mbim_helpers_get_devpath (path, error);
+    if (!devpath) {
+        g_prefix_error (error, "Couldn't lookup real device path: ");
+        return FALSE;
+    }
+
+    proxy_lock (self);
+
+    if (g_hash_table_contains (self->priv->keep_open_paths, devpath)) {
+        g_debug ("[%s] device already kept open", devpath);
+        proxy_unlock (self);
+        return TRUE;
+    }
+    g_hash_table_insert (self->priv->keep_open_paths, g_strdup (devpath), NULL);
+
+    proxy_unlock (self);
+
+    /* Devices are created in the shard they're assigned to */
+    ctx = keep_open_context_new (self, devpath);
+    shard = peek_shard_for_path (self, devpath);
+    if (shard != self->priv->main_shard)
+        shard_attach_idle (shard, (GSourceFunc) keep_open_device_start, ctx);
+    else
+        keep_open_device_start (ctx);
+
+    return TRUE;
 }
 
 /*****************************************************************************/
@@ -1606,6 +3873,39 @@ static void
 mbim_proxy_init (MbimProxy *self)
 {
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, MBIM_TYPE_PROXY, MbimProxyPrivate);
+    self->priv->client_max_in_flight = CLIENT_MAX_IN_FLIGHT_DEFAULT;
+    self->priv->context = g_main_context_ref_thread_default ();
+    self->priv->main_shard = shard_new_main (self->priv->context);
+    self->priv->keep_open_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) keep_open_retry_clear);
+    g_mutex_init (&self->priv->lock);
+}
+
+static void
+set_property (GObject      *object,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+    MbimProxy *self = MBIM_PROXY (object);
+
+    proxy_lock (self);
+    switch (prop_id) {
+    case PROP_CLIENT_MAX_IN_FLIGHT:
+        g_atomic_int_set (&self->priv->client_max_in_flight, g_value_get_uint (value));
+        break;
+    case PROP_N_SHARDS:
+        /* Shard threads are started with the first client bound to a device,
+         * the number of shards cannot be changed afterwards */
+        if (self->priv->shards)
+            g_warning ("cannot change the number of shards: already running");
+        else
+            self->priv->n_shards = g_value_get_uint (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+    proxy_unlock (self);
 }
 
 static void
@@ -1616,36 +3916,60 @@ get_property (GObject    *object,
 {
     MbimProxy *self = MBIM_PROXY (object);
 
+    proxy_lock (self);
     switch (prop_id) {
     case PROP_N_CLIENTS:
-        g_value_set_uint (value, g_list_length (self->priv->clients));
+        g_value_set_uint (value, (guint) g_atomic_int_get (&self->priv->n_clients));
         break;
     case PROP_N_DEVICES:
-        g_value_set_uint (value, g_list_length (self->priv->devices));
+        g_value_set_uint (value, (guint) g_atomic_int_get (&self->priv->n_devices));
+        break;
+    case PROP_CLIENT_MAX_IN_FLIGHT:
+        g_value_set_uint (value, (guint) g_atomic_int_get (&self->priv->client_max_in_flight));
+        break;
+    case PROP_N_SHARDS:
+        g_value_set_uint (value, self->priv->n_shards);
         break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
     }
+    proxy_unlock (self);
 }
 
 static void
-dispose (GObject *object)
+shard_clear (Shard *shard)
 {
-    MbimProxyPrivate *priv = MBIM_PROXY (object)->priv;
-
     /* This list should always be empty when disposing */
-    g_assert (priv->opening_devices == NULL);
+    g_assert (shard->opening_devices == NULL);
 
-    if (priv->clients) {
-        g_list_free_full (priv->clients, (GDestroyNotify) client_unref);
-        priv->clients = NULL;
+    if (shard->clients) {
+        g_list_free_full (shard->clients, (GDestroyNotify) client_unref);
+        shard->clients = NULL;
     }
 
-    if (priv->devices) {
-        g_list_free_full (priv->devices, g_object_unref);
-        priv->devices = NULL;
+    if (shard->devices) {
+        g_list_free_full (shard->devices, g_object_unref);
+        shard->devices = NULL;
     }
+}
+
+static void
+dispose (GObject *object)
+{
+    MbimProxyPrivate *priv = MBIM_PROXY (object)->priv;
+
+    /* Stop all shard threads before releasing the clients and devices
+     * they were running; the shard contexts are kept around until then */
+    if (priv->shards)
+        g_ptr_array_foreach (priv->shards, (GFunc) shard_stop, NULL);
+
+    /* No more attempts to open devices kept open */
+    g_clear_pointer (&priv->keep_open_paths, g_hash_table_unref);
+
+    shard_clear (priv->main_shard);
+    if (priv->shards)
+        g_ptr_array_foreach (priv->shards, (GFunc) shard_clear, NULL);
 
     if (priv->socket_service) {
         if (g_socket_service_is_active (priv->socket_service))
@@ -1654,9 +3978,24 @@ dispose (GObject *object)
         g_debug ("UNIX socket service at '%s' stopped", MBIM_PROXY_SOCKET_PATH);
     }
 
+    g_clear_pointer (&priv->shards, g_ptr_array_unref);
+    g_clear_pointer (&priv->shard_paths, g_hash_table_unref);
+
     G_OBJECT_CLASS (mbim_proxy_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+    MbimProxyPrivate *priv = MBIM_PROXY (object)->priv;
+
+    shard_free (priv->main_shard);
+    g_mutex_clear (&priv->lock);
+    g_main_context_unref (priv->context);
+
+    G_OBJECT_CLASS (mbim_proxy_parent_class)->finalize (object);
+}
+
 static void
 mbim_proxy_class_init (MbimProxyClass *proxy_class)
 {
@@ -1666,7 +4005,9 @@ mbim_proxy_class_init (MbimProxyClass *proxy_class)
 
     /* Virtual methods */
     object_class->get_property = get_property;
+    object_class->set_property = set_property;
     object_class->dispose = dispose;
+    object_class->finalize = finalize;
 
     /**
      * MbimProxy:mbim-proxy-n-clients
@@ -1697,4 +4038,42 @@ mbim_proxy_class_init (MbimProxyClass *proxy_class)
                            0,
                            G_PARAM_READABLE);
     g_object_class_install_property (object_class, PROP_N_DEVICES, properties[PROP_N_DEVICES]);
+
+    /**
+     * MbimProxy:mbim-proxy-client-max-in-flight
+     *
+     * Maximum number of requests from a single client that may be ongoing in
+     * a device at the same time, or 0 for no limit.
+     *
+     * Since: 1.36
+     */
+    properties[PROP_CLIENT_MAX_IN_FLIGHT] =
+        g_param_spec_uint (MBIM_PROXY_CLIENT_MAX_IN_FLIGHT,
+                           "Client max in flight",
+                           "Maximum number of requests of a client ongoing in a device",
+                           0,
+                           G_MAXUINT,
+                           CLIENT_MAX_IN_FLIGHT_DEFAULT,
+                           G_PARAM_READWRITE);
+    g_object_class_install_property (object_class, PROP_CLIENT_MAX_IN_FLIGHT, properties[PROP_CLIENT_MAX_IN_FLIGHT]);
+
+    /**
+     * MbimProxy:mbim-proxy-n-shards
+     *
+     * Number of worker threads running the devices, each with its own main
+     * context, or 0 to run everything in the main context. Devices are
+     * assigned to shards when the first client is bound to them, and the
+     * client is then moved to the shard running its device.
+     *
+     * Since: 1.36
+     */
+    properties[PROP_N_SHARDS] =
+        g_param_spec_uint (MBIM_PROXY_N_SHARDS,
+                           "Number of shards",
+                           "Number of worker threads running the devices",
+                           0,
+                           MBIM_PROXY_N_SHARDS_MAX,
+                           0,
+                           G_PARAM_READWRITE);
+    g_object_class_install_property (object_class, PROP_N_SHARDS, properties[PROP_N_SHARDS]);
 }
@@ -53,6 +53,17 @@ typedef struct _MbimProxyPrivate MbimProxyPrivate;
  */
 #define MBIM_PROXY_SOCKET_PATH "mbim-proxy"
 
+/**
+ * MBIM_PROXY_SEQPACKET_SOCKET_PATH:
+ *
+ * Symbol defining the abstract socket name where the #MbimProxy will listen
+ * for clients using a SOCK_SEQPACKET transport, where each MBIM message or
+ * fragment is sent as a single datagram.
+ *
+ * Since: 1.36
+ */
+#define MBIM_PROXY_SEQPACKET_SOCKET_PATH "mbim-proxy-seqpacket"
+
 /**
  * MBIM_PROXY_N_CLIENTS:
  *
@@ -71,6 +82,35 @@ typedef struct _MbimProxyPrivate MbimProxyPrivate;
  */
 #define MBIM_PROXY_N_DEVICES "mbim-proxy-n-devices"
 
+/**
+ * MBIM_PROXY_CLIENT_MAX_IN_FLIGHT:
+ *
+ * Symbol defining the #MbimProxy:mbim-proxy-client-max-in-flight property.
+ *
+ * Since: 1.36
+ */
+#define MBIM_PROXY_CLIENT_MAX_IN_FLIGHT "mbim-proxy-client-max-in-flight"
+
+/**
+ * MBIM_PROXY_N_SHARDS:
+ *
+ * Symbol defining the #MbimProxy:mbim-proxy-n-shards property.
+ *
+ * Since: 1.36
+ */
+#define MBIM_PROXY_N_SHARDS "mbim-proxy-n-shards"
+
+/**
+ * MBIM_PROXY_N_SHARDS_MAX:
+ *
+ * Maximum value of the #MbimProxy:mbim-proxy-n-shards property. All the
+ * shard threads are started at once, so there's no point in having many
+ * more than CPUs.
+ *
+ * Since: 1.36
+ */
+#define MBIM_PROXY_N_SHARDS_MAX 64
+
 /**
  * MbimProxy:
  *
@@ -127,6 +167,91 @@ guint mbim_proxy_get_n_clients (MbimProxy *self);
  */
 guint mbim_proxy_get_n_devices (MbimProxy *self);
 
+/**
+ * mbim_proxy_get_device_queue_depth:
+ * @self: a #MbimProxy.
+ * @path: the path of the device.
+ * @out_n_queued: (out) (optional): return location for the number of
+ *  requests currently queued in the proxy for the device, or %NULL.
+ * @out_max_queued: (out) (optional): return location for the maximum number
+ *  of requests ever queued in the proxy for the device, or %NULL.
+ *
+ * Gets the depth of the queue of requests waiting to be sent to the device at
+ * @path, i.e. requests received from clients which already have the maximum
+ * number of requests ongoing in the device.
+ *
+ * Returns: %TRUE if the device is managed by the proxy, %FALSE otherwise.
+ *
+ * Since: 1.36
+ */
+gboolean mbim_proxy_get_device_queue_depth (MbimProxy   *self,
+                                            const gchar *path,
+                                            guint       *out_n_queued,
+                                            guint       *out_max_queued);
+
+/**
+ * mbim_proxy_save_state:
+ * @self: a #MbimProxy.
+ * @path: the path of the state file to write.
+ * @error: Return location for error or %NULL.
+ *
+ * Saves the state of the devices currently open by the proxy (transaction ID,
+ * MBIMEx version and merged service subscribe list), so that a new proxy
+ * instance may resume them with mbim_proxy_restore_state() without going
+ * through the whole open sequence again.
+ *
+ * The proxy never closes the MBIM session of the devices it manages, so this
+ * is expected to be called right before the proxy is disposed.
+ *
+ * Returns: %TRUE if the state was saved, %FALSE if @error is set.
+ *
+ * Since: 1.36
+ */
+gboolean mbim_proxy_save_state (MbimProxy    *self,
+                                const gchar  *path,
+                                GError      **error);
+
+/**
+ * mbim_proxy_restore_state:
+ * @self: a #MbimProxy.
+ * @path: the path of the state file to read.
+ * @error: Return location for error or %NULL.
+ *
+ * Restores the state of the devices saved by a previous proxy instance with
+ * mbim_proxy_save_state(). The devices are opened right away, reusing the
+ * MBIM session already established.
+ *
+ * Returns: %TRUE if the state was loaded, %FALSE if @error is set.
+ *
+ * Since: 1.36
+ */
+gboolean mbim_proxy_restore_state (MbimProxy    *self,
+                                   const gchar  *path,
+                                   GError      **error);
+
+/**
+ * mbim_proxy_keep_device_open:
+ * @self: a #MbimProxy.
+ * @path: the path of the device.
+ * @error: Return location for error or %NULL.
+ *
+ * Opens the device at @path right away, without waiting for a client to
+ * request it, and subscribes to the standard set of indications.
+ *
+ * If @path is a symlink, the device it points to is the one kept open, the
+ * same way as when clients request it.
+ *
+ * The device is kept open regardless of the clients using it, and if it is
+ * removed or fails to be opened, it is opened again after a few seconds.
+ *
+ * Returns: %TRUE if the device is kept open, %FALSE if @error is set.
+ *
+ * Since: 1.36
+ */
+gboolean mbim_proxy_keep_device_open (MbimProxy    *self,
+                                      const gchar  *path,
+                                      GError      **error);
+
 G_END_DECLS
 
 #endif /* MBIM_PROXY_H */
@@ -0,0 +1,496 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libmbim-glib -- GLib/GIO based library to control MBIM devices
+ */
+
+#include <config.h>
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/memfd.h>
+
+#include "mbim-shm-transport.h"
+#include "mbim-error-types.h"
+
+/* File sealing may not be exposed by old libc headers */
+#ifndef F_ADD_SEALS
+# define F_ADD_SEALS   1033
+# define F_GET_SEALS   1034
+# define F_SEAL_SEAL   0x0001
+# define F_SEAL_SHRINK 0x0002
+# define F_SEAL_GROW   0x0004
+#endif
+
+#define RING_SIZE_MIN (4 * 1024)
+#define RING_SIZE_MAX (4 * 1024 * 1024)
+
+/* Data not yet written to a full tx ring is kept up to this number of ring
+ * sizes; beyond that the peer is assumed not to be reading */
+#define PENDING_MAX_RINGS 4
+
+/* The indices are free running counters of the bytes written to and read
+ * from the ring, each one updated by a single side. They are kept in
+ * different cache lines, so that producer and consumer don't compete for
+ * the same one. */
+typedef struct {
+    volatile gint head;
+    guint8        padding1[60];
+    volatile gint tail;
+    volatile gint producer_waiting;
+    guint8        padding2[56];
+} RingHeader;
+
+G_STATIC_ASSERT (sizeof (RingHeader) == 128);
+
+typedef struct {
+    RingHeader *header;
+    guint8     *data;
+    /* Own copy of the index updated by this side, as the shared one may be
+     * modified by the peer at any time */
+    guint32     index;
+} Ring;
+
+typedef enum {
+    ROLE_CLIENT,
+    ROLE_PROXY,
+} Role;
+
+struct _MbimShmTransport {
+    Role     role;
+    guint32  ring_size;
+    gint     fds[MBIM_SHM_TRANSPORT_N_FDS];
+    gpointer map;
+    gsize    map_size;
+    Ring     tx;
+    Ring     rx;
+    /* Data not yet written because the tx ring is full */
+    GByteArray *pending;
+};
+
+/*****************************************************************************/
+
+static gint
+get_own_wake_fd (MbimShmTransport *self)
+{
+    return self->fds[self->role == ROLE_CLIENT ? MBIM_SHM_TRANSPORT_FD_CLIENT_WAKE : MBIM_SHM_TRANSPORT_FD_PROXY_WAKE];
+}
+
+static gint
+get_peer_wake_fd (MbimShmTransport *self)
+{
+    return self->fds[self->role == ROLE_CLIENT ? MBIM_SHM_TRANSPORT_FD_PROXY_WAKE : MBIM_SHM_TRANSPORT_FD_CLIENT_WAKE];
+}
+
+static void
+wake (gint fd)
+{
+    guint64 value = 1;
+
+    /* If the counter is about to overflow the peer has pending wakeups
+     * anyway, so EAGAIN is not an issue */
+    while (write (fd, &value, sizeof (value)) < 0 && errno == EINTR);
+}
+
+static void
+wake_ack (gint fd)
+{
+    guint64 value;
+
+    while (read (fd, &value, sizeof (value)) < 0 && errno == EINTR);
+}
+
+/*****************************************************************************/
+
+static gboolean
+ring_produce (MbimShmTransport  *self,
+              const guint8      *data,
+              gsize              data_length,
+              gsize             *out_written,
+              GError           **error)
+{
+    Ring     *ring = &self->tx;
+    gboolean  waiting = FALSE;
+    gsize     written = 0;
+
+    while (written < data_length) {
+        guint32 previous;
+        guint32 used;
+        guint32 n;
+        guint32 offset;
+        guint32 chunk;
+
+        used = ring->index - (guint32) g_atomic_int_get (&ring->header->tail);
+        if (used > self->ring_size) {
+            g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                         "Invalid shared memory ring state: %u bytes used", used);
+            return FALSE;
+        }
+
+        n = (guint32) MIN (data_length - written, (gsize)(self->ring_size - used));
+        if (n == 0) {
+            /* Ask the consumer to wake us up once it frees some space, and
+             * recheck as it may have done so already */
+            if (waiting)
+                break;
+            g_atomic_int_set (&ring->header->producer_waiting, 1);
+            waiting = TRUE;
+            continue;
+        }
+
+        offset = ring->index & (self->ring_size - 1);
+        chunk = MIN (n, self->ring_size - offset);
+        memcpy (ring->data + offset, data + written, chunk);
+        if (n > chunk)
+            memcpy (ring->data, data + written + chunk, n - chunk);
+
+        previous = ring->index;
+        ring->index += n;
+        g_atomic_int_set (&ring->header->head, (gint) ring->index);
+        written += n;
+
+        /* Only if the consumer had already read everything it may be
+         * waiting for a wakeup; the check must be done after publishing the
+         * new head, as the consumer reloads the head after updating the
+         * tail. */
+        if ((guint32) g_atomic_int_get (&ring->header->tail) == previous)
+            wake (get_peer_wake_fd (self));
+    }
+
+    *out_written = written;
+    return TRUE;
+}
+
+static gboolean
+ring_consume (MbimShmTransport  *self,
+              GByteArray        *buffer,
+              GError           **error)
+{
+    Ring  *ring = &self->rx;
+    gsize  total = 0;
+
+    while (TRUE) {
+        guint32 available;
+        guint32 offset;
+        guint32 chunk;
+
+        available = (guint32) g_atomic_int_get (&ring->header->head) - ring->index;
+        if (available == 0)
+            break;
+
+        if (available > self->ring_size) {
+            g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                         "Invalid shared memory ring state: %u bytes available", available);
+            return FALSE;
+        }
+
+        /* Don't let a peer that never stops writing starve everyone else;
+         * wake ourselves up to keep on reading later */
+        if (total >= self->ring_size) {
+            wake (get_own_wake_fd (self));
+            break;
+        }
+
+        offset = ring->index & (self->ring_size - 1);
+        chunk = MIN (available, self->ring_size - offset);
+        g_byte_array_append (buffer, ring->data + offset, chunk);
+        if (available > chunk)
+            g_byte_array_append (buffer, ring->data, available - chunk);
+
+        ring->index += available;
+        g_atomic_int_set (&ring->header->tail, (gint) ring->index);
+        total += available;
+
+        if (g_atomic_int_compare_and_exchange (&ring->header->producer_waiting, 1, 0))
+            wake (get_peer_wake_fd (self));
+    }
+
+    return TRUE;
+}
+
+static gboolean
+flush_pending (MbimShmTransport  *self,
+               GError           **error)
+{
+    gsize written;
+
+    if (!self->pending || !self->pending->len)
+        return TRUE;
+
+    if (!ring_produce (self, self->pending->data, self->pending->len, &written, error))
+        return FALSE;
+
+    if (written)
+        g_byte_array_remove_range (self->pending, 0, written);
+    return TRUE;
+}
+
+gboolean
+_mbim_shm_transport_write (MbimShmTransport  *self,
+                           const guint8      *data,
+                           gsize              data_length,
+                           GError           **error)
+{
+    gsize written = 0;
+
+    /* Keep ordering with any data still pending */
+    if (!flush_pending (self, error))
+        return FALSE;
+
+    /* Messages are either refused or fully queued, never cut; the limit is
+     * checked only while data is already pending, as a message partially
+     * written to the ring must be completed */
+    if (self->pending &&
+        self->pending->len &&
+        self->pending->len + data_length > (gsize) self->ring_size * PENDING_MAX_RINGS) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                     "Peer not reading: %u bytes already pending", self->pending->len);
+        return FALSE;
+    }
+
+    if ((!self->pending || !self->pending->len) &&
+        !ring_produce (self, data, data_length, &written, error))
+        return FALSE;
+
+    if (written < data_length) {
+        if (!self->pending)
+            self->pending = g_byte_array_new ();
+        g_byte_array_append (self->pending, data + written, data_length - written);
+    }
+
+    return TRUE;
+}
+
+gboolean
+_mbim_shm_transport_read (MbimShmTransport  *self,
+                          GByteArray        *buffer,
+                          GError           **error)
+{
+    /* Acknowledge the wakeup before looking at the rings, so that no
+     * later one gets lost */
+    wake_ack (get_own_wake_fd (self));
+
+    /* We may have been woken up because there is free space to write */
+    if (!flush_pending (self, error))
+        return FALSE;
+
+    return ring_consume (self, buffer, error);
+}
+
+/*****************************************************************************/
+
+guint32
+_mbim_shm_transport_get_ring_size (MbimShmTransport *self)
+{
+    return self->ring_size;
+}
+
+gint
+_mbim_shm_transport_get_wake_fd (MbimShmTransport *self)
+{
+    return get_own_wake_fd (self);
+}
+
+GUnixFDList *
+_mbim_shm_transport_get_fd_list (MbimShmTransport  *self,
+                                 GError           **error)
+{
+    g_autoptr(GUnixFDList) fd_list = NULL;
+    guint                  i;
+
+    /* The fds are duplicated when appended */
+    fd_list = g_unix_fd_list_new ();
+    for (i = 0; i < MBIM_SHM_TRANSPORT_N_FDS; i++) {
+        if (g_unix_fd_list_append (fd_list, self->fds[i], error) < 0)
+            return NULL;
+    }
+    return g_steal_pointer (&fd_list);
+}
+
+/*****************************************************************************/
+
+static gboolean
+setup_map (MbimShmTransport  *self,
+           GError           **error)
+{
+    guint8     *map;
+    RingHeader *headers;
+    guint8     *data;
+
+    map = mmap (NULL, self->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, self->fds[MBIM_SHM_TRANSPORT_FD_MEMFD], 0);
+    if (map == MAP_FAILED) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                     "Couldn't map shared memory: %s", g_strerror (errno));
+        return FALSE;
+    }
+    self->map = map;
+
+    /* Both headers first, then the client to proxy ring data, and then the
+     * proxy to client ring data */
+    headers = (RingHeader *) map;
+    data = map + (2 * sizeof (RingHeader));
+    if (self->role == ROLE_CLIENT) {
+        self->tx.header = &headers[0];
+        self->tx.data = data;
+        self->rx.header = &headers[1];
+        self->rx.data = data + self->ring_size;
+    } else {
+        self->rx.header = &headers[0];
+        self->rx.data = data;
+        self->tx.header = &headers[1];
+        self->tx.data = data + self->ring_size;
+    }
+
+    /* Both rings start empty, but the contents are not trusted on the proxy
+     * side; any later inconsistency is detected when processing them */
+    self->tx.index = (guint32) g_atomic_int_get (&self->tx.header->head);
+    self->rx.index = (guint32) g_atomic_int_get (&self->rx.header->tail);
+    return TRUE;
+}
+
+static gboolean
+check_ring_size (guint32   ring_size,
+                 GError  **error)
+{
+    if (ring_size < RING_SIZE_MIN || ring_size > RING_SIZE_MAX || (ring_size & (ring_size - 1))) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                     "Invalid shared memory ring size: %u", ring_size);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static MbimShmTransport *
+transport_new (Role    role,
+               guint32 ring_size)
+{
+    MbimShmTransport *self;
+    guint             i;
+
+    self = g_slice_new0 (MbimShmTransport);
+    self->role = role;
+    self->ring_size = ring_size;
+    self->map_size = 2 * (sizeof (RingHeader) + ring_size);
+    for (i = 0; i < MBIM_SHM_TRANSPORT_N_FDS; i++)
+        self->fds[i] = -1;
+    return self;
+}
+
+MbimShmTransport *
+_mbim_shm_transport_new (guint32   ring_size,
+                         GError  **error)
+{
+    g_autoptr(MbimShmTransport) self = NULL;
+
+    if (!check_ring_size (ring_size, error))
+        return NULL;
+
+    self = transport_new (ROLE_CLIENT, ring_size);
+
+    /* Not all libc versions provide memfd_create() */
+    self->fds[MBIM_SHM_TRANSPORT_FD_MEMFD] = (gint) syscall (SYS_memfd_create, "mbim-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (self->fds[MBIM_SHM_TRANSPORT_FD_MEMFD] < 0) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED,
+                     "Couldn't create shared memory: %s", g_strerror (errno));
+        return NULL;
+    }
+
+    /* The proxy requires the size to be sealed, so that the mapping is
+     * always fully backed */
+    if (ftruncate (self->fds[MBIM_SHM_TRANSPORT_FD_MEMFD], (off_t) self->map_size) < 0 ||
+        fcntl (self->fds[MBIM_SHM_TRANSPORT_FD_MEMFD], F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED,
+                     "Couldn't setup shared memory: %s", g_strerror (errno));
+        return NULL;
+    }
+
+    self->fds[MBIM_SHM_TRANSPORT_FD_PROXY_WAKE] = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    self->fds[MBIM_SHM_TRANSPORT_FD_CLIENT_WAKE] = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (self->fds[MBIM_SHM_TRANSPORT_FD_PROXY_WAKE] < 0 || self->fds[MBIM_SHM_TRANSPORT_FD_CLIENT_WAKE] < 0) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_UNSUPPORTED,
+                     "Couldn't create eventfd: %s", g_strerror (errno));
+        return NULL;
+    }
+
+    if (!setup_map (self, error))
+        return NULL;
+
+    return g_steal_pointer (&self);
+}
+
+MbimShmTransport *
+_mbim_shm_transport_new_from_fds (const gint  *fds,
+                                  guint32      ring_size,
+                                  GError     **error)
+{
+    g_autoptr(MbimShmTransport) self = NULL;
+    struct stat                 st;
+    gint                        seals;
+    guint                       i;
+
+    self = transport_new (ROLE_PROXY, ring_size);
+
+    /* Own the descriptors right away, so that they're closed on error */
+    for (i = 0; i < MBIM_SHM_TRANSPORT_N_FDS; i++)
+        self->fds[i] = fds[i];
+
+    if (!check_ring_size (ring_size, error))
+        return NULL;
+
+    /* The memory is provided by the client, so don't map it unless it is
+     * guaranteed to be large enough for as long as it's mapped */
+    if (fstat (self->fds[MBIM_SHM_TRANSPORT_FD_MEMFD], &st) < 0 ||
+        !S_ISREG (st.st_mode) ||
+        (gsize) st.st_size < self->map_size) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                     "Invalid shared memory: wrong type or size");
+        return NULL;
+    }
+
+    seals = fcntl (self->fds[MBIM_SHM_TRANSPORT_FD_MEMFD], F_GET_SEALS);
+    if (seals < 0 || !(seals & F_SEAL_SHRINK)) {
+        g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                     "Invalid shared memory: size not sealed");
+        return NULL;
+    }
+
+    /* Never block on wakeups */
+    for (i = MBIM_SHM_TRANSPORT_FD_PROXY_WAKE; i < MBIM_SHM_TRANSPORT_N_FDS; i++) {
+        gint flags;
+
+        flags = fcntl (self->fds[i], F_GETFL);
+        if (flags < 0 || fcntl (self->fds[i], F_SETFL, flags | O_NONBLOCK) < 0) {
+            g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS,
+                         "Invalid wakeup descriptor: %s", g_strerror (errno));
+            return NULL;
+        }
+    }
+
+    if (!setup_map (self, error))
+        return NULL;
+
+    return g_steal_pointer (&self);
+}
+
+void
+_mbim_shm_transport_free (MbimShmTransport *self)
+{
+    guint i;
+
+    if (self->map)
+        munmap (self->map, self->map_size);
+    for (i = 0; i < MBIM_SHM_TRANSPORT_N_FDS; i++) {
+        if (self->fds[i] >= 0)
+            close (self->fds[i]);
+    }
+    if (self->pending)
+        g_byte_array_unref (self->pending);
+    g_slice_free (MbimShmTransport, self);
+}
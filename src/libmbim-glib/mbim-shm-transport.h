@@ -0,0 +1,68 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libmbim-glib -- GLib/GIO based library to control MBIM devices
+ *
+ * This is a private non-installed header
+ */
+
+#ifndef _LIBMBIM_GLIB_MBIM_SHM_TRANSPORT_H_
+#define _LIBMBIM_GLIB_MBIM_SHM_TRANSPORT_H_
+
+#if !defined (LIBMBIM_GLIB_COMPILATION)
+#error "This is a private header!!"
+#endif
+
+#include <glib.h>
+#include <gio/gunixfdlist.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Shared memory transport between a libmbim client and the mbim-proxy.
+ *
+ * A single memfd created by the client holds two rings, one for each
+ * direction. Each ring is a plain byte pipe carrying the same stream of
+ * MBIM messages that would otherwise be sent over the unix socket, so the
+ * message framing is the same as in the socket transports.
+ *
+ * Each peer is woken up through its own eventfd, which is only signaled
+ * when the peer may have run out of data to read, or when it is waiting
+ * for free space to write; under load, messages are exchanged without any
+ * syscall.
+ */
+
+/* Default size of each ring */
+#define MBIM_SHM_TRANSPORT_RING_SIZE_DEFAULT (128 * 1024)
+
+/* Order of the file descriptors passed to the proxy */
+#define MBIM_SHM_TRANSPORT_FD_MEMFD       0
+#define MBIM_SHM_TRANSPORT_FD_PROXY_WAKE  1
+#define MBIM_SHM_TRANSPORT_FD_CLIENT_WAKE 2
+#define MBIM_SHM_TRANSPORT_N_FDS          3
+
+typedef struct _MbimShmTransport MbimShmTransport;
+
+MbimShmTransport *_mbim_shm_transport_new           (guint32            ring_size,
+                                                     GError           **error);
+MbimShmTransport *_mbim_shm_transport_new_from_fds  (const gint        *fds,
+                                                     guint32            ring_size,
+                                                     GError           **error);
+void              _mbim_shm_transport_free          (MbimShmTransport  *self);
+guint32           _mbim_shm_transport_get_ring_size (MbimShmTransport  *self);
+gint              _mbim_shm_transport_get_wake_fd   (MbimShmTransport  *self);
+GUnixFDList      *_mbim_shm_transport_get_fd_list   (MbimShmTransport  *self,
+                                                     GError           **error);
+gboolean          _mbim_shm_transport_write         (MbimShmTransport  *self,
+                                                     const guint8      *data,
+                                                     gsize              data_length,
+                                                     GError           **error);
+gboolean          _mbim_shm_transport_read          (MbimShmTransport  *self,
+                                                     GByteArray        *buffer,
+                                                     GError           **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MbimShmTransport, _mbim_shm_transport_free)
+
+G_END_DECLS
+
+#endif /* _LIBMBIM_GLIB_MBIM_SHM_TRANSPORT_H_ */
@@ -60,11 +60,33 @@ gchar *_mbim_tlv_print (const MbimTlv *tlv,
 /*****************************************************************************/
 /* Parsing support */
 
+gboolean _mbim_tlv_get_raw_size (const guint8  *raw,
+                                 guint32        raw_length,
+                                 guint32       *tlv_size,
+                                 GError       **error);
+
 MbimTlv *_mbim_tlv_new_from_raw (const guint8  *raw,
                                  guint32        raw_length,
                                  guint32       *bytes_read,
                                  GError       **error);
 
+/*****************************************************************************/
+/* TLV list iterator */
+
+/* The actual contents of the public MbimTlvIter */
+typedef struct {
+    const guint8 *raw;
+    guint32       raw_length;
+    guint32       offset;
+    gpointer      reserved;
+} RealTlvIter;
+
+G_STATIC_ASSERT (sizeof (RealTlvIter) == sizeof (MbimTlvIter));
+
+void _mbim_tlv_iter_init (MbimTlvIter  *iter,
+                          const guint8 *raw,
+                          guint32       raw_length);
+
 G_END_DECLS
 
 #endif /* _LIBMBIM_GLIB_MBIM_TLV_PRIVATE_H_ */
@@ -130,43 +130,58 @@ mbim_tlv_new (MbimTlvType   tlv_type,
     return (MbimTlv *)self;
 }
 
-MbimTlv *
-_mbim_tlv_new_from_raw (const guint8  *raw,
+gboolean
+_mbim_tlv_get_raw_size (const guint8  *raw,
                         guint32        raw_length,
-                        guint32       *bytes_read,
+                        guint32       *tlv_size,
                         GError       **error)
 {
-    guint64 tlv_size;
+    guint64 size;
     struct tlv tlv_header;
 
     if (raw_length < sizeof (struct tlv)) {
         g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
                      "Cannot read TLV header: (%u < %" G_GSIZE_FORMAT ")",
                      raw_length, sizeof (struct tlv));
-        return NULL;
+        return FALSE;
     }
 
     /* intermediate variable to ensure the data_length value is properly aligned */
     memcpy (&tlv_header, raw, sizeof (struct tlv));
-    tlv_size = ((guint64)sizeof (struct tlv) +
-                (guint64)GUINT32_FROM_LE (tlv_header.data_length) +
-                (guint64)tlv_header.padding_length);
+    size = ((guint64)sizeof (struct tlv) +
+            (guint64)GUINT32_FROM_LE (tlv_header.data_length) +
+            (guint64)tlv_header.padding_length);
 
-    if ((guint64)raw_length < tlv_size) {
+    if ((guint64)raw_length < size) {
         g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
                      "Cannot read full TLV data (%u > %" G_GUINT64_FORMAT ")",
-                     raw_length, tlv_size);
-        return NULL;
+                     raw_length, size);
+        return FALSE;
     }
 
-    if (tlv_size > (guint64) G_MAXUINT32) {
+    if (size > (guint64) G_MAXUINT32) {
         g_set_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE,
                      "Unsupported TLV size (%" G_GUINT64_FORMAT " > %u)",
-                     tlv_size, G_MAXUINT32);
-        return NULL;
+                     size, G_MAXUINT32);
+        return FALSE;
     }
 
-    *bytes_read = (guint32)tlv_size;
+    *tlv_size = (guint32)size;
+    return TRUE;
+}
+
+MbimTlv *
+_mbim_tlv_new_from_raw (const guint8  *raw,
+                        guint32        raw_length,
+                        guint32       *bytes_read,
+                        GError       **error)
+{
+    guint32 tlv_size;
+
+    if (!_mbim_tlv_get_raw_size (raw, raw_length, &tlv_size, error))
+        return NULL;
+
+    *bytes_read = tlv_size;
     return (MbimTlv *) g_byte_array_append (g_byte_array_sized_new (tlv_size), raw, tlv_size);
 }
 
@@ -234,6 +249,68 @@ mbim_tlv_get_raw (const MbimTlv  *self,
 
 /*****************************************************************************/
 
+void
+_mbim_tlv_iter_init (MbimTlvIter  *iter,
+                     const guint8 *raw,
+                     guint32       raw_length)
+{
+    RealTlvIter *ri = (RealTlvIter *)iter;
+
+    ri->raw        = raw;
+    ri->raw_length = raw_length;
+    ri->offset     = 0;
+    ri->reserved   = NULL;
+}
+
+gboolean
+mbim_tlv_iter_next (MbimTlvIter   *iter,
+                    MbimTlvType   *out_type,
+                    const guint8 **out_data,
+                    guint32       *out_data_length,
+                    GError       **error)
+{
+    RealTlvIter  *ri = (RealTlvIter *)iter;
+    const guint8 *tlv_raw;
+    guint32       tlv_raw_size;
+    guint32       tlv_size;
+    struct tlv    tlv_header;
+
+    g_return_val_if_fail (iter != NULL, FALSE);
+
+    g_assert (ri->offset <= ri->raw_length);
+    tlv_raw = ri->raw + ri->offset;
+    tlv_raw_size = ri->raw_length - ri->offset;
+
+    if (!tlv_raw_size)
+        return FALSE;
+
+    /* Same as when parsing the whole TLV list */
+    if (tlv_raw_size < sizeof (struct tlv)) {
+        g_debug ("Ignored %u bytes unused after the TLV list", tlv_raw_size);
+        ri->offset = ri->raw_length;
+        return FALSE;
+    }
+
+    /* The whole TLV, including its padding, must be available */
+    if (!_mbim_tlv_get_raw_size (tlv_raw, tlv_raw_size, &tlv_size, error)) {
+        ri->offset = ri->raw_length;
+        return FALSE;
+    }
+
+    memcpy (&tlv_header, tlv_raw, sizeof (struct tlv));
+    if (out_type)
+        *out_type = (MbimTlvType) GUINT16_FROM_LE (tlv_header.type);
+    if (out_data)
+        *out_data = tlv_header.data_length ? (tlv_raw + sizeof (struct tlv)) : NULL;
+    if (out_data_length)
+        *out_data_length = GUINT32_FROM_LE (tlv_header.data_length);
+
+    ri->offset += tlv_size;
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 MbimTlv *
 mbim_tlv_string_new (const gchar  *str,
                      GError      **error)
@@ -191,6 +191,63 @@ const guint8 *mbim_tlv_get_tlv_data (const MbimTlv *self,
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (MbimTlv, mbim_tlv_unref)
 
+/*****************************************************************************/
+/* TLV list iterator */
+
+/**
+ * MbimTlvIter:
+ *
+ * An opaque structure used to iterate over the TLVs of a list found in a
+ * #MbimMessage, without copying them.
+ *
+ * The iterator is usually allocated in the stack and initialized with one of
+ * the generated methods for the messages with TLV lists, e.g.
+ * mbim_message_ms_basic_connect_v3_connect_response_iter_init_unnamed_ies().
+ * It points to the contents of the message, so it is only valid while the
+ * message is alive.
+ *
+ * Since: 1.36
+ */
+typedef struct _MbimTlvIter MbimTlvIter;
+
+struct _MbimTlvIter {
+    /*< private >*/
+    gconstpointer dummy1;
+    guint32       dummy2;
+    guint32       dummy3;
+    gpointer      dummy4;
+};
+
+/**
+ * mbim_tlv_iter_next:
+ * @iter: a #MbimTlvIter.
+ * @out_type: (out)(optional): return location for the #MbimTlvType of the next
+ *   TLV, or %NULL if not needed.
+ * @out_data: (out)(optional)(transfer none)(array length=out_data_length):
+ *   return location for the data of the next TLV, or %NULL if not needed.
+ * @out_data_length: (out)(optional): return location for the length of the
+ *   data of the next TLV, or %NULL if not needed.
+ * @error: return location for error or %NULL.
+ *
+ * Advances @iter to the next TLV of the list, if any.
+ *
+ * The data returned is owned by the message being iterated, and it does not
+ * include the padding of the TLV. Each TLV is validated when reached, so an
+ * error may be reported after some TLVs have been returned; once the end of
+ * the list is reached or an error is reported, @iter should not be used any
+ * more.
+ *
+ * Returns: %TRUE if a TLV was read, %FALSE if there are no more TLVs or if
+ * @error is set.
+ *
+ * Since: 1.36
+ */
+gboolean mbim_tlv_iter_next (MbimTlvIter   *iter,
+                             MbimTlvType   *out_type,
+                             const guint8 **out_data,
+                             guint32       *out_data_length,
+                             GError       **error);
+
 /*****************************************************************************/
 /* String TLV type helpers */
 
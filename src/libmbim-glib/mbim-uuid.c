@@ -14,6 +14,7 @@
 #include <string.h>
 
 #include "mbim-uuid.h"
+#include "mbim-cid-private.h"
 #include "generated/mbim-enum-types.h"
 
 /*****************************************************************************/
@@ -25,6 +26,33 @@ mbim_uuid_cmp (const MbimUuid *a,
     return (memcmp (a, b, sizeof (*a)) == 0);
 }
 
+/* The known service and context type UUIDs all have a different first word,
+ * which is used to select the single candidate to compare with */
+static inline guint32
+uuid_first_word (const MbimUuid *uuid)
+{
+    return (((guint32)uuid->a[0] << 24) |
+            ((guint32)uuid->a[1] << 16) |
+            ((guint32)uuid->a[2] << 8)  |
+            ((guint32)uuid->a[3]));
+}
+
+static guint
+uuid_hash (gconstpointer v)
+{
+    guint32 words[4];
+
+    memcpy (words, v, sizeof (words));
+    return words[0] ^ words[1] ^ words[2] ^ words[3];
+}
+
+static gboolean
+uuid_equal (gconstpointer a,
+            gconstpointer b)
+{
+    return mbim_uuid_cmp (a, b);
+}
+
 gchar *
 mbim_uuid_get_printable (const MbimUuid *uuid)
 
@@ -305,37 +333,60 @@ static const MbimUuid uuid_intel_at_tunnel = {
     .e = { 0xa1, 0xe1, 0xca, 0x7c, 0x81, 0xca }
 };
 
-static GList *mbim_custom_service_list = NULL;
+/* Custom services are indexed by their id; ids are allocated right after the
+ * highest one in use, so the array only has holes for services unregistered
+ * in between */
+#define MBIM_CUSTOM_SERVICE_ID_FIRST 101
+
+static GPtrArray *mbim_custom_services = NULL;
+
+/* Custom services indexed by their UUID */
+static GHashTable *mbim_custom_service_uuids = NULL;
 
 typedef struct {
     guint service_id;
     MbimUuid uuid;
     gchar *nickname;
+    MbimCidDescriptor cid_descriptor;
 } MbimCustomService;
 
+static MbimCustomService *
+custom_service_lookup (guint id)
+{
+    if (!mbim_custom_services ||
+        id < MBIM_CUSTOM_SERVICE_ID_FIRST ||
+        id - MBIM_CUSTOM_SERVICE_ID_FIRST >= mbim_custom_services->len)
+        return NULL;
+
+    return g_ptr_array_index (mbim_custom_services, id - MBIM_CUSTOM_SERVICE_ID_FIRST);
+}
+
 guint
 mbim_register_custom_service (const MbimUuid *uuid,
                               const gchar *nickname)
 {
     MbimCustomService *s;
-    GList *l;
-    guint service_id = 100;
-
-    for (l = mbim_custom_service_list; l != NULL; l = l->next) {
-        s = (MbimCustomService *)l->data;
-        if (mbim_uuid_cmp (&s->uuid, uuid))
-            return s->service_id;
-        else
-            service_id = MAX (service_id, s->service_id);
+
+    if (!mbim_custom_services) {
+        mbim_custom_services = g_ptr_array_new ();
+        mbim_custom_service_uuids = g_hash_table_new (uuid_hash, uuid_equal);
     }
 
+    s = g_hash_table_lookup (mbim_custom_service_uuids, uuid);
+    if (s)
+        return s->service_id;
+
     /* create a new custom service */
     s = g_slice_new (MbimCustomService);
-    s->service_id = service_id + 1;
+    s->service_id = MBIM_CUSTOM_SERVICE_ID_FIRST + mbim_custom_services->len;
     memcpy (&s->uuid, uuid, sizeof (MbimUuid));
     s->nickname = g_strdup (nickname);
+    s->cid_descriptor.service_name = s->nickname;
+    s->cid_descriptor.name = NULL;
+    s->cid_descriptor.flags = MBIM_CID_FLAG_CUSTOM_SERVICE;
 
-    mbim_custom_service_list = g_list_append (mbim_custom_service_list, s);
+    g_ptr_array_add (mbim_custom_services, s);
+    g_hash_table_insert (mbim_custom_service_uuids, &s->uuid, s);
     return s->service_id;
 }
 
@@ -343,58 +394,55 @@ gboolean
 mbim_unregister_custom_service (const guint id)
 {
     MbimCustomService *s;
-    GList *l;
-
-    for (l = mbim_custom_service_list; l != NULL; l = l->next) {
-        s = (MbimCustomService *)l->data;
-        if (s->service_id == id) {
-            g_free (s->nickname);
-            g_slice_free (MbimCustomService, s);
-            mbim_custom_service_list = \
-                g_list_delete_link (mbim_custom_service_list, l);
-            return TRUE;
-        }
-    }
 
-    return FALSE;
+    s = custom_service_lookup (id);
+    if (!s)
+        return FALSE;
+
+    g_hash_table_remove (mbim_custom_service_uuids, &s->uuid);
+    g_free (s->nickname);
+    g_slice_free (MbimCustomService, s);
+    g_ptr_array_index (mbim_custom_services, id - MBIM_CUSTOM_SERVICE_ID_FIRST) = NULL;
+
+    /* drop the holes at the end, so that the next id allocated is the one
+     * right after the highest in use */
+    while (mbim_custom_services->len > 0 &&
+           !g_ptr_array_index (mbim_custom_services, mbim_custom_services->len - 1))
+        g_ptr_array_set_size (mbim_custom_services, mbim_custom_services->len - 1);
+
+    return TRUE;
 }
 
 gboolean
 mbim_service_id_is_custom (const guint id)
 {
-    GList *l;
-
-    if (id < MBIM_SERVICE_LAST)
-        return FALSE;
-
-    for (l = mbim_custom_service_list; l != NULL; l = l->next) {
-        if (((MbimCustomService *)l->data)->service_id == id)
-            return TRUE;
-    }
-
-    return FALSE;
+    return !!custom_service_lookup (id);
 }
 
 const gchar *
 mbim_service_lookup_name (guint service)
 {
-    GList *l;
+    MbimCustomService *s;
 
     if (service < MBIM_SERVICE_LAST)
         return mbim_service_get_string (service);
 
-    for (l = mbim_custom_service_list; l != NULL; l = l->next) {
-        if (service == ((MbimCustomService *)l->data)->service_id)
-            return ((MbimCustomService *)l->data)->nickname;
-    }
-    return NULL;
+    s = custom_service_lookup (service);
+    return s ? s->nickname : NULL;
+}
+
+const MbimCidDescriptor *
+_mbim_custom_service_get_cid_descriptor (guint service)
+{
+    MbimCustomService *s;
+
+    s = custom_service_lookup (service);
+    return s ? &s->cid_descriptor : NULL;
 }
 
 const MbimUuid *
 mbim_uuid_from_service (MbimService service)
 {
-    GList *l;
-
     g_return_val_if_fail (service < MBIM_SERVICE_LAST || mbim_service_id_is_custom (service), &uuid_invalid);
 
     switch (service) {
@@ -454,104 +502,116 @@ mbim_uuid_from_service (MbimService service)
         return &uuid_intel_at_tunnel;
     case MBIM_SERVICE_LAST:
         g_assert_not_reached ();
-    default:
-        for (l = mbim_custom_service_list; l != NULL; l = l->next) {
-            if (service == ((MbimCustomService *)l->data)->service_id)
-                return &((MbimCustomService *)l->data)->uuid;
-        }
+    default: {
+        MbimCustomService *s;
+
+        s = custom_service_lookup (service);
+        if (s)
+            return &s->uuid;
         g_return_val_if_reached (NULL);
     }
+    }
 }
 
 MbimService
 mbim_uuid_to_service (const MbimUuid *uuid)
 {
-    GList *l;
-
-    if (mbim_uuid_cmp (uuid, &uuid_basic_connect))
-        return MBIM_SERVICE_BASIC_CONNECT;
-
-    if (mbim_uuid_cmp (uuid, &uuid_sms))
-        return MBIM_SERVICE_SMS;
-
-    if (mbim_uuid_cmp (uuid, &uuid_ussd))
-        return MBIM_SERVICE_USSD;
-
-    if (mbim_uuid_cmp (uuid, &uuid_phonebook))
-        return MBIM_SERVICE_PHONEBOOK;
-
-    if (mbim_uuid_cmp (uuid, &uuid_stk))
-        return MBIM_SERVICE_STK;
-
-    if (mbim_uuid_cmp (uuid, &uuid_auth))
-        return MBIM_SERVICE_AUTH;
-
-    if (mbim_uuid_cmp (uuid, &uuid_dss))
-        return MBIM_SERVICE_DSS;
-
-    if (mbim_uuid_cmp (uuid, &uuid_ms_firmware_id))
-        return MBIM_SERVICE_MS_FIRMWARE_ID;
-
-    if (mbim_uuid_cmp (uuid, &uuid_ms_host_shutdown))
-        return MBIM_SERVICE_MS_HOST_SHUTDOWN;
-
-    if (mbim_uuid_cmp (uuid, &uuid_ms_sar))
-        return MBIM_SERVICE_MS_SAR;
-
-    if (mbim_uuid_cmp (uuid, &uuid_proxy_control))
-        return MBIM_SERVICE_PROXY_CONTROL;
-
-    if (mbim_uuid_cmp (uuid, &uuid_qmi))
-        return MBIM_SERVICE_QMI;
-
-    if (mbim_uuid_cmp (uuid, &uuid_atds))
-        return MBIM_SERVICE_ATDS;
-
-    if (mbim_uuid_cmp (uuid, &uuid_intel_firmware_update))
-        return MBIM_SERVICE_INTEL_FIRMWARE_UPDATE;
-
-    if (mbim_uuid_cmp (uuid, &uuid_qdu))
-        return MBIM_SERVICE_QDU;
-
-    if (mbim_uuid_cmp (uuid, &uuid_ms_basic_connect_extensions))
-        return MBIM_SERVICE_MS_BASIC_CONNECT_EXTENSIONS;
-
-    if (mbim_uuid_cmp (uuid, &uuid_ms_uicc_low_level_access))
-        return MBIM_SERVICE_MS_UICC_LOW_LEVEL_ACCESS;
-
-    if (mbim_uuid_cmp (uuid, &uuid_quectel))
-        return MBIM_SERVICE_QUECTEL;
-
-    if (mbim_uuid_cmp (uuid, &uuid_intel_thermal_rf))
-        return MBIM_SERVICE_INTEL_THERMAL_RF;
-
-    if (mbim_uuid_cmp (uuid, &uuid_ms_voice_extensions))
-        return MBIM_SERVICE_MS_VOICE_EXTENSIONS;
-
-    if (mbim_uuid_cmp (uuid, &uuid_intel_mutual_authentication))
-        return MBIM_SERVICE_INTEL_MUTUAL_AUTHENTICATION;
-
-    if (mbim_uuid_cmp (uuid, &uuid_intel_tools))
-        return MBIM_SERVICE_INTEL_TOOLS;
-
-    if (mbim_uuid_cmp (uuid, &uuid_google))
-        return MBIM_SERVICE_GOOGLE;
-
-    if (mbim_uuid_cmp (uuid, &uuid_fibocom))
-        return MBIM_SERVICE_FIBOCOM;
+    MbimService        service;
+    MbimCustomService *s;
 
-    if (mbim_uuid_cmp (uuid, &uuid_compal))
-        return MBIM_SERVICE_COMPAL;
+    /* Select the only known service with the same first word, and confirm it */
+    switch (uuid_first_word (uuid)) {
+    case 0xa289cc33:
+        service = MBIM_SERVICE_BASIC_CONNECT;
+        break;
+    case 0x533fbeeb:
+        service = MBIM_SERVICE_SMS;
+        break;
+    case 0xe550a0c8:
+        service = MBIM_SERVICE_USSD;
+        break;
+    case 0x4bf38476:
+        service = MBIM_SERVICE_PHONEBOOK;
+        break;
+    case 0xd8f20131:
+        service = MBIM_SERVICE_STK;
+        break;
+    case 0x1d2b5ff7:
+        service = MBIM_SERVICE_AUTH;
+        break;
+    case 0xc08a26dd:
+        service = MBIM_SERVICE_DSS;
+        break;
+    case 0xe9f7dea2:
+        service = MBIM_SERVICE_MS_FIRMWARE_ID;
+        break;
+    case 0x883b7c26:
+        service = MBIM_SERVICE_MS_HOST_SHUTDOWN;
+        break;
+    case 0x68223d04:
+        service = MBIM_SERVICE_MS_SAR;
+        break;
+    case 0x838cf7fb:
+        service = MBIM_SERVICE_PROXY_CONTROL;
+        break;
+    case 0xd1a30bc2:
+        service = MBIM_SERVICE_QMI;
+        break;
+    case 0x5967bdcc:
+        service = MBIM_SERVICE_ATDS;
+        break;
+    case 0x0ed374cb:
+        service = MBIM_SERVICE_INTEL_FIRMWARE_UPDATE;
+        break;
+    case 0x6427015f:
+        service = MBIM_SERVICE_QDU;
+        break;
+    case 0x3d01dcc5:
+        service = MBIM_SERVICE_MS_BASIC_CONNECT_EXTENSIONS;
+        break;
+    case 0xc2f6588e:
+        service = MBIM_SERVICE_MS_UICC_LOW_LEVEL_ACCESS;
+        break;
+    case 0x11223344:
+        service = MBIM_SERVICE_QUECTEL;
+        break;
+    case 0xfdc22af2:
+        service = MBIM_SERVICE_INTEL_THERMAL_RF;
+        break;
+    case 0x8d8b9eba:
+        service = MBIM_SERVICE_MS_VOICE_EXTENSIONS;
+        break;
+    case 0xf85d46ef:
+        service = MBIM_SERVICE_INTEL_MUTUAL_AUTHENTICATION;
+        break;
+    case 0x4ada4962:
+        service = MBIM_SERVICE_INTEL_TOOLS;
+        break;
+    case 0x3e1e92cf:
+        service = MBIM_SERVICE_GOOGLE;
+        break;
+    case 0xffffffff:
+        service = MBIM_SERVICE_FIBOCOM;
+        break;
+    case 0xa2a32a97:
+        service = MBIM_SERVICE_COMPAL;
+        break;
+    case 0xda138c64:
+        service = MBIM_SERVICE_INTEL_AT_TUNNEL;
+        break;
+    default:
+        service = MBIM_SERVICE_INVALID;
+        break;
+    }
 
-    if (mbim_uuid_cmp (uuid, &uuid_intel_at_tunnel))
-        return MBIM_SERVICE_INTEL_AT_TUNNEL;
+    if (service != MBIM_SERVICE_INVALID && mbim_uuid_cmp (uuid, mbim_uuid_from_service (service)))
+        return service;
 
-    for (l = mbim_custom_service_list; l != NULL; l = l->next) {
-        if (mbim_uuid_cmp (&((MbimCustomService *)l->data)->uuid, uuid))
-            return ((MbimCustomService *)l->data)->service_id;
-    }
+    if (!mbim_custom_service_uuids)
+        return MBIM_SERVICE_INVALID;
 
-    return MBIM_SERVICE_INVALID;
+    s = g_hash_table_lookup (mbim_custom_service_uuids, uuid);
+    return s ? s->service_id : MBIM_SERVICE_INVALID;
 }
 
 /*****************************************************************************/
@@ -683,7 +743,7 @@ mbim_uuid_from_context_type (MbimContextType context_type)
     case MBIM_CONTEXT_TYPE_VPN:
         return &uuid_context_type_vpn;
     case MBIM_CONTEXT_TYPE_VOICE:
-        return &uuid_context_type_none;
+        return &uuid_context_type_voice;
     case MBIM_CONTEXT_TYPE_VIDEO_SHARE:
         return &uuid_context_type_video_share;
     case MBIM_CONTEXT_TYPE_PURCHASE:
@@ -712,47 +772,59 @@ mbim_uuid_from_context_type (MbimContextType context_type)
 MbimContextType
 mbim_uuid_to_context_type (const MbimUuid *uuid)
 {
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_none))
-        return MBIM_CONTEXT_TYPE_NONE;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_internet))
-        return MBIM_CONTEXT_TYPE_INTERNET;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_vpn))
-        return MBIM_CONTEXT_TYPE_VPN;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_voice))
-        return MBIM_CONTEXT_TYPE_VOICE;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_video_share))
-        return MBIM_CONTEXT_TYPE_VIDEO_SHARE;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_purchase))
-        return MBIM_CONTEXT_TYPE_PURCHASE;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_ims))
-        return MBIM_CONTEXT_TYPE_IMS;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_mms))
-        return MBIM_CONTEXT_TYPE_MMS;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_local))
-        return MBIM_CONTEXT_TYPE_LOCAL;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_admin))
-        return MBIM_CONTEXT_TYPE_ADMIN;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_app))
-        return MBIM_CONTEXT_TYPE_APP;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_xcap))
-        return MBIM_CONTEXT_TYPE_XCAP;
-
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_tethering))
-        return MBIM_CONTEXT_TYPE_TETHERING;
+    MbimContextType context_type;
+
+    /* Select the only known context type with the same first word, and confirm it */
+    switch (uuid_first_word (uuid)) {
+    case 0xb43f758c:
+        context_type = MBIM_CONTEXT_TYPE_NONE;
+        break;
+    case 0x7e5e2a7e:
+        context_type = MBIM_CONTEXT_TYPE_INTERNET;
+        break;
+    case 0x9b9f7bbe:
+        context_type = MBIM_CONTEXT_TYPE_VPN;
+        break;
+    case 0x88918294:
+        context_type = MBIM_CONTEXT_TYPE_VOICE;
+        break;
+    case 0x05a2a716:
+        context_type = MBIM_CONTEXT_TYPE_VIDEO_SHARE;
+        break;
+    case 0xb3272496:
+        context_type = MBIM_CONTEXT_TYPE_PURCHASE;
+        break;
+    case 0x21610d01:
+        context_type = MBIM_CONTEXT_TYPE_IMS;
+        break;
+    case 0x46726664:
+        context_type = MBIM_CONTEXT_TYPE_MMS;
+        break;
+    case 0xa57a9afc:
+        context_type = MBIM_CONTEXT_TYPE_LOCAL;
+        break;
+    case 0x5f7e4c2e:
+        context_type = MBIM_CONTEXT_TYPE_ADMIN;
+        break;
+    case 0x74d88a3d:
+        context_type = MBIM_CONTEXT_TYPE_APP;
+        break;
+    case 0x50d378a7:
+        context_type = MBIM_CONTEXT_TYPE_XCAP;
+        break;
+    case 0x5e4e0601:
+        context_type = MBIM_CONTEXT_TYPE_TETHERING;
+        break;
+    case 0x5f41adb8:
+        context_type = MBIM_CONTEXT_TYPE_EMERGENCY_CALLING;
+        break;
+    default:
+        context_type = MBIM_CONTEXT_TYPE_INVALID;
+        break;
+    }
 
-    if (mbim_uuid_cmp (uuid, &uuid_context_type_emergency_calling))
-        return MBIM_CONTEXT_TYPE_EMERGENCY_CALLING;
+    if (context_type != MBIM_CONTEXT_TYPE_INVALID && mbim_uuid_cmp (uuid, mbim_uuid_from_context_type (context_type)))
+        return context_type;
 
     return MBIM_CONTEXT_TYPE_INVALID;
 }
@@ -7,6 +7,7 @@
 #include <config.h>
 
 #include "mbim-cid.h"
+#include "mbim-enum-types.h"
 
 static void
 test_common (MbimService service,
@@ -120,6 +121,128 @@ test_cid_ms_sar (void)
                  TRUE, TRUE, TRUE);
 }
 
+static void
+test_cid_descriptor (void)
+{
+    const MbimCidDescriptor *descriptor;
+
+    descriptor = mbim_cid_get_descriptor (MBIM_SERVICE_BASIC_CONNECT, MBIM_CID_BASIC_CONNECT_REGISTER_STATE);
+    g_assert (descriptor);
+    g_assert_cmpstr (descriptor->service_name, ==, "basic-connect");
+    g_assert_cmpstr (descriptor->name, ==, "register-state");
+    g_assert_cmpuint (descriptor->flags, ==, (MBIM_CID_FLAG_CAN_SET |
+                                              MBIM_CID_FLAG_CAN_QUERY |
+                                              MBIM_CID_FLAG_CAN_NOTIFY |
+                                              MBIM_CID_FLAG_SET_MESSAGE |
+                                              MBIM_CID_FLAG_QUERY_MESSAGE |
+                                              MBIM_CID_FLAG_RESPONSE_MESSAGE |
+                                              MBIM_CID_FLAG_NOTIFICATION_MESSAGE));
+
+    /* Notifications allowed, but not implemented */
+    descriptor = mbim_cid_get_descriptor (MBIM_SERVICE_MS_SAR, MBIM_CID_MS_SAR_CONFIG);
+    g_assert (descriptor);
+    g_assert (descriptor->flags & MBIM_CID_FLAG_CAN_NOTIFY);
+    g_assert (!(descriptor->flags & MBIM_CID_FLAG_NOTIFICATION_MESSAGE));
+
+    /* No messages implemented at all */
+    descriptor = mbim_cid_get_descriptor (MBIM_SERVICE_MS_BASIC_CONNECT_EXTENSIONS, MBIM_CID_MS_BASIC_CONNECT_EXTENSIONS_NETWORK_DENYLIST);
+    g_assert (descriptor);
+    g_assert_cmpstr (descriptor->name, ==, "network-denylist");
+    g_assert_cmpuint (descriptor->flags, ==, (MBIM_CID_FLAG_CAN_SET |
+                                              MBIM_CID_FLAG_CAN_QUERY |
+                                              MBIM_CID_FLAG_CAN_NOTIFY));
+
+    /* Unknown commands */
+    g_assert (!mbim_cid_get_descriptor (MBIM_SERVICE_BASIC_CONNECT, 0));
+    g_assert (!mbim_cid_get_descriptor (MBIM_SERVICE_BASIC_CONNECT, 17));
+    g_assert (!mbim_cid_get_descriptor (MBIM_SERVICE_BASIC_CONNECT, 0xFFFFFFFF));
+    g_assert (!mbim_cid_get_descriptor (MBIM_SERVICE_INVALID, 1));
+    g_assert (!mbim_cid_get_descriptor (MBIM_SERVICE_LAST, 1));
+}
+
+static void
+test_cid_descriptor_custom (void)
+{
+    static const MbimUuid uuid_custom = {
+        .a = { 0x52, 0x65, 0x67, 0x69 },
+        .b = { 0x73, 0x74 },
+        .c = { 0x65, 0x72 },
+        .d = { 0x20, 0x63 },
+        .e = { 0x75, 0x73, 0x74, 0x6f, 0x6d, 0x21 }
+    };
+    const MbimCidDescriptor *descriptor;
+    guint                    service;
+
+    service = mbim_register_custom_service (&uuid_custom, "custom");
+
+    descriptor = mbim_cid_get_descriptor (service, 1);
+    g_assert (descriptor);
+    g_assert_cmpstr (descriptor->service_name, ==, "custom");
+    g_assert (!descriptor->name);
+    g_assert_cmpuint (descriptor->flags, ==, MBIM_CID_FLAG_CUSTOM_SERVICE);
+    g_assert (mbim_cid_get_descriptor (service, 1000) == descriptor);
+    g_assert (!mbim_cid_get_descriptor (service, 0));
+
+    g_assert (mbim_unregister_custom_service (service));
+    g_assert (!mbim_cid_get_descriptor (service, 1));
+}
+
+/* The generated names must match the enum nicks */
+static void
+test_cid_printable (void)
+{
+    static const struct {
+        MbimService service;
+        GType       (* get_type) (void);
+    } services[] = {
+        { MBIM_SERVICE_BASIC_CONNECT,               mbim_cid_basic_connect_get_type               },
+        { MBIM_SERVICE_SMS,                         mbim_cid_sms_get_type                         },
+        { MBIM_SERVICE_USSD,                        mbim_cid_ussd_get_type                        },
+        { MBIM_SERVICE_PHONEBOOK,                   mbim_cid_phonebook_get_type                   },
+        { MBIM_SERVICE_STK,                         mbim_cid_stk_get_type                         },
+        { MBIM_SERVICE_AUTH,                        mbim_cid_auth_get_type                        },
+        { MBIM_SERVICE_DSS,                         mbim_cid_dss_get_type                         },
+        { MBIM_SERVICE_MS_FIRMWARE_ID,              mbim_cid_ms_firmware_id_get_type              },
+        { MBIM_SERVICE_MS_HOST_SHUTDOWN,            mbim_cid_ms_host_shutdown_get_type            },
+        { MBIM_SERVICE_MS_SAR,                      mbim_cid_ms_sar_get_type                      },
+        { MBIM_SERVICE_PROXY_CONTROL,               mbim_cid_proxy_control_get_type               },
+        { MBIM_SERVICE_QMI,                         mbim_cid_qmi_get_type                         },
+        { MBIM_SERVICE_ATDS,                        mbim_cid_atds_get_type                        },
+        { MBIM_SERVICE_INTEL_FIRMWARE_UPDATE,       mbim_cid_intel_firmware_update_get_type       },
+        { MBIM_SERVICE_QDU,                         mbim_cid_qdu_get_type                         },
+        { MBIM_SERVICE_MS_BASIC_CONNECT_EXTENSIONS, mbim_cid_ms_basic_connect_extensions_get_type },
+        { MBIM_SERVICE_MS_UICC_LOW_LEVEL_ACCESS,    mbim_cid_ms_uicc_low_level_access_get_type    },
+        { MBIM_SERVICE_QUECTEL,                     mbim_cid_quectel_get_type                     },
+        { MBIM_SERVICE_INTEL_THERMAL_RF,            mbim_cid_intel_thermal_rf_get_type            },
+        { MBIM_SERVICE_MS_VOICE_EXTENSIONS,         mbim_cid_ms_voice_extensions_get_type         },
+        { MBIM_SERVICE_INTEL_MUTUAL_AUTHENTICATION, mbim_cid_intel_mutual_authentication_get_type },
+        { MBIM_SERVICE_INTEL_TOOLS,                 mbim_cid_intel_tools_get_type                 },
+        { MBIM_SERVICE_GOOGLE,                      mbim_cid_google_get_type                      },
+        { MBIM_SERVICE_FIBOCOM,                     mbim_cid_fibocom_get_type                     },
+        { MBIM_SERVICE_COMPAL,                      mbim_cid_compal_get_type                      },
+        { MBIM_SERVICE_INTEL_AT_TUNNEL,             mbim_cid_intel_at_tunnel_get_type             },
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (services); i++) {
+        GEnumClass *enum_class;
+        guint       j;
+
+        enum_class = G_ENUM_CLASS (g_type_class_ref (services[i].get_type ()));
+        for (j = 0; j < enum_class->n_values; j++) {
+            const GEnumValue *value = &enum_class->values[j];
+
+            /* Skip the UNKNOWN values */
+            if (!value->value)
+                continue;
+            g_assert_cmpstr (mbim_cid_get_printable (services[i].service, value->value), ==, value->value_nick);
+            g_assert_cmpstr (mbim_cid_get_descriptor (services[i].service, value->value)->service_name, ==,
+                             mbim_service_get_string (services[i].service));
+        }
+        g_type_class_unref (enum_class);
+    }
+}
+
 int main (int argc, char **argv)
 {
     g_test_init (&argc, &argv, NULL);
@@ -134,6 +257,9 @@ int main (int argc, char **argv)
     g_test_add_func ("/libmbim-glib/cid/ms-firmware-id",   test_cid_ms_firmware_id);
     g_test_add_func ("/libmbim-glib/cid/ms-host-shutdown", test_cid_ms_host_shutdown);
     g_test_add_func ("/libmbim-glib/cid/ms-sar",           test_cid_ms_sar);
+    g_test_add_func ("/libmbim-glib/cid/descriptor",       test_cid_descriptor);
+    g_test_add_func ("/libmbim-glib/cid/custom",           test_cid_descriptor_custom);
+    g_test_add_func ("/libmbim-glib/cid/printable",        test_cid_printable);
 
     return g_test_run ();
 }
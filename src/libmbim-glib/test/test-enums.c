@@ -0,0 +1,241 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <config.h>
+
+#include "mbim-enum-types.h"
+#include "mbim-flag-types.h"
+#include "mbim-error-types.h"
+
+/*****************************************************************************/
+
+typedef const gchar * (* EnumGetStringFunc)    (gint  val);
+typedef gchar       * (* FlagsBuildStringFunc) (guint mask);
+
+static void
+common_enum (GType             type,
+             EnumGetStringFunc get_string)
+{
+    GEnumClass *enum_class;
+    guint       i;
+
+    enum_class = G_ENUM_CLASS (g_type_class_ref (type));
+
+    for (i = 0; i < enum_class->n_values; i++) {
+        const GEnumValue *value = &enum_class->values[i];
+
+        /* when several names share a value, the first one is reported */
+        g_assert_cmpstr (get_string (value->value), ==, g_enum_get_value (enum_class, value->value)->value_nick);
+
+        if (!g_enum_get_value (enum_class, value->value + 1))
+            g_assert_null (get_string (value->value + 1));
+        if (!g_enum_get_value (enum_class, value->value - 1))
+            g_assert_null (get_string (value->value - 1));
+    }
+
+    if (!g_enum_get_value (enum_class, G_MAXINT))
+        g_assert_null (get_string (G_MAXINT));
+    if (!g_enum_get_value (enum_class, G_MININT))
+        g_assert_null (get_string (G_MININT));
+
+    g_type_class_unref (enum_class);
+}
+
+static void
+common_flags (GType                type,
+              FlagsBuildStringFunc build_string)
+{
+    GFlagsClass *flags_class;
+    GString     *expected;
+    guint        mask = 0;
+    guint        i;
+    gchar       *str;
+
+    flags_class = G_FLAGS_CLASS (g_type_class_ref (type));
+
+    /* exact matches */
+    for (i = 0; i < flags_class->n_values; i++) {
+        const GFlagsValue *value = &flags_class->values[i];
+        guint              j;
+
+        for (j = 0; j < i; j++) {
+            if (flags_class->values[j].value == value->value)
+                break;
+        }
+        if (j < i)
+            continue;
+
+        str = build_string (value->value);
+        g_assert_cmpstr (str, ==, value->value_nick);
+        g_free (str);
+    }
+
+    /* all single-bit values together, in the given order */
+    expected = g_string_new (NULL);
+    for (i = 0; i < flags_class->n_values; i++) {
+        const GFlagsValue *value = &flags_class->values[i];
+
+        if (!value->value || (value->value & (value->value - 1)))
+            continue;
+        mask |= value->value;
+        g_string_append_printf (expected, "%s%s", expected->len ? ", " : "", value->value_nick);
+    }
+    for (i = 0; i < flags_class->n_values; i++) {
+        if (flags_class->values[i].value == mask)
+            break;
+    }
+    if (i == flags_class->n_values && mask) {
+        str = build_string (mask);
+        g_assert_cmpstr (str, ==, expected->str);
+        g_free (str);
+    }
+    g_string_free (expected, TRUE);
+
+    /* no single-bit value in the mask, and no exact match either */
+    if (~mask) {
+        for (i = 0; i < flags_class->n_values; i++) {
+            if (flags_class->values[i].value == ~mask)
+                break;
+        }
+        if (i == flags_class->n_values)
+            g_assert_null (build_string (~mask));
+    }
+
+    g_type_class_unref (flags_class);
+}
+
+/*****************************************************************************/
+
+static void
+test_enums_status_error (void)
+{
+    common_enum (MBIM_TYPE_STATUS_ERROR, (EnumGetStringFunc) mbim_status_error_get_string);
+}
+
+static void
+test_enums_protocol_error (void)
+{
+    common_enum (MBIM_TYPE_PROTOCOL_ERROR, (EnumGetStringFunc) mbim_protocol_error_get_string);
+}
+
+static void
+test_enums_message_type (void)
+{
+    common_enum (MBIM_TYPE_MESSAGE_TYPE, (EnumGetStringFunc) mbim_message_type_get_string);
+}
+
+static void
+test_enums_cid_basic_connect (void)
+{
+    common_enum (MBIM_TYPE_CID_BASIC_CONNECT, (EnumGetStringFunc) mbim_cid_basic_connect_get_string);
+}
+
+static void
+test_enums_context_type (void)
+{
+    common_enum (MBIM_TYPE_CONTEXT_TYPE, (EnumGetStringFunc) mbim_context_type_get_string);
+}
+
+static void
+test_flags_data_class (void)
+{
+    common_flags (MBIM_TYPE_DATA_CLASS, (FlagsBuildStringFunc) mbim_data_class_build_string_from_mask);
+}
+
+static void
+test_flags_cid_flags (void)
+{
+    common_flags (MBIM_TYPE_CID_FLAGS, (FlagsBuildStringFunc) mbim_cid_flags_build_string_from_mask);
+}
+
+static void
+test_flags_data_class_mixed (void)
+{
+    gchar *str;
+
+    str = mbim_data_class_build_string_from_mask (MBIM_DATA_CLASS_LTE | MBIM_DATA_CLASS_UMTS | MBIM_DATA_CLASS_CUSTOM);
+    g_assert_cmpstr (str, ==, "umts, lte, custom");
+    g_free (str);
+
+    str = mbim_data_class_build_string_from_mask (MBIM_DATA_CLASS_NONE);
+    g_assert_cmpstr (str, ==, "none");
+    g_free (str);
+
+    g_assert_null (mbim_data_class_build_string_from_mask (1 << 8));
+}
+
+/*****************************************************************************/
+
+#define BENCHMARK_N_LOOPS 100000
+
+static const gchar *
+benchmark_status_error_get_string_linear (GEnumClass *enum_class,
+                                          gint        val)
+{
+    guint i;
+
+    for (i = 0; i < enum_class->n_values; i++) {
+        if (enum_class->values[i].value == val)
+            return enum_class->values[i].value_nick;
+    }
+    return NULL;
+}
+
+static void
+test_enums_status_error_benchmark (void)
+{
+    GEnumClass *enum_class;
+    guint       checksum_linear = 0;
+    guint       checksum = 0;
+    gdouble     linear_elapsed;
+    gdouble     elapsed;
+    guint       i;
+    guint       j;
+
+    enum_class = G_ENUM_CLASS (g_type_class_ref (MBIM_TYPE_STATUS_ERROR));
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_LOOPS; i++) {
+        for (j = 0; j < enum_class->n_values; j++)
+            checksum_linear += GPOINTER_TO_UINT (benchmark_status_error_get_string_linear (enum_class, enum_class->values[j].value));
+    }
+    linear_elapsed = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_LOOPS; i++) {
+        for (j = 0; j < enum_class->n_values; j++)
+            checksum += GPOINTER_TO_UINT (mbim_status_error_get_string ((MbimStatusError) enum_class->values[j].value));
+    }
+    elapsed = g_test_timer_elapsed ();
+
+    /* Both the GEnumClass and the generated method use the same nick strings */
+    g_assert_cmpuint (checksum, ==, checksum_linear);
+
+    g_test_message ("%u values, %u lookups each: linear %.1f ns/lookup, generated %.1f ns/lookup",
+                    enum_class->n_values, BENCHMARK_N_LOOPS,
+                    linear_elapsed * 1e9 / (BENCHMARK_N_LOOPS * enum_class->n_values),
+                    elapsed * 1e9 / (BENCHMARK_N_LOOPS * enum_class->n_values));
+
+    g_type_class_unref (enum_class);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/libmbim-glib/enums/status-error",           test_enums_status_error);
+    if (g_test_perf ())
+        g_test_add_func ("/libmbim-glib/enums/status-error/benchmark", test_enums_status_error_benchmark);
+    g_test_add_func ("/libmbim-glib/enums/protocol-error",         test_enums_protocol_error);
+    g_test_add_func ("/libmbim-glib/enums/message-type",           test_enums_message_type);
+    g_test_add_func ("/libmbim-glib/enums/cid-basic-connect",      test_enums_cid_basic_connect);
+    g_test_add_func ("/libmbim-glib/enums/context-type",           test_enums_context_type);
+
+    g_test_add_func ("/libmbim-glib/flags/data-class",       test_flags_data_class);
+    g_test_add_func ("/libmbim-glib/flags/data-class/mixed", test_flags_data_class_mixed);
+    g_test_add_func ("/libmbim-glib/flags/cid-flags",        test_flags_cid_flags);
+
+    return g_test_run ();
+}
@@ -1919,6 +1919,156 @@ test_google_carrier_lock_set (void)
     test_message_printable (message, 1, 0);
 }
 
+/*****************************************************************************/
+
+static MbimMessage *
+build_connect_set (guint32 session_id,
+                   guint32 transaction_id)
+{
+    g_autoptr(GError)  error = NULL;
+    MbimMessage       *message;
+
+    message = (mbim_message_connect_set_new (
+                   session_id,
+                   MBIM_ACTIVATION_COMMAND_ACTIVATE,
+                   "internet",
+                   "user",
+                   "password",
+                   MBIM_COMPRESSION_NONE,
+                   MBIM_AUTH_PROTOCOL_CHAP,
+                   MBIM_CONTEXT_IP_TYPE_IPV4V6,
+                   mbim_uuid_from_context_type (MBIM_CONTEXT_TYPE_INTERNET),
+                   &error));
+    g_assert_no_error (error);
+    g_assert (message != NULL);
+
+    mbim_message_set_transaction_id (message, transaction_id);
+    return message;
+}
+
+static void
+test_message_template_connect_set (void)
+{
+    g_autoptr(GError)              error = NULL;
+    g_autoptr(MbimMessage)         message = NULL;
+    g_autoptr(MbimMessageTemplate) template = NULL;
+    guint32                        session_id;
+
+    message = build_connect_set (0, 0);
+    template = mbim_message_template_new (message, &error);
+    g_assert_no_error (error);
+    g_assert (template != NULL);
+
+    /* The template keeps its own copy */
+    g_clear_pointer (&message, mbim_message_unref);
+
+    for (session_id = 0; session_id < 4; session_id++) {
+        g_autoptr(MbimMessage) expected = NULL;
+        g_autoptr(MbimMessage) stamped = NULL;
+
+        expected = build_connect_set (session_id, 100 + session_id);
+        stamped = mbim_message_template_build (template, 100 + session_id);
+        g_assert (mbim_message_command_patch_guint32 (stamped, MBIM_MESSAGE_CONNECT_SET_SESSION_ID_OFFSET, session_id, &error));
+        g_assert_no_error (error);
+
+        g_assert (mbim_message_validate (stamped, &error));
+        g_assert_no_error (error);
+        g_assert_cmpuint (mbim_message_get_transaction_id (stamped), ==, 100 + session_id);
+        g_assert_cmpuint (((GByteArray *)stamped)->len, ==, ((GByteArray *)expected)->len);
+        g_assert (memcmp (((GByteArray *)stamped)->data, ((GByteArray *)expected)->data, ((GByteArray *)expected)->len) == 0);
+    }
+}
+
+static void
+test_message_template_signal_state_set (void)
+{
+    g_autoptr(GError)              error = NULL;
+    g_autoptr(MbimMessage)         message = NULL;
+    g_autoptr(MbimMessage)         expected = NULL;
+    g_autoptr(MbimMessage)         stamped = NULL;
+    g_autoptr(MbimMessageTemplate) template = NULL;
+
+    message = mbim_message_signal_state_set_new (5, 0, 0, &error);
+    g_assert_no_error (error);
+    template = mbim_message_template_new (message, &error);
+    g_assert_no_error (error);
+
+    expected = mbim_message_signal_state_set_new (5, 2, 1, &error);
+    g_assert_no_error (error);
+    mbim_message_set_transaction_id (expected, 7);
+
+    stamped = mbim_message_template_build (template, 7);
+    g_assert (mbim_message_command_patch_guint32 (stamped, MBIM_MESSAGE_SIGNAL_STATE_SET_RSSI_THRESHOLD_OFFSET, 2, &error));
+    g_assert_no_error (error);
+    g_assert (mbim_message_command_patch_guint32 (stamped, MBIM_MESSAGE_SIGNAL_STATE_SET_ERROR_RATE_THRESHOLD_OFFSET, 1, &error));
+    g_assert_no_error (error);
+
+    g_assert_cmpuint (((GByteArray *)stamped)->len, ==, ((GByteArray *)expected)->len);
+    g_assert (memcmp (((GByteArray *)stamped)->data, ((GByteArray *)expected)->data, ((GByteArray *)expected)->len) == 0);
+}
+
+static void
+test_message_template_invalid (void)
+{
+    g_autoptr(GError)              error = NULL;
+    g_autoptr(MbimMessage)         message = NULL;
+    g_autoptr(MbimMessage)         stamped = NULL;
+    g_autoptr(MbimMessageTemplate) template = NULL;
+
+    /* Only commands may be used as templates */
+    message = mbim_message_open_new (1, 4096);
+    template = mbim_message_template_new (message, &error);
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE);
+    g_assert (template == NULL);
+    g_clear_error (&error);
+    g_clear_pointer (&message, mbim_message_unref);
+
+    /* Empty information buffer, nothing to patch */
+    message = mbim_message_packet_statistics_query_new (&error);
+    g_assert_no_error (error);
+    template = mbim_message_template_new (message, &error);
+    g_assert_no_error (error);
+    stamped = mbim_message_template_build (template, 1);
+    g_assert (!mbim_message_command_patch_guint32 (stamped, 0, 1, &error));
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE);
+}
+
+#define TEMPLATE_BENCHMARK_N_LOOPS 20000
+
+static void
+test_message_template_benchmark (void)
+{
+    g_autoptr(MbimMessageTemplate) template = NULL;
+    g_autoptr(MbimMessage)         message = NULL;
+    gdouble                        build_elapsed;
+    gdouble                        template_elapsed;
+    guint                          i;
+
+    message = build_connect_set (0, 0);
+    template = mbim_message_template_new (message, NULL);
+    g_assert (template != NULL);
+
+    g_test_timer_start ();
+    for (i = 0; i < TEMPLATE_BENCHMARK_N_LOOPS; i++)
+        mbim_message_unref (build_connect_set (i, i + 1));
+    build_elapsed = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < TEMPLATE_BENCHMARK_N_LOOPS; i++) {
+        MbimMessage *stamped;
+
+        stamped = mbim_message_template_build (template, i + 1);
+        g_assert (mbim_message_command_patch_guint32 (stamped, MBIM_MESSAGE_CONNECT_SET_SESSION_ID_OFFSET, i, NULL));
+        mbim_message_unref (stamped);
+    }
+    template_elapsed = g_test_timer_elapsed ();
+
+    g_test_message ("connect set, %u messages: built %.1f ns/message, from template %.1f ns/message",
+                    TEMPLATE_BENCHMARK_N_LOOPS,
+                    build_elapsed * 1e9 / TEMPLATE_BENCHMARK_N_LOOPS,
+                    template_elapsed * 1e9 / TEMPLATE_BENCHMARK_N_LOOPS);
+}
+
 int main (int argc, char **argv)
 {
     g_test_init (&argc, &argv, NULL);
@@ -1949,6 +2099,12 @@ int main (int argc, char **argv)
     g_test_add_func (PREFIX "/ms-uicc-low-level-access/terminal-capability", test_ms_uicc_low_level_access_terminal_capability);
     g_test_add_func (PREFIX "/google/carrier-lock/set", test_google_carrier_lock_set);
 
+    g_test_add_func (PREFIX "/template/connect/set",      test_message_template_connect_set);
+    g_test_add_func (PREFIX "/template/signal-state/set", test_message_template_signal_state_set);
+    g_test_add_func (PREFIX "/template/invalid",          test_message_template_invalid);
+    if (g_test_perf ())
+        g_test_add_func (PREFIX "/template/benchmark", test_message_template_benchmark);
+
 #undef PREFIX
 
     return g_test_run ();
@@ -0,0 +1,481 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <config.h>
+#include <string.h>
+
+#include "mbim-basic-connect.h"
+#include "mbim-auth.h"
+#include "mbim-qmi.h"
+#include "mbim-ussd.h"
+#include "mbim-message.h"
+#include "mbim-message-private.h"
+#include "mbim-message-codec.h"
+#include "mbim-enum-types.h"
+#include "mbim-error-types.h"
+#include "mbim-codec-tables.h"
+
+/*****************************************************************************/
+/* The field tables are the ones generated with --codec-tables, the same ones
+ * used by the library when built with -Dcodegen_tables=true, so the generic
+ * codec can be compared with the messages built in whichever mode */
+
+static const guint8 connect_response_buffer [] = {
+    /* header */
+    0x03, 0x00, 0x00, 0x80, /* type */
+    0x54, 0x00, 0x00, 0x00, /* length */
+    0x1A, 0x0D, 0x00, 0x00, /* transaction id */
+    /* fragment header */
+    0x01, 0x00, 0x00, 0x00, /* total */
+    0x00, 0x00, 0x00, 0x00, /* current */
+    /* command_done_message */
+    0xA2, 0x89, 0xCC, 0x33, /* service id */
+    0xBC, 0xBB, 0x8B, 0x4F,
+    0xB6, 0xB0, 0x13, 0x3E,
+    0xC2, 0xAA, 0xE6, 0xDF,
+    0x0C, 0x00, 0x00, 0x00, /* command id */
+    0x00, 0x00, 0x00, 0x00, /* status code */
+    0x24, 0x00, 0x00, 0x00, /* buffer length */
+    /* information buffer */
+    0x01, 0x00, 0x00, 0x00, /* session id */
+    0x01, 0x00, 0x00, 0x00, /* activation state */
+    0x00, 0x00, 0x00, 0x00, /* voice call state */
+    0x01, 0x00, 0x00, 0x00, /* ip type */
+    0x7E, 0x5E, 0x2A, 0x7E, /* context type */
+    0x4E, 0x6F, 0x72, 0x72,
+    0x73, 0x6B, 0x65, 0x6E,
+    0x7E, 0x5E, 0x2A, 0x7E,
+    0x00, 0x00, 0x00, 0x00  /* nw error */
+};
+
+static MbimMessage *
+connect_set_codec_new (void)
+{
+    const MbimMessageCodecValue values[] = {
+        { .integer = 1 },
+        { .integer = MBIM_ACTIVATION_COMMAND_ACTIVATE },
+        { .pointer = "internet" },
+        { .pointer = "user" },
+        { .pointer = "password" },
+        { .integer = MBIM_COMPRESSION_NONE },
+        { .integer = MBIM_AUTH_PROTOCOL_PAP },
+        { .integer = MBIM_CONTEXT_IP_TYPE_IPV4V6 },
+        { .pointer = mbim_uuid_from_context_type (MBIM_CONTEXT_TYPE_INTERNET) },
+    };
+
+    return _mbim_message_codec_build (MBIM_SERVICE_BASIC_CONNECT,
+                                      MBIM_CID_BASIC_CONNECT_CONNECT,
+                                      MBIM_MESSAGE_COMMAND_TYPE_SET,
+                                      &mbim_message_connect_set_codec,
+                                      values);
+}
+
+static MbimMessage *
+connect_set_generated_new (void)
+{
+    return mbim_message_connect_set_new (1,
+                                         MBIM_ACTIVATION_COMMAND_ACTIVATE,
+                                         "internet",
+                                         "user",
+                                         "password",
+                                         MBIM_COMPRESSION_NONE,
+                                         MBIM_AUTH_PROTOCOL_PAP,
+                                         MBIM_CONTEXT_IP_TYPE_IPV4V6,
+                                         mbim_uuid_from_context_type (MBIM_CONTEXT_TYPE_INTERNET),
+                                         NULL);
+}
+
+/*****************************************************************************/
+
+static void
+test_codec_build (void)
+{
+    g_autoptr(MbimMessage) codec = NULL;
+    g_autoptr(MbimMessage) generated = NULL;
+    const guint8          *codec_raw;
+    const guint8          *generated_raw;
+    guint32                codec_len = 0;
+    guint32                generated_len = 0;
+
+    codec = connect_set_codec_new ();
+    generated = connect_set_generated_new ();
+
+    codec_raw = mbim_message_get_raw (codec, &codec_len, NULL);
+    generated_raw = mbim_message_get_raw (generated, &generated_len, NULL);
+    g_assert_cmpmem (codec_raw, codec_len, generated_raw, generated_len);
+}
+
+static void
+test_codec_parse (void)
+{
+    g_autoptr(MbimMessage) message = NULL;
+    g_autoptr(GError)      error = NULL;
+    g_autofree gchar      *access_string = NULL;
+    g_autofree gchar      *user_name = NULL;
+    guint32                session_id = 0;
+    MbimActivationCommand  activation_command = MBIM_ACTIVATION_COMMAND_DEACTIVATE;
+    MbimContextIpType      ip_type = MBIM_CONTEXT_IP_TYPE_DEFAULT;
+    const MbimUuid        *context_type = NULL;
+    gpointer               out[] = {
+        &session_id,
+        &activation_command,
+        &access_string,
+        &user_name,
+        NULL,
+        NULL,
+        NULL,
+        &ip_type,
+        &context_type,
+    };
+
+    message = connect_set_codec_new ();
+    g_assert (!_mbim_message_codec_parse (message, MBIM_MESSAGE_TYPE_COMMAND_DONE, &mbim_message_connect_set_codec, out, &error));
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE);
+    g_clear_error (&error);
+
+    /* Parse the set message as if it were a response, as both have the
+     * information buffer at the same place */
+    ((struct full_message *)(message->data))->header.type = GUINT32_TO_LE (MBIM_MESSAGE_TYPE_COMMAND_DONE);
+    g_assert (_mbim_message_codec_parse (message, MBIM_MESSAGE_TYPE_COMMAND_DONE, &mbim_message_connect_set_codec, out, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (session_id, ==, 1);
+    g_assert_cmpuint (activation_command, ==, MBIM_ACTIVATION_COMMAND_ACTIVATE);
+    g_assert_cmpstr (access_string, ==, "internet");
+    g_assert_cmpstr (user_name, ==, "user");
+    g_assert_cmpuint (ip_type, ==, MBIM_CONTEXT_IP_TYPE_IPV4V6);
+    g_assert (mbim_uuid_cmp (context_type, mbim_uuid_from_context_type (MBIM_CONTEXT_TYPE_INTERNET)));
+}
+
+static void
+test_codec_parse_short (void)
+{
+    g_autoptr(MbimMessage) message = NULL;
+    g_autoptr(GError)      error = NULL;
+    guint32                session_id = 0;
+    gpointer               out[] = { &session_id, NULL, NULL, NULL, NULL, NULL };
+    guint8                 buffer[sizeof (connect_response_buffer)];
+
+    /* Information buffer shorter than the fixed-size fields */
+    memcpy (buffer, connect_response_buffer, sizeof (buffer));
+    buffer[4] = 0x50;
+    buffer[44] = 0x20;
+    message = mbim_message_new (buffer, sizeof (buffer) - 4);
+    g_assert (!_mbim_message_codec_parse (message, MBIM_MESSAGE_TYPE_COMMAND_DONE, &mbim_message_connect_response_codec, out, &error));
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE);
+    g_assert_cmpuint (session_id, ==, 0);
+}
+
+static void
+test_codec_print (void)
+{
+    g_autoptr(MbimMessage) message = NULL;
+    g_autoptr(GError)      error = NULL;
+    g_autofree gchar      *codec = NULL;
+    g_autofree gchar      *generated = NULL;
+
+    message = mbim_message_new (connect_response_buffer, sizeof (connect_response_buffer));
+    codec = _mbim_message_codec_print (message, &mbim_message_connect_response_codec, "");
+    generated = __mbim_message_basic_connect_get_printable_fields (message, "", &error);
+    g_assert_no_error (error);
+    g_assert_cmpstr (codec, ==, generated);
+}
+
+/*****************************************************************************/
+/* Byte array fields */
+
+typedef gchar *(* GetPrintableFields) (const MbimMessage *message, const gchar *line_prefix, GError **error);
+
+static void
+assert_same_raw (MbimMessage *codec,
+                 MbimMessage *generated)
+{
+    const guint8 *codec_raw;
+    const guint8 *generated_raw;
+    guint32       codec_len = 0;
+    guint32       generated_len = 0;
+
+    g_assert (codec != NULL);
+    g_assert (generated != NULL);
+    codec_raw = mbim_message_get_raw (codec, &codec_len, NULL);
+    generated_raw = mbim_message_get_raw (generated, &generated_len, NULL);
+    g_assert_cmpmem (codec_raw, codec_len, generated_raw, generated_len);
+}
+
+/* Responses are built as if they were queries, which have the information
+ * buffer at the same place, and then turned into responses */
+static MbimMessage *
+codec_response_new (MbimService                    service,
+                    guint32                        cid,
+                    const MbimMessageCodecMessage *descriptor,
+                    const MbimMessageCodecValue   *values)
+{
+    MbimMessage *message;
+
+    message = _mbim_message_codec_build (service, cid, MBIM_MESSAGE_COMMAND_TYPE_QUERY, descriptor, values);
+    ((struct full_message *)(message->data))->header.type = GUINT32_TO_LE (MBIM_MESSAGE_TYPE_COMMAND_DONE);
+    return message;
+}
+
+static void
+assert_same_printable (MbimMessage                   *message,
+                       const MbimMessageCodecMessage *descriptor,
+                       GetPrintableFields             get_printable_fields)
+{
+    g_autoptr(GError)  error = NULL;
+    g_autofree gchar  *codec = NULL;
+    g_autofree gchar  *generated = NULL;
+
+    codec = _mbim_message_codec_print (message, descriptor, "");
+    generated = get_printable_fields (message, "", &error);
+    g_assert_no_error (error);
+    g_assert_cmpstr (codec, ==, generated);
+}
+
+static void
+test_codec_byte_array (void)
+{
+    g_autoptr(MbimMessage) codec = NULL;
+    g_autoptr(MbimMessage) generated = NULL;
+    g_autoptr(GError)      error = NULL;
+    const guint8          *res = NULL;
+    const guint8          *auts = NULL;
+    const guint8          *codec_res = NULL;
+    const guint8          *codec_auts = NULL;
+    guint32                res_len = 0;
+    guint32                codec_res_len = 0;
+    gpointer               out[] = { &codec_res, &codec_res_len, NULL, NULL, &codec_auts };
+    guint8                 rand[16];
+    guint8                 autn[16];
+    guint8                 key[16];
+    guint                  i;
+
+    for (i = 0; i < sizeof (rand); i++) {
+        rand[i] = i;
+        autn[i] = 0xF0 | i;
+        key[i] = 0xA0 | i;
+    }
+
+    {
+        const MbimMessageCodecValue values[] = {
+            { .pointer = rand },
+            { .pointer = autn },
+        };
+
+        codec = _mbim_message_codec_build (MBIM_SERVICE_AUTH, MBIM_CID_AUTH_AKA, MBIM_MESSAGE_COMMAND_TYPE_QUERY,
+                                           &mbim_message_auth_aka_query_codec, values);
+        generated = mbim_message_auth_aka_query_new (rand, autn, &error);
+        g_assert_no_error (error);
+        assert_same_raw (codec, generated);
+        g_clear_pointer (&codec, mbim_message_unref);
+    }
+
+    {
+        const MbimMessageCodecValue values[] = {
+            { .pointer = rand },
+            { .integer = 8 },
+            { .pointer = key },
+            { .pointer = key },
+            { .pointer = autn },
+        };
+
+        codec = codec_response_new (MBIM_SERVICE_AUTH, MBIM_CID_AUTH_AKA, &mbim_message_auth_aka_response_codec, values);
+    }
+
+    g_assert (mbim_message_auth_aka_response_parse (codec, &res, &res_len, NULL, NULL, &auts, &error));
+    g_assert_no_error (error);
+    g_assert (_mbim_message_codec_parse (codec, MBIM_MESSAGE_TYPE_COMMAND_DONE, &mbim_message_auth_aka_response_codec, out, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (codec_res_len, ==, res_len);
+    g_assert_cmpmem (codec_res, 16, res, 16);
+    g_assert_cmpmem (codec_auts, 14, auts, 14);
+    g_assert_cmpmem (codec_auts, 14, autn, 14);
+
+    assert_same_printable (codec, &mbim_message_auth_aka_response_codec, __mbim_message_auth_get_printable_fields);
+}
+
+static void
+test_codec_unsized_byte_array (void)
+{
+    g_autoptr(MbimMessage) codec = NULL;
+    g_autoptr(MbimMessage) generated = NULL;
+    g_autoptr(GError)      error = NULL;
+    const guint8          *qmux = NULL;
+    const guint8          *codec_qmux = NULL;
+    guint32                qmux_size = 0;
+    guint32                codec_qmux_size = 0;
+    gpointer               out[] = { &codec_qmux_size, &codec_qmux };
+    const guint8           qmi_msg[] = { 0x01, 0x0C, 0x00, 0x00, 0x02 };
+    const MbimMessageCodecValue values[] = {
+        { .size = sizeof (qmi_msg), .pointer = qmi_msg },
+    };
+
+    /* Not padded */
+    codec = _mbim_message_codec_build (MBIM_SERVICE_QMI, MBIM_CID_QMI_MSG, MBIM_MESSAGE_COMMAND_TYPE_SET,
+                                       &mbim_message_qmi_msg_set_codec, values);
+    generated = mbim_message_qmi_msg_set_new (sizeof (qmi_msg), qmi_msg, &error);
+    g_assert_no_error (error);
+    assert_same_raw (codec, generated);
+    g_clear_pointer (&codec, mbim_message_unref);
+    g_clear_pointer (&generated, mbim_message_unref);
+
+    /* Padded */
+    codec = _mbim_message_codec_build (MBIM_SERVICE_BASIC_CONNECT, MBIM_CID_BASIC_CONNECT_SERVICE_ACTIVATION, MBIM_MESSAGE_COMMAND_TYPE_SET,
+                                       &mbim_message_service_activation_set_codec, values);
+    generated = mbim_message_service_activation_set_new (sizeof (qmi_msg), qmi_msg, &error);
+    g_assert_no_error (error);
+    assert_same_raw (codec, generated);
+    g_clear_pointer (&codec, mbim_message_unref);
+
+    codec = codec_response_new (MBIM_SERVICE_QMI, MBIM_CID_QMI_MSG, &mbim_message_qmi_msg_response_codec, values);
+    g_assert (mbim_message_qmi_msg_response_parse (codec, &qmux_size, &qmux, &error));
+    g_assert_no_error (error);
+    g_assert (_mbim_message_codec_parse (codec, MBIM_MESSAGE_TYPE_COMMAND_DONE, &mbim_message_qmi_msg_response_codec, out, &error));
+    g_assert_no_error (error);
+    g_assert_cmpmem (codec_qmux, codec_qmux_size, qmux, qmux_size);
+    g_assert_cmpmem (codec_qmux, codec_qmux_size, qmi_msg, sizeof (qmi_msg));
+
+    assert_same_printable (codec, &mbim_message_qmi_msg_response_codec, __mbim_message_qmi_get_printable_fields);
+}
+
+static void
+test_codec_ref_byte_array (void)
+{
+    g_autoptr(MbimMessage) codec = NULL;
+    g_autoptr(MbimMessage) generated = NULL;
+    g_autoptr(GError)      error = NULL;
+    MbimUssdResponse       response = MBIM_USSD_RESPONSE_NO_ACTION_REQUIRED;
+    MbimUssdResponse       codec_response = MBIM_USSD_RESPONSE_NO_ACTION_REQUIRED;
+    const guint8          *payload = NULL;
+    const guint8          *codec_payload = NULL;
+    guint32                payload_size = 0;
+    guint32                codec_payload_size = 0;
+    gpointer               out[] = { &codec_response, NULL, NULL, &codec_payload_size, &codec_payload };
+    const guint8           data[] = { 0xAA, 0x18, 0x0C, 0x36, 0x02, 0x2A, 0x0A };
+
+    {
+        const MbimMessageCodecValue values[] = {
+            { .integer = MBIM_USSD_ACTION_CONTINUE },
+            { .integer = 0x0F },
+            { .size = sizeof (data), .pointer = data },
+        };
+
+        codec = _mbim_message_codec_build (MBIM_SERVICE_USSD, MBIM_CID_USSD, MBIM_MESSAGE_COMMAND_TYPE_SET,
+                                           &mbim_message_ussd_set_codec, values);
+        generated = mbim_message_ussd_set_new (MBIM_USSD_ACTION_CONTINUE, 0x0F, sizeof (data), data, &error);
+        g_assert_no_error (error);
+        assert_same_raw (codec, generated);
+        g_clear_pointer (&codec, mbim_message_unref);
+    }
+
+    {
+        const MbimMessageCodecValue values[] = {
+            { .integer = MBIM_USSD_RESPONSE_ACTION_REQUIRED },
+            { .integer = MBIM_USSD_SESSION_STATE_EXISTING_SESSION },
+            { .integer = 0x0F },
+            { .size = sizeof (data), .pointer = data },
+        };
+
+        codec = codec_response_new (MBIM_SERVICE_USSD, MBIM_CID_USSD, &mbim_message_ussd_response_codec, values);
+    }
+
+    g_assert (mbim_message_ussd_response_parse (codec, &response, NULL, NULL, &payload_size, &payload, &error));
+    g_assert_no_error (error);
+    g_assert (_mbim_message_codec_parse (codec, MBIM_MESSAGE_TYPE_COMMAND_DONE, &mbim_message_ussd_response_codec, out, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (codec_response, ==, response);
+    g_assert_cmpuint (codec_response, ==, MBIM_USSD_RESPONSE_ACTION_REQUIRED);
+    g_assert_cmpmem (codec_payload, codec_payload_size, payload, payload_size);
+    g_assert_cmpmem (codec_payload, codec_payload_size, data, sizeof (data));
+
+    assert_same_printable (codec, &mbim_message_ussd_response_codec, __mbim_message_ussd_get_printable_fields);
+}
+
+/*****************************************************************************/
+/* Per-message throughput of the generic codec and of the message support
+ * built in the configured codegen mode; the binary size and cold start time
+ * are compared by building with and without -Dcodegen_tables=true */
+
+#define BENCHMARK_N_MESSAGES 100000
+
+static void
+test_codec_benchmark (void)
+{
+    g_autoptr(MbimMessage) response = NULL;
+    g_autoptr(GError)      error = NULL;
+    guint32                session_id;
+    MbimActivationState    activation_state;
+    MbimVoiceCallState     voice_call_state;
+    MbimContextIpType      ip_type;
+    const MbimUuid        *context_type;
+    guint32                nw_error;
+    gpointer               out[] = {
+        &session_id, &activation_state, &voice_call_state, &ip_type, &context_type, &nw_error,
+    };
+    gdouble                elapsed[6];
+    guint                  i;
+
+    response = mbim_message_new (connect_response_buffer, sizeof (connect_response_buffer));
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_MESSAGES; i++) {
+        if (!mbim_message_connect_response_parse (response, &session_id, &activation_state, &voice_call_state,
+                                                  &ip_type, &context_type, &nw_error, &error))
+            g_assert_not_reached ();
+    }
+    elapsed[0] = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_MESSAGES; i++) {
+        if (!_mbim_message_codec_parse (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &mbim_message_connect_response_codec, out, &error))
+            g_assert_not_reached ();
+    }
+    elapsed[1] = g_test_timer_elapsed ();
+    g_assert_cmpuint (activation_state, ==, MBIM_ACTIVATION_STATE_ACTIVATED);
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_MESSAGES; i++)
+        mbim_message_unref (connect_set_generated_new ());
+    elapsed[2] = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_MESSAGES; i++)
+        mbim_message_unref (connect_set_codec_new ());
+    elapsed[3] = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_MESSAGES; i++)
+        g_free (__mbim_message_basic_connect_get_printable_fields (response, "", NULL));
+    elapsed[4] = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_MESSAGES; i++)
+        g_free (_mbim_message_codec_print (response, &mbim_message_connect_response_codec, ""));
+    elapsed[5] = g_test_timer_elapsed ();
+
+    for (i = 0; i < G_N_ELEMENTS (elapsed); i++)
+        elapsed[i] = elapsed[i] * 1e9 / BENCHMARK_N_MESSAGES;
+
+    g_test_message ("connect, %u messages (built message support vs generic codec): "
+                    "parse %.1f/%.1f ns, build %.1f/%.1f ns, print %.1f/%.1f ns",
+                    BENCHMARK_N_MESSAGES,
+                    elapsed[0], elapsed[1], elapsed[2], elapsed[3], elapsed[4], elapsed[5]);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/libmbim-glib/message/codec/build",       test_codec_build);
+    g_test_add_func ("/libmbim-glib/message/codec/parse",       test_codec_parse);
+    g_test_add_func ("/libmbim-glib/message/codec/parse-short", test_codec_parse_short);
+    g_test_add_func ("/libmbim-glib/message/codec/print",       test_codec_print);
+    g_test_add_func ("/libmbim-glib/message/codec/byte-array",  test_codec_byte_array);
+    g_test_add_func ("/libmbim-glib/message/codec/unsized",     test_codec_unsized_byte_array);
+    g_test_add_func ("/libmbim-glib/message/codec/ref",         test_codec_ref_byte_array);
+    if (g_test_perf ())
+        g_test_add_func ("/libmbim-glib/message/codec/benchmark", test_codec_benchmark);
+
+    return g_test_run ();
+}
@@ -17,6 +17,7 @@
 #include "mbim-ms-uicc-low-level-access.h"
 #include "mbim-google.h"
 #include "mbim-message.h"
+#include "mbim-message-private.h"
 #include "mbim-tlv.h"
 #include "mbim-cid.h"
 #include "mbim-common.h"
@@ -184,6 +185,119 @@ test_basic_connect_visible_providers (void)
     g_assert_cmpuint (providers[1]->error_rate, ==, 0);
 }
 
+typedef struct {
+    guint    n_visited;
+    guint    max_visited;
+    gboolean found_home;
+} VisitProvidersContext;
+
+static gboolean
+visit_provider (const MbimProviderView *view,
+                gpointer                user_data)
+{
+    VisitProvidersContext *ctx = user_data;
+    g_autofree gchar      *provider_name = NULL;
+    g_autoptr(GError)      error = NULL;
+
+    ctx->n_visited++;
+
+    g_assert (mbim_string_view_equal (&view->provider_id, "21403"));
+    g_assert (!mbim_string_view_equal (&view->provider_id, "2140"));
+    g_assert (!mbim_string_view_equal (&view->provider_id, "214030"));
+    g_assert_cmpuint (view->provider_id.size, ==, 10);
+
+    provider_name = mbim_string_view_dup (&view->provider_name, &error);
+    g_assert_no_error (error);
+    g_assert_cmpstr (provider_name, ==, "Orange");
+
+    g_assert_cmpuint (view->cellular_class, ==, MBIM_CELLULAR_CLASS_GSM);
+    g_assert_cmpuint (view->rssi, ==, 11);
+    if (view->provider_state & MBIM_PROVIDER_STATE_HOME)
+        ctx->found_home = TRUE;
+
+    return (ctx->n_visited < ctx->max_visited);
+}
+
+static void
+test_basic_connect_visible_providers_visit (void)
+{
+    VisitProvidersContext  ctx = { 0 };
+    g_autoptr(GError)      error = NULL;
+    g_autoptr(MbimMessage) response = NULL;
+
+    const guint8 buffer [] =  {
+        /* header */
+        0x03, 0x00, 0x00, 0x80, /* type */
+        0xB4, 0x00, 0x00, 0x00, /* length */
+        0x02, 0x00, 0x00, 0x00, /* transaction id */
+        /* fragment header */
+        0x01, 0x00, 0x00, 0x00, /* total */
+        0x00, 0x00, 0x00, 0x00, /* current */
+        /* command_done_message */
+        0xA2, 0x89, 0xCC, 0x33, /* service id */
+        0xBC, 0xBB, 0x8B, 0x4F,
+        0xB6, 0xB0, 0x13, 0x3E,
+        0xC2, 0xAA, 0xE6, 0xDF,
+        0x08, 0x00, 0x00, 0x00, /* command id */
+        0x00, 0x00, 0x00, 0x00, /* status code */
+        0x84, 0x00, 0x00, 0x00, /* buffer length */
+        /* information buffer */
+        0x02, 0x00, 0x00, 0x00, /* 0x00 providers count */
+        0x14, 0x00, 0x00, 0x00, /* 0x04 provider 0 offset */
+        0x38, 0x00, 0x00, 0x00, /* 0x08 provider 0 length */
+        0x4C, 0x00, 0x00, 0x00, /* 0x0C provider 1 offset */
+        0x38, 0x00, 0x00, 0x00, /* 0x10 provider 1 length */
+        /* data buffer... struct provider 0 */
+        0x20, 0x00, 0x00, 0x00, /* 0x14 [0x00] id offset */
+        0x0A, 0x00, 0x00, 0x00, /* 0x18 [0x04] id length */
+        0x08, 0x00, 0x00, 0x00, /* 0x1C [0x08] state */
+        0x2C, 0x00, 0x00, 0x00, /* 0x20 [0x0C] name offset */
+        0x0C, 0x00, 0x00, 0x00, /* 0x24 [0x10] name length */
+        0x01, 0x00, 0x00, 0x00, /* 0x28 [0x14] cellular class */
+        0x0B, 0x00, 0x00, 0x00, /* 0x2C [0x18] rssi */
+        0x00, 0x00, 0x00, 0x00, /* 0x30 [0x1C] error rate */
+        0x32, 0x00, 0x31, 0x00, /* 0x34 [0x20] id string (10 bytes) */
+        0x34, 0x00, 0x30, 0x00,
+        0x33, 0x00, 0x00, 0x00,
+        0x4F, 0x00, 0x72, 0x00, /* 0x40 [0x2C] name string (12 bytes) */
+        0x61, 0x00, 0x6E, 0x00,
+        0x67, 0x00, 0x65, 0x00,
+        /* data buffer... struct provider 1 */
+        0x20, 0x00, 0x00, 0x00, /* 0x4C [0x00] id offset */
+        0x0A, 0x00, 0x00, 0x00, /* 0x50 [0x04] id length */
+        0x19, 0x00, 0x00, 0x00, /* 0x51 [0x08] state */
+        0x2C, 0x00, 0x00, 0x00, /* 0x54 [0x0C] name offset */
+        0x0C, 0x00, 0x00, 0x00, /* 0x58 [0x10] name length */
+        0x01, 0x00, 0x00, 0x00, /* 0x5C [0x14] cellular class */
+        0x0B, 0x00, 0x00, 0x00, /* 0x60 [0x18] rssi */
+        0x00, 0x00, 0x00, 0x00, /* 0x64 [0x1C] error rate */
+        0x32, 0x00, 0x31, 0x00, /* 0x68 [0x20] id string (10 bytes) */
+        0x34, 0x00, 0x30, 0x00,
+        0x33, 0x00, 0x00, 0x00,
+        0x4F, 0x00, 0x72, 0x00, /* 0x74 [0x2C] name string (12 bytes) */
+        0x61, 0x00, 0x6E, 0x00,
+        0x67, 0x00, 0x65, 0x00 };
+
+    response = mbim_message_new (buffer, sizeof (buffer));
+    g_assert (mbim_message_validate (response, &error));
+    g_assert_no_error (error);
+
+    /* All elements */
+    ctx.max_visited = G_MAXUINT;
+    g_assert (mbim_message_visible_providers_response_visit_providers (response, visit_provider, &ctx, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (ctx.n_visited, ==, 2);
+    g_assert (ctx.found_home);
+
+    /* Stopped after the first one */
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.max_visited = 1;
+    g_assert (mbim_message_visible_providers_response_visit_providers (response, visit_provider, &ctx, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (ctx.n_visited, ==, 1);
+    g_assert (!ctx.found_home);
+}
+
 static void
 test_basic_connect_subscriber_ready_status (void)
 {
@@ -716,6 +830,115 @@ test_basic_connect_ip_configuration_2 (void)
     }
 }
 
+static void
+test_basic_connect_ip_configuration_peek (void)
+{
+    guint32 ipv4addresscount;
+    guint32 ipv6addresscount;
+    const MbimIPv4ElementOverlay *ipv4address;
+    const MbimIPv6ElementOverlay *ipv6address;
+    guint8 truncated[0xC4];
+    g_autoptr(GError) error = NULL;
+    g_autoptr(MbimMessage) response = NULL;
+    g_autoptr(MbimMessage) truncated_response = NULL;
+
+    const guint8 buffer [] =  {
+        /* header */
+        0x03, 0x00, 0x00, 0x80, /* type */
+        0xC4, 0x00, 0x00, 0x00, /* length */
+        0x24, 0x00, 0x00, 0x00, /* transaction id */
+        /* fragment header */
+        0x01, 0x00, 0x00, 0x00, /* total */
+        0x00, 0x00, 0x00, 0x00, /* current */
+        /* command_done_message */
+        0xA2, 0x89, 0xCC, 0x33, /* service id */
+        0xBC, 0xBB, 0x8B, 0x4F,
+        0xB6, 0xB0, 0x13, 0x3E,
+        0xC2, 0xAA, 0xE6, 0xDF,
+        0x0F, 0x00, 0x00, 0x00, /* command id */
+        0x00, 0x00, 0x00, 0x00, /* status code */
+        0x94, 0x00, 0x00, 0x00, /* buffer length */
+        /* information buffer */
+        0x00, 0x00, 0x00, 0x00, /* session id */
+        0x0F, 0x00, 0x00, 0x00, /* IPv4ConfigurationAvailable */
+        0x0F, 0x00, 0x00, 0x00, /* IPv6ConfigurationAvailable */
+        0x01, 0x00, 0x00, 0x00, /* IPv4 element count */
+        0x3C, 0x00, 0x00, 0x00, /* IPv4 element offset */
+        0x01, 0x00, 0x00, 0x00, /* IPv6 element count */
+        0x50, 0x00, 0x00, 0x00, /* IPv6 element offset */
+        0x44, 0x00, 0x00, 0x00, /* IPv4 gateway offset */
+        0x64, 0x00, 0x00, 0x00, /* IPv6 gateway offset */
+        0x02, 0x00, 0x00, 0x00, /* IPv4 DNS count */
+        0x48, 0x00, 0x00, 0x00, /* IPv4 DNS offset */
+        0x02, 0x00, 0x00, 0x00, /* IPv6 DNS count */
+        0x74, 0x00, 0x00, 0x00, /* IPv6 DNS offset */
+        0xDC, 0x05, 0x00, 0x00, /* IPv4 MTU */
+        0xDC, 0x05, 0x00, 0x00, /* IPv6 MTU */
+        /* data buffer */
+        0x1D, 0x00, 0x00, 0x00, /* IPv4 element (netmask) */
+        0x1C, 0xF6, 0xC9, 0xDB, /* IPv4 element (address) */
+        0x1C, 0xF6, 0xC9, 0xDC, /* IPv4 gateway */
+        0x0A, 0xB1, 0x00, 0x22, /* IPv4 DNS1 */
+        0x0A, 0xB1, 0x00, 0xD2, /* IPv4 DNS2 */
+        0x40, 0x00, 0x00, 0x00, /* IPv6 element (netmask) */
+        0x26, 0x07, 0xFB, 0x90, /* IPv6 element (address) */
+        0x64, 0x3B, 0x28, 0x1F,
+        0x1D, 0xFF, 0xBF, 0x3D,
+        0xC5, 0xC8, 0x48, 0xAD,
+        0x26, 0x07, 0xFB, 0x90, /* IPv6 gateway */
+        0x64, 0x3B, 0x28, 0x1F,
+        0xFD, 0xF7, 0x80, 0xF4,
+        0xE3, 0x99, 0x98, 0x4A,
+        0xFD, 0x00, 0x97, 0x6A, /* IPv6 DNS1 */
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x09,
+        0xFD, 0x00, 0x97, 0x6A, /* IPv6 DNS2 */
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x10
+    };
+
+    response = mbim_message_new (buffer, sizeof (buffer));
+    g_assert (mbim_message_validate (response, &error));
+    g_assert_no_error (error);
+
+    g_assert (mbim_message_ip_configuration_response_peek_ipv4_address (response, &ipv4addresscount, &ipv4address, &error));
+    g_assert_no_error (error);
+    g_assert (mbim_message_ip_configuration_response_peek_ipv6_address (response, &ipv6addresscount, &ipv6address, &error));
+    g_assert_no_error (error);
+
+    {
+        MbimIPv4 addr = { .addr = { 0x1C, 0xF6, 0xC9, 0xDB } };
+
+        g_assert_cmpuint (ipv4addresscount, ==, 1);
+        g_assert_cmpuint (mbim_ipv4_element_overlay_get_on_link_prefix_length (&ipv4address[0]), ==, 29);
+        g_assert (memcmp (&addr, mbim_ipv4_element_overlay_get_ipv4_address (&ipv4address[0]), 4) == 0);
+    }
+
+    {
+        MbimIPv6 addr = { .addr = { 0x26, 0x07, 0xFB, 0x90,
+                                    0x64, 0x3B, 0x28, 0x1F,
+                                    0x1D, 0xFF, 0xBF, 0x3D,
+                                    0xC5, 0xC8, 0x48, 0xAD } };
+
+        g_assert_cmpuint (ipv6addresscount, ==, 1);
+        g_assert_cmpuint (mbim_ipv6_element_overlay_get_on_link_prefix_length (&ipv6address[0]), ==, 64);
+        g_assert (memcmp (&addr, mbim_ipv6_element_overlay_get_ipv6_address (&ipv6address[0]), 16) == 0);
+    }
+
+    /* The whole array must fit in the information buffer */
+    g_assert_cmpuint (sizeof (truncated), ==, sizeof (buffer));
+    memcpy (truncated, buffer, sizeof (buffer));
+    truncated[68] = 0x10; /* IPv6 element count */
+    truncated_response = mbim_message_new (truncated, sizeof (truncated));
+    g_assert (mbim_message_validate (truncated_response, &error));
+    g_assert_no_error (error);
+
+    g_assert (!mbim_message_ip_configuration_response_peek_ipv6_address (truncated_response, &ipv6addresscount, &ipv6address, &error));
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE);
+}
+
 static void
 test_basic_connect_service_activation (void)
 {
@@ -851,6 +1074,121 @@ test_basic_connect_register_state (void)
     g_assert (provider_name == NULL);
     g_assert (roaming_text == NULL);
     g_assert_cmpuint (registration_flag, ==, MBIM_REGISTRATION_FLAG_PACKET_SERVICE_AUTOMATIC_ATTACH);
+
+    /* Same fields, read one by one */
+    g_assert (mbim_message_register_state_response_get_register_state (response, &register_state, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (register_state, ==, MBIM_REGISTER_STATE_HOME);
+
+    g_clear_pointer (&provider_id, g_free);
+    g_assert (mbim_message_register_state_response_get_provider_id (response, &provider_id, &error));
+    g_assert_no_error (error);
+    g_assert_cmpstr (provider_id, ==, "26006");
+
+    g_clear_pointer (&provider_name, g_free);
+    g_assert (mbim_message_register_state_response_get_provider_name (response, &provider_name, &error));
+    g_assert_no_error (error);
+    g_assert (provider_name == NULL);
+
+    g_assert (mbim_message_register_state_response_get_registration_flag (response, &registration_flag, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (registration_flag, ==, MBIM_REGISTRATION_FLAG_PACKET_SERVICE_AUTOMATIC_ATTACH);
+
+    /* Not a notification */
+    g_assert (!mbim_message_register_state_notification_get_register_state (response, &register_state, &error));
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE);
+}
+
+static void
+test_basic_connect_register_state_serialize (void)
+{
+    g_autoptr(GError) error = NULL;
+    g_autoptr(MbimMessage) response = NULL;
+    g_autoptr(MbimMessage) truncated = NULL;
+    g_autoptr(MbimMessage) padded = NULL;
+    g_autoptr(GString) json = NULL;
+
+    const guint8 buffer [] =  {
+        /* header */
+        0x03, 0x00, 0x00, 0x80, /* type */
+        0x6C, 0x00, 0x00, 0x00, /* length */
+        0x12, 0x00, 0x00, 0x00, /* transaction id */
+        /* fragment header */
+        0x01, 0x00, 0x00, 0x00, /* total */
+        0x00, 0x00, 0x00, 0x00, /* current */
+        /* command_done message */
+        0xA2, 0x89, 0xCC, 0x33, /* service id */
+        0xBC, 0xBB, 0x8B, 0x4F,
+        0xB6, 0xB0, 0x13, 0x3E,
+        0xC2, 0xAA, 0xE6, 0xDF,
+        0x09, 0x00, 0x00, 0x00, /* command id */
+        0x00, 0x00, 0x00, 0x00, /* status code */
+        0x3C, 0x00, 0x00, 0x00, /* buffer length */
+        /* information buffer */
+        0x00, 0x00, 0x00, 0x00, /* nw error */
+        0x03, 0x00, 0x00, 0x00, /* register state */
+        0x01, 0x00, 0x00, 0x00, /* register mode */
+        0x1C, 0x00, 0x00, 0x00, /* available data classes */
+        0x01, 0x00, 0x00, 0x00, /* current cellular class */
+        0x30, 0x00, 0x00, 0x00, /* provider id offset */
+        0x0A, 0x00, 0x00, 0x00, /* provider id size */
+        0x00, 0x00, 0x00, 0x00, /* provider name offset */
+        0x00, 0x00, 0x00, 0x00, /* provider name size */
+        0x00, 0x00, 0x00, 0x00, /* roaming text offset */
+        0x00, 0x00, 0x00, 0x00, /* roaming text size */
+        0x02, 0x00, 0x00, 0x00, /* registration flag */
+        /* data buffer */
+        0x32, 0x00, 0x36, 0x00,
+        0x30, 0x00, 0x30, 0x00,
+        0x36, 0x00, 0x00, 0x00 };
+    guint8 broken [sizeof (buffer)];
+
+    response = mbim_message_new (buffer, sizeof (buffer));
+    g_assert (mbim_message_validate (response, &error));
+    g_assert_no_error (error);
+
+    /* Output is appended to whatever the string already contains */
+    json = g_string_new ("prefix:");
+    g_assert (mbim_message_serialize (response, MBIM_MESSAGE_SERIALIZE_FORMAT_JSON, 1, 0, json, &error));
+    g_assert_no_error (error);
+    g_assert_cmpstr (json->str, ==,
+                     "prefix:"
+                     "{\"length\":108,"
+                     "\"type\":\"command-done\","
+                     "\"transaction\":18,"
+                     "\"fragment\":{\"total\":1,\"current\":0},"
+                     "\"status\":\"none\","
+                     "\"service\":\"basic-connect\","
+                     "\"service-id\":\"a289cc33-bcbb-8b4f-b6b0-133ec2aae6df\","
+                     "\"cid\":\"register-state\","
+                     "\"fields\":{"
+                     "\"NwError\":\"none\","
+                     "\"RegisterState\":\"home\","
+                     "\"RegisterMode\":\"automatic\","
+                     "\"AvailableDataClasses\":[\"umts\",\"hsdpa\",\"hsupa\"],"
+                     "\"CurrentCellularClass\":[\"gsm\"],"
+                     "\"ProviderId\":\"26006\","
+                     "\"ProviderName\":\"\","
+                     "\"RoamingText\":\"\","
+                     "\"RegistrationFlag\":[\"packet-service-automatic-attach\"]}}");
+
+    /* A string size including the trailing NUL does not add it to the output */
+    memcpy (broken, buffer, sizeof (buffer));
+    broken[72] = 0x0C; /* provider id size */
+    padded = mbim_message_new (broken, sizeof (broken));
+    g_string_truncate (json, 0);
+    g_assert (mbim_message_serialize (padded, MBIM_MESSAGE_SERIALIZE_FORMAT_JSON, 1, 0, json, &error));
+    g_assert_no_error (error);
+    g_assert (strstr (json->str, "\"ProviderId\":\"26006\","));
+
+    /* A string pointing out of the message fails and leaves the output untouched */
+    memcpy (broken, buffer, sizeof (buffer));
+    broken[68] = 0x40; /* provider id offset */
+    truncated = mbim_message_new (broken, sizeof (broken));
+    g_string_assign (json, "prefix:");
+    g_assert (!mbim_message_serialize (truncated, MBIM_MESSAGE_SERIALIZE_FORMAT_JSON, 1, 0, json, &error));
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_MESSAGE);
+    g_assert_cmpstr (json->str, ==, "prefix:");
 }
 
 static void
@@ -1026,10 +1364,32 @@ test_sms_read_single_pdu (void)
     g_assert (memcmp (pdu_messages[0]->pdu_data, expected_pdu, sizeof (expected_pdu)) == 0);
 }
 
+static gboolean
+visit_sms_pdu (const MbimSmsPduReadRecordView *view,
+               gpointer                        user_data)
+{
+    guint *n_visited = user_data;
+
+    g_assert_cmpuint (view->message_index, ==, 6 + *n_visited);
+    g_assert_cmpuint (view->message_status, ==, MBIM_SMS_STATUS_SENT);
+    g_assert_cmpuint (view->pdu_data_size, ==, 16);
+    (*n_visited)++;
+    return TRUE;
+}
+
+static gboolean
+visit_sms_cdma (const MbimSmsCdmaReadRecordView *view,
+                gpointer                         user_data)
+{
+    g_assert_not_reached ();
+    return FALSE;
+}
+
 static void
 test_sms_read_multiple_pdu (void)
 {
     guint32 idx;
+    guint n_visited = 0;
     MbimSmsFormat format;
     guint32 messages_count;
     g_autoptr(MbimSmsPduReadRecordArray) pdu_messages = NULL;
@@ -1147,6 +1507,13 @@ test_sms_read_multiple_pdu (void)
                         sizeof (expected_pdu_idx7));
     g_assert_cmpuint (pdu_messages[idx]->pdu_data_size, ==, sizeof (expected_pdu_idx7));
     g_assert (memcmp (pdu_messages[idx]->pdu_data, expected_pdu_idx7, sizeof (expected_pdu_idx7)) == 0);
+
+    /* The visitors only see the array available for the format */
+    g_assert (mbim_message_sms_read_response_visit_pdu_messages (response, visit_sms_pdu, &n_visited, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (n_visited, ==, 2);
+    g_assert (mbim_message_sms_read_response_visit_cdma_messages (response, visit_sms_cdma, NULL, &error));
+    g_assert_no_error (error);
 }
 
 static void
@@ -2063,6 +2430,7 @@ test_basic_connect_connect_short (void)
 static void
 test_basic_connect_visible_providers_overflow (void)
 {
+    VisitProvidersContext ctx = { 0 };
     guint32 n_providers;
     g_autoptr(GError) error = NULL;
     g_autoptr(MbimProviderArray) providers = NULL;
@@ -2133,6 +2501,14 @@ test_basic_connect_visible_providers_overflow (void)
 
     g_assert (error != NULL);
     g_assert (!result);
+
+    /* The first element is already wrong, so nothing is visited */
+    g_clear_error (&error);
+    ctx.max_visited = G_MAXUINT;
+    result = mbim_message_visible_providers_response_visit_providers (response, visit_provider, &ctx, &error);
+    g_assert (error != NULL);
+    g_assert (!result);
+    g_assert_cmpuint (ctx.n_visited, ==, 0);
 }
 
 static void
@@ -2610,6 +2986,15 @@ test_ms_basic_connect_v3_connect_0_unnamed_tlvs (void)
     g_assert_cmpuint (media_type, ==, MBIM_ACCESS_MEDIA_TYPE_3GPP);
     g_assert_cmpstr  (access_string, ==, "internet");
     g_assert_cmpuint (g_list_length (unnamed_ies), ==, 0);
+
+    {
+        MbimTlvIter tlv_iter;
+
+        g_assert (mbim_message_ms_basic_connect_v3_connect_response_iter_init_unnamed_ies (response, &tlv_iter, &error));
+        g_assert_no_error (error);
+        g_assert (!mbim_tlv_iter_next (&tlv_iter, NULL, NULL, NULL, &error));
+        g_assert_no_error (error);
+    }
 }
 
 static void
@@ -2925,6 +3310,34 @@ test_ms_basic_connect_v3_connect_3_unnamed_tlvs (void)
     g_assert_cmpuint (pco_3_size, ==, sizeof (expected_pco));
     g_assert (memcmp (pco_3, expected_pco, sizeof (expected_pco)) == 0);
 
+    /* Same TLVs, read in place */
+    {
+        MbimTlvIter   tlv_iter;
+        MbimTlvType   tlv_type;
+        const guint8 *tlv_data;
+        guint32       tlv_data_length;
+
+        g_assert (mbim_message_ms_basic_connect_v3_connect_response_iter_init_unnamed_ies (response, &tlv_iter, &error));
+        g_assert_no_error (error);
+
+        for (iter = unnamed_ies; iter; iter = g_list_next (iter)) {
+            const guint8 *expected_data;
+            guint32       expected_data_length;
+
+            tlv = (MbimTlv *)(iter->data);
+            expected_data = mbim_tlv_get_tlv_data (tlv, &expected_data_length);
+
+            g_assert (mbim_tlv_iter_next (&tlv_iter, &tlv_type, &tlv_data, &tlv_data_length, &error));
+            g_assert_no_error (error);
+            g_assert_cmpuint (tlv_type, ==, mbim_tlv_get_tlv_type (tlv));
+            g_assert_cmpuint (tlv_data_length, ==, expected_data_length);
+            g_assert (memcmp (tlv_data, expected_data, tlv_data_length) == 0);
+        }
+
+        g_assert (!mbim_tlv_iter_next (&tlv_iter, NULL, NULL, NULL, &error));
+        g_assert_no_error (error);
+    }
+
     g_list_free_full (unnamed_ies, (GDestroyNotify)mbim_tlv_unref);
 }
 
@@ -3496,6 +3909,120 @@ test_google_carrier_lock_notification (void)
     g_assert_cmpuint (carrier_lock_cause, ==, MBIM_CARRIER_LOCK_CAUSE_NOT_APPLICABLE);
 }
 
+/*****************************************************************************/
+
+#define BENCHMARK_N_PARSES 200000
+
+/* Connect response parser reading each field with its own bounds check, as
+ * generated parsers did before using a parse cursor */
+static gboolean
+benchmark_connect_response_parse_per_field (const MbimMessage    *message,
+                                            guint32              *out_session_id,
+                                            MbimActivationState  *out_activation_state,
+                                            MbimVoiceCallState   *out_voice_call_state,
+                                            MbimContextIpType    *out_ip_type,
+                                            const MbimUuid      **out_context_type,
+                                            guint32              *out_nw_error,
+                                            GError              **error)
+{
+    guint32 aux;
+
+    if (!_mbim_message_read_guint32 (message, 0, out_session_id, error))
+        return FALSE;
+    if (!_mbim_message_read_guint32 (message, 4, &aux, error))
+        return FALSE;
+    *out_activation_state = (MbimActivationState) aux;
+    if (!_mbim_message_read_guint32 (message, 8, &aux, error))
+        return FALSE;
+    *out_voice_call_state = (MbimVoiceCallState) aux;
+    if (!_mbim_message_read_guint32 (message, 12, &aux, error))
+        return FALSE;
+    *out_ip_type = (MbimContextIpType) aux;
+    if (!_mbim_message_read_uuid (message, 16, out_context_type, NULL, error))
+        return FALSE;
+    return _mbim_message_read_guint32 (message, 32, out_nw_error, error);
+}
+
+static void
+test_parse_benchmark (void)
+{
+    g_autoptr(MbimMessage) response = NULL;
+    g_autoptr(GError)      error = NULL;
+    guint32                session_id;
+    MbimActivationState    activation_state;
+    MbimVoiceCallState     voice_call_state;
+    MbimContextIpType      ip_type;
+    const MbimUuid        *context_type;
+    guint32                nw_error;
+    gdouble                per_field_elapsed;
+    gdouble                cursor_elapsed;
+    guint                  i;
+
+    const guint8 buffer [] = {
+        /* header */
+        0x03, 0x00, 0x00, 0x80, /* type */
+        0x54, 0x00, 0x00, 0x00, /* length */
+        0x1A, 0x0D, 0x00, 0x00, /* transaction id */
+        /* fragment header */
+        0x01, 0x00, 0x00, 0x00, /* total */
+        0x00, 0x00, 0x00, 0x00, /* current */
+        /* command_done_message */
+        0xA2, 0x89, 0xCC, 0x33, /* service id */
+        0xBC, 0xBB, 0x8B, 0x4F,
+        0xB6, 0xB0, 0x13, 0x3E,
+        0xC2, 0xAA, 0xE6, 0xDF,
+        0x0C, 0x00, 0x00, 0x00, /* command id */
+        0x00, 0x00, 0x00, 0x00, /* status code */
+        0x24, 0x00, 0x00, 0x00, /* buffer length */
+        /* information buffer */
+        0x01, 0x00, 0x00, 0x00, /* session id */
+        0x01, 0x00, 0x00, 0x00, /* activation state */
+        0x00, 0x00, 0x00, 0x00, /* voice call state */
+        0x01, 0x00, 0x00, 0x00, /* ip type */
+        0x7E, 0x5E, 0x2A, 0x7E, /* context type */
+        0x4E, 0x6F, 0x72, 0x72,
+        0x73, 0x6B, 0x65, 0x6E,
+        0x7E, 0x5E, 0x2A, 0x7E,
+        0x00, 0x00, 0x00, 0x00  /* nw error */
+    };
+
+    response = mbim_message_new (buffer, sizeof (buffer));
+    g_assert (mbim_message_validate (response, &error));
+    g_assert_no_error (error);
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_PARSES; i++) {
+        if (!benchmark_connect_response_parse_per_field (response, &session_id, &activation_state, &voice_call_state,
+                                                         &ip_type, &context_type, &nw_error, &error))
+            g_assert_not_reached ();
+    }
+    per_field_elapsed = g_test_timer_elapsed ();
+    g_assert_cmpuint (session_id, ==, 1);
+    g_assert_cmpuint (activation_state, ==, MBIM_ACTIVATION_STATE_ACTIVATED);
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_PARSES; i++) {
+        if (!mbim_message_connect_response_parse (response, &session_id, &activation_state, &voice_call_state,
+                                                  &ip_type, &context_type, &nw_error, &error))
+            g_assert_not_reached ();
+    }
+    cursor_elapsed = g_test_timer_elapsed ();
+    g_assert_no_error (error);
+    g_assert_cmpuint (session_id, ==, 1);
+    g_assert_cmpuint (activation_state, ==, MBIM_ACTIVATION_STATE_ACTIVATED);
+    g_assert_cmpuint (voice_call_state, ==, MBIM_VOICE_CALL_STATE_NONE);
+    g_assert_cmpuint (ip_type, ==, MBIM_CONTEXT_IP_TYPE_IPV4);
+    g_assert (mbim_uuid_cmp (context_type, mbim_uuid_from_context_type (MBIM_CONTEXT_TYPE_INTERNET)));
+    g_assert_cmpuint (nw_error, ==, 0);
+
+    /* The generated parser also checks the message type and information
+     * buffer, which the per-field reference doesn't */
+    g_test_message ("connect response, %u parses: per-field checks %.1f ns/message, parse cursor %.1f ns/message",
+                    BENCHMARK_N_PARSES,
+                    per_field_elapsed * 1e9 / BENCHMARK_N_PARSES,
+                    cursor_elapsed * 1e9 / BENCHMARK_N_PARSES);
+}
+
 int main (int argc, char **argv)
 {
     g_test_init (&argc, &argv, NULL);
@@ -3503,12 +4030,15 @@ int main (int argc, char **argv)
 #define PREFIX "/libmbim-glib/message/parser"
 
     g_test_add_func (PREFIX "/basic-connect/visible-providers", test_basic_connect_visible_providers);
+    g_test_add_func (PREFIX "/basic-connect/visible-providers/visit", test_basic_connect_visible_providers_visit);
     g_test_add_func (PREFIX "/basic-connect/subscriber-ready-status", test_basic_connect_subscriber_ready_status);
     g_test_add_func (PREFIX "/basic-connect/device-caps", test_basic_connect_device_caps);
     g_test_add_func (PREFIX "/basic-connect/ip-configuration/1", test_basic_connect_ip_configuration);
     g_test_add_func (PREFIX "/basic-connect/ip-configuration/2", test_basic_connect_ip_configuration_2);
+    g_test_add_func (PREFIX "/basic-connect/ip-configuration/peek", test_basic_connect_ip_configuration_peek);
     g_test_add_func (PREFIX "/basic-connect/service-activation", test_basic_connect_service_activation);
     g_test_add_func (PREFIX "/basic-connect/register-state", test_basic_connect_register_state);
+    g_test_add_func (PREFIX "/basic-connect/register-state/serialize", test_basic_connect_register_state_serialize);
     g_test_add_func (PREFIX "/basic-connect/provisioned-contexts", test_provisioned_contexts);
     g_test_add_func (PREFIX "/sms/read/zero-pdu", test_sms_read_zero_pdu);
     g_test_add_func (PREFIX "/sms/read/single-pdu", test_sms_read_single_pdu);
@@ -3540,6 +4070,8 @@ int main (int argc, char **argv)
     g_test_add_func (PREFIX "/ms-uicc-low-level-access/application-list", test_ms_uicc_low_level_access_application_list);
     g_test_add_func (PREFIX "/google/carrier-lock-response", test_google_carrier_lock);
     g_test_add_func (PREFIX "/google/carrier-lock-notify", test_google_carrier_lock_notification);
+    if (g_test_perf ())
+        g_test_add_func (PREFIX "/benchmark", test_parse_benchmark);
 
 #undef PREFIX
 
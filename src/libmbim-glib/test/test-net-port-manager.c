@@ -0,0 +1,811 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <config.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+/* Built-in kernel header, for the WWAN specific link attributes */
+#include <kernel/if_link.h>
+
+#include "mbim-message.h"
+#include "mbim-device.h"
+#include "mbim-error-types.h"
+#include "mbim-net-port-manager.h"
+
+#define TEST_IFINDEX      7
+#define TEST_ROUTE_METRIC 700
+
+/*****************************************************************************/
+
+typedef struct {
+    GPtrArray *msgs;
+    GPtrArray *requests;
+    GPtrArray *undo_msgs;
+} Requests;
+
+static void
+requests_init (Requests *r)
+{
+    r->msgs = g_ptr_array_new_with_free_func ((GDestroyNotify) mbim_helpers_netlink_message_free);
+    r->requests = g_ptr_array_new_with_free_func (g_free);
+    r->undo_msgs = g_ptr_array_new_with_free_func ((GDestroyNotify) mbim_helpers_netlink_message_free);
+}
+
+static void
+requests_clear (Requests *r)
+{
+    g_ptr_array_unref (r->msgs);
+    g_ptr_array_unref (r->requests);
+    g_ptr_array_unref (r->undo_msgs);
+}
+
+static guint16
+msg_type (GPtrArray *msgs,
+          guint      i)
+{
+    NetlinkMessage *msg = g_ptr_array_index (msgs, i);
+
+    g_assert_cmpuint (msg->len, >=, NLMSG_HDRLEN);
+    g_assert_cmpuint (((struct nlmsghdr *) msg->data)->nlmsg_len, ==, msg->len);
+    return ((struct nlmsghdr *) msg->data)->nlmsg_type;
+}
+
+static gboolean
+msg_has_attribute (GPtrArray    *msgs,
+                   guint         i,
+                   gsize         family_header_len,
+                   guint16       type,
+                   const guint8 *value,
+                   gsize         value_len)
+{
+    NetlinkMessage *msg = g_ptr_array_index (msgs, i);
+    struct rtattr  *rta;
+    gint            len;
+
+    rta = (struct rtattr *) (msg->data + NLMSG_SPACE (family_header_len));
+    len = msg->len - NLMSG_SPACE (family_header_len);
+    for (; RTA_OK (rta, len); rta = RTA_NEXT (rta, len)) {
+        if (rta->rta_type == type &&
+            RTA_PAYLOAD (rta) == value_len &&
+            memcmp (RTA_DATA (rta), value, value_len) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/*****************************************************************************/
+/* Net port manager without a netlink socket
+ *
+ * The manager talks to one end of a socket pair, and the test plays the
+ * kernel in the other one, acknowledging all requests. */
+
+typedef struct {
+    MbimNetPortManager  parent;
+    gint                kernel_fd;
+    GPtrArray          *new_links; /* "<session id>:<ifname>", in order */
+} TestNetPortManager;
+
+typedef struct {
+    MbimNetPortManagerClass parent;
+} TestNetPortManagerClass;
+
+GType test_net_port_manager_get_type (void);
+G_DEFINE_TYPE (TestNetPortManager, test_net_port_manager, MBIM_TYPE_NET_PORT_MANAGER)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (TestNetPortManager, g_object_unref)
+
+static NetlinkMessage *
+test_net_port_manager_new_link_message (MbimNetPortManager  *manager,
+                                        guint                session_id,
+                                        const gchar         *base_ifname,
+                                        const gchar         *ifname,
+                                        GError             **error)
+{
+    TestNetPortManager *self = (TestNetPortManager *) manager;
+    NetlinkMessage     *msg;
+
+    g_ptr_array_add (self->new_links, g_strdup_printf ("%u:%s", session_id, ifname));
+
+    msg = mbim_helpers_netlink_message_new (RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL);
+    mbim_helpers_netlink_append_attribute_string (msg, IFLA_IFNAME, ifname);
+    return msg;
+}
+
+static void
+test_net_port_manager_init (TestNetPortManager *self)
+{
+    self->kernel_fd = -1;
+    self->new_links = g_ptr_array_new_with_free_func (g_free);
+}
+
+static void
+test_net_port_manager_finalize (GObject *object)
+{
+    TestNetPortManager *self = (TestNetPortManager *) object;
+
+    g_ptr_array_unref (self->new_links);
+    if (self->kernel_fd >= 0)
+        close (self->kernel_fd);
+
+    G_OBJECT_CLASS (test_net_port_manager_parent_class)->finalize (object);
+}
+
+static void
+test_net_port_manager_class_init (TestNetPortManagerClass *klass)
+{
+    GObjectClass            *object_class = G_OBJECT_CLASS (klass);
+    MbimNetPortManagerClass *net_port_manager_class = MBIM_NET_PORT_MANAGER_CLASS (klass);
+
+    object_class->finalize = test_net_port_manager_finalize;
+    net_port_manager_class->new_link_message = test_net_port_manager_new_link_message;
+}
+
+static TestNetPortManager *
+test_net_port_manager_new (void)
+{
+    TestNetPortManager *self;
+    GSocket            *gsocket;
+    GError             *error = NULL;
+    gint                fds[2];
+
+    g_assert_cmpint (socketpair (AF_UNIX, SOCK_DGRAM, 0, fds), ==, 0);
+    gsocket = g_socket_new_from_fd (fds[0], &error);
+    g_assert_no_error (error);
+
+    self = g_object_new (test_net_port_manager_get_type (), NULL);
+    self->kernel_fd = fds[1];
+    mbim_net_port_manager_common_setup (MBIM_NET_PORT_MANAGER (self), NULL, gsocket);
+    return self;
+}
+
+/* Acknowledges all the requests received so far, failing the removals with
+ * @del_errno if given, and returns the requests in the order received */
+static GPtrArray *
+test_net_port_manager_kernel_ack (TestNetPortManager *self,
+                                  gint                del_errno)
+{
+    GPtrArray *msgs;
+    guint32    buf[2048];
+    gssize     len;
+
+    msgs = g_ptr_array_new_with_free_func ((GDestroyNotify) mbim_helpers_netlink_message_free);
+    while ((len = recv (self->kernel_fd, buf, sizeof (buf), MSG_DONTWAIT)) > 0) {
+        struct nlmsghdr *hdr;
+        guint            buf_len = (guint) len;
+
+        for (hdr = (struct nlmsghdr *) buf; NLMSG_OK (hdr, buf_len); hdr = NLMSG_NEXT (hdr, buf_len)) {
+            struct {
+                struct nlmsghdr hdr;
+                struct nlmsgerr err;
+            } ack;
+
+            g_ptr_array_add (msgs, g_byte_array_append (g_byte_array_new (), (const guint8 *) hdr, hdr->nlmsg_len));
+
+            memset (&ack, 0, sizeof (ack));
+            ack.hdr.nlmsg_len = sizeof (ack);
+            ack.hdr.nlmsg_type = NLMSG_ERROR;
+            ack.hdr.nlmsg_seq = hdr->nlmsg_seq;
+            if (hdr->nlmsg_type == RTM_DELADDR || hdr->nlmsg_type == RTM_DELROUTE)
+                ack.err.error = -del_errno;
+            ack.err.msg = *hdr;
+            g_assert_cmpint (send (self->kernel_fd, &ack, sizeof (ack), 0), ==, sizeof (ack));
+        }
+    }
+    return msgs;
+}
+
+static void
+async_result_ready (GObject       *source,
+                    GAsyncResult  *res,
+                    GAsyncResult **out_res)
+{
+    *out_res = g_object_ref (res);
+}
+
+static GAsyncResult *
+wait_async_result (GAsyncResult **res)
+{
+    while (!*res)
+        g_main_context_iteration (NULL, TRUE);
+    return *res;
+}
+
+/*****************************************************************************/
+
+static void
+test_add_links (void)
+{
+    g_autoptr(TestNetPortManager) self = NULL;
+    g_autoptr(GAsyncResult)       res = NULL;
+    g_autoptr(GPtrArray)          links = NULL;
+    g_autoptr(GArray)             session_ids = NULL;
+    g_autoptr(GPtrArray)          sent = NULL;
+    g_autoptr(GError)             error = NULL;
+    const guint                   requested[] = { MBIM_DEVICE_SESSION_ID_AUTOMATIC, 1, MBIM_DEVICE_SESSION_ID_AUTOMATIC, 3 };
+
+    self = test_net_port_manager_new ();
+    mbim_net_port_manager_add_links (MBIM_NET_PORT_MANAGER (self), requested, G_N_ELEMENTS (requested),
+                                     "mbimtest", "mbimtest.", 5, NULL,
+                                     (GAsyncReadyCallback) async_result_ready, &res);
+
+    /* The static session ids are reserved before allocating the automatic
+     * ones, and the links are built in the order requested */
+    g_assert_cmpuint (self->new_links->len, ==, 4);
+    g_assert_cmpstr (g_ptr_array_index (self->new_links, 0), ==, "2:mbimtest.2");
+    g_assert_cmpstr (g_ptr_array_index (self->new_links, 1), ==, "1:mbimtest.1");
+    g_assert_cmpstr (g_ptr_array_index (self->new_links, 2), ==, "4:mbimtest.4");
+    g_assert_cmpstr (g_ptr_array_index (self->new_links, 3), ==, "3:mbimtest.3");
+
+    /* All sent at once */
+    sent = test_net_port_manager_kernel_ack (self, 0);
+    g_assert_cmpuint (sent->len, ==, 4);
+    g_assert_cmpuint (msg_type (sent, 0), ==, RTM_NEWLINK);
+    g_assert_cmpuint (msg_type (sent, 3), ==, RTM_NEWLINK);
+
+    links = mbim_net_port_manager_add_links_finish (MBIM_NET_PORT_MANAGER (self), &session_ids,
+                                                    wait_async_result (&res), &error);
+    g_assert_no_error (error);
+    g_assert (links);
+    g_assert_cmpuint (links->len, ==, 4);
+    g_assert_cmpuint (session_ids->len, ==, 4);
+    g_assert_cmpstr (g_ptr_array_index (links, 0), ==, "mbimtest.2");
+    g_assert_cmpuint (g_array_index (session_ids, guint, 0), ==, 2);
+    g_assert_cmpstr (g_ptr_array_index (links, 1), ==, "mbimtest.1");
+    g_assert_cmpuint (g_array_index (session_ids, guint, 1), ==, 1);
+    g_assert_cmpstr (g_ptr_array_index (links, 2), ==, "mbimtest.4");
+    g_assert_cmpuint (g_array_index (session_ids, guint, 2), ==, 4);
+    g_assert_cmpstr (g_ptr_array_index (links, 3), ==, "mbimtest.3");
+    g_assert_cmpuint (g_array_index (session_ids, guint, 3), ==, 3);
+}
+
+static void
+test_add_links_duplicated (void)
+{
+    g_autoptr(TestNetPortManager) self = NULL;
+    g_autoptr(GAsyncResult)       res = NULL;
+    g_autoptr(GPtrArray)          links = NULL;
+    g_autoptr(GPtrArray)          sent = NULL;
+    g_autoptr(GError)             error = NULL;
+    const guint                   requested[] = { 2, MBIM_DEVICE_SESSION_ID_AUTOMATIC, 2 };
+
+    self = test_net_port_manager_new ();
+    mbim_net_port_manager_add_links (MBIM_NET_PORT_MANAGER (self), requested, G_N_ELEMENTS (requested),
+                                     "mbimtest", "mbimtest.", 5, NULL,
+                                     (GAsyncReadyCallback) async_result_ready, &res);
+
+    /* Nothing is built nor sent */
+    g_assert_cmpuint (self->new_links->len, ==, 0);
+    sent = test_net_port_manager_kernel_ack (self, 0);
+    g_assert_cmpuint (sent->len, ==, 0);
+
+    links = mbim_net_port_manager_add_links_finish (MBIM_NET_PORT_MANAGER (self), NULL,
+                                                    wait_async_result (&res), &error);
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS);
+    g_assert (!links);
+}
+
+static void
+test_add_link (void)
+{
+    g_autoptr(TestNetPortManager) self = NULL;
+    g_autoptr(GAsyncResult)       res = NULL;
+    g_autofree gchar             *ifname = NULL;
+    g_autoptr(GPtrArray)          sent = NULL;
+    g_autoptr(GError)             error = NULL;
+    guint                         session_id = 0;
+
+    /* A single link goes through the same path, as a batch of one */
+    self = test_net_port_manager_new ();
+    mbim_net_port_manager_add_link (MBIM_NET_PORT_MANAGER (self), MBIM_DEVICE_SESSION_ID_AUTOMATIC,
+                                    "mbimtest", "mbimtest.", 5, NULL,
+                                    (GAsyncReadyCallback) async_result_ready, &res);
+    g_assert_cmpuint (self->new_links->len, ==, 1);
+    g_assert_cmpstr (g_ptr_array_index (self->new_links, 0), ==, "1:mbimtest.1");
+
+    sent = test_net_port_manager_kernel_ack (self, 0);
+    g_assert_cmpuint (sent->len, ==, 1);
+
+    ifname = mbim_net_port_manager_add_link_finish (MBIM_NET_PORT_MANAGER (self), &session_id,
+                                                    wait_async_result (&res), &error);
+    g_assert_no_error (error);
+    g_assert_cmpstr (ifname, ==, "mbimtest.1");
+    g_assert_cmpuint (session_id, ==, 1);
+}
+
+/*****************************************************************************/
+/* Link index */
+
+#define LINK_HDR(msg) (&mbim_helpers_netlink_get_message_header (msg)->msghdr)
+
+/* Link notification, as the kernel sends them */
+static NetlinkMessage *
+link_message_new (guint16      type,
+                  gint         ifindex,
+                  const gchar *ifname,
+                  guint32      link_ifindex,
+                  const gchar *parent_dev_name)
+{
+    NetlinkMessage *msg;
+
+    msg = mbim_helpers_netlink_message_new (type, 0);
+    LINK_HDR (msg)->nlmsg_flags = 0;
+    mbim_helpers_netlink_get_message_header (msg)->ifreq.ifi_index = ifindex;
+    if (ifname)
+        mbim_helpers_netlink_append_attribute_string_null (msg, IFLA_IFNAME, ifname);
+    if (link_ifindex)
+        mbim_helpers_netlink_append_attribute_uint32 (msg, IFLA_LINK, link_ifindex);
+    if (parent_dev_name)
+        mbim_helpers_netlink_append_attribute_string_null (msg, MBIM_IFLA_PARENT_DEV_NAME, parent_dev_name);
+    return msg;
+}
+
+static void
+link_event (TestNetPortManager *self,
+            guint16             type,
+            gint                ifindex,
+            const gchar        *ifname,
+            guint32             link_ifindex,
+            const gchar        *parent_dev_name)
+{
+    NetlinkMessage *msg;
+
+    msg = link_message_new (type, ifindex, ifname, link_ifindex, parent_dev_name);
+    mbim_net_port_manager_index_link_event (MBIM_NET_PORT_MANAGER (self), LINK_HDR (msg));
+    mbim_helpers_netlink_message_free (msg);
+}
+
+static void
+assert_links (GPtrArray   *links,
+              const gchar *expected)
+{
+    g_autofree gchar *str = NULL;
+
+    g_assert (links);
+    g_ptr_array_add (links, NULL);
+    str = g_strjoinv (",", (gchar **) links->pdata);
+    g_ptr_array_remove_index (links, links->len - 1);
+    g_assert_cmpstr (str, ==, expected);
+}
+
+static void
+test_parse_link (void)
+{
+    NetlinkMessage *msg;
+    guint           ifindex = 0;
+    const gchar    *ifname = NULL;
+    guint           link_ifindex = 0;
+    const gchar    *parent_dev_name = NULL;
+
+    /* VLAN on top of another link */
+    msg = link_message_new (RTM_NEWLINK, 6, "wwan0.1", 2, NULL);
+    g_assert (mbim_helpers_netlink_parse_link (LINK_HDR (msg), &ifindex, &ifname, &link_ifindex, &parent_dev_name));
+    g_assert_cmpuint (ifindex, ==, 6);
+    g_assert_cmpstr (ifname, ==, "wwan0.1");
+    g_assert_cmpuint (link_ifindex, ==, 2);
+    g_assert_null (parent_dev_name);
+    mbim_helpers_netlink_message_free (msg);
+
+    /* WWAN link going away */
+    msg = link_message_new (RTM_DELLINK, 3, "mbim0", 0, "wwan0");
+    g_assert (mbim_helpers_netlink_parse_link (LINK_HDR (msg), &ifindex, &ifname, &link_ifindex, &parent_dev_name));
+    g_assert_cmpuint (ifindex, ==, 3);
+    g_assert_cmpstr (ifname, ==, "mbim0");
+    g_assert_cmpuint (link_ifindex, ==, 0);
+    g_assert_cmpstr (parent_dev_name, ==, "wwan0");
+    mbim_helpers_netlink_message_free (msg);
+
+    /* Lower link in a different network namespace */
+    msg = link_message_new (RTM_NEWLINK, 6, "wwan0.1", 2, NULL);
+    mbim_helpers_netlink_append_attribute_uint32 (msg, IFLA_LINK_NETNSID, 1);
+    g_assert (mbim_helpers_netlink_parse_link (LINK_HDR (msg), &ifindex, &ifname, &link_ifindex, &parent_dev_name));
+    g_assert_cmpuint (link_ifindex, ==, 0);
+    mbim_helpers_netlink_message_free (msg);
+
+    /* Not a link notification */
+    msg = link_message_new (RTM_GETLINK, 6, "wwan0.1", 2, NULL);
+    g_assert (!mbim_helpers_netlink_parse_link (LINK_HDR (msg), &ifindex, &ifname, &link_ifindex, &parent_dev_name));
+    mbim_helpers_netlink_message_free (msg);
+
+    /* Change in a bridge port */
+    msg = link_message_new (RTM_NEWLINK, 6, "wwan0.1", 2, NULL);
+    mbim_helpers_netlink_get_message_header (msg)->ifreq.ifi_family = AF_BRIDGE;
+    g_assert (!mbim_helpers_netlink_parse_link (LINK_HDR (msg), &ifindex, &ifname, &link_ifindex, &parent_dev_name));
+    mbim_helpers_netlink_message_free (msg);
+
+    /* Invalid index */
+    msg = link_message_new (RTM_NEWLINK, 0, "wwan0.1", 2, NULL);
+    g_assert (!mbim_helpers_netlink_parse_link (LINK_HDR (msg), &ifindex, &ifname, &link_ifindex, &parent_dev_name));
+    mbim_helpers_netlink_message_free (msg);
+
+    /* Without name, or with a name that is not NUL-terminated */
+    msg = link_message_new (RTM_NEWLINK, 6, NULL, 2, NULL);
+    g_assert (!mbim_helpers_netlink_parse_link (LINK_HDR (msg), &ifindex, &ifname, &link_ifindex, &parent_dev_name));
+    mbim_helpers_netlink_append_attribute_string (msg, IFLA_IFNAME, "wwan0.1");
+    g_assert (!mbim_helpers_netlink_parse_link (LINK_HDR (msg), &ifindex, &ifname, &link_ifindex, &parent_dev_name));
+    mbim_helpers_netlink_message_free (msg);
+
+    /* Too short for the link info */
+    msg = link_message_new (RTM_NEWLINK, 6, "wwan0.1", 2, NULL);
+    LINK_HDR (msg)->nlmsg_len = NLMSG_LENGTH (sizeof (struct ifinfomsg)) - 1;
+    g_assert (!mbim_helpers_netlink_parse_link (LINK_HDR (msg), &ifindex, &ifname, &link_ifindex, &parent_dev_name));
+    mbim_helpers_netlink_message_free (msg);
+}
+
+static void
+test_link_index_list (void)
+{
+    g_autoptr(TestNetPortManager) self = NULL;
+    MbimNetPortManager           *manager;
+    GPtrArray                    *links = NULL;
+
+    self = test_net_port_manager_new ();
+    manager = MBIM_NET_PORT_MANAGER (self);
+
+    link_event (self, RTM_NEWLINK, 2, "wwan0",   0, "wwandev0");
+    link_event (self, RTM_NEWLINK, 4, "mbim1",   0, "wwandev0");
+    link_event (self, RTM_NEWLINK, 3, "mbim0",   0, "wwandev0");
+    link_event (self, RTM_NEWLINK, 5, "eth0",    0, NULL);
+    link_event (self, RTM_NEWLINK, 6, "wwan0.2", 2, NULL);
+    link_event (self, RTM_NEWLINK, 7, "wwan0.1", 2, NULL);
+    link_event (self, RTM_NEWLINK, 8, "eth0.5",  5, NULL);
+
+    /* Until the index is in sync, the callers must look at sysfs */
+    g_assert (!mbim_net_port_manager_index_list_upper_links (manager, "wwan0", &links));
+    mbim_net_port_manager_index_set_synced (manager);
+
+    /* Links on top of the base link, sorted by name */
+    g_assert (mbim_net_port_manager_index_list_upper_links (manager, "wwan0", &links));
+    assert_links (links, "wwan0.1,wwan0.2");
+    g_clear_pointer (&links, g_ptr_array_unref);
+
+    g_assert (mbim_net_port_manager_index_list_upper_links (manager, "eth0", &links));
+    assert_links (links, "eth0.5");
+    g_clear_pointer (&links, g_ptr_array_unref);
+
+    /* Links sharing the parent device with the base link */
+    g_assert (mbim_net_port_manager_index_list_sibling_links (manager, "wwan0", &links));
+    assert_links (links, "mbim0,mbim1");
+    g_clear_pointer (&links, g_ptr_array_unref);
+
+    /* No links at all */
+    g_assert (mbim_net_port_manager_index_list_upper_links (manager, "mbim0", &links));
+    g_assert_null (links);
+
+    /* Unknown base links, or without a parent device, are left to the
+     * fallback, which reports the errors */
+    g_assert (!mbim_net_port_manager_index_list_upper_links (manager, "wwan1", &links));
+    g_assert (!mbim_net_port_manager_index_list_sibling_links (manager, "eth0", &links));
+
+    g_assert_cmpuint (mbim_net_port_manager_get_ifindex (manager, "wwan0.2"), ==, 6);
+    g_assert_cmpuint (mbim_net_port_manager_get_ifindex (manager, "wwan1"), ==, 0);
+}
+
+static void
+test_link_index_events (void)
+{
+    g_autoptr(TestNetPortManager) self = NULL;
+    MbimNetPortManager           *manager;
+    GPtrArray                    *links = NULL;
+
+    self = test_net_port_manager_new ();
+    manager = MBIM_NET_PORT_MANAGER (self);
+
+    link_event (self, RTM_NEWLINK, 2, "wwan0",   0, "wwandev0");
+    link_event (self, RTM_NEWLINK, 3, "mbim0",   0, "wwandev0");
+    link_event (self, RTM_NEWLINK, 6, "wwan0.1", 2, NULL);
+    mbim_net_port_manager_index_set_synced (manager);
+
+    /* Removed */
+    link_event (self, RTM_DELLINK, 6, "wwan0.1", 2, NULL);
+    g_assert_cmpuint (mbim_net_port_manager_get_ifindex (manager, "wwan0.1"), ==, 0);
+    g_assert (mbim_net_port_manager_index_list_upper_links (manager, "wwan0", &links));
+    g_assert_null (links);
+
+    /* Renamed */
+    link_event (self, RTM_NEWLINK, 3, "mbim9", 0, "wwandev0");
+    g_assert_cmpuint (mbim_net_port_manager_get_ifindex (manager, "mbim0"), ==, 0);
+    g_assert_cmpuint (mbim_net_port_manager_get_ifindex (manager, "mbim9"), ==, 3);
+
+    /* A new link takes the name of one whose rename was missed, and the
+     * name stays with the new link when the stale one goes away */
+    link_event (self, RTM_NEWLINK, 4, "mbim9", 0, "wwandev0");
+    g_assert_cmpuint (mbim_net_port_manager_get_ifindex (manager, "mbim9"), ==, 4);
+    link_event (self, RTM_DELLINK, 3, "mbim9", 0, "wwandev0");
+    g_assert_cmpuint (mbim_net_port_manager_get_ifindex (manager, "mbim9"), ==, 4);
+
+    g_assert (mbim_net_port_manager_index_list_sibling_links (manager, "wwan0", &links));
+    assert_links (links, "mbim9");
+    g_clear_pointer (&links, g_ptr_array_unref);
+}
+
+/*****************************************************************************/
+
+/* 212.73.34.248/28 via 212.73.34.241, MTU 1500 */
+static const guint8 ip_configuration_response_ipv4[] = {
+    /* header */
+    0x03, 0x00, 0x00, 0x80, /* type */
+    0x80, 0x00, 0x00, 0x00, /* length */
+    0x1A, 0x00, 0x00, 0x00, /* transaction id */
+    /* fragment header */
+    0x01, 0x00, 0x00, 0x00, /* total */
+    0x00, 0x00, 0x00, 0x00, /* current */
+    /* command_done_message */
+    0xA2, 0x89, 0xCC, 0x33, /* service id */
+    0xBC, 0xBB, 0x8B, 0x4F,
+    0xB6, 0xB0, 0x13, 0x3E,
+    0xC2, 0xAA, 0xE6, 0xDF,
+    0x0F, 0x00, 0x00, 0x00, /* command id */
+    0x00, 0x00, 0x00, 0x00, /* status code */
+    0x50, 0x00, 0x00, 0x00, /* buffer length */
+    /* information buffer */
+    0x00, 0x00, 0x00, 0x00, /* session id */
+    0x0F, 0x00, 0x00, 0x00, /* IPv4ConfigurationAvailable */
+    0x00, 0x00, 0x00, 0x00, /* IPv6ConfigurationAvailable */
+    0x01, 0x00, 0x00, 0x00, /* IPv4 element count */
+    0x3C, 0x00, 0x00, 0x00, /* IPv4 element offset */
+    0x00, 0x00, 0x00, 0x00, /* IPv6 element count */
+    0x00, 0x00, 0x00, 0x00, /* IPv6 element offset */
+    0x44, 0x00, 0x00, 0x00, /* IPv4 gateway offset */
+    0x00, 0x00, 0x00, 0x00, /* IPv6 gateway offset */
+    0x02, 0x00, 0x00, 0x00, /* IPv4 DNS count */
+    0x48, 0x00, 0x00, 0x00, /* IPv4 DNS offset */
+    0x00, 0x00, 0x00, 0x00, /* IPv6 DNS count */
+    0x00, 0x00, 0x00, 0x00, /* IPv6 DNS offset */
+    0xDC, 0x05, 0x00, 0x00, /* IPv4 MTU */
+    0x00, 0x00, 0x00, 0x00, /* IPv6 MTU */
+    /* data buffer */
+    0x1C, 0x00, 0x00, 0x00, /* IPv4 element (netmask) */
+    0xD4, 0x49, 0x22, 0xF8, /* IPv4 element (address) */
+    0xD4, 0x49, 0x22, 0xF1, /* IPv4 gateway */
+    0xD4, 0xA6, 0xD2, 0x50, /* IPv4 DNS1 */
+    0xD4, 0x49, 0x20, 0x43  /* IPv4 DNS2 */
+};
+
+static void
+test_ip_configuration_response_ipv4 (void)
+{
+    g_autoptr(MbimMessage) response = NULL;
+    g_autoptr(GError)      error = NULL;
+    Requests               r;
+    struct ifinfomsg      *ifi;
+    struct ifaddrmsg      *ifa;
+    struct rtmsg          *rtm;
+    const guint8           address[] = { 0xD4, 0x49, 0x22, 0xF8 };
+    const guint8           gateway[] = { 0xD4, 0x49, 0x22, 0xF1 };
+    const guint32          mtu = 1500;
+    const guint32          metric = TEST_ROUTE_METRIC;
+
+    response = mbim_message_new (ip_configuration_response_ipv4, sizeof (ip_configuration_response_ipv4));
+    g_assert (mbim_message_validate (response, &error));
+    g_assert_no_error (error);
+
+    requests_init (&r);
+    g_assert (mbim_net_port_manager_util_build_ip_configuration (response, "wwan0", TEST_IFINDEX, TEST_ROUTE_METRIC,
+                                                                 r.msgs, r.requests, r.undo_msgs, &error));
+    g_assert_no_error (error);
+
+    /* link up, address, default route; DNS servers are ignored */
+    g_assert_cmpuint (r.msgs->len, ==, 3);
+    g_assert_cmpuint (r.requests->len, ==, 3);
+    g_assert_cmpstr (g_ptr_array_index (r.requests, 0), ==, "bring up wwan0 with MTU 1500");
+    g_assert_cmpstr (g_ptr_array_index (r.requests, 1), ==, "add address 212.73.34.248/28 to wwan0");
+    g_assert_cmpstr (g_ptr_array_index (r.requests, 2), ==, "add IPv4 default route via 212.73.34.241 to wwan0");
+
+    g_assert_cmpuint (msg_type (r.msgs, 0), ==, RTM_NEWLINK);
+    ifi = NLMSG_DATA (((NetlinkMessage *) g_ptr_array_index (r.msgs, 0))->data);
+    g_assert_cmpint (ifi->ifi_index, ==, TEST_IFINDEX);
+    g_assert_cmpuint (ifi->ifi_flags & IFF_UP, ==, IFF_UP);
+    g_assert_cmpuint (ifi->ifi_change & IFF_UP, ==, IFF_UP);
+    g_assert (msg_has_attribute (r.msgs, 0, sizeof (struct ifinfomsg), IFLA_MTU, (const guint8 *) &mtu, sizeof (mtu)));
+
+    g_assert_cmpuint (msg_type (r.msgs, 1), ==, RTM_NEWADDR);
+    ifa = NLMSG_DATA (((NetlinkMessage *) g_ptr_array_index (r.msgs, 1))->data);
+    g_assert_cmpuint (ifa->ifa_family, ==, AF_INET);
+    g_assert_cmpuint (ifa->ifa_prefixlen, ==, 28);
+    g_assert_cmpuint (ifa->ifa_index, ==, TEST_IFINDEX);
+    g_assert (msg_has_attribute (r.msgs, 1, sizeof (struct ifaddrmsg), IFA_LOCAL, address, sizeof (address)));
+
+    g_assert_cmpuint (msg_type (r.msgs, 2), ==, RTM_NEWROUTE);
+    rtm = NLMSG_DATA (((NetlinkMessage *) g_ptr_array_index (r.msgs, 2))->data);
+    g_assert_cmpuint (rtm->rtm_family, ==, AF_INET);
+    g_assert_cmpuint (rtm->rtm_dst_len, ==, 0);
+    g_assert_cmpuint (rtm->rtm_flags & RTNH_F_ONLINK, ==, RTNH_F_ONLINK);
+    g_assert (msg_has_attribute (r.msgs, 2, sizeof (struct rtmsg), RTA_GATEWAY, gateway, sizeof (gateway)));
+    g_assert (msg_has_attribute (r.msgs, 2, sizeof (struct rtmsg), RTA_PRIORITY, (const guint8 *) &metric, sizeof (metric)));
+
+    /* the link is left up when undoing */
+    g_assert_cmpuint (r.undo_msgs->len, ==, 2);
+    g_assert_cmpuint (msg_type (r.undo_msgs, 0), ==, RTM_DELADDR);
+    g_assert_cmpuint (msg_type (r.undo_msgs, 1), ==, RTM_DELROUTE);
+
+    requests_clear (&r);
+}
+
+static void
+test_ip_configuration_indication_ipv6 (void)
+{
+    g_autoptr(MbimMessage) indication = NULL;
+    g_autoptr(GError)      error = NULL;
+    Requests               r;
+    const guint32          mtu = 1280;
+
+    const guint8 buffer [] =  {
+        /* header */
+        0x07, 0x00, 0x00, 0x80, /* type */
+        0x8C, 0x00, 0x00, 0x00, /* length */
+        0x00, 0x00, 0x00, 0x00, /* transaction id */
+        /* fragment header */
+        0x01, 0x00, 0x00, 0x00, /* total */
+        0x00, 0x00, 0x00, 0x00, /* current */
+        /* indicate_status_message */
+        0xA2, 0x89, 0xCC, 0x33, /* service id */
+        0xBC, 0xBB, 0x8B, 0x4F,
+        0xB6, 0xB0, 0x13, 0x3E,
+        0xC2, 0xAA, 0xE6, 0xDF,
+        0x0F, 0x00, 0x00, 0x00, /* command id */
+        0x60, 0x00, 0x00, 0x00, /* buffer length */
+        /* information buffer */
+        0x00, 0x00, 0x00, 0x00, /* session id */
+        0x00, 0x00, 0x00, 0x00, /* IPv4ConfigurationAvailable */
+        0x0B, 0x00, 0x00, 0x00, /* IPv6ConfigurationAvailable */
+        0x00, 0x00, 0x00, 0x00, /* IPv4 element count */
+        0x00, 0x00, 0x00, 0x00, /* IPv4 element offset */
+        0x01, 0x00, 0x00, 0x00, /* IPv6 element count */
+        0x3C, 0x00, 0x00, 0x00, /* IPv6 element offset */
+        0x00, 0x00, 0x00, 0x00, /* IPv4 gateway offset */
+        0x50, 0x00, 0x00, 0x00, /* IPv6 gateway offset */
+        0x00, 0x00, 0x00, 0x00, /* IPv4 DNS count */
+        0x00, 0x00, 0x00, 0x00, /* IPv4 DNS offset */
+        0x00, 0x00, 0x00, 0x00, /* IPv6 DNS count */
+        0x00, 0x00, 0x00, 0x00, /* IPv6 DNS offset */
+        0x00, 0x00, 0x00, 0x00, /* IPv4 MTU */
+        0xE8, 0x03, 0x00, 0x00, /* IPv6 MTU */
+        /* data buffer */
+        0x40, 0x00, 0x00, 0x00, /* IPv6 element (netmask) */
+        0x20, 0x01, 0x0D, 0xB8, /* IPv6 element (address) */
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x10,
+        0xFE, 0x80, 0x00, 0x00, /* IPv6 gateway */
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x01
+    };
+
+    indication = mbim_message_new (buffer, sizeof (buffer));
+    g_assert (mbim_message_validate (indication, &error));
+    g_assert_no_error (error);
+
+    requests_init (&r);
+    g_assert (mbim_net_port_manager_util_build_ip_configuration (indication, "wwan0", TEST_IFINDEX, TEST_ROUTE_METRIC,
+                                                                 r.msgs, r.requests, r.undo_msgs, &error));
+    g_assert_no_error (error);
+
+    /* the MTU reported is too low for IPv6 */
+    g_assert_cmpuint (r.msgs->len, ==, 3);
+    g_assert_cmpstr (g_ptr_array_index (r.requests, 0), ==, "bring up wwan0 with MTU 1280");
+    g_assert_cmpstr (g_ptr_array_index (r.requests, 1), ==, "add address 2001:db8::10/64 to wwan0");
+    g_assert_cmpstr (g_ptr_array_index (r.requests, 2), ==, "add IPv6 default route via fe80::1 to wwan0");
+    g_assert (msg_has_attribute (r.msgs, 0, sizeof (struct ifinfomsg), IFLA_MTU, (const guint8 *) &mtu, sizeof (mtu)));
+    g_assert_cmpuint (msg_type (r.msgs, 1), ==, RTM_NEWADDR);
+    g_assert_cmpuint (msg_type (r.msgs, 2), ==, RTM_NEWROUTE);
+
+    g_assert_cmpuint (r.undo_msgs->len, ==, 2);
+
+    requests_clear (&r);
+}
+
+static void
+test_ip_configuration_invalid (void)
+{
+    g_autoptr(MbimMessage) message = NULL;
+    g_autoptr(GError)      error = NULL;
+    Requests               r;
+
+    /* Not an IP configuration response */
+    message = mbim_message_open_new (1, 4096);
+    requests_init (&r);
+    g_assert (!mbim_net_port_manager_util_build_ip_configuration (message, "wwan0", TEST_IFINDEX, TEST_ROUTE_METRIC,
+                                                                  r.msgs, r.requests, r.undo_msgs, &error));
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS);
+    g_assert_cmpuint (r.msgs->len, ==, 0);
+    g_assert_cmpuint (r.undo_msgs->len, ==, 0);
+    requests_clear (&r);
+}
+
+static GPtrArray *
+apply_ip_configuration (TestNetPortManager *self,
+                        const guint8       *buffer,
+                        gsize               buffer_len,
+                        gint                del_errno)
+{
+    g_autoptr(MbimMessage)  response = NULL;
+    g_autoptr(GAsyncResult) res = NULL;
+    g_autoptr(GError)       error = NULL;
+    GPtrArray              *sent;
+
+    response = mbim_message_new (buffer, buffer_len);
+    mbim_net_port_manager_apply_ip_configuration (MBIM_NET_PORT_MANAGER (self), "mbimtest0", response,
+                                                  TEST_ROUTE_METRIC, 5, NULL,
+                                                  (GAsyncReadyCallback) async_result_ready, &res);
+    sent = test_net_port_manager_kernel_ack (self, del_errno);
+    g_assert (mbim_net_port_manager_apply_ip_configuration_finish (MBIM_NET_PORT_MANAGER (self),
+                                                                   wait_async_result (&res), &error));
+    g_assert_no_error (error);
+    return sent;
+}
+
+static void
+test_ip_configuration_apply_twice (void)
+{
+    g_autoptr(TestNetPortManager) self = NULL;
+    g_autoptr(GPtrArray)          sent = NULL;
+    guint8                        changed[sizeof (ip_configuration_response_ipv4)];
+    const guint8                  old_address[] = { 0xD4, 0x49, 0x22, 0xF8 };
+    const guint8                  new_address[] = { 0xD4, 0x49, 0x22, 0xF9 };
+
+    /* Same configuration with a different address */
+    memcpy (changed, ip_configuration_response_ipv4, sizeof (changed));
+    changed[115] = 0xF9;
+
+    self = test_net_port_manager_new ();
+    link_event (self, RTM_NEWLINK, TEST_IFINDEX, "mbimtest0", 0, NULL);
+    mbim_net_port_manager_index_set_synced (MBIM_NET_PORT_MANAGER (self));
+
+    /* Nothing to remove the first time */
+    sent = apply_ip_configuration (self, ip_configuration_response_ipv4, sizeof (ip_configuration_response_ipv4), 0);
+    g_assert_cmpuint (sent->len, ==, 3);
+    g_assert_cmpuint (msg_type (sent, 0), ==, RTM_NEWLINK);
+    g_assert_cmpuint (msg_type (sent, 1), ==, RTM_NEWADDR);
+    g_assert_cmpuint (msg_type (sent, 2), ==, RTM_NEWROUTE);
+    g_clear_pointer (&sent, g_ptr_array_unref);
+
+    /* Only the old address is removed, at the front of the same batch; the
+     * route didn't change. Failing to remove it is not an error. */
+    sent = apply_ip_configuration (self, changed, sizeof (changed), EADDRNOTAVAIL);
+    g_assert_cmpuint (sent->len, ==, 4);
+    g_assert_cmpuint (msg_type (sent, 0), ==, RTM_DELADDR);
+    g_assert (msg_has_attribute (sent, 0, sizeof (struct ifaddrmsg), IFA_LOCAL, old_address, sizeof (old_address)));
+    g_assert_cmpuint (msg_type (sent, 1), ==, RTM_NEWLINK);
+    g_assert_cmpuint (msg_type (sent, 2), ==, RTM_NEWADDR);
+    g_assert (msg_has_attribute (sent, 2, sizeof (struct ifaddrmsg), IFA_LOCAL, new_address, sizeof (new_address)));
+    g_assert_cmpuint (msg_type (sent, 3), ==, RTM_NEWROUTE);
+    g_clear_pointer (&sent, g_ptr_array_unref);
+
+    /* The old address may still be there, so it is removed again */
+    sent = apply_ip_configuration (self, changed, sizeof (changed), 0);
+    g_assert_cmpuint (sent->len, ==, 4);
+    g_assert_cmpuint (msg_type (sent, 0), ==, RTM_DELADDR);
+    g_assert (msg_has_attribute (sent, 0, sizeof (struct ifaddrmsg), IFA_LOCAL, old_address, sizeof (old_address)));
+    g_clear_pointer (&sent, g_ptr_array_unref);
+
+    /* Once removed, applying it again removes nothing */
+    sent = apply_ip_configuration (self, changed, sizeof (changed), 0);
+    g_assert_cmpuint (sent->len, ==, 3);
+    g_assert_cmpuint (msg_type (sent, 0), ==, RTM_NEWLINK);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/libmbim-glib/net-port-manager/ip-configuration/response-ipv4",   test_ip_configuration_response_ipv4);
+    g_test_add_func ("/libmbim-glib/net-port-manager/ip-configuration/indication-ipv6", test_ip_configuration_indication_ipv6);
+    g_test_add_func ("/libmbim-glib/net-port-manager/ip-configuration/invalid",         test_ip_configuration_invalid);
+    g_test_add_func ("/libmbim-glib/net-port-manager/ip-configuration/apply-twice",     test_ip_configuration_apply_twice);
+    g_test_add_func ("/libmbim-glib/net-port-manager/add-links",                        test_add_links);
+    g_test_add_func ("/libmbim-glib/net-port-manager/add-links/duplicated",             test_add_links_duplicated);
+    g_test_add_func ("/libmbim-glib/net-port-manager/add-link",                         test_add_link);
+    g_test_add_func ("/libmbim-glib/net-port-manager/link-index/parse",                 test_parse_link);
+    g_test_add_func ("/libmbim-glib/net-port-manager/link-index/list",                  test_link_index_list);
+    g_test_add_func ("/libmbim-glib/net-port-manager/link-index/events",                test_link_index_events);
+
+    return g_test_run ();
+}
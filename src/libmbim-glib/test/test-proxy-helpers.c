@@ -396,6 +396,350 @@ test_merge_list_merged_services (void)
 
 /*****************************************************************************/
 
+static MbimEventEntry *
+event_entry_new (MbimService    service,
+                 guint32        cids_count,
+                 const guint32 *cids)
+{
+    MbimEventEntry *entry;
+
+    entry = g_new0 (MbimEventEntry, 1);
+    memcpy (&entry->device_service_id, mbim_uuid_from_service (service), sizeof (MbimUuid));
+    entry->cids_count = cids_count;
+    if (cids_count)
+        entry->cids = g_memdup (cids, sizeof (guint32) * cids_count);
+    return entry;
+}
+
+static void
+test_subscription_set_update (void)
+{
+    MbimProxySubscriptionSet *set;
+    MbimEventEntry          **standard;
+    gsize                     standard_size;
+    MbimEventEntry          **a;
+    MbimEventEntry          **b;
+    MbimEventEntry          **built;
+    gsize                     built_size;
+    MbimEventEntry          **expected;
+    gsize                     expected_size;
+    static const guint32      atds_cids_a[] = { MBIM_CID_ATDS_SIGNAL, MBIM_CID_ATDS_LOCATION };
+    static const guint32      atds_cids_b[] = { MBIM_CID_ATDS_LOCATION, MBIM_CID_ATDS_RAT };
+    static const guint32      sms_cids[]    = { MBIM_CID_SMS_READ };
+
+    set = _mbim_proxy_helper_subscription_set_new ();
+    standard = _mbim_proxy_helper_service_subscribe_list_new_standard (&standard_size);
+
+    /* Client A: ATDS signal+location, and a standard service which is ignored */
+    a = g_new0 (MbimEventEntry *, 3);
+    a[0] = event_entry_new (MBIM_SERVICE_ATDS, G_N_ELEMENTS (atds_cids_a), atds_cids_a);
+    a[1] = event_entry_new (MBIM_SERVICE_SMS, G_N_ELEMENTS (sms_cids), sms_cids);
+
+    /* Client B: ATDS location+rat, and all QMI CIDs */
+    b = g_new0 (MbimEventEntry *, 3);
+    b[0] = event_entry_new (MBIM_SERVICE_ATDS, G_N_ELEMENTS (atds_cids_b), atds_cids_b);
+    b[1] = event_entry_new (MBIM_SERVICE_QMI, 0, NULL);
+
+    /* Standard services only: nothing changes */
+    _mbim_proxy_helper_subscription_set_update (set, NULL, 0, (const MbimEventEntry * const *)&a[1], 1);
+    g_assert (!_mbim_proxy_helper_subscription_set_changed (set));
+    _mbim_proxy_helper_subscription_set_update (set, (const MbimEventEntry * const *)&a[1], 1, NULL, 0);
+    g_assert (!_mbim_proxy_helper_subscription_set_changed (set));
+
+    /* Adding both clients matches the full merge */
+    _mbim_proxy_helper_subscription_set_update (set, NULL, 0, (const MbimEventEntry * const *)a, 2);
+    _mbim_proxy_helper_subscription_set_update (set, NULL, 0, (const MbimEventEntry * const *)b, 2);
+    g_assert (_mbim_proxy_helper_subscription_set_changed (set));
+    built = _mbim_proxy_helper_subscription_set_build (set, &built_size);
+    g_assert (!_mbim_proxy_helper_subscription_set_changed (set));
+
+    expected = _mbim_proxy_helper_service_subscribe_list_dup (standard, standard_size, &expected_size);
+    expected = _mbim_proxy_helper_service_subscribe_list_merge (expected, expected_size, a, 2, &expected_size);
+    expected = _mbim_proxy_helper_service_subscribe_list_merge (expected, expected_size, b, 2, &expected_size);
+    g_assert_cmpuint (built_size, ==, standard_size + 2);
+    g_assert (_mbim_proxy_helper_service_subscribe_list_cmp ((const MbimEventEntry * const *)built, built_size,
+                                                             (const MbimEventEntry * const *)expected, expected_size));
+    mbim_event_entry_array_free (built);
+    mbim_event_entry_array_free (expected);
+
+    /* Re-sending the same list doesn't change anything */
+    _mbim_proxy_helper_subscription_set_update (set,
+                                                (const MbimEventEntry * const *)a, 2,
+                                                (const MbimEventEntry * const *)a, 2);
+    g_assert (!_mbim_proxy_helper_subscription_set_changed (set));
+
+    /* Removing client B keeps the ATDS location CID, as A still uses it */
+    _mbim_proxy_helper_subscription_set_update (set, (const MbimEventEntry * const *)b, 2, NULL, 0);
+    g_assert (_mbim_proxy_helper_subscription_set_changed (set));
+    built = _mbim_proxy_helper_subscription_set_build (set, &built_size);
+    expected = _mbim_proxy_helper_service_subscribe_list_dup (standard, standard_size, &expected_size);
+    expected = _mbim_proxy_helper_service_subscribe_list_merge (expected, expected_size, a, 2, &expected_size);
+    g_assert (_mbim_proxy_helper_service_subscribe_list_cmp ((const MbimEventEntry * const *)built, built_size,
+                                                             (const MbimEventEntry * const *)expected, expected_size));
+    mbim_event_entry_array_free (built);
+    mbim_event_entry_array_free (expected);
+
+    /* Removing client A leaves the standard list */
+    _mbim_proxy_helper_subscription_set_update (set, (const MbimEventEntry * const *)a, 2, NULL, 0);
+    g_assert (_mbim_proxy_helper_subscription_set_changed (set));
+    built = _mbim_proxy_helper_subscription_set_build (set, &built_size);
+    g_assert (_mbim_proxy_helper_service_subscribe_list_cmp ((const MbimEventEntry * const *)built, built_size,
+                                                             (const MbimEventEntry * const *)standard, standard_size));
+    mbim_event_entry_array_free (built);
+
+    mbim_event_entry_array_free (a);
+    mbim_event_entry_array_free (b);
+    mbim_event_entry_array_free (standard);
+    _mbim_proxy_helper_subscription_set_free (set);
+}
+
+/*****************************************************************************/
+
+#define BENCHMARK_N_CLIENTS 500
+#define BENCHMARK_N_UPDATES 200
+
+static MbimEventEntry **
+benchmark_client_list_new (GRand *rand,
+                           gsize *out_size)
+{
+    static const MbimService services[] = {
+        MBIM_SERVICE_SMS, /* standard, ignored */
+        MBIM_SERVICE_MS_FIRMWARE_ID,
+        MBIM_SERVICE_MS_HOST_SHUTDOWN,
+        MBIM_SERVICE_QMI,
+        MBIM_SERVICE_ATDS,
+        MBIM_SERVICE_INTEL_FIRMWARE_UPDATE,
+        MBIM_SERVICE_MS_BASIC_CONNECT_EXTENSIONS,
+        MBIM_SERVICE_MS_SAR,
+        MBIM_SERVICE_MS_VOICE_EXTENSIONS,
+    };
+    MbimEventEntry **list;
+    gsize            n;
+    gsize            i;
+
+    n = g_rand_int_range (rand, 1, 4);
+    list = g_new0 (MbimEventEntry *, n + 1);
+    for (i = 0; i < n; i++) {
+        guint32 cids[4];
+        guint32 n_cids = 0;
+        guint32 j;
+
+        /* One in ten services with all CIDs enabled */
+        if (g_rand_int_range (rand, 0, 10) > 0) {
+            guint32 first;
+
+            /* Distinct CIDs, as a client would never list the same one twice */
+            n_cids = g_rand_int_range (rand, 1, G_N_ELEMENTS (cids) + 1);
+            first = g_rand_int_range (rand, 1, 12);
+            for (j = 0; j < n_cids; j++)
+                cids[j] = first + j;
+        }
+        list[i] = event_entry_new (services[g_rand_int_range (rand, 0, G_N_ELEMENTS (services))], n_cids, cids);
+    }
+
+    *out_size = n;
+    return list;
+}
+
+static MbimEventEntry **
+benchmark_full_merge (MbimEventEntry **lists[],
+                      gsize            lists_size[],
+                      gsize           *out_size)
+{
+    MbimEventEntry **merged;
+    gsize            merged_size;
+    guint            i;
+
+    merged = _mbim_proxy_helper_service_subscribe_list_new_standard (&merged_size);
+    for (i = 0; i < BENCHMARK_N_CLIENTS; i++)
+        merged = _mbim_proxy_helper_service_subscribe_list_merge (merged, merged_size, lists[i], lists_size[i], &merged_size);
+
+    *out_size = merged_size;
+    return merged;
+}
+
+static void
+test_subscription_set_benchmark (void)
+{
+    MbimProxySubscriptionSet  *set;
+    GRand                     *rand;
+    MbimEventEntry           **lists[BENCHMARK_N_CLIENTS];
+    gsize                      lists_size[BENCHMARK_N_CLIENTS];
+    MbimEventEntry           **current;
+    gsize                      current_size;
+    gdouble                    full_elapsed = 0;
+    gdouble                    incremental_elapsed = 0;
+    guint                      n_changes = 0;
+    guint                      i;
+
+    rand = g_rand_new_with_seed (1234);
+    set = _mbim_proxy_helper_subscription_set_new ();
+
+    for (i = 0; i < BENCHMARK_N_CLIENTS; i++) {
+        lists[i] = benchmark_client_list_new (rand, &lists_size[i]);
+        _mbim_proxy_helper_subscription_set_update (set, NULL, 0, (const MbimEventEntry * const *)lists[i], lists_size[i]);
+    }
+    current = _mbim_proxy_helper_subscription_set_build (set, &current_size);
+
+    for (i = 0; i < BENCHMARK_N_UPDATES; i++) {
+        g_autoptr(MbimEventEntryArray)  merged = NULL;
+        gsize                           merged_size;
+        MbimEventEntry                **updated;
+        gsize                           updated_size;
+        guint                           client;
+
+        /* A random client updates its subscription list */
+        client = g_rand_int_range (rand, 0, BENCHMARK_N_CLIENTS);
+        updated = benchmark_client_list_new (rand, &updated_size);
+
+        /* Incremental update */
+        g_test_timer_start ();
+        _mbim_proxy_helper_subscription_set_update (set,
+                                                    (const MbimEventEntry * const *)lists[client], lists_size[client],
+                                                    (const MbimEventEntry * const *)updated, updated_size);
+        if (_mbim_proxy_helper_subscription_set_changed (set)) {
+            mbim_event_entry_array_free (current);
+            current = _mbim_proxy_helper_subscription_set_build (set, &current_size);
+            n_changes++;
+        }
+        incremental_elapsed += g_test_timer_elapsed ();
+
+        mbim_event_entry_array_free (lists[client]);
+        lists[client] = updated;
+        lists_size[client] = updated_size;
+
+        /* Full merge of all client lists, as reference */
+        g_test_timer_start ();
+        merged = benchmark_full_merge (lists, lists_size, &merged_size);
+        full_elapsed += g_test_timer_elapsed ();
+
+        g_assert (_mbim_proxy_helper_service_subscribe_list_cmp ((const MbimEventEntry * const *)current, current_size,
+                                                                 (const MbimEventEntry * const *)merged, merged_size));
+    }
+
+    g_test_message ("%u clients, %u updates (%u changing the merged list): "
+                    "full merge %.3f ms, incremental %.3f ms",
+                    BENCHMARK_N_CLIENTS, BENCHMARK_N_UPDATES, n_changes,
+                    full_elapsed * 1000, incremental_elapsed * 1000);
+
+    /* Once all clients are gone, only the standard list is left */
+    for (i = 0; i < BENCHMARK_N_CLIENTS; i++) {
+        _mbim_proxy_helper_subscription_set_update (set, (const MbimEventEntry * const *)lists[i], lists_size[i], NULL, 0);
+        mbim_event_entry_array_free (lists[i]);
+    }
+    mbim_event_entry_array_free (current);
+    current = _mbim_proxy_helper_subscription_set_build (set, &current_size);
+    g_assert_cmpuint (current_size, ==, 5);
+
+    mbim_event_entry_array_free (current);
+    _mbim_proxy_helper_subscription_set_free (set);
+    g_rand_free (rand);
+}
+
+/*****************************************************************************/
+
+static void
+test_serialize_list (void)
+{
+    static const guint32   atds_cids[] = { MBIM_CID_ATDS_SIGNAL, MBIM_CID_ATDS_RAT };
+    MbimEventEntry       **list;
+    gsize                  list_size = 3;
+    MbimEventEntry       **parsed;
+    gsize                  parsed_size = 0;
+    g_auto(GStrv)          strv = NULL;
+    g_autoptr(GError)      error = NULL;
+
+    list = g_new0 (MbimEventEntry *, list_size + 1);
+    list[0] = event_entry_new (MBIM_SERVICE_ATDS, G_N_ELEMENTS (atds_cids), atds_cids);
+    list[1] = event_entry_new (MBIM_SERVICE_QMI, 0, NULL);
+    list[2] = event_entry_new (MBIM_SERVICE_MS_HOST_SHUTDOWN, 0, NULL);
+
+    strv = _mbim_proxy_helper_service_subscribe_list_to_strv ((const MbimEventEntry * const *)list, list_size);
+    g_assert_cmpuint (g_strv_length (strv), ==, list_size);
+    g_assert_cmpstr (strv[0], ==, "5967bdcc-7fd2-49a2-9f5c-b2e70e527db3:1,4");
+    g_assert_cmpstr (strv[1], ==, "d1a30bc2-f97a-6e43-bf65-c7e24fb0f0d3");
+
+    parsed = _mbim_proxy_helper_service_subscribe_list_from_strv ((const gchar * const *)strv, &parsed_size, &error);
+    g_assert_no_error (error);
+    g_assert (parsed);
+    g_assert (_mbim_proxy_helper_service_subscribe_list_cmp ((const MbimEventEntry * const *)list, list_size,
+                                                             (const MbimEventEntry * const *)parsed, parsed_size));
+
+    mbim_event_entry_array_free (parsed);
+    mbim_event_entry_array_free (list);
+}
+
+static void
+test_serialize_list_invalid (void)
+{
+    static const gchar *invalid_uuid[] = { "not-an-uuid:1", NULL };
+    static const gchar *invalid_cid[]  = { "5967bdcc-7fd2-49a2-9f5c-b2e70e527db3:1,x", NULL };
+    MbimEventEntry    **parsed;
+    gsize               parsed_size = 0;
+    GError             *error = NULL;
+
+    parsed = _mbim_proxy_helper_service_subscribe_list_from_strv (invalid_uuid, &parsed_size, &error);
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS);
+    g_assert (!parsed);
+    g_clear_error (&error);
+
+    parsed = _mbim_proxy_helper_service_subscribe_list_from_strv (invalid_cid, &parsed_size, &error);
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS);
+    g_assert (!parsed);
+    g_clear_error (&error);
+}
+
+/*****************************************************************************/
+
+static void
+test_latency_histogram_empty (void)
+{
+    MbimProxyLatencyHistogram histogram = { 0 };
+
+    g_assert_cmpuint (_mbim_proxy_helper_latency_histogram_percentile (&histogram, 50), ==, 0);
+    g_assert_cmpuint (_mbim_proxy_helper_latency_histogram_percentile (&histogram, 99), ==, 0);
+}
+
+static void
+test_latency_histogram_percentiles (void)
+{
+    MbimProxyLatencyHistogram histogram = { 0 };
+    guint                     i;
+
+    /* 90 samples in [8,16), 9 samples in [512,1024), 1 sample in [65536,131072) */
+    for (i = 0; i < 90; i++)
+        _mbim_proxy_helper_latency_histogram_add (&histogram, 10);
+    for (i = 0; i < 9; i++)
+        _mbim_proxy_helper_latency_histogram_add (&histogram, 1000);
+    _mbim_proxy_helper_latency_histogram_add (&histogram, 100000);
+
+    g_assert_cmpuint (histogram.count, ==, 100);
+    g_assert_cmpuint (_mbim_proxy_helper_latency_histogram_percentile (&histogram, 0),   ==, 15);
+    g_assert_cmpuint (_mbim_proxy_helper_latency_histogram_percentile (&histogram, 50),  ==, 15);
+    g_assert_cmpuint (_mbim_proxy_helper_latency_histogram_percentile (&histogram, 90),  ==, 15);
+    g_assert_cmpuint (_mbim_proxy_helper_latency_histogram_percentile (&histogram, 99),  ==, 1023);
+    g_assert_cmpuint (_mbim_proxy_helper_latency_histogram_percentile (&histogram, 100), ==, 131071);
+}
+
+static void
+test_latency_histogram_limits (void)
+{
+    MbimProxyLatencyHistogram histogram = { 0 };
+
+    /* Zero and negative latencies go to the first bucket */
+    _mbim_proxy_helper_latency_histogram_add (&histogram, 0);
+    _mbim_proxy_helper_latency_histogram_add (&histogram, -5);
+    g_assert_cmpuint (histogram.buckets[0], ==, 2);
+    g_assert_cmpuint (_mbim_proxy_helper_latency_histogram_percentile (&histogram, 100), ==, 1);
+
+    /* Huge latencies go to the last bucket */
+    _mbim_proxy_helper_latency_histogram_add (&histogram, G_MAXINT64);
+    g_assert_cmpuint (histogram.buckets[MBIM_PROXY_LATENCY_HISTOGRAM_BUCKETS - 1], ==, 1);
+    g_assert_cmpuint (_mbim_proxy_helper_latency_histogram_percentile (&histogram, 100), ==, G_MAXUINT32);
+}
+
+/*****************************************************************************/
+
 int main (int argc, char **argv)
 {
     g_test_init (&argc, &argv, NULL);
@@ -409,6 +753,14 @@ int main (int argc, char **argv)
     g_test_add_func ("/libmbim-glib/proxy/merge/same-service",         test_merge_list_same_service);
     g_test_add_func ("/libmbim-glib/proxy/merge/different-services",   test_merge_list_different_services);
     g_test_add_func ("/libmbim-glib/proxy/merge/merged-services",      test_merge_list_merged_services);
+    g_test_add_func ("/libmbim-glib/proxy/subscriptions/update",       test_subscription_set_update);
+    if (g_test_perf ())
+        g_test_add_func ("/libmbim-glib/proxy/subscriptions/benchmark", test_subscription_set_benchmark);
+    g_test_add_func ("/libmbim-glib/proxy/serialize/list",             test_serialize_list);
+    g_test_add_func ("/libmbim-glib/proxy/serialize/invalid",          test_serialize_list_invalid);
+    g_test_add_func ("/libmbim-glib/proxy/latency/empty",              test_latency_histogram_empty);
+    g_test_add_func ("/libmbim-glib/proxy/latency/percentiles",        test_latency_histogram_percentiles);
+    g_test_add_func ("/libmbim-glib/proxy/latency/limits",             test_latency_histogram_limits);
 
     return g_test_run ();
 }
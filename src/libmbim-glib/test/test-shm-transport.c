@@ -0,0 +1,220 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <config.h>
+#include <string.h>
+
+#include "mbim-error-types.h"
+#include "mbim-shm-transport.h"
+
+/*****************************************************************************/
+
+static void
+transport_pair_new (guint32            ring_size,
+                    MbimShmTransport **out_client,
+                    MbimShmTransport **out_proxy)
+{
+    g_autoptr(MbimShmTransport) client = NULL;
+    g_autoptr(MbimShmTransport) proxy = NULL;
+    g_autoptr(GUnixFDList)      fd_list = NULL;
+    g_autofree gint            *fds = NULL;
+    g_autoptr(GError)           error = NULL;
+    gint                        n_fds = 0;
+
+    client = _mbim_shm_transport_new (ring_size, &error);
+    g_assert_no_error (error);
+    g_assert (client);
+
+    /* As if sent to the proxy */
+    fd_list = _mbim_shm_transport_get_fd_list (client, &error);
+    g_assert_no_error (error);
+    fds = g_unix_fd_list_steal_fds (fd_list, &n_fds);
+    g_assert_cmpint (n_fds, ==, MBIM_SHM_TRANSPORT_N_FDS);
+
+    proxy = _mbim_shm_transport_new_from_fds (fds, ring_size, &error);
+    g_assert_no_error (error);
+    g_assert (proxy);
+
+    *out_client = g_steal_pointer (&client);
+    *out_proxy = g_steal_pointer (&proxy);
+}
+
+static gboolean
+wake_pending (MbimShmTransport *transport)
+{
+    GPollFD pollfd;
+
+    pollfd.fd = _mbim_shm_transport_get_wake_fd (transport);
+    pollfd.events = G_IO_IN;
+    pollfd.revents = 0;
+    return (g_poll (&pollfd, 1, 0) == 1 && (pollfd.revents & G_IO_IN));
+}
+
+/*****************************************************************************/
+
+static void
+test_shm_transport_exchange (void)
+{
+    g_autoptr(MbimShmTransport) client = NULL;
+    g_autoptr(MbimShmTransport) proxy = NULL;
+    g_autoptr(GByteArray)       buffer = NULL;
+    g_autoptr(GError)           error = NULL;
+    static const guint8         request[]  = { 0x03, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00 };
+    static const guint8         response[] = { 0x03, 0x00, 0x00, 0x80, 0x0C, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00 };
+
+    transport_pair_new (MBIM_SHM_TRANSPORT_RING_SIZE_DEFAULT, &client, &proxy);
+    buffer = g_byte_array_new ();
+
+    /* Nothing to read yet */
+    g_assert (!wake_pending (proxy));
+    g_assert (_mbim_shm_transport_read (proxy, buffer, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (buffer->len, ==, 0);
+
+    /* Client to proxy, the proxy is woken up */
+    g_assert (_mbim_shm_transport_write (client, request, sizeof (request), &error));
+    g_assert_no_error (error);
+    g_assert (wake_pending (proxy));
+    g_assert (_mbim_shm_transport_read (proxy, buffer, &error));
+    g_assert_no_error (error);
+    g_assert (!wake_pending (proxy));
+    g_assert_cmpmem (buffer->data, buffer->len, request, sizeof (request));
+
+    /* Proxy to client */
+    g_byte_array_set_size (buffer, 0);
+    g_assert (_mbim_shm_transport_write (proxy, response, sizeof (response), &error));
+    g_assert_no_error (error);
+    g_assert (wake_pending (client));
+    g_assert (_mbim_shm_transport_read (client, buffer, &error));
+    g_assert_no_error (error);
+    g_assert_cmpmem (buffer->data, buffer->len, response, sizeof (response));
+}
+
+static void
+test_shm_transport_coalesce (void)
+{
+    g_autoptr(MbimShmTransport) client = NULL;
+    g_autoptr(MbimShmTransport) proxy = NULL;
+    g_autoptr(GByteArray)       buffer = NULL;
+    g_autoptr(GError)           error = NULL;
+    static const guint8         data[] = { 0x01, 0x02, 0x03, 0x04 };
+    guint                       i;
+
+    transport_pair_new (MBIM_SHM_TRANSPORT_RING_SIZE_DEFAULT, &client, &proxy);
+    buffer = g_byte_array_new ();
+
+    /* Only the first write into an empty ring wakes up the consumer, but
+     * all data is read at once */
+    for (i = 0; i < 10; i++)
+        g_assert (_mbim_shm_transport_write (client, data, sizeof (data), &error));
+    g_assert (_mbim_shm_transport_read (proxy, buffer, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (buffer->len, ==, 10 * sizeof (data));
+    g_assert (!wake_pending (proxy));
+}
+
+static void
+test_shm_transport_wrap (void)
+{
+    g_autoptr(MbimShmTransport) client = NULL;
+    g_autoptr(MbimShmTransport) proxy = NULL;
+    g_autoptr(GByteArray)       sent = NULL;
+    g_autoptr(GByteArray)       received = NULL;
+    g_autoptr(GByteArray)       unused = NULL;
+    g_autoptr(GError)           error = NULL;
+    guint                       i;
+
+    transport_pair_new (4096, &client, &proxy);
+
+    /* Much more data than the ring size: the part not fitting is kept
+     * pending in the producer until the consumer frees some space */
+    sent = g_byte_array_sized_new (10000);
+    for (i = 0; i < 10000; i++) {
+        guint8 value = (guint8) (i % 251);
+
+        g_byte_array_append (sent, &value, 1);
+    }
+    g_assert (_mbim_shm_transport_write (client, sent->data, 3000, &error));
+    g_assert_no_error (error);
+    g_assert (_mbim_shm_transport_write (client, sent->data + 3000, 7000, &error));
+    g_assert_no_error (error);
+
+    received = g_byte_array_new ();
+    unused = g_byte_array_new ();
+    for (i = 0; i < 10; i++) {
+        g_assert (_mbim_shm_transport_read (proxy, received, &error));
+        g_assert_no_error (error);
+        if (received->len == sent->len)
+            break;
+
+        /* The consumer wakes the producer up once space is available, and
+         * the pending data is written when the producer processes it */
+        g_assert (wake_pending (client));
+        g_assert (_mbim_shm_transport_read (client, unused, &error));
+        g_assert_no_error (error);
+        g_assert_cmpuint (unused->len, ==, 0);
+    }
+    g_assert_cmpmem (received->data, received->len, sent->data, sent->len);
+}
+
+static void
+test_shm_transport_not_reading (void)
+{
+    g_autoptr(MbimShmTransport) client = NULL;
+    g_autoptr(MbimShmTransport) proxy = NULL;
+    g_autoptr(GByteArray)       received = NULL;
+    g_autoptr(GByteArray)       unused = NULL;
+    g_autoptr(GError)           error = NULL;
+    guint8                      data[4000] = { 0 };
+    guint                       i;
+
+    transport_pair_new (4096, &client, &proxy);
+
+    /* Data is kept pending only up to a few times the ring size */
+    for (i = 0; i < 10; i++) {
+        if (!_mbim_shm_transport_write (client, data, sizeof (data), &error))
+            break;
+        g_assert_no_error (error);
+    }
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_FAILED);
+    g_assert_cmpuint (i, >, 1);
+    g_assert_cmpuint (i, <, 10);
+    g_clear_error (&error);
+
+    /* Once the consumer frees some space, it is accepted again */
+    received = g_byte_array_new ();
+    g_assert (_mbim_shm_transport_read (proxy, received, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (received->len, >, 0);
+    unused = g_byte_array_new ();
+    g_assert (_mbim_shm_transport_read (client, unused, &error));
+    g_assert_no_error (error);
+    g_assert (_mbim_shm_transport_write (client, data, sizeof (data), &error));
+    g_assert_no_error (error);
+}
+
+static void
+test_shm_transport_invalid_ring_size (void)
+{
+    g_autoptr(MbimShmTransport) transport = NULL;
+    g_autoptr(GError)           error = NULL;
+
+    transport = _mbim_shm_transport_new (5000, &error);
+    g_assert_error (error, MBIM_CORE_ERROR, MBIM_CORE_ERROR_INVALID_ARGS);
+    g_assert (!transport);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/libmbim-glib/shm-transport/exchange",          test_shm_transport_exchange);
+    g_test_add_func ("/libmbim-glib/shm-transport/coalesce",          test_shm_transport_coalesce);
+    g_test_add_func ("/libmbim-glib/shm-transport/wrap",              test_shm_transport_wrap);
+    g_test_add_func ("/libmbim-glib/shm-transport/not-reading",       test_shm_transport_not_reading);
+    g_test_add_func ("/libmbim-glib/shm-transport/invalid-ring-size", test_shm_transport_invalid_ring_size);
+
+    return g_test_run ();
+}
@@ -5,6 +5,7 @@
  */
 
 #include <config.h>
+#include <string.h>
 
 #include "mbim-uuid.h"
 
@@ -206,6 +207,134 @@ test_uuid_custom (void)
 
 /*****************************************************************************/
 
+static void
+test_uuid_to_service (void)
+{
+    MbimService service;
+    MbimUuid    uuid;
+
+    for (service = MBIM_SERVICE_BASIC_CONNECT; service < MBIM_SERVICE_LAST; service++)
+        g_assert_cmpuint (mbim_uuid_to_service (mbim_uuid_from_service (service)), ==, service);
+
+    g_assert_cmpuint (mbim_uuid_to_service (MBIM_UUID_INVALID), ==, MBIM_SERVICE_INVALID);
+
+    /* same first word as a known service, but not the same UUID */
+    memcpy (&uuid, MBIM_UUID_BASIC_CONNECT, sizeof (uuid));
+    uuid.e[5] ^= 0xFF;
+    g_assert_cmpuint (mbim_uuid_to_service (&uuid), ==, MBIM_SERVICE_INVALID);
+}
+
+static void
+test_uuid_to_context_type (void)
+{
+    MbimContextType context_type;
+    MbimUuid        uuid;
+
+    for (context_type = MBIM_CONTEXT_TYPE_NONE; context_type <= MBIM_CONTEXT_TYPE_EMERGENCY_CALLING; context_type++)
+        g_assert_cmpuint (mbim_uuid_to_context_type (mbim_uuid_from_context_type (context_type)), ==, context_type);
+
+    g_assert_cmpuint (mbim_uuid_to_context_type (MBIM_UUID_INVALID), ==, MBIM_CONTEXT_TYPE_INVALID);
+
+    memcpy (&uuid, mbim_uuid_from_context_type (MBIM_CONTEXT_TYPE_INTERNET), sizeof (uuid));
+    uuid.d[0] ^= 0xFF;
+    g_assert_cmpuint (mbim_uuid_to_context_type (&uuid), ==, MBIM_CONTEXT_TYPE_INVALID);
+}
+
+static void
+test_uuid_custom_first_word (void)
+{
+    MbimUuid uuid;
+    guint    service;
+
+    /* custom service sharing the first word with a known one */
+    memcpy (&uuid, MBIM_UUID_BASIC_CONNECT, sizeof (uuid));
+    uuid.e[5] ^= 0xFF;
+
+    service = mbim_register_custom_service (&uuid, "first_word");
+    g_assert (mbim_service_id_is_custom (service));
+    g_assert_cmpuint (mbim_uuid_to_service (&uuid), ==, service);
+    g_assert_cmpuint (mbim_uuid_to_service (MBIM_UUID_BASIC_CONNECT), ==, MBIM_SERVICE_BASIC_CONNECT);
+
+    /* registering the same UUID again gives the same service */
+    g_assert_cmpuint (mbim_register_custom_service (&uuid, "first_word"), ==, service);
+
+    g_assert (mbim_unregister_custom_service (service));
+    g_assert_cmpuint (mbim_uuid_to_service (&uuid), ==, MBIM_SERVICE_INVALID);
+}
+
+/*****************************************************************************/
+
+#define BENCHMARK_N_CUSTOM_SERVICES 8
+#define BENCHMARK_N_LOOPS           100000
+
+/* Reference lookup comparing the UUIDs one by one, as done before */
+static MbimService
+benchmark_uuid_to_service_linear (const MbimUuid *uuid,
+                                  const guint    *custom_services)
+{
+    guint i;
+
+    for (i = MBIM_SERVICE_BASIC_CONNECT; i < MBIM_SERVICE_LAST; i++) {
+        if (mbim_uuid_cmp (uuid, mbim_uuid_from_service (i)))
+            return i;
+    }
+    for (i = 0; i < BENCHMARK_N_CUSTOM_SERVICES; i++) {
+        if (mbim_uuid_cmp (uuid, mbim_uuid_from_service (custom_services[i])))
+            return custom_services[i];
+    }
+    return MBIM_SERVICE_INVALID;
+}
+
+static void
+test_uuid_to_service_benchmark (void)
+{
+    guint           custom_services[BENCHMARK_N_CUSTOM_SERVICES];
+    const MbimUuid *uuids[MBIM_SERVICE_LAST - 1 + BENCHMARK_N_CUSTOM_SERVICES];
+    guint           n_uuids = 0;
+    guint           checksum_linear = 0;
+    guint           checksum = 0;
+    gdouble         linear_elapsed;
+    gdouble         elapsed;
+    guint           i;
+    guint           j;
+
+    for (i = MBIM_SERVICE_BASIC_CONNECT; i < MBIM_SERVICE_LAST; i++)
+        uuids[n_uuids++] = mbim_uuid_from_service (i);
+
+    for (i = 0; i < BENCHMARK_N_CUSTOM_SERVICES; i++) {
+        MbimUuid uuid = { .a = { 0xBE, 0x9C, 0x4A, (guint8)i } };
+
+        custom_services[i] = mbim_register_custom_service (&uuid, "benchmark");
+        uuids[n_uuids++] = mbim_uuid_from_service (custom_services[i]);
+    }
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_LOOPS; i++) {
+        for (j = 0; j < n_uuids; j++)
+            checksum_linear += benchmark_uuid_to_service_linear (uuids[j], custom_services);
+    }
+    linear_elapsed = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_N_LOOPS; i++) {
+        for (j = 0; j < n_uuids; j++)
+            checksum += mbim_uuid_to_service (uuids[j]);
+    }
+    elapsed = g_test_timer_elapsed ();
+
+    g_assert_cmpuint (checksum, ==, checksum_linear);
+
+    for (i = 0; i < BENCHMARK_N_CUSTOM_SERVICES; i++)
+        g_assert (mbim_unregister_custom_service (custom_services[i]));
+
+    g_test_message ("%u services (%u custom), %u lookups each: linear %.1f ns/lookup, first word dispatch %.1f ns/lookup",
+                    n_uuids, BENCHMARK_N_CUSTOM_SERVICES, BENCHMARK_N_LOOPS,
+                    linear_elapsed * 1e9 / (BENCHMARK_N_LOOPS * n_uuids),
+                    elapsed * 1e9 / (BENCHMARK_N_LOOPS * n_uuids));
+}
+
+/*****************************************************************************/
+
 int main (int argc, char **argv)
 {
     g_test_init (&argc, &argv, NULL);
@@ -234,6 +363,12 @@ int main (int argc, char **argv)
     g_test_add_func ("/libmbim-glib/uuid/invalid/no-hex", test_uuid_invalid_no_hex);
 
     g_test_add_func ("/libmbim-glib/uuid/custom", test_uuid_custom);
+    g_test_add_func ("/libmbim-glib/uuid/custom/first-word", test_uuid_custom_first_word);
+
+    g_test_add_func ("/libmbim-glib/uuid/to-service",           test_uuid_to_service);
+    if (g_test_perf ())
+        g_test_add_func ("/libmbim-glib/uuid/to-service/benchmark", test_uuid_to_service_benchmark);
+    g_test_add_func ("/libmbim-glib/uuid/to-context-type",      test_uuid_to_context_type);
 
     return g_test_run ();
 }
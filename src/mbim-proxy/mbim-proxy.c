@@ -13,6 +13,8 @@
 #include <stdlib.h>
 #include <locale.h>
 #include <string.h>
+#include <unistd.h>
+#include <errno.h>
 
 #include <glib.h>
 #include <glib/gprintf.h>
@@ -38,6 +40,11 @@ static gboolean verbose_full_flag;
 static gboolean version_flag;
 static gboolean no_exit_flag;
 static gint     empty_timeout = -1;
+static gint     client_max_in_flight = -1;
+static gint     n_shards = -1;
+static gint     ready_fd = -1;
+static gchar   *state_file;
+static gchar  **keep_open;
 
 static GOptionEntry main_entries[] = {
     { "no-exit", 0, 0, G_OPTION_ARG_NONE, &no_exit_flag,
@@ -48,6 +55,26 @@ static GOptionEntry main_entries[] = {
       "If no clients/devices, exit after this timeout. If set to 0, equivalent to --no-exit.",
       "[SECS]"
     },
+    { "client-max-in-flight", 0, 0, G_OPTION_ARG_INT, &client_max_in_flight,
+      "Maximum number of requests from a single client ongoing in a device. If set to 0, no limit.",
+      "[N]"
+    },
+    { "shards", 0, 0, G_OPTION_ARG_INT, &n_shards,
+      "Run devices in this number of worker threads, up to " G_STRINGIFY (MBIM_PROXY_N_SHARDS_MAX) ". If set to 0, everything runs in the main thread.",
+      "[N]"
+    },
+    { "state-file", 0, 0, G_OPTION_ARG_FILENAME, &state_file,
+      "Save the state of the open devices in this file on exit, and resume them from it on startup.",
+      "[PATH]"
+    },
+    { "keep-open", 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &keep_open,
+      "Open this device on startup and keep it open even without clients; implies --no-exit. May be given multiple times.",
+      "[PATH]"
+    },
+    { "ready-fd", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_INT, &ready_fd,
+      "Write to this file descriptor once ready to accept clients, and close it.",
+      "[FD]"
+    },
     { "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose_flag,
       "Run action with verbose logs, including the debug ones",
       NULL
@@ -162,11 +189,13 @@ proxy_n_clients_changed (MbimProxy *_proxy)
         return;
 
     if (mbim_proxy_get_n_clients (proxy) == 0) {
-        g_assert (timeout_id == 0);
         g_assert (empty_timeout > 0);
-        timeout_id = g_timeout_add_seconds (empty_timeout,
-                                            (GSourceFunc)stop_loop_cb,
-                                            NULL);
+        /* Notifications may be coalesced when running shards, so the
+         * timeout may already be set */
+        if (!timeout_id)
+            timeout_id = g_timeout_add_seconds (empty_timeout,
+                                                (GSourceFunc)stop_loop_cb,
+                                                NULL);
         return;
     }
 
@@ -183,11 +212,13 @@ static void
 proxy_n_devices_changed (MbimProxy *_proxy)
 {
     if (mbim_proxy_get_n_devices (proxy) == 0) {
-        g_assert (timeout_id == 0);
         g_assert (empty_timeout > 0);
-        timeout_id = g_timeout_add_seconds (empty_timeout,
-                                            (GSourceFunc)stop_loop_cb,
-                                            NULL);
+        /* Notifications may be coalesced when running shards, so the
+         * timeout may already be set */
+        if (!timeout_id)
+            timeout_id = g_timeout_add_seconds (empty_timeout,
+                                                (GSourceFunc)stop_loop_cb,
+                                                NULL);
         return;
     }
 
@@ -200,6 +231,25 @@ proxy_n_devices_changed (MbimProxy *_proxy)
 
 /*****************************************************************************/
 
+static void
+report_ready (void)
+{
+    static const gchar ready = 1;
+
+    /* The process spawning the proxy waits for either this byte or the
+     * descriptor being closed, so that it doesn't need to poll */
+    while (write (ready_fd, &ready, 1) < 0) {
+        if (errno != EINTR) {
+            g_warning ("couldn't report readiness: %s", g_strerror (errno));
+            break;
+        }
+    }
+    close (ready_fd);
+    ready_fd = -1;
+}
+
+/*****************************************************************************/
+
 int main (int argc, char **argv)
 {
     g_autoptr(GError)         error = NULL;
@@ -247,6 +297,43 @@ int main (int argc, char **argv)
         exit (EXIT_FAILURE);
     }
 
+    /* Setup per-client scheduling limits */
+    if (client_max_in_flight >= 0)
+        g_object_set (proxy, MBIM_PROXY_CLIENT_MAX_IN_FLIGHT, (guint) client_max_in_flight, NULL);
+
+    /* Setup worker threads running the devices */
+    if (n_shards > MBIM_PROXY_N_SHARDS_MAX) {
+        g_printerr ("error: too many shards: %d (maximum %u)\n", n_shards, MBIM_PROXY_N_SHARDS_MAX);
+        exit (EXIT_FAILURE);
+    }
+    if (n_shards >= 0)
+        g_object_set (proxy, MBIM_PROXY_N_SHARDS, (guint) n_shards, NULL);
+
+    /* Resume the devices left open by a previous instance; the state is
+     * valid only once, so remove it right away */
+    if (state_file && g_file_test (state_file, G_FILE_TEST_EXISTS)) {
+        if (!mbim_proxy_restore_state (proxy, state_file, &error)) {
+            g_warning ("couldn't restore proxy state: %s", error->message);
+            g_clear_error (&error);
+        }
+        if (unlink (state_file) < 0)
+            g_warning ("couldn't remove proxy state file: %s", g_strerror (errno));
+    }
+
+    /* Open the devices to keep warm; the proxy must not exit while they're
+     * not available, or they wouldn't be opened again */
+    if (keep_open) {
+        guint i;
+
+        for (i = 0; keep_open[i]; i++) {
+            if (!mbim_proxy_keep_device_open (proxy, keep_open[i], &error)) {
+                g_printerr ("error: couldn't keep device '%s' open: %s\n", keep_open[i], error->message);
+                exit (EXIT_FAILURE);
+            }
+        }
+        no_exit_flag = TRUE;
+    }
+
     /* Don't exit the proxy when no clients/devices are found */
     if (!no_exit_flag && empty_timeout != 0) {
         g_debug ("proxy will exit after %d secs if unused", empty_timeout);
@@ -262,14 +349,27 @@ int main (int argc, char **argv)
     } else
         g_debug ("proxy will remain running if unused");
 
+    /* Clients may be accepted right away */
+    if (ready_fd >= 0)
+        report_ready ();
+
     /* Loop */
     loop = g_main_loop_new (NULL, FALSE);
     g_main_loop_run (loop);
     g_main_loop_unref (loop);
 
+    /* Keep the open devices available for the next instance */
+    if (state_file && !mbim_proxy_save_state (proxy, state_file, &error)) {
+        g_warning ("couldn't save proxy state: %s", error->message);
+        g_clear_error (&error);
+    }
+
     /* Cleanup; releases socket and such */
     g_object_unref (proxy);
 
+    g_free (state_file);
+    g_strfreev (keep_open);
+
     g_debug ("exiting 'mbim-proxy'...");
 
     return EXIT_SUCCESS;
@@ -127,7 +127,7 @@ query_signal_ready (MbimDevice   *device,
     g_autofree gchar       *rssnr_str = NULL;
     guint32 rssi = 0, error_rate = 0, rscp = 0, ecno = 0, rsrq = 0, rsrp = 0, rssnr = 0;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -245,7 +245,7 @@ query_location_ready (MbimDevice   *device,
     g_autoptr(GError)      error = NULL;
     guint32 lac = 0, tac = 0, cellid = 0;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -285,7 +285,7 @@ query_operators_ready (MbimDevice   *device,
     g_autoptr(MbimAtdsProviderArray) operators = NULL;
     guint                            i;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -341,7 +341,7 @@ query_rat_ready (MbimDevice   *device,
     g_autoptr(GError)      error = NULL;
     MbimAtdsRatMode        rat = MBIM_ATDS_RAT_MODE_AUTOMATIC;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
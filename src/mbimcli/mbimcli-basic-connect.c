@@ -411,7 +411,7 @@ query_device_caps_ready (MbimDevice   *device,
     g_autofree gchar       *firmware_info = NULL;
     g_autofree gchar       *hardware_info = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -493,7 +493,7 @@ query_subscriber_ready_status_ready (MbimDevice   *device,
     g_autofree gchar              *telephone_numbers_str = NULL;
     MbimSubscriberReadyStatusFlag  flags;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -575,7 +575,7 @@ query_radio_state_ready (MbimDevice   *device,
     MbimRadioSwitchState    software_radio_state;
     const gchar            *software_radio_state_str;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -615,7 +615,7 @@ query_device_services_ready (MbimDevice   *device,
     guint32                                  device_services_count;
     guint32                                  max_dss_sessions;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -696,7 +696,7 @@ pin_ready (MbimDevice   *device,
     const gchar            *pin_state_str;
     guint32                 remaining_attempts;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -838,7 +838,7 @@ pin_list_ready (MbimDevice   *device,
     g_autoptr(MbimPinDesc) pin_desc_subsidy_lock = NULL;
     g_autoptr(MbimPinDesc) pin_desc_custom = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -888,7 +888,7 @@ ip_configuration_query_ready (MbimDevice   *device,
     g_autoptr(MbimMessage) response;
     gboolean               success = FALSE;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response ||
         !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: couldn't get IP configuration response message: %s\n", error->message);
@@ -956,7 +956,7 @@ connect_ready (MbimDevice   *device,
     const MbimUuid          *context_type;
     guint32                  nw_error;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1050,7 +1050,7 @@ ip_packet_filters_ready (MbimDevice   *device,
     guint32                            filters_count;
     guint32                            i;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response ||
         !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
@@ -1500,7 +1500,7 @@ home_provider_ready (MbimDevice   *device,
     g_autofree gchar        *provider_state_str = NULL;
     g_autofree gchar        *cellular_class_str = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1544,7 +1544,7 @@ preferred_providers_ready (MbimDevice   *device,
     guint                        n_providers;
     guint                        i;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1598,7 +1598,7 @@ visible_providers_ready (MbimDevice   *device,
     guint                        n_providers;
     guint                        i;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1663,7 +1663,7 @@ register_state_ready (MbimDevice   *device,
     g_autofree gchar       *registration_flag_str = NULL;
     MbimDataClass           preferred_data_classes;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1804,7 +1804,7 @@ signal_state_ready (MbimDevice   *device,
     guint32                         rsrp_snr_count;
     g_autoptr(MbimRsrpSnrInfoArray) rsrp_snr = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1931,7 +1931,7 @@ packet_service_ready (MbimDevice   *device,
     MbimDataSubclass        data_subclass;
     g_autoptr(MbimTai)      tai = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -2088,7 +2088,7 @@ packet_statistics_ready (MbimDevice   *device,
     guint32                out_errors;
     guint32                out_discards;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -2142,7 +2142,7 @@ provisioned_contexts_ready (MbimDevice   *device,
     guint32 provisioned_contexts_count;
     guint   i;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -2301,7 +2301,7 @@ network_idle_hint_ready (MbimDevice   *device,
     MbimNetworkIdleHintState  network_state;
     const gchar              *network_state_str = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -2334,7 +2334,7 @@ emergency_mode_ready (MbimDevice   *device,
     MbimEmergencyModeState  emergency_state;
     const gchar            *emergency_state_str = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -2369,7 +2369,7 @@ set_service_activation_ready (MbimDevice   *device,
     const guint8           *result_data = NULL;
     g_autofree gchar       *result_data_str = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
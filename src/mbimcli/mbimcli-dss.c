@@ -117,7 +117,7 @@ ip_configuration_query_ready (MbimDevice   *device,
     g_autoptr(GError)      error = NULL;
     gboolean               success = FALSE;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response ||
         !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: couldn't get IP configuration response message: %s\n", error->message);
@@ -139,7 +139,7 @@ set_dss_ready (MbimDevice   *device,
     g_autoptr(MbimMessage) message = NULL;
     g_autoptr(GError)      error = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
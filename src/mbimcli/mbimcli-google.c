@@ -108,7 +108,7 @@ set_carrier_lock_ready (MbimDevice   *device,
     g_autoptr(MbimMessage)  response = NULL;
     g_autoptr(GError)       error = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -134,7 +134,7 @@ query_carrier_lock_ready (MbimDevice   *device,
     MbimCarrierLockModemState  carrier_lock_modem_state;
     MbimCarrierLockCause       carrier_lock_cause;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -103,7 +103,7 @@ intel_at_tunnel_at_command_ready (MbimDevice   *device,
     const guint8           *ret_str  = NULL;
     g_autoptr(MbimMessage) response  = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
 
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
@@ -119,7 +119,7 @@ modem_reboot_ready (MbimDevice   *device,
     g_autoptr(MbimMessage) response = NULL;
     g_autoptr(GError)      error = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
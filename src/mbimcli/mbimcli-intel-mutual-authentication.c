@@ -113,7 +113,7 @@ query_fcc_lock_ready (MbimDevice *device,
     gboolean      challenge_present = FALSE;
     guint32       challenge         = 0;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
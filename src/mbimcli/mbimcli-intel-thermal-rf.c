@@ -126,7 +126,7 @@ query_rfim_ready (MbimDevice   *device,
     guint32                           element_count;
     MbimIntelRfimFrequencyValueArray *rfim_frequency;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -215,7 +215,7 @@ set_rfim_state_ready (MbimDevice   *device,
     g_autoptr(MbimMessage) response = NULL;
     g_autoptr(GError)      error = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -123,7 +123,7 @@ query_trace_config_ready (MbimDevice   *device,
     const gchar            *trace_cmd_str;
     guint32                 trace_result;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -161,7 +161,7 @@ set_trace_config_ready (MbimDevice   *device,
     g_autoptr(MbimMessage)  response = NULL;
     g_autoptr(GError)       error = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
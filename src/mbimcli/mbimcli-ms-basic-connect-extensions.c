@@ -267,7 +267,7 @@ query_pco_ready (MbimDevice   *device,
     g_autoptr(MbimPcoValue)  pco_value = NULL;
     g_autofree gchar        *pco_data = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -310,7 +310,7 @@ lte_attach_configuration_ready (MbimDevice   *device,
     guint32                                    configuration_count = 0;
     guint                                      i;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -459,7 +459,7 @@ query_lte_attach_info_ready (MbimDevice   *device,
     guint32                 auth_protocol;
     MbimNwError             nw_error = 0;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -544,7 +544,7 @@ query_sys_caps_ready (MbimDevice   *device,
     guint32                 concurrency;
     guint64                 modem_id;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -614,7 +614,7 @@ query_device_caps_ready (MbimDevice   *device,
     g_autofree gchar       *hardware_info = NULL;
     guint32                 executor_index = 0;
 
-    response = mbim_device_command_finish(device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -789,7 +789,7 @@ query_slot_information_status_ready (MbimDevice   *device,
     MbimUiccSlotState      slot_state;
     const gchar           *slot_state_str;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -871,7 +871,7 @@ query_device_slot_mappings_ready (MbimDevice   *device,
     g_autoptr(MbimSlotArray) slot_mappings = NULL;
     guint                    i;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -915,7 +915,7 @@ query_location_info_status_ready (MbimDevice   *device,
     guint32                tracking_area_code = 0;
     guint32                cell_id = 0;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1038,7 +1038,7 @@ provisioned_contexts_ready (MbimDevice   *device,
     guint32 provisioned_contexts_count;
     guint32 i = 0;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1125,7 +1125,7 @@ query_base_stations_ready (MbimDevice   *device,
     guint32                                        nr_neighboring_cells_count;
     g_autoptr(MbimCellInfoNeighboringNrArray)      nr_neighboring_cells = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1457,7 +1457,7 @@ query_version_ready (MbimDevice   *device,
     guint16                mbim_version;
     guint16                mbim_ext_version;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1550,7 +1550,7 @@ registration_parameters_ready (MbimDevice   *device,
     MbimDefaultPduActivationHint pdu_hint;
     gboolean                     re_register_if_nedeed;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1591,7 +1591,7 @@ query_modem_configuration_ready (MbimDevice   *device,
     MbimModemConfigurationStatus   configuration_status;
     g_autofree gchar              *configuration_name = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1629,7 +1629,7 @@ query_wake_reason_ready (MbimDevice   *device,
     guint32                 session_id;
     MbimTlv                *wake_tlv = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -1737,7 +1737,7 @@ device_reset_ready (MbimDevice   *device,
     g_autoptr(MbimMessage)  response = NULL;
     g_autoptr(GError)       error = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
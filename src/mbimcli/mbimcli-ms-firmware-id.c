@@ -103,7 +103,7 @@ query_firmware_id_ready (MbimDevice   *device,
     const MbimUuid         *firmware_id;
     g_autofree gchar       *firmware_id_str = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
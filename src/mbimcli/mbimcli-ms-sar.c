@@ -129,7 +129,7 @@ ms_sar_ready (MbimDevice   *device,
     g_autoptr(MbimSarConfigStateArray)  config_states = NULL;
     guint32                             i;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -189,7 +189,7 @@ modem_transmission_status_ready (MbimDevice   *device,
     const gchar                        *transmission_status_str;
     guint32                             hysteresis_timer;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -114,7 +114,7 @@ query_nitz_ready (MbimDevice   *device,
     MbimDataClass data_class;
     g_autofree gchar *data_class_str = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -0,0 +1,217 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * mbimcli -- Command line interface to control MBIM devices
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <locale.h>
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libmbim-glib.h>
+
+#include "mbimcli.h"
+
+/* Context */
+typedef struct {
+    MbimDevice *device;
+    GCancellable *cancellable;
+} Context;
+static Context *ctx;
+
+/* Options */
+static gboolean query_proxy_stats_flag;
+
+static GOptionEntry entries[] = {
+    { "query-proxy-stats", 0, 0, G_OPTION_ARG_NONE, &query_proxy_stats_flag,
+      "Query proxy statistics (requires --device-open-proxy)",
+      NULL
+    },
+    { NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+
+GOptionGroup *
+mbimcli_proxy_control_get_option_group (void)
+{
+   GOptionGroup *group;
+
+   group = g_option_group_new ("proxy-control",
+                               "Proxy Control options:",
+                               "Show Proxy Control Service options",
+                               NULL,
+                               NULL);
+   g_option_group_add_entries (group, entries);
+
+   return group;
+}
+
+gboolean
+mbimcli_proxy_control_options_enabled (void)
+{
+    static guint n_actions = 0;
+    static gboolean checked = FALSE;
+
+    if (checked)
+        return !!n_actions;
+
+    n_actions = query_proxy_stats_flag;
+
+    if (n_actions > 1) {
+        g_printerr ("error: too many Proxy Control actions requested\n");
+        exit (EXIT_FAILURE);
+    }
+
+    checked = TRUE;
+    return !!n_actions;
+}
+
+static void
+context_free (Context *context)
+{
+    if (!context)
+        return;
+
+    if (context->cancellable)
+        g_object_unref (context->cancellable);
+    if (context->device)
+        g_object_unref (context->device);
+    g_slice_free (Context, context);
+}
+
+static void
+shutdown (gboolean operation_status)
+{
+    /* Cleanup context and finish async operation */
+    context_free (ctx);
+    mbimcli_async_operation_done (operation_status);
+}
+
+static void
+query_proxy_stats_ready (MbimDevice   *device,
+                         GAsyncResult *res)
+{
+    g_autoptr(MbimMessage)                    response = NULL;
+    g_autoptr(GError)                         error = NULL;
+    guint32                                   devices_count;
+    g_autoptr(MbimProxyDeviceStatisticsArray) devices = NULL;
+    guint32                                   clients_count;
+    g_autoptr(MbimProxyClientStatisticsArray) clients = NULL;
+    guint32                                   i;
+
+    response = mbimcli_device_command_finish (device, res, &error);
+    if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
+        g_printerr ("error: operation failed: %s\n", error->message);
+        shutdown (FALSE);
+        return;
+    }
+
+    if (!mbim_message_proxy_control_statistics_response_parse (response,
+                                                               &devices_count,
+                                                               &devices,
+                                                               &clients_count,
+                                                               &clients,
+                                                               &error)) {
+        g_printerr ("error: couldn't parse response message: %s\n", error->message);
+        shutdown (FALSE);
+        return;
+    }
+
+    g_print ("[%s] Proxy statistics retrieved:\n",
+             mbim_device_get_path_display (device));
+
+    g_print ("\t                   Devices: %u\n", devices_count);
+    for (i = 0; i < devices_count; i++) {
+        g_print ("\t[%s]\n"
+                 "\t                   Clients: %u\n"
+                 "\t        Requests forwarded: %" G_GUINT64_FORMAT "\n"
+                 "\t        Requests timed out: %" G_GUINT64_FORMAT "\n"
+                 "\t          Abandoned queued: %u\n"
+                 "\t       Abandoned in flight: %u\n"
+                 "\t           Requests queued: %u (max %u)\n"
+                 "\t              Queued bytes: %u\n"
+                 "\tDevice latency p50/p90/p99: %u/%u/%u us\n"
+                 "\t Queue latency p50/p90/p99: %u/%u/%u us\n"
+                 "\t      Indications received: %" G_GUINT64_FORMAT "\n"
+                 "\t     Indications forwarded: %" G_GUINT64_FORMAT "\n"
+                 "\t                Cache hits: %" G_GUINT64_FORMAT "\n",
+                 VALIDATE_UNKNOWN (devices[i]->device_path),
+                 devices[i]->clients,
+                 devices[i]->requests_forwarded,
+                 devices[i]->requests_timed_out,
+                 devices[i]->requests_abandoned_queued,
+                 devices[i]->requests_abandoned_in_flight,
+                 devices[i]->requests_queued,
+                 devices[i]->requests_queued_max,
+                 devices[i]->queued_bytes,
+                 devices[i]->device_latency_p50, devices[i]->device_latency_p90, devices[i]->device_latency_p99,
+                 devices[i]->queue_latency_p50, devices[i]->queue_latency_p90, devices[i]->queue_latency_p99,
+                 devices[i]->indications_received,
+                 devices[i]->indications_forwarded,
+                 devices[i]->cache_hits);
+    }
+
+    g_print ("\t                   Clients: %u\n", clients_count);
+    for (i = 0; i < clients_count; i++) {
+        g_print ("\t[client %u]\n"
+                 "\t                    Device: %s\n"
+                 "\t        Requests forwarded: %" G_GUINT64_FORMAT "\n"
+                 "\t        Requests timed out: %" G_GUINT64_FORMAT "\n"
+                 "\t        Requests in flight: %u\n"
+                 "\t           Requests queued: %u\n"
+                 "\t              Queued bytes: %u\n"
+                 "\tDevice latency p50/p90/p99: %u/%u/%u us\n"
+                 "\t Queue latency p50/p90/p99: %u/%u/%u us\n"
+                 "\t     Indications forwarded: %" G_GUINT64_FORMAT "\n"
+                 "\t                Cache hits: %" G_GUINT64_FORMAT "\n"
+                 "\t                    Weight: %u\n"
+                 "\t            Outgoing bytes: %u\n",
+                 clients[i]->client_id,
+                 VALIDATE_UNKNOWN (clients[i]->device_path),
+                 clients[i]->requests_forwarded,
+                 clients[i]->requests_timed_out,
+                 clients[i]->requests_in_flight,
+                 clients[i]->requests_queued,
+                 clients[i]->queued_bytes,
+                 clients[i]->device_latency_p50, clients[i]->device_latency_p90, clients[i]->device_latency_p99,
+                 clients[i]->queue_latency_p50, clients[i]->queue_latency_p90, clients[i]->queue_latency_p99,
+                 clients[i]->indications_forwarded,
+                 clients[i]->cache_hits,
+                 clients[i]->weight,
+                 clients[i]->outgoing_bytes);
+    }
+
+    shutdown (TRUE);
+}
+
+void
+mbimcli_proxy_control_run (MbimDevice   *device,
+                           GCancellable *cancellable)
+{
+    g_autoptr(MbimMessage) request = NULL;
+
+    /* Initialize context */
+    ctx = g_slice_new (Context);
+    ctx->device = g_object_ref (device);
+    ctx->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+
+    /* Request to query proxy statistics */
+    if (query_proxy_stats_flag) {
+        g_debug ("Asynchronously querying proxy statistics...");
+        request = mbim_message_proxy_control_statistics_query_new (NULL);
+        mbim_device_command (ctx->device,
+                             request,
+                             10,
+                             ctx->cancellable,
+                             (GAsyncReadyCallback)query_proxy_stats_ready,
+                             NULL);
+        return;
+    }
+
+    g_warn_if_reached ();
+}
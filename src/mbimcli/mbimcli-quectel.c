@@ -122,7 +122,7 @@ radio_state_ready (MbimDevice   *device,
 
     action_flag = GPOINTER_TO_UINT (user_data);
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -162,7 +162,7 @@ qdu_command_ready (MbimDevice   *device,
     const guint8           *ret_data   = NULL;
     g_autoptr(MbimMessage)  response   = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
 
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
@@ -122,7 +122,7 @@ delete_sms_ready (MbimDevice   *device,
     g_autoptr(GError)      error = NULL;
     MbimSmsFlag            filter = GPOINTER_TO_INT (user_data);
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -155,7 +155,7 @@ read_sms_ready (MbimDevice   *device,
     guint32                              num_messages = 0;
     MbimSmsFlag                          filter = GPOINTER_TO_INT (user_data);
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -206,7 +206,7 @@ query_sms_config_ready (MbimDevice   *device,
     guint32                 cdma_short_message_size = 0;
     g_autofree gchar       *sc_address = NULL;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
@@ -256,7 +256,7 @@ query_sms_message_store_status_ready (MbimDevice   *device,
     const gchar            *status_str;
     guint                   message_index = 0;
 
-    response = mbim_device_command_finish (device, res, &error);
+    response = mbimcli_device_command_finish (device, res, &error);
     if (!response || !mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error)) {
         g_printerr ("error: operation failed: %s\n", error->message);
         shutdown (FALSE);
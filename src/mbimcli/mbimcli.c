@@ -47,8 +47,12 @@ static gboolean verbose_flag;
 static gboolean verbose_full_flag;
 static gboolean silent_flag;
 static gchar *printable_str;
+static gchar *output_format_str;
 static gboolean version_flag;
 
+/* Output format */
+static gboolean output_format_json;
+
 static GOptionEntry main_entries[] = {
     { "device", 'd', 0, G_OPTION_ARG_STRING, &device_str,
       "Specify device path",
@@ -94,6 +98,10 @@ static GOptionEntry main_entries[] = {
       "Get the printable info of the given hex encoded MBIM message",
       "[(Data)]"
     },
+    { "output-format", 0, 0, G_OPTION_ARG_STRING, &output_format_str,
+      "Output format of the received messages",
+      "[text|json]"
+    },
     { "version", 'V', 0, G_OPTION_ARG_NONE, &version_flag,
       "Print version",
       NULL
@@ -197,6 +205,50 @@ print_version_and_exit (void)
 
 /*****************************************************************************/
 
+static void
+discard_print_handler (const gchar *string)
+{
+}
+
+/* The JSON output is written directly to stdout, as the print handler
+ * discards the text output of the actions when JSON is requested */
+static gboolean
+print_json (const MbimMessage  *message,
+            guint8              mbimex_version_major,
+            guint8              mbimex_version_minor,
+            GError            **error)
+{
+    static GString *json;
+    gboolean        show_personal_info;
+    gboolean        serialized;
+
+    if (!json)
+        json = g_string_sized_new (1024);
+
+    /* The JSON output is the command output itself, not a trace, so just
+     * like the text output it always includes the personal info, regardless
+     * of what the traces are allowed to show */
+    show_personal_info = mbim_utils_get_show_personal_info ();
+    mbim_utils_set_show_personal_info (TRUE);
+
+    g_string_truncate (json, 0);
+    serialized = mbim_message_serialize (message,
+                                         MBIM_MESSAGE_SERIALIZE_FORMAT_JSON,
+                                         mbimex_version_major,
+                                         mbimex_version_minor,
+                                         json,
+                                         error);
+
+    mbim_utils_set_show_personal_info (show_personal_info);
+    if (!serialized)
+        return FALSE;
+
+    g_string_append_c (json, '\n');
+    fwrite (json->str, 1, json->len, stdout);
+    fflush (stdout);
+    return TRUE;
+}
+
 G_GNUC_NORETURN
 static void
 print_printable_str_and_exit (const gchar *hex)
@@ -219,6 +271,14 @@ print_printable_str_and_exit (const gchar *hex)
         exit (EXIT_FAILURE);
     }
 
+    if (output_format_json) {
+        if (!print_json (message, 1, 0, &error)) {
+            g_printerr ("error: serializing message failed: %s\n", error->message);
+            exit (EXIT_FAILURE);
+        }
+        exit (EXIT_SUCCESS);
+    }
+
     printable = mbim_message_get_printable_full (message, 1, 0, "---- ", FALSE, &error);
     if (!printable) {
         g_printerr ("error: printable info retrieval failed: %s\n", error->message);
@@ -229,6 +289,30 @@ print_printable_str_and_exit (const gchar *hex)
     exit (EXIT_SUCCESS);
 }
 
+/*****************************************************************************/
+/* Command responses */
+
+MbimMessage *
+mbimcli_device_command_finish (MbimDevice    *dev,
+                               GAsyncResult  *res,
+                               GError       **error)
+{
+    g_autoptr(GError)  serialize_error = NULL;
+    MbimMessage       *response;
+    guint8             mbimex_version_major;
+    guint8             mbimex_version_minor = 0;
+
+    response = mbim_device_command_finish (dev, res, error);
+    if (!response || !output_format_json)
+        return response;
+
+    mbimex_version_major = mbim_device_get_ms_mbimex_version (dev, &mbimex_version_minor);
+    if (!print_json (response, mbimex_version_major, mbimex_version_minor, &serialize_error))
+        g_printerr ("error: serializing response failed: %s\n", serialize_error->message);
+
+    return response;
+}
+
 /*****************************************************************************/
 /* Running asynchronously */
 
@@ -363,7 +447,6 @@ device_open_ready (MbimDevice   *dev,
     case MBIM_SERVICE_USSD:
     case MBIM_SERVICE_STK:
     case MBIM_SERVICE_AUTH:
-    case MBIM_SERVICE_PROXY_CONTROL:
     case MBIM_SERVICE_QMI:
     case MBIM_SERVICE_QDU:
     case MBIM_SERVICE_INTEL_TOOLS:
@@ -378,6 +461,9 @@ device_open_ready (MbimDevice   *dev,
     case MBIM_SERVICE_INTEL_AT_TUNNEL:
         mbimcli_intel_at_tunnel_run (dev, cancellable);
         return;
+    case MBIM_SERVICE_PROXY_CONTROL:
+        mbimcli_proxy_control_run (dev, cancellable);
+        return;
 
         /* unsupported actions in the CLI */
     case MBIM_SERVICE_INVALID:
@@ -543,6 +629,11 @@ parse_actions (void)
         actions_enabled++;
     }
 
+    if (mbimcli_proxy_control_options_enabled ()) {
+        service = MBIM_SERVICE_PROXY_CONTROL;
+        actions_enabled++;
+    }
+
     /* Noop */
     if (noop_flag)
         actions_enabled++;
@@ -564,6 +655,12 @@ parse_actions (void)
         exit (EXIT_FAILURE);
     }
 
+    /* Proxy control actions are only processed by the proxy */
+    if (service == MBIM_SERVICE_PROXY_CONTROL && !device_open_proxy_flag) {
+        g_printerr ("error: proxy control actions require --device-open-proxy\n");
+        exit (EXIT_FAILURE);
+    }
+
     /* Go on! */
 }
 
@@ -598,6 +695,7 @@ int main (int argc, char **argv)
     g_option_context_add_group (context, mbimcli_sms_get_option_group ());
     g_option_context_add_group (context, mbimcli_compal_get_option_group ());
     g_option_context_add_group (context, mbimcli_intel_at_tunnel_get_option_group ());
+    g_option_context_add_group (context, mbimcli_proxy_control_get_option_group ());
 
     g_option_context_add_main_entries (context, main_entries, NULL);
     if (!g_option_context_parse (context, &argc, &argv, &error)) {
@@ -622,6 +720,14 @@ int main (int argc, char **argv)
         mbim_utils_set_show_personal_info (TRUE);
     }
 
+    if (output_format_str && g_str_equal (output_format_str, "json")) {
+        output_format_json = TRUE;
+        g_set_print_handler (discard_print_handler);
+    } else if (output_format_str && !g_str_equal (output_format_str, "text")) {
+        g_printerr ("error: invalid output format: '%s'\n", output_format_str);
+        exit (EXIT_FAILURE);
+    }
+
     if (printable_str)
         print_printable_str_and_exit (printable_str);
 
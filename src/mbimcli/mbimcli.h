@@ -16,7 +16,10 @@
 #define VALIDATE_EMPTY(str) ((str) ? (str) : "")
 
 /* Common */
-void mbimcli_async_operation_done (gboolean operation_status);
+void         mbimcli_async_operation_done  (gboolean operation_status);
+MbimMessage *mbimcli_device_command_finish (MbimDevice    *device,
+                                            GAsyncResult  *res,
+                                            GError       **error);
 
 /* Basic Connect group */
 GOptionGroup *mbimcli_basic_connect_get_option_group               (void);
@@ -39,6 +42,7 @@ GOptionGroup *mbimcli_fibocom_get_option_group                     (void);
 GOptionGroup *mbimcli_sms_get_option_group                         (void);
 GOptionGroup *mbimcli_compal_get_option_group                      (void);
 GOptionGroup *mbimcli_intel_at_tunnel_get_option_group             (void);
+GOptionGroup *mbimcli_proxy_control_get_option_group               (void);
 
 gboolean      mbimcli_basic_connect_options_enabled               (void);
 gboolean      mbimcli_phonebook_options_enabled                   (void);
@@ -60,6 +64,7 @@ gboolean      mbimcli_fibocom_options_enabled                     (void);
 gboolean      mbimcli_sms_options_enabled                         (void);
 gboolean      mbimcli_compal_options_enabled                      (void);
 gboolean      mbimcli_intel_at_tunnel_options_enabled             (void);
+gboolean      mbimcli_proxy_control_options_enabled               (void);
 
 void          mbimcli_basic_connect_run                 (MbimDevice   *device,
                                                          GCancellable *cancellable);
@@ -101,6 +106,8 @@ void          mbimcli_compal_run                        (MbimDevice *device,
                                                          GCancellable *cancellable);
 void          mbimcli_intel_at_tunnel_run               (MbimDevice *device,
                                                          GCancellable *cancellable);
+void          mbimcli_proxy_control_run                 (MbimDevice   *device,
+                                                         GCancellable *cancellable);
 
 /* link management */
 GOptionGroup *mbimcli_link_management_get_option_group (void);